@@ -111,6 +111,79 @@ namespace ciphers {
                                                   aes_state_t ciphertext,
                                                   const size_t num_rounds);
 
+    // ---------------------------------------------------------------------
+    // Batches of 8 or 16 independent texts. They compute the same as their
+    // single-text counterparts above, but keep all texts in flight in
+    // every round to hide the latency of aesenc. With VAES, four (AVX-512)
+    // or two (AVX2) texts share one vector register.
+    // ---------------------------------------------------------------------
+
+    void aes128_encrypt_rounds_8(const aes128_ctx_t *ctx,
+                                 const aes_state_t plaintexts[8],
+                                 aes_state_t ciphertexts[8],
+                                 size_t num_rounds);
+
+    void aes128_encrypt_rounds_16(const aes128_ctx_t *ctx,
+                                  const aes_state_t plaintexts[16],
+                                  aes_state_t ciphertexts[16],
+                                  size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    void aes128_encrypt_rounds_always_mc_8(const aes128_ctx_t *ctx,
+                                           const aes_state_t plaintexts[8],
+                                           aes_state_t ciphertexts[8],
+                                           size_t num_rounds);
+
+    void aes128_encrypt_rounds_always_mc_16(const aes128_ctx_t *ctx,
+                                            const aes_state_t plaintexts[16],
+                                            aes_state_t ciphertexts[16],
+                                            size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    void aes128_encrypt_rounds_only_sbox_in_final_8(
+        const aes128_ctx_t *ctx,
+        const aes_state_t plaintexts[8],
+        aes_state_t ciphertexts[8],
+        size_t num_rounds);
+
+    void aes128_encrypt_rounds_only_sbox_in_final_16(
+        const aes128_ctx_t *ctx,
+        const aes_state_t plaintexts[16],
+        aes_state_t ciphertexts[16],
+        size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+#define AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE  (1L << 32)
+
+    /**
+     * Encrypts the texts with indices [first_text_index,
+     * first_text_index + num_texts) of the diagonal structure of
+     * base_plaintext as aes128_encrypt_rounds_always_mc(), and increments
+     * histogram[c[0]] for the first byte c[0] of every ciphertext. The text
+     * with index i = [i0 i1 i2 i3] has the bytes 0, 5, 10, and 15 set to
+     * i0, i1, i2, and i3; all other bytes are those of base_plaintext.
+     *
+     * Generates, encrypts, and counts the texts in registers, eight at a
+     * time; no text is written to memory.
+     * @param ctx
+     * @param base_plaintext
+     * @param first_text_index Multiple of 8.
+     * @param num_texts Multiple of 8; first_text_index + num_texts must not
+     * exceed AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE.
+     * @param num_rounds Integer in [0, AES_128_NUM_ROUNDS].
+     * @param histogram Array of 256 counters.
+     */
+    void aes128_encrypt_diagonal_structure_histogram(
+        const aes128_ctx_t *ctx,
+        const aes_state_t base_plaintext,
+        size_t first_text_index,
+        size_t num_texts,
+        size_t num_rounds,
+        size_t histogram[256]);
+
     // ---------------------------------------------------------------------
 
     void aes128_key_setup(aes128_ctx_t *ctx, const aes128_key_t key);
@@ -33,6 +33,8 @@ namespace ciphers {
 #define SMALL_AES_NUM_ROWS          4
 #define SMALL_AES_NUM_COLUMNS       4
 
+#define SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE  (1L << 16)
+
 #define aesdec(x, k)       _mm_aesdec_si128(x, k)
 #define aesdeclast(x, k)   _mm_aesdeclast_si128(x, k)
 #define aesenc(x, k)       _mm_aesenc_si128(x, k)
@@ -68,6 +70,18 @@ namespace ciphers {
     ALIGN(16)
     typedef uint8_t small_aes_state_t[SMALL_AES_NUM_STATE_BYTES];
 
+    /**
+     * A state as a single word [x0 || x1 || ... || x15], i.e., nibble 0 in
+     * the most significant bits, so that column c is the 16-bit value at
+     * the bit offset (3 - c) * 16. Equals the big-endian interpretation of
+     * small_aes_state_t and the result of utils::convert_to_uint64().
+     */
+    typedef uint64_t small_aes_packed_state_t;
+
+#define SMALL_AES_PACKED_COLUMN_MASK(c) \
+    (UINT64_C(0xFFFF) << ((3 - (c)) * 16))
+#define SMALL_AES_PACKED_DIAGONAL_MASK      UINT64_C(0xF0000F0000F0000F)
+
     ALIGN(32)
     typedef struct {
         __m128i key[SMALL_AES_NUM_ROUND_KEYS];
@@ -91,6 +105,15 @@ namespace ciphers {
 
     // ---------------------------------------------------------------------
 
+    small_aes_packed_state_t small_aes_to_packed(const small_aes_state_t input);
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_from_packed(small_aes_state_t output,
+                               small_aes_packed_state_t input);
+
+    // ---------------------------------------------------------------------
+
     void small_aes_decrypt(const small_aes_ctx_t *ctx,
                            const small_aes_state_t ciphertext,
                            small_aes_state_t plaintext);
@@ -130,6 +153,70 @@ namespace ciphers {
         small_aes_state_t ciphertext,
         size_t num_rounds);
 
+    // ---------------------------------------------------------------------
+    // Overloads on packed states, which keep the state in registers
+    // instead of passing it through byte arrays. The variants with
+    // num_rounds return the input if num_rounds > SMALL_AES_NUM_ROUNDS.
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_decrypt(const small_aes_ctx_t *ctx,
+                      small_aes_packed_state_t ciphertext);
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_encrypt(const small_aes_ctx_t *ctx,
+                      small_aes_packed_state_t plaintext);
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_encrypt_rounds(const small_aes_ctx_t *ctx,
+                             small_aes_packed_state_t plaintext,
+                             size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_encrypt_rounds_always_mc(const small_aes_ctx_t *ctx,
+                                       small_aes_packed_state_t plaintext,
+                                       size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_decrypt_rounds_always_mc(const small_aes_ctx_t *ctx,
+                                       small_aes_packed_state_t ciphertext,
+                                       size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_encrypt_rounds_only_sbox_in_final(
+        const small_aes_ctx_t *ctx,
+        small_aes_packed_state_t plaintext,
+        size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Encrypts the plaintext over every number of rounds r in
+     * [min_num_rounds, max_num_rounds] as
+     * small_aes_encrypt_rounds_only_sbox_in_final(). Carries the state
+     * forward one round at a time and applies the SubBytes-only final round
+     * to a copy, so that every round is computed only once. The ciphertext
+     * for r rounds is written to ciphertexts[r - min_num_rounds]. Does
+     * nothing unless
+     * 1 <= min_num_rounds <= max_num_rounds <= SMALL_AES_NUM_ROUNDS.
+     */
+    void small_aes_encrypt_rounds_only_sbox_in_final_sweep(
+        const small_aes_ctx_t *ctx,
+        small_aes_packed_state_t plaintext,
+        small_aes_packed_state_t *ciphertexts,
+        size_t min_num_rounds,
+        size_t max_num_rounds);
+
     // ---------------------------------------------------------------------
 
     __m128i
@@ -284,6 +371,60 @@ namespace ciphers {
 
     // ---------------------------------------------------------------------
 
+    /**
+     * Encrypts all 2^16 plaintexts of the diagonal structure with the given
+     * index over num_rounds rounds, where the final round consists only of
+     * SubBytes and the key addition.
+     *
+     * The nibbles 2, 3, 6, 7, 8, 9, 12, 13 of every plaintext are the nibbles
+     * of structure_index (nibble 2 = bits 31..28, ..., nibble 13 = bits
+     * 3..0), nibbles 1, 4, 11, 14 are zero. The diagonal nibbles 0, 5, 10, 15
+     * of the j-th plaintext are (j >> 12), (j >> 8), (j >> 4), and j.
+     *
+     * The ciphertext of the j-th plaintext is written to ciphertexts[j] as
+     * [c0 || c1 || ... || c15], i.e., nibble 0 in the most significant bits.
+     *
+     * Needs only ctx->key. Encrypts 16 texts in four AVX2 registers at once
+     * if AVX2 is available.
+     * @param ctx
+     * @param structure_index
+     * @param ciphertexts Provides at least
+     * SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE elements.
+     * @param num_rounds Integer in [1, SMALL_AES_NUM_ROUNDS].
+     */
+    void small_aes_encrypt_diagonal_structure(const small_aes_ctx_t *ctx,
+                                              size_t structure_index,
+                                              uint64_t *ciphertexts,
+                                              size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Encrypts all 2^16 plaintexts of the diagonal structure with the given
+     * index as small_aes_encrypt_diagonal_structure(), but over every number
+     * of rounds r in [min_num_rounds, max_num_rounds] in a single pass. The
+     * ciphertext of the j-th plaintext after r rounds is written to
+     * ciphertexts[(r - min_num_rounds)
+     *             * SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE + j].
+     * Does nothing unless
+     * 1 <= min_num_rounds <= max_num_rounds <= SMALL_AES_NUM_ROUNDS.
+     * @param ctx
+     * @param structure_index
+     * @param ciphertexts Provides at least
+     * (max_num_rounds - min_num_rounds + 1)
+     * * SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE elements.
+     * @param min_num_rounds
+     * @param max_num_rounds
+     */
+    void small_aes_encrypt_diagonal_structure_sweep(
+        const small_aes_ctx_t *ctx,
+        size_t structure_index,
+        uint64_t *ciphertexts,
+        size_t min_num_rounds,
+        size_t max_num_rounds);
+
+    // ---------------------------------------------------------------------
+
 }
 
 #endif  // _SMALL_AES_H_
@@ -0,0 +1,128 @@
+/**
+ * Bitsliced implementation of Small-AES that encrypts 256 states at once.
+ *
+ * Do NOT use for any production purpose. No guarantees are given for anything.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _SMALL_AES_BITSLICED_H_
+#define _SMALL_AES_BITSLICED_H_
+
+// ---------------------------------------------------------------------
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#include "ciphers/small_aes.h"
+#include "utils/utils.h"
+
+// ---------------------------------------------------------------------
+
+namespace ciphers {
+
+#define SMALL_AES_BITSLICED_NUM_STATES      256
+#define SMALL_AES_NUM_CELLS                  16
+#define SMALL_AES_NUM_CELL_BITS               4
+
+    // ---------------------------------------------------------------------
+    // Types
+    // ---------------------------------------------------------------------
+
+    /**
+     * 256 Small-AES states as 64 bit-planes. cells[k][b] holds bit b (0 =
+     * least significant) of the nibble k of all states; bit i of its 64-bit
+     * lane l belongs to the state 64 * l + i.
+     */
+    ALIGN(32)
+    typedef struct {
+        __m256i cells[SMALL_AES_NUM_CELLS][SMALL_AES_NUM_CELL_BITS];
+    } small_aes_bitsliced_state_t;
+
+    /**
+     * Round keys as bit-planes, i.e., a plane is all-ones if the bit in the
+     * round key is set, and zero otherwise. The keys of rounds 1 to 10 also
+     * contain the constant 0x66...6 that the S-box circuit omits.
+     */
+    ALIGN(32)
+    typedef struct {
+        small_aes_bitsliced_state_t key[SMALL_AES_NUM_ROUND_KEYS];
+    } small_aes_bitsliced_ctx_t;
+
+    // ---------------------------------------------------------------------
+    // API
+    // ---------------------------------------------------------------------
+
+    void small_aes_bitsliced_key_setup(small_aes_bitsliced_ctx_t *ctx,
+                                       const small_aes_key_t key);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Transposes 256 states [x0 || x1 || ... || x15], nibble 0 in the most
+     * significant bits, into bit-planes.
+     */
+    void small_aes_bitsliced_pack(small_aes_bitsliced_state_t *state,
+                                  const uint64_t *texts);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Inverse of small_aes_bitsliced_pack().
+     */
+    void small_aes_bitsliced_unpack(uint64_t *texts,
+                                    const small_aes_bitsliced_state_t *state);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Encrypts the 256 states in place over num_rounds rounds as
+     * small_aes_encrypt_rounds(), i.e., the final round omits MixColumns.
+     * @param num_rounds Integer in [1, SMALL_AES_NUM_ROUNDS].
+     */
+    void small_aes_bitsliced_encrypt_rounds(
+        const small_aes_bitsliced_ctx_t *ctx,
+        small_aes_bitsliced_state_t *state,
+        size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Encrypts the 256 states in place over num_rounds rounds as
+     * small_aes_encrypt_rounds_only_sbox_in_final(), i.e., the final round
+     * consists only of SubBytes and the key addition.
+     * @param num_rounds Integer in [1, SMALL_AES_NUM_ROUNDS].
+     */
+    void small_aes_bitsliced_encrypt_rounds_only_sbox_in_final(
+        const small_aes_bitsliced_ctx_t *ctx,
+        small_aes_bitsliced_state_t *state,
+        size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Encrypts all 2^16 plaintexts of the diagonal structure with the given
+     * index as small_aes_encrypt_diagonal_structure(). The plaintexts are
+     * generated directly as bit-planes, in 256 batches of 256 texts.
+     * Since the ciphertexts must be transposed back, this is slower than
+     * small_aes_encrypt_diagonal_structure() for every number of rounds;
+     * it serves as an independent reference for the structure engines.
+     * @param ctx
+     * @param structure_index
+     * @param ciphertexts Provides at least
+     * SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE elements.
+     * @param num_rounds Integer in [1, SMALL_AES_NUM_ROUNDS].
+     */
+    void small_aes_bitsliced_encrypt_diagonal_structure(
+        const small_aes_bitsliced_ctx_t *ctx,
+        size_t structure_index,
+        uint64_t *ciphertexts,
+        size_t num_rounds);
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _SMALL_AES_BITSLICED_H_
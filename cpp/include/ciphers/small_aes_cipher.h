@@ -0,0 +1,526 @@
+/**
+ * Header-only family of Small-AES variants that differ in the S-box and
+ * the MixColumns matrix. SmallAesCipher<SBox, MixColumns, NumRounds> fixes
+ * both and the number of rounds at compile time, so that the round loops
+ * unroll completely; SmallAesCipherVariant<SBox, MixColumns> dispatches a
+ * number of rounds that is known only at run time to these instances.
+ * All variants use the key schedule of Small-AES. Variants with the
+ * MixColumns matrix of the AES compute their rounds with aesenc.
+ *
+ * Do NOT use for any production purpose. No guarantees are given for anything.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _SMALL_AES_CIPHER_H_
+#define _SMALL_AES_CIPHER_H_
+
+// ---------------------------------------------------------------------
+
+#include <immintrin.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ciphers/small_aes.h"
+#include "ciphers/small_aes_present_sbox.h"
+#include "ciphers/small_aes_pride_sbox.h"
+#include "ciphers/small_aes_prince_sbox.h"
+#include "ciphers/small_aes_toy6_sbox.h"
+#include "ciphers/small_aes_toy8_sbox.h"
+#include "ciphers/small_aes_toy10_sbox.h"
+#include "utils/utils.h"
+
+// ---------------------------------------------------------------------
+
+namespace ciphers {
+
+    // ---------------------------------------------------------------------
+    // Arithmetic in GF(2^4) with the polynomial x^4 + x + 1
+    // ---------------------------------------------------------------------
+
+    constexpr uint8_t small_aes_gf16_times_two(const uint8_t x) {
+        return (uint8_t) (((x << 1) ^ ((x & 0x8) ? 0x3 : 0)) & 0xF);
+    }
+
+    // ---------------------------------------------------------------------
+
+    constexpr uint8_t small_aes_gf16_multiply(const uint8_t x,
+                                              const uint8_t y) {
+        return (y == 0) ? 0 :
+               (uint8_t) (((y & 1) ? x : 0)
+                          ^ small_aes_gf16_multiply(
+                              small_aes_gf16_times_two(x),
+                              (uint8_t) (y >> 1)));
+    }
+
+    // ---------------------------------------------------------------------
+    // S-boxes
+    // ---------------------------------------------------------------------
+
+    /**
+     * An S-box policy provides table(), the 16 values of the S-box in the
+     * low nibbles of a shuffle mask.
+     */
+    struct SmallAesSBox {
+        static inline __m128i table() { return SMALL_AES_SBOX_1; }
+    };
+
+    struct SmallAesPresentSBox {
+        static inline __m128i table() { return SMALL_AES_PRESENT_SBOX; }
+    };
+
+    struct SmallAesPrideSBox {
+        static inline __m128i table() { return SMALL_AES_PRIDE_SBOX; }
+    };
+
+    struct SmallAesPrinceSBox {
+        static inline __m128i table() { return SMALL_AES_PRINCE_SBOX; }
+    };
+
+    struct SmallAesToy6SBox {
+        static inline __m128i table() { return SMALL_AES_TOY6_SBOX; }
+    };
+
+    struct SmallAesToy8SBox {
+        static inline __m128i table() { return SMALL_AES_TOY8_SBOX; }
+    };
+
+    struct SmallAesToy10SBox {
+        static inline __m128i table() { return SMALL_AES_TOY10_SBOX; }
+    };
+
+    // ---------------------------------------------------------------------
+    // MixColumns
+    // ---------------------------------------------------------------------
+
+    /**
+     * MixColumns with the circulant matrix whose first row is
+     * (A0, A1, A2, A3), i.e., the cell i of every column becomes
+     * A0 x_i + A1 x_{i+1} + A2 x_{i+2} + A3 x_{i+3}, indices modulo 4.
+     */
+    template <uint8_t A0, uint8_t A1, uint8_t A2, uint8_t A3>
+    struct SmallAesCirculantMixColumns {
+        static constexpr uint8_t coefficient(const size_t i) {
+            return (i == 0) ? A0 : (i == 1) ? A1 : (i == 2) ? A2 : A3;
+        }
+
+        /**
+         * True iff aesenc, followed by small_aes_aes_ni_correct_mix_columns(),
+         * computes this matrix on states in low nibbles. The AES multiplies
+         * by (2, 3, 1, 1) in GF(2^8); for nibbles, these products have at
+         * most five bits and never need the reduction of GF(2^8), so that
+         * only the fifth bit must be reduced modulo x^4 + x + 1. No such
+         * correction exists for other matrices.
+         */
+        static constexpr bool has_aes_ni_round() {
+            return (A0 == 2) && (A1 == 3) && (A2 == 1) && (A3 == 1);
+        }
+
+        static inline __m128i apply(const __m128i state) {
+            const __m128i y0 = multiply<A0, 0>(state);
+            const __m128i y1 = multiply<A1, 1>(state);
+            const __m128i y2 = multiply<A2, 2>(state);
+            const __m128i y3 = multiply<A3, 3>(state);
+            return vxor(vxor(y0, y1), vxor(y2, y3));
+        }
+
+    private:
+        /**
+         * Returns A x_{i+K} in the cell i of every column. Zero and one
+         * coefficients are resolved at compile time.
+         */
+        template <uint8_t A, size_t K>
+        static inline __m128i multiply(const __m128i state) {
+            if (A == 0) {
+                return zero;
+            }
+
+            const __m128i rotated = (K == 0) ? state : vshuffle(
+                state,
+                vsetr8(K % 4, (K + 1) % 4, (K + 2) % 4, (K + 3) % 4,
+                       4 + K % 4, 4 + (K + 1) % 4,
+                       4 + (K + 2) % 4, 4 + (K + 3) % 4,
+                       8 + K % 4, 8 + (K + 1) % 4,
+                       8 + (K + 2) % 4, 8 + (K + 3) % 4,
+                       12 + K % 4, 12 + (K + 1) % 4,
+                       12 + (K + 2) % 4, 12 + (K + 3) % 4)
+            );
+
+            if (A == 1) {
+                return rotated;
+            }
+
+            const __m128i times_a = vsetr8(
+                small_aes_gf16_multiply(A, 0), small_aes_gf16_multiply(A, 1),
+                small_aes_gf16_multiply(A, 2), small_aes_gf16_multiply(A, 3),
+                small_aes_gf16_multiply(A, 4), small_aes_gf16_multiply(A, 5),
+                small_aes_gf16_multiply(A, 6), small_aes_gf16_multiply(A, 7),
+                small_aes_gf16_multiply(A, 8), small_aes_gf16_multiply(A, 9),
+                small_aes_gf16_multiply(A, 10), small_aes_gf16_multiply(A, 11),
+                small_aes_gf16_multiply(A, 12), small_aes_gf16_multiply(A, 13),
+                small_aes_gf16_multiply(A, 14), small_aes_gf16_multiply(A, 15)
+            );
+            return vshuffle(times_a, rotated);
+        }
+    };
+
+    typedef SmallAesCirculantMixColumns<2, 3, 1, 1> SmallAesMixColumns;
+
+    /**
+     * As small_aes_m02_mc.cc: x_i + 3 x_{i+1} + 2 x_{i+2} + 2 x_{i+3}.
+     */
+    typedef SmallAesCirculantMixColumns<1, 3, 2, 2> SmallAesM02MixColumns;
+
+    /**
+     * As small_aes_midori_mc.cc, which adds all four cells of a column.
+     */
+    typedef SmallAesCirculantMixColumns<1, 1, 1, 1> SmallAesMidoriMixColumns;
+
+    // ---------------------------------------------------------------------
+    // AES-NI
+    // ---------------------------------------------------------------------
+
+    /**
+     * Returns the map M with AES-Sbox[M[x]] = S[x] for the 4-bit S-box S
+     * in the low nibbles of sbox, so that vshuffle(M, state) followed by
+     * the SubBytes of aesenc applies S. Since the AES S-box permutes the
+     * bytes, every nibble has exactly one preimage, and the search for M
+     * is an inversion: aesdeclast applies InvShiftRows and InvSubBytes,
+     * and the ShiftRows before it cancels the former.
+     */
+    inline __m128i small_aes_aes_ni_sbox_map(const __m128i sbox) {
+        const __m128i shifted_sbox = vshuffle(
+            sbox,
+            vsetr8(0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11)
+        );
+        return aesdeclast(shifted_sbox, zero);
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Reduces the fifth bit that the MixColumns of aesenc can set in every
+     * byte modulo x^4 + x + 1.
+     */
+    inline __m128i small_aes_aes_ni_correct_mix_columns(__m128i state) {
+        const __m128i mask = vand(state, vset8_single(0x10));
+        state = vxor(state, mask);
+        state = vxor(state, vshiftright16(mask, 3));
+        return vxor(state, vshiftright16(mask, 4));
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * A full round of Small-AES with the S-box whose map from
+     * small_aes_aes_ni_sbox_map() is sbox_map, computed with aesenc.
+     */
+    inline __m128i small_aes_encrypt_round_with_aes_ni(
+        const __m128i state,
+        const __m128i round_key,
+        const __m128i sbox_map) {
+        return small_aes_aes_ni_correct_mix_columns(
+            aesenc(vshuffle(sbox_map, state), round_key)
+        );
+    }
+
+    // ---------------------------------------------------------------------
+    // Ciphers
+    // ---------------------------------------------------------------------
+
+    template <typename Cipher, size_t Round, size_t End>
+    struct SmallAesRoundLoop;
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Small-AES with the given S-box and MixColumns over NumRounds rounds.
+     * The functions behave as their counterparts in small_aes.h with
+     * num_rounds = NumRounds and expect a key schedule from
+     * small_aes_key_setup().
+     */
+    template <typename SBox, typename MixColumns, size_t NumRounds>
+    class SmallAesCipher {
+    public:
+        typedef SmallAesCipher<SBox, MixColumns, NumRounds> Self;
+
+        static inline __m128i sub_bytes(const __m128i state) {
+            return vshuffle(SBox::table(), state);
+        }
+
+        // -----------------------------------------------------------------
+
+        static inline __m128i shift_rows(const __m128i state) {
+            return vshuffle(
+                state,
+                vsetr8(0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11)
+            );
+        }
+
+        // -----------------------------------------------------------------
+
+        static inline __m128i mix_columns(const __m128i state) {
+            return MixColumns::apply(state);
+        }
+
+        // -----------------------------------------------------------------
+
+        /**
+         * Uses aesenc if MixColumns permits; the compiler hoists the map
+         * out of the unrolled rounds.
+         */
+        static inline __m128i encrypt_round(__m128i state,
+                                            const __m128i round_key) {
+            if (MixColumns::has_aes_ni_round()) {
+                return small_aes_encrypt_round_with_aes_ni(
+                    state, round_key, small_aes_aes_ni_sbox_map(SBox::table())
+                );
+            }
+
+            state = sub_bytes(state);
+            state = shift_rows(state);
+            state = mix_columns(state);
+            return vxor(state, round_key);
+        }
+
+        // -----------------------------------------------------------------
+
+        /**
+         * Encrypts the state in low nibbles over NumRounds rounds; the
+         * final round consists only of SubBytes and the key addition.
+         */
+        static inline __m128i encrypt_rounds_only_sbox_in_final_with_aes_ni(
+            const small_aes_ctx_t *ctx,
+            const __m128i plaintext) {
+            __m128i state = vxor(plaintext, ctx->key[0]);
+            state = SmallAesRoundLoop<Self, 1, NumRounds>::apply(ctx, state);
+            state = sub_bytes(state);
+            return vxor(state, ctx->key[NumRounds]);
+        }
+
+        // -----------------------------------------------------------------
+
+        static inline void encrypt_rounds_only_sbox_in_final(
+            const small_aes_ctx_t *ctx,
+            const small_aes_state_t plaintext,
+            small_aes_state_t ciphertext) {
+            to_byte_array(
+                ciphertext,
+                encrypt_rounds_only_sbox_in_final_with_aes_ni(
+                    ctx, to_lower_nibbles(plaintext)
+                )
+            );
+        }
+
+        // -----------------------------------------------------------------
+
+        /**
+         * Encrypts over NumRounds full rounds, including the final
+         * MixColumns.
+         */
+        static inline void encrypt_rounds_always_mc(
+            const small_aes_ctx_t *ctx,
+            const small_aes_state_t plaintext,
+            small_aes_state_t ciphertext) {
+            __m128i state = vxor(to_lower_nibbles(plaintext), ctx->key[0]);
+            state = SmallAesRoundLoop<Self, 1, NumRounds + 1>::apply(ctx,
+                                                                     state);
+            to_byte_array(ciphertext, state);
+        }
+    };
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Applies the full rounds [Round, End) with the round keys of ctx.
+     */
+    template <typename Cipher, size_t Round, size_t End>
+    struct SmallAesRoundLoop {
+        static inline __m128i apply(const small_aes_ctx_t *ctx,
+                                    const __m128i state) {
+            return SmallAesRoundLoop<Cipher, Round + 1, End>::apply(
+                ctx, Cipher::encrypt_round(state, ctx->key[Round])
+            );
+        }
+    };
+
+    template <typename Cipher, size_t End>
+    struct SmallAesRoundLoop<Cipher, End, End> {
+        static inline __m128i apply(const small_aes_ctx_t *,
+                                    const __m128i state) {
+            return state;
+        }
+    };
+
+    // Rounds [1, 0) for NumRounds = 0 apply nothing either.
+    template <typename Cipher>
+    struct SmallAesRoundLoop<Cipher, 1, 0> {
+        static inline __m128i apply(const small_aes_ctx_t *,
+                                    const __m128i state) {
+            return state;
+        }
+    };
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Runtime interface of a variant with the signatures of the functions
+     * in small_aes.h. Dispatches num_rounds to the unrolled
+     * SmallAesCipher<SBox, MixColumns, num_rounds> for every number of
+     * rounds in [0, SMALL_AES_NUM_ROUNDS]; larger values leave the
+     * ciphertext untouched or return the plaintext.
+     */
+    template <typename SBox, typename MixColumns>
+    class SmallAesCipherVariant {
+    public:
+        typedef SBox SBoxType;
+        typedef MixColumns MixColumnsType;
+
+        static inline __m128i encrypt_rounds_only_sbox_in_final_with_aes_ni(
+            const small_aes_ctx_t *ctx,
+            const __m128i plaintext,
+            const size_t num_rounds) {
+            if (num_rounds > SMALL_AES_NUM_ROUNDS) {
+                return plaintext;
+            }
+
+            return Dispatch<SMALL_AES_NUM_ROUNDS>::
+                encrypt_rounds_only_sbox_in_final_with_aes_ni(
+                    ctx, plaintext, num_rounds
+                );
+        }
+
+        // -----------------------------------------------------------------
+
+        static inline void encrypt_rounds_only_sbox_in_final(
+            const small_aes_ctx_t *ctx,
+            const small_aes_state_t plaintext,
+            small_aes_state_t ciphertext,
+            const size_t num_rounds) {
+            if (num_rounds > SMALL_AES_NUM_ROUNDS) {
+                return;
+            }
+
+            to_byte_array(
+                ciphertext,
+                encrypt_rounds_only_sbox_in_final_with_aes_ni(
+                    ctx, to_lower_nibbles(plaintext), num_rounds
+                )
+            );
+        }
+
+        // -----------------------------------------------------------------
+
+        static inline void encrypt_rounds_always_mc(
+            const small_aes_ctx_t *ctx,
+            const small_aes_state_t plaintext,
+            small_aes_state_t ciphertext,
+            const size_t num_rounds) {
+            if (num_rounds > SMALL_AES_NUM_ROUNDS) {
+                return;
+            }
+
+            if (num_rounds == 0) {
+                memcpy(ciphertext, plaintext, SMALL_AES_NUM_STATE_BYTES);
+                return;
+            }
+
+            Dispatch<SMALL_AES_NUM_ROUNDS>::encrypt_rounds_always_mc(
+                ctx, plaintext, ciphertext, num_rounds
+            );
+        }
+
+    private:
+        template <size_t NumRounds, bool IsLast = (NumRounds == 0)>
+        struct Dispatch {
+            typedef SmallAesCipher<SBox, MixColumns, NumRounds> Cipher;
+            typedef Dispatch<NumRounds - 1> Next;
+
+            static inline __m128i
+            encrypt_rounds_only_sbox_in_final_with_aes_ni(
+                const small_aes_ctx_t *ctx,
+                const __m128i plaintext,
+                const size_t num_rounds) {
+                return (num_rounds == NumRounds)
+                    ? Cipher::encrypt_rounds_only_sbox_in_final_with_aes_ni(
+                        ctx, plaintext
+                    )
+                    : Next::encrypt_rounds_only_sbox_in_final_with_aes_ni(
+                        ctx, plaintext, num_rounds
+                    );
+            }
+
+            static inline void encrypt_rounds_always_mc(
+                const small_aes_ctx_t *ctx,
+                const small_aes_state_t plaintext,
+                small_aes_state_t ciphertext,
+                const size_t num_rounds) {
+                if (num_rounds == NumRounds) {
+                    Cipher::encrypt_rounds_always_mc(ctx, plaintext,
+                                                     ciphertext);
+                } else {
+                    Next::encrypt_rounds_always_mc(ctx, plaintext, ciphertext,
+                                                   num_rounds);
+                }
+            }
+        };
+
+        template <size_t NumRounds>
+        struct Dispatch<NumRounds, true> {
+            typedef SmallAesCipher<SBox, MixColumns, 0> Cipher;
+
+            static inline __m128i
+            encrypt_rounds_only_sbox_in_final_with_aes_ni(
+                const small_aes_ctx_t *ctx,
+                const __m128i plaintext,
+                const size_t) {
+                return Cipher::encrypt_rounds_only_sbox_in_final_with_aes_ni(
+                    ctx, plaintext
+                );
+            }
+
+            static inline void encrypt_rounds_always_mc(
+                const small_aes_ctx_t *ctx,
+                const small_aes_state_t plaintext,
+                small_aes_state_t ciphertext,
+                const size_t) {
+                Cipher::encrypt_rounds_always_mc(ctx, plaintext, ciphertext);
+            }
+        };
+    };
+
+    // ---------------------------------------------------------------------
+    // Variants
+    // ---------------------------------------------------------------------
+
+    typedef SmallAesCipherVariant<SmallAesSBox, SmallAesMixColumns>
+        SmallAesDefaultCipher;
+    typedef SmallAesCipherVariant<SmallAesSBox, SmallAesM02MixColumns>
+        SmallAesM02McCipher;
+    typedef SmallAesCipherVariant<SmallAesSBox, SmallAesMidoriMixColumns>
+        SmallAesMidoriMcCipher;
+    typedef SmallAesCipherVariant<SmallAesPresentSBox, SmallAesMixColumns>
+        SmallAesPresentSBoxCipher;
+    typedef SmallAesCipherVariant<SmallAesPresentSBox, SmallAesM02MixColumns>
+        SmallAesPresentSBoxM02McCipher;
+    typedef SmallAesCipherVariant<SmallAesPresentSBox,
+                                  SmallAesMidoriMixColumns>
+        SmallAesPresentSBoxMidoriMcCipher;
+    typedef SmallAesCipherVariant<SmallAesPrideSBox, SmallAesMixColumns>
+        SmallAesPrideSBoxCipher;
+    typedef SmallAesCipherVariant<SmallAesPrinceSBox, SmallAesMixColumns>
+        SmallAesPrinceSBoxCipher;
+    typedef SmallAesCipherVariant<SmallAesToy6SBox, SmallAesMixColumns>
+        SmallAesToy6SBoxCipher;
+    typedef SmallAesCipherVariant<SmallAesToy8SBox, SmallAesMixColumns>
+        SmallAesToy8SBoxCipher;
+    typedef SmallAesCipherVariant<SmallAesToy10SBox, SmallAesMixColumns>
+        SmallAesToy10SBoxCipher;
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _SMALL_AES_CIPHER_H_
@@ -0,0 +1,147 @@
+/**
+ * Implementation of Small-AES that encrypts the same texts under several
+ * keys, or under one key with several S-boxes, at once, with every key or
+ * S-box in its own 128-bit lane.
+ *
+ * Do NOT use for any production purpose. No guarantees are given for anything.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _SMALL_AES_MULTI_KEY_H_
+#define _SMALL_AES_MULTI_KEY_H_
+
+// ---------------------------------------------------------------------
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#include "ciphers/small_aes.h"
+#include "utils/utils.h"
+
+// ---------------------------------------------------------------------
+
+namespace ciphers {
+
+#define SMALL_AES_MULTI_KEY_MAX_NUM_KEYS    8
+
+    // ---------------------------------------------------------------------
+    // Types
+    // ---------------------------------------------------------------------
+
+    /**
+     * round_keys[i][k] holds the round key i of the key k with every nibble
+     * in both halves of its byte, so that the 16 bytes form the 128-bit lane
+     * of the key k. The lanes of consecutive keys are adjacent, so that a
+     * single load fills an AVX2 register with two and an AVX-512 register
+     * with four keys. Lanes from num_keys on repeat the key 0.
+     * sboxes[k] holds the S-box that SubBytes applies in the lane k; the key
+     * schedule always uses the Small-AES S-box. num_keys is the number of
+     * lanes in use, i.e., the number of keys or S-boxes.
+     */
+    ALIGN(64)
+    typedef struct {
+        size_t num_keys;
+        ALIGN(64) uint8_t round_keys[SMALL_AES_NUM_ROUND_KEYS]
+                                    [SMALL_AES_MULTI_KEY_MAX_NUM_KEYS]
+                                    [16];
+        ALIGN(64) uint8_t sboxes[SMALL_AES_MULTI_KEY_MAX_NUM_KEYS][16];
+    } small_aes_multi_key_ctx_t;
+
+    // ---------------------------------------------------------------------
+    // API
+    // ---------------------------------------------------------------------
+
+    /**
+     * Expands num_keys keys at once, with one key per lane. All lanes use
+     * the Small-AES S-box. Leaves ctx->num_keys at zero, which turns the
+     * encryption functions into no-ops, if num_keys is not 2, 4, or 8.
+     * @param ctx
+     * @param keys Provides num_keys keys.
+     * @param num_keys 2, 4, or 8.
+     */
+    void small_aes_multi_key_key_setup(small_aes_multi_key_ctx_t *ctx,
+                                       const small_aes_key_t *keys,
+                                       size_t num_keys);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Expands a single key into all lanes and lets SubBytes in the lane k
+     * apply sboxes[k] instead of the Small-AES S-box, as the S-box variants
+     * of small_aes_random_sbox.h do. The encryption functions then write the
+     * ciphertexts under sboxes[k] where they write those under the key k
+     * otherwise. Leaves ctx->num_keys at zero if num_sboxes is not in
+     * [1, SMALL_AES_MULTI_KEY_MAX_NUM_KEYS].
+     * @param ctx
+     * @param key
+     * @param sboxes Provides num_sboxes 4-bit S-boxes, one value per byte.
+     * @param num_sboxes
+     */
+    void small_aes_multi_key_sbox_setup(small_aes_multi_key_ctx_t *ctx,
+                                        const small_aes_key_t key,
+                                        const __m128i *sboxes,
+                                        size_t num_sboxes);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Encrypts num_texts plaintexts under all keys of ctx over num_rounds
+     * rounds as small_aes_encrypt_rounds(), i.e., the final round omits
+     * MixColumns. Texts are uint64 values as small_aes_packed_state_t.
+     * @param ctx
+     * @param plaintexts Provides num_texts elements.
+     * @param num_texts
+     * @param ciphertexts Provides ctx->num_keys * num_texts elements. The
+     * ciphertext of plaintexts[j] under the key k is written to
+     * ciphertexts[k * num_texts + j].
+     * @param num_rounds Integer in [1, SMALL_AES_NUM_ROUNDS].
+     */
+    void small_aes_multi_key_encrypt_rounds(
+        const small_aes_multi_key_ctx_t *ctx,
+        const uint64_t *plaintexts,
+        size_t num_texts,
+        uint64_t *ciphertexts,
+        size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * As small_aes_multi_key_encrypt_rounds(), but the final round consists
+     * only of SubBytes and the key addition as
+     * small_aes_encrypt_rounds_only_sbox_in_final().
+     */
+    void small_aes_multi_key_encrypt_rounds_only_sbox_in_final(
+        const small_aes_multi_key_ctx_t *ctx,
+        const uint64_t *plaintexts,
+        size_t num_texts,
+        uint64_t *ciphertexts,
+        size_t num_rounds);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Encrypts all 2^16 plaintexts of the diagonal structure with the given
+     * index under all keys of ctx, as small_aes_encrypt_diagonal_structure()
+     * does under a single key. The ciphertext of the j-th plaintext under
+     * the key k is written to
+     * ciphertexts[k * SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE + j].
+     * @param ctx
+     * @param structure_index
+     * @param ciphertexts Provides at least
+     * ctx->num_keys * SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE elements.
+     * @param num_rounds Integer in [1, SMALL_AES_NUM_ROUNDS].
+     */
+    void small_aes_multi_key_encrypt_diagonal_structure(
+        const small_aes_multi_key_ctx_t *ctx,
+        size_t structure_index,
+        uint64_t *ciphertexts,
+        size_t num_rounds);
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _SMALL_AES_MULTI_KEY_H_
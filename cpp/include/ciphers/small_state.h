@@ -22,6 +22,14 @@ namespace ciphers {
 
         }
 
+        explicit SmallState(const small_aes_packed_state_t packed) {
+            small_aes_from_packed(state, packed);
+        }
+
+        small_aes_packed_state_t to_packed() const {
+            return small_aes_to_packed(state);
+        }
+
         small_aes_state_t state;
 
     };
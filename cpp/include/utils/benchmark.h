@@ -0,0 +1,172 @@
+/**
+ * A small harness to measure the throughput of the kernels, with results
+ * in cycles per byte and states per second, printable as JSON.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+// ---------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+#define BENCHMARK_DEFAULT_MIN_SECONDS       0.1
+#define BENCHMARK_DEFAULT_NUM_REPETITIONS   3
+
+    // ---------------------------------------------------------------------
+    // Types
+    // ---------------------------------------------------------------------
+
+    /**
+     * Runs the measured kernel num_iterations times.
+     */
+    typedef std::function<void(size_t num_iterations)> benchmark_function_t;
+
+    // ---------------------------------------------------------------------
+
+    typedef struct {
+        std::string name;
+        size_t num_iterations;
+        // Number of states, e.g., texts, that one iteration processes
+        size_t num_states_per_iteration;
+        size_t num_bytes_per_state;
+        // Wall-clock time
+        double num_seconds;
+        // Processor time of the process
+        double num_cpu_seconds;
+        uint64_t num_cycles;
+    } BenchmarkResult;
+
+    // ---------------------------------------------------------------------
+    // Timing
+    // ---------------------------------------------------------------------
+
+    /**
+     * The time-stamp counter. It ticks at the nominal frequency of the CPU,
+     * which differs from the core clock under frequency scaling or turbo.
+     */
+    inline uint64_t read_cycle_counter() {
+        return __builtin_ia32_rdtsc();
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Keeps the compiler from discarding the computation of value.
+     */
+    template <typename T>
+    inline void do_not_optimize(const T &value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // ---------------------------------------------------------------------
+
+    double get_cycles_per_byte(const BenchmarkResult &result);
+
+    // ---------------------------------------------------------------------
+
+    double get_states_per_second(const BenchmarkResult &result);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Escapes value as a JSON string, including the quotes.
+     */
+    std::string to_json_string(const std::string &value);
+
+    // ---------------------------------------------------------------------
+
+    void print_benchmark_table_header(FILE *file);
+
+    // ---------------------------------------------------------------------
+
+    void print_benchmark_table_row(FILE *file, const BenchmarkResult &result);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Measures kernels and collects their results.
+     *
+     * Every benchmark first doubles the number of iterations until one run
+     * takes at least min_seconds, and then repeats that run
+     * num_repetitions times; the fastest repetition is kept, which is the
+     * one least disturbed by other processes.
+     */
+    class BenchmarkRunner {
+
+    public:
+
+        BenchmarkRunner(double min_seconds, size_t num_repetitions);
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * Benchmarks function and stores its result.
+         * @param name Unique name of the benchmark.
+         * @param num_states_per_iteration
+         * @param num_bytes_per_state
+         * @param function
+         */
+        const BenchmarkResult &run(const std::string &name,
+                                   size_t num_states_per_iteration,
+                                   size_t num_bytes_per_state,
+                                   const benchmark_function_t &function);
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * Adds a key-value pair to the "context" object of the JSON output,
+         * e.g., the number of rounds or a label of the commit.
+         */
+        void add_context(const std::string &key, const std::string &value);
+
+        // ---------------------------------------------------------------------
+
+        const std::vector<BenchmarkResult> &get_results() const;
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * Writes the context, with the CPU, compiler, and date, and all
+         * results as JSON. The layout follows that of Google Benchmark,
+         * with the extra fields cycles_per_byte and states_per_second.
+         */
+        void write_json(FILE *file) const;
+
+    private:
+
+        BenchmarkResult measure(const std::string &name,
+                                size_t num_states_per_iteration,
+                                size_t num_bytes_per_state,
+                                size_t num_iterations,
+                                const benchmark_function_t &function) const;
+
+        // ---------------------------------------------------------------------
+
+        double min_seconds;
+        size_t num_repetitions;
+        std::vector<std::pair<std::string, std::string> > context;
+        std::vector<BenchmarkResult> results;
+
+    };
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _BENCHMARK_H_
@@ -0,0 +1,106 @@
+/**
+ * Flat bucket storage of Small-AES texts by the value of a ciphertext column.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _COLUMN_BUCKETS_H_
+#define _COLUMN_BUCKETS_H_
+
+// ---------------------------------------------------------------------
+
+#include <stdint.h>
+#include <vector>
+
+#include "utils/utils.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+#define COLUMN_BUCKETS_NUM_COLUMNS          4
+#define COLUMN_BUCKETS_NUM_COLUMN_VALUES    (1L << 16)
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Sorts up to 2^16 ciphertexts [c0 || c1 || ... || c15], where column i
+     * is the 16-bit value at the bit offset (3 - i) * 16, into buckets by the
+     * value of one column, in compressed sparse row layout: one histogram
+     * pass, one prefix sum, and one scatter into a single flat array.
+     *
+     * Since all texts in a bucket share the bucketed column, each entry
+     * stores the ciphertext with that column replaced by the index j of the
+     * text. Within a bucket, the entries are in ascending order of j.
+     *
+     * The buffers are allocated once in the constructor and reused by
+     * every call to fill().
+     */
+    class ColumnBuckets {
+
+    public:
+
+        ColumnBuckets();
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * @throws std::length_error if num_texts exceeds 2^16.
+         */
+        void fill(const uint64_t *ciphertexts,
+                  size_t num_texts,
+                  size_t column_index);
+
+        // ---------------------------------------------------------------------
+
+        const uint64_t *get_bucket_begin(const size_t column_value) const {
+            return entries.data() + offsets[column_value];
+        }
+
+        // ---------------------------------------------------------------------
+
+        const uint64_t *get_bucket_end(const size_t column_value) const {
+            return entries.data() + offsets[column_value + 1];
+        }
+
+        // ---------------------------------------------------------------------
+
+        size_t get_bucket_size(const size_t column_value) const {
+            return offsets[column_value + 1] - offsets[column_value];
+        }
+
+        // ---------------------------------------------------------------------
+
+        size_t get_column_index() const {
+            return column_index;
+        }
+
+        // ---------------------------------------------------------------------
+
+        size_t get_text_index(const uint64_t entry) const {
+            return get_column(entry, column_index);
+        }
+
+        // ---------------------------------------------------------------------
+
+        static size_t get_column(const uint64_t text,
+                                 const size_t column_index) {
+            return (text >> ((COLUMN_BUCKETS_NUM_COLUMNS - 1 - column_index)
+                             * 16)) & 0xFFFF;
+        }
+
+    private:
+
+        std::vector<uint32_t> offsets;
+        std::vector<uint64_t> entries;
+        size_t column_index;
+
+    };
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _COLUMN_BUCKETS_H_
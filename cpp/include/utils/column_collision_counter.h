@@ -0,0 +1,104 @@
+/**
+ * Counts column collisions among Small-AES states in linear time.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _COLUMN_COLLISION_COUNTER_H_
+#define _COLUMN_COLLISION_COUNTER_H_
+
+// ---------------------------------------------------------------------
+
+#include <stdint.h>
+#include <vector>
+
+#include "utils/utils.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+#define COLUMN_COLLISION_COUNTER_NUM_COLUMNS          4
+#define COLUMN_COLLISION_COUNTER_NUM_COLUMN_VALUES    (1L << 16)
+
+    // ---------------------------------------------------------------------
+
+    typedef struct {
+        // Number of pairs that collide in at least one column.
+        size_t num_collisions;
+        // Sum over all pairs of the number of colliding columns minus one.
+        size_t num_multi_column_collisions;
+    } ColumnCollisions;
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Given states as uint64_t [x0 || x1 || ... || x15], where column i is
+     * the 16-bit value at the bit offset (3 - i) * 16, counts the pairs that
+     * collide in columns without sorting.
+     *
+     * For every non-empty set of columns S, N_S is the number of pairs that
+     * collide in all columns of S. The N_{i} follow from the column
+     * histograms. For the larger sets, the states are scattered into buckets
+     * by their value in the smallest column of S, and only states within
+     * the same bucket are compared on the remaining columns. The number of
+     * pairs that collide in at least one column is obtained by
+     * inclusion-exclusion over all N_S.
+     *
+     * The buffers are allocated once in the constructor and reused by
+     * every call to count().
+     */
+    class ColumnCollisionCounter {
+
+    public:
+
+        explicit ColumnCollisionCounter(size_t max_num_texts);
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * @throws std::length_error if num_texts exceeds the max_num_texts
+         * of the constructor, since the buckets could not hold all texts.
+         */
+        ColumnCollisions count(const uint64_t *texts, size_t num_texts);
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * The number of pairs N_S that collided in all columns of S for the
+         * last call of count(), where bit (3 - i) of column_mask represents
+         * column i.
+         */
+        size_t get_num_pairs_colliding_in(size_t column_mask) const;
+
+    private:
+
+        void build_histograms(const uint64_t *texts, size_t num_texts);
+
+        // ---------------------------------------------------------------------
+
+        void scatter_to_buckets(const uint64_t *texts,
+                                size_t num_texts,
+                                size_t column_index);
+
+        // ---------------------------------------------------------------------
+
+        void count_pairs_in_buckets(size_t column_index);
+
+        // ---------------------------------------------------------------------
+
+        std::vector<uint32_t> histograms;
+        std::vector<uint32_t> bucket_ends;
+        std::vector<uint64_t> buckets;
+        size_t max_num_texts;
+        size_t num_pairs_colliding_in[1 << COLUMN_COLLISION_COUNTER_NUM_COLUMNS];
+
+    };
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _COLUMN_COLLISION_COUNTER_H_
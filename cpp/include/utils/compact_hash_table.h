@@ -0,0 +1,170 @@
+/**
+ * Compact, serializable form of the hash tables for the key recovery.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _COMPACT_HASH_TABLE_H_
+#define _COMPACT_HASH_TABLE_H_
+
+// ---------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "utils/utils.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+#define COMPACT_HASH_TABLE_MAGIC            0x54484153  // "SAHT"
+#define COMPACT_HASH_TABLE_VERSION          1
+#define COMPACT_HASH_TABLE_NUM_ALPHAS       (1L << 16)
+#define COMPACT_HASH_TABLE_MAX_SBOX_SIZE    16
+
+    // ---------------------------------------------------------------------
+
+    typedef struct {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t num_tables;
+        uint32_t num_alphas;
+        uint64_t num_diagonals;
+        uint8_t sbox[COMPACT_HASH_TABLE_MAX_SBOX_SIZE];
+    } CompactHashTableHeader;
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Stores the hash tables of HashTableGenerator::create_hash_table() for
+     * all active cells in a single buffer:
+     *
+     * [header || offsets || diagonals]
+     *
+     * For table t and a difference alpha, the candidates are the 16-bit
+     * diagonals [x0 || x1 || x2 || x3] in
+     * diagonals[offsets[t * (num_alphas + 1) + alpha],
+     *           offsets[t * (num_alphas + 1) + alpha + 1]).
+     *
+     * The buffer is either built in memory and can be written to a file
+     * with write_to_file(), or is memory-mapped read-only from such a file
+     * by map_from_file().
+     */
+    class CompactHashTables {
+
+    public:
+
+        CompactHashTables();
+
+        // ---------------------------------------------------------------------
+
+        ~CompactHashTables();
+
+        // ---------------------------------------------------------------------
+
+        CompactHashTables(const CompactHashTables &) = delete;
+        CompactHashTables &operator=(const CompactHashTables &) = delete;
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * Packs the given hash tables, one per active cell, each mapping
+         * the 2^16 values of alpha to lists of four nibbles.
+         * @param sbox The S-box that the tables were created from.
+         */
+        void build(const std::vector<ExtendedDDT> &hash_tables,
+                   const size_t *sbox,
+                   size_t num_sbox_entries);
+
+        // ---------------------------------------------------------------------
+
+        bool write_to_file(const std::string &file_name) const;
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * Maps the tables from the file. Fails if the file does not exist,
+         * is malformed, or was created for another S-box.
+         */
+        bool map_from_file(const std::string &file_name,
+                           const size_t *sbox,
+                           size_t num_sbox_entries);
+
+        // ---------------------------------------------------------------------
+
+        bool is_empty() const {
+            return header == NULL;
+        }
+
+        // ---------------------------------------------------------------------
+
+        size_t get_num_tables() const {
+            return is_empty() ? 0 : header->num_tables;
+        }
+
+        // ---------------------------------------------------------------------
+
+        size_t get_num_diagonals() const {
+            return is_empty() ? 0 : header->num_diagonals;
+        }
+
+        // ---------------------------------------------------------------------
+
+        const uint16_t *get_diagonals_begin(const size_t table_index,
+                                            const size_t alpha) const {
+            return diagonals + offsets[get_offset_index(table_index, alpha)];
+        }
+
+        // ---------------------------------------------------------------------
+
+        const uint16_t *get_diagonals_end(const size_t table_index,
+                                          const size_t alpha) const {
+            return diagonals
+                   + offsets[get_offset_index(table_index, alpha) + 1];
+        }
+
+    private:
+
+        size_t get_offset_index(const size_t table_index,
+                                const size_t alpha) const {
+            return table_index * (header->num_alphas + 1) + alpha;
+        }
+
+        // ---------------------------------------------------------------------
+
+        void release();
+
+        // ---------------------------------------------------------------------
+
+        bool set_pointers(const uint8_t *data, size_t num_bytes);
+
+        // ---------------------------------------------------------------------
+
+        std::vector<uint8_t> buffer;
+        void *mapped_data;
+        size_t mapped_size;
+
+        const CompactHashTableHeader *header;
+        const uint32_t *offsets;
+        const uint16_t *diagonals;
+
+    };
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Returns a file name that depends on the S-box, e.g.,
+     * "hash_tables_6b542e7a9dfc3108.bin".
+     */
+    std::string get_compact_hash_table_file_name(const size_t *sbox,
+                                                 size_t num_sbox_entries);
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _COMPACT_HASH_TABLE_H_
@@ -0,0 +1,77 @@
+/**
+ * Counts collisions among the 16 packed Small-AES states of a delta set.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _DELTA_SET_COLLISION_COUNTER_H_
+#define _DELTA_SET_COLLISION_COUNTER_H_
+
+// ---------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+#define DELTA_SET_COLLISION_COUNTER_NUM_TEXTS    16
+#define DELTA_SET_COLLISION_COUNTER_NUM_COLUMNS   4
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * The bits of cell i in a state [x0 || x1 || ... || x15] as uint64_t,
+     * i.e., the nibble at the bit offset (15 - i) * 4.
+     */
+    inline uint64_t get_cell_mask(const size_t cell_index) {
+        return 0xF000000000000000ULL >> (4 * cell_index);
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * The bits of column i, i.e., of the cells 4i, ..., 4i + 3.
+     */
+    inline uint64_t get_column_mask(const size_t column_index) {
+        return 0xFFFF000000000000ULL >> (16 * column_index);
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Masks of the four columns, e.g., to count pairs that collide in at
+     * least one column.
+     */
+    extern const uint64_t COLUMN_MASKS[DELTA_SET_COLLISION_COUNTER_NUM_COLUMNS];
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Counts the pairs among 16 states that are equal in all bits of at
+     * least one of the masks. A mask can contain any set of cells, e.g., a
+     * single cell, a column, or an inverse diagonal, which is the OR of the
+     * masks of its cells.
+     *
+     * With AVX2, holds the states in four registers and compares each state
+     * broadcast against all others at once; the colliding pairs are
+     * extracted with movemask. Needs no memory besides the states.
+     * @param texts 16 states as uint64_t.
+     * @param masks
+     * @param num_masks
+     * @return The number of pairs (i, j), i < j, that collide in at least
+     * one mask.
+     */
+    size_t count_delta_set_collisions(
+        const uint64_t texts[DELTA_SET_COLLISION_COUNTER_NUM_TEXTS],
+        const uint64_t *masks,
+        size_t num_masks);
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _DELTA_SET_COLLISION_COUNTER_H_
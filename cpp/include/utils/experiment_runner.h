@@ -0,0 +1,120 @@
+/**
+ * Runs the experiments of the distinguishers on multiple threads.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _EXPERIMENT_RUNNER_H_
+#define _EXPERIMENT_RUNNER_H_
+
+// ---------------------------------------------------------------------
+
+#include <functional>
+#include <vector>
+
+#include "utils/utils.h"
+#include "utils/xorshift1024.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    // ---------------------------------------------------------------------
+    // Types
+    // ---------------------------------------------------------------------
+
+    /**
+     * A contiguous range of sets [first_set_index, first_set_index + num_sets)
+     * of the key with index key_index. thread_index is in
+     * [0, num_threads) and can be used to address per-worker buffers.
+     * prng is an independent stream that belongs to this task only.
+     */
+    typedef struct {
+        size_t key_index;
+        size_t first_set_index;
+        size_t num_sets;
+        size_t thread_index;
+        xorshift_prng_ctx_t *prng;
+    } ExperimentTask;
+
+    /**
+     * num_collisions_per_set holds the collisions per key, and
+     * num_sets_per_key the number of sets that were run for each key, which
+     * is smaller than requested only for the last key of a stopped run.
+     */
+    typedef struct {
+        std::vector<size_t> num_collisions_per_set;
+        std::vector<size_t> num_sets_per_key;
+        size_t num_collisions;
+    } ExperimentResult;
+
+    typedef std::function<void(size_t, size_t)> parallel_function_t;
+    typedef std::function<size_t(const ExperimentTask &)>
+        experiment_task_function_t;
+    typedef std::function<bool(const ExperimentTask &, size_t)>
+        stop_function_t;
+
+    // ---------------------------------------------------------------------
+    // API
+    // ---------------------------------------------------------------------
+
+    size_t get_num_available_threads();
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Calls function(task_index, thread_index) for all task indices in
+     * [0, num_tasks) on num_threads threads. Tasks are handed out in
+     * ascending order to the next idle thread.
+     */
+    void run_in_parallel(size_t num_tasks,
+                         size_t num_threads,
+                         const parallel_function_t &function);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Splits the sets of every key into tasks of at most num_sets_per_task
+     * sets, runs them on num_threads threads, and sums the returned number
+     * of collisions per key into result.num_collisions_per_set[key_index]
+     * and over all keys into result.num_collisions.
+     * Every task obtains its own stream that is split off from prng in the
+     * order of the tasks. Since neither the task boundaries nor the streams
+     * depend on num_threads, the totals are the same as for a serial run
+     * with the same seed.
+     */
+    void run_experiments_in_parallel(ExperimentResult &result,
+                                     size_t num_keys,
+                                     size_t num_sets_per_key,
+                                     size_t num_sets_per_task,
+                                     size_t num_threads,
+                                     xorshift_prng_ctx_t *prng,
+                                     const experiment_task_function_t &function);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * As above, but calls should_stop(task, num_collisions) for the finished
+     * tasks in ascending order, so that a run can stop within the first key.
+     * If it returns true, no further tasks are started, and result holds
+     * only the sets up to the end of that task.
+     * Tasks run in batches of num_threads; the tasks of a batch after the
+     * stopping task are discarded, so that the result for a given seed is
+     * still independent of num_threads.
+     */
+    void run_experiments_in_parallel(ExperimentResult &result,
+                                     size_t num_keys,
+                                     size_t num_sets_per_key,
+                                     size_t num_sets_per_task,
+                                     size_t num_threads,
+                                     xorshift_prng_ctx_t *prng,
+                                     const experiment_task_function_t &function,
+                                     const stop_function_t &should_stop);
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _EXPERIMENT_RUNNER_H_
@@ -0,0 +1,47 @@
+/**
+ * Counts nibble collisions among Small-AES states for all cells at once.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _NIBBLE_COLLISION_COUNTER_H_
+#define _NIBBLE_COLLISION_COUNTER_H_
+
+// ---------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+#define NIBBLE_COLLISION_COUNTER_NUM_CELLS          16
+#define NIBBLE_COLLISION_COUNTER_NUM_CELL_VALUES    16
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Given states as uint64_t [x0 || x1 || ... || x15], where cell i is the
+     * nibble at the bit offset (15 - i) * 4, adds the number of pairs that
+     * collide in cell i to num_collisions[i] for every cell i.
+     *
+     * Builds one histogram per cell in a single pass over the states, so
+     * that every state is read once for all 16 cells, and sums
+     * binom(n, 2) over the counters n.
+     * @param texts
+     * @param num_texts
+     * @param num_collisions Array of NIBBLE_COLLISION_COUNTER_NUM_CELLS
+     * counters.
+     */
+    void count_nibble_collisions(const uint64_t *texts,
+                                 size_t num_texts,
+                                 size_t *num_collisions);
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _NIBBLE_COLLISION_COUNTER_H_
@@ -0,0 +1,108 @@
+/**
+ * Counts nibble collisions for all 16x16 input/output cells of the
+ * byte-combination distinguishers.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _NIBBLE_COLLISION_MATRIX_H_
+#define _NIBBLE_COLLISION_MATRIX_H_
+
+// ---------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <array>
+#include <functional>
+
+#include "utils/argparse.h"
+#include "utils/nibble_collision_counter.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    // ---------------------------------------------------------------------
+    // Types
+    // ---------------------------------------------------------------------
+
+    /**
+     * matrix[i][o] holds the collisions in output cell o from delta sets over
+     * input cell i.
+     */
+    typedef std::array<std::array<size_t, NIBBLE_COLLISION_COUNTER_NUM_CELLS>,
+                       NIBBLE_COLLISION_COUNTER_NUM_CELLS>
+        NibbleCollisionMatrix;
+
+    /**
+     * Draws a fresh key and sets up the cipher with it.
+     */
+    typedef std::function<void()> key_setup_function_t;
+
+    /**
+     * Encrypts a state [x0 || x1 || ... || x15], where cell i is the nibble
+     * at the bit offset (15 - i) * 4, into a ciphertext of the same layout.
+     */
+    typedef std::function<uint64_t(uint64_t)> packed_encryption_function_t;
+
+    // ---------------------------------------------------------------------
+    // API
+    // ---------------------------------------------------------------------
+
+    /**
+     * Encrypts num_sets random delta sets over every input cell, and adds
+     * the collisions in all 16 output cells to the matrix. Each ciphertext
+     * is counted for every output cell from per-nibble histograms, instead
+     * of one pair loop per output cell.
+     */
+    void add_nibble_collision_matrix(
+        size_t num_sets,
+        const packed_encryption_function_t &encrypt,
+        NibbleCollisionMatrix &matrix);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Prints the mean collisions per set of every input/output cell.
+     */
+    void print_nibble_collision_matrix(const NibbleCollisionMatrix &matrix,
+                                       size_t num_sets);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Calls setup_key() and add_nibble_collision_matrix() for each of
+     * num_keys keys, prints the collisions per key, and finally the matrix
+     * of the mean collisions per set over all keys.
+     */
+    void perform_nibble_collision_matrix_experiments(
+        size_t num_keys,
+        size_t num_sets_per_key,
+        const key_setup_function_t &setup_key,
+        const packed_encryption_function_t &encrypt);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Adds the optional arguments -i (--input_cell_index),
+     * -o (--output_cell_index), and -a (--all_cells).
+     */
+    void add_cell_arguments(ArgumentParser &parser);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Returns true if -a 1 was set. Otherwise, retrieves -i and -o into the
+     * cell indices, and throws std::invalid_argument if either is missing.
+     */
+    bool retrieve_cell_arguments(ArgumentParser &parser,
+                                 size_t *input_cell_index,
+                                 size_t *output_cell_index);
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _NIBBLE_COLLISION_MATRIX_H_
@@ -0,0 +1,156 @@
+/**
+ * Per-phase cycle counters for the distinguishers and the key recovery.
+ * The PROFILE_* hooks are compiled in only with ENABLE_PROFILING
+ * (cmake -DENABLE_PROFILING=ON); otherwise, they expand to nothing.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+// ---------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "utils/benchmark.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    // ---------------------------------------------------------------------
+    // Types
+    // ---------------------------------------------------------------------
+
+    typedef enum {
+        PROFILER_PHASE_KEY_SETUP = 0,
+        // Drawing random keys, texts, and splitting the generator streams
+        PROFILER_PHASE_RNG = 1,
+        PROFILER_PHASE_PLAINTEXT_GENERATION = 2,
+        PROFILER_PHASE_ENCRYPTION = 3,
+        PROFILER_PHASE_BUCKETING = 4,
+        PROFILER_PHASE_COLLISION_COUNTING = 5,
+        PROFILER_PHASE_PRECOMPUTATION = 6,
+        PROFILER_NUM_PHASES = 7
+    } ProfilerPhase;
+
+    // ---------------------------------------------------------------------
+
+    typedef enum {
+        PROFILER_COUNTER_TEXTS = 0,
+        // Delta sets or structures
+        PROFILER_COUNTER_SETS = 1,
+        PROFILER_NUM_COUNTERS = 2
+    } ProfilerCounter;
+
+    // ---------------------------------------------------------------------
+
+    const char *get_profiler_phase_name(ProfilerPhase phase);
+
+    // ---------------------------------------------------------------------
+    // API
+    // ---------------------------------------------------------------------
+
+    /**
+     * Adds to the counters of the calling thread. They are merged into the
+     * totals when the thread exits or when the profile is printed, so that
+     * threads never share a cache line while they count.
+     */
+    void profiler_add_cycles(ProfilerPhase phase, uint64_t num_cycles);
+
+    // ---------------------------------------------------------------------
+
+    void profiler_add(ProfilerCounter counter, uint64_t value);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Clears all counters and restarts the wall clock of the profile.
+     */
+    void profiler_start();
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Prints the cycles of every phase summed over all threads, their
+     * share, the number of timed scopes, and cycles per text, followed by
+     * the wall-clock time since profiler_start(), texts per second, and
+     * the cycles of all phases per text.
+     */
+    void profiler_print(FILE *file);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Adds the time-stamp cycles from its construction to its destruction
+     * to the given phase. Reading the counter costs about 20-40 cycles, so
+     * timed scopes should span at least a few hundred cycles.
+     */
+    class ScopedPhaseTimer {
+
+    public:
+
+        explicit ScopedPhaseTimer(const ProfilerPhase phase) :
+            phase(phase),
+            start_cycles(read_cycle_counter()) {
+
+        }
+
+        // ---------------------------------------------------------------------
+
+        ~ScopedPhaseTimer() {
+            profiler_add_cycles(phase, read_cycle_counter() - start_cycles);
+        }
+
+    private:
+
+        ScopedPhaseTimer(const ScopedPhaseTimer &);
+
+        // ---------------------------------------------------------------------
+
+        ScopedPhaseTimer &operator=(const ScopedPhaseTimer &);
+
+        // ---------------------------------------------------------------------
+
+        const ProfilerPhase phase;
+        const uint64_t start_cycles;
+
+    };
+
+}
+
+// ---------------------------------------------------------------------
+
+#if defined(ENABLE_PROFILING)
+
+#define PROFILER_CONCATENATE_(a, b)  a ## b
+#define PROFILER_CONCATENATE(a, b)   PROFILER_CONCATENATE_(a, b)
+
+/**
+ * Times the rest of the enclosing scope as the given phase.
+ */
+#define PROFILE_PHASE(phase) \
+    utils::ScopedPhaseTimer PROFILER_CONCATENATE(phase_timer_, __LINE__)( \
+        utils::phase)
+#define PROFILE_ADD(counter, value) \
+    utils::profiler_add(utils::counter, (uint64_t) (value))
+#define PROFILE_START()  utils::profiler_start()
+#define PROFILE_PRINT()  utils::profiler_print(stdout)
+
+#else
+
+#define PROFILE_PHASE(phase)         ((void) 0)
+#define PROFILE_ADD(counter, value)  ((void) 0)
+#define PROFILE_START()              ((void) 0)
+#define PROFILE_PRINT()              ((void) 0)
+
+#endif
+
+// ---------------------------------------------------------------------
+
+#endif  // _PROFILER_H_
@@ -0,0 +1,176 @@
+/**
+ * Streaming statistics and a sequential test for the distinguishers.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _RUNNING_STATISTICS_H_
+#define _RUNNING_STATISTICS_H_
+
+// ---------------------------------------------------------------------
+
+#include <stdlib.h>
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    // ---------------------------------------------------------------------
+    // Types
+    // ---------------------------------------------------------------------
+
+    typedef struct {
+        double lower;
+        double upper;
+    } ConfidenceInterval;
+
+    // ---------------------------------------------------------------------
+
+    typedef enum {
+        SPRT_CONTINUE = 0,
+        // The mean is the one of the PRP
+        SPRT_ACCEPT_NULL = 1,
+        // The mean differs from that of the PRP
+        SPRT_ACCEPT_ALTERNATIVE = 2
+    } SprtDecision;
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * The quantile z with P[X <= z] = p of the standard normal distribution
+     * for p in (0, 1), from the rational approximation by P. J. Acklam that
+     * is refined by one step of Halley's method.
+     */
+    double get_normal_quantile(double p);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Mean and variance of a stream of values without storing them, with
+     * Welford's update. Two accumulators, e.g., of two threads, can be
+     * merged into one that equals the accumulator of both streams.
+     */
+    class RunningStatistics {
+
+    public:
+
+        RunningStatistics();
+
+        // ---------------------------------------------------------------------
+
+        void add(double value);
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * Adds all values of other (Chan et al.'s parallel update).
+         */
+        void merge(const RunningStatistics &other);
+
+        // ---------------------------------------------------------------------
+
+        size_t get_num_values() const;
+
+        // ---------------------------------------------------------------------
+
+        double get_mean() const;
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * The sample variance with n - 1 in the denominator, or 0 for fewer
+         * than two values, as compute_variance().
+         */
+        double get_variance() const;
+
+        // ---------------------------------------------------------------------
+
+        double get_standard_deviation() const;
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * The standard deviation of the mean.
+         */
+        double get_standard_error() const;
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * The two-sided interval that contains the true mean with the given
+         * probability, from the normal approximation of the mean.
+         * @param confidence In (0, 1), e.g., 0.99.
+         */
+        ConfidenceInterval get_confidence_interval(double confidence) const;
+
+    private:
+
+        size_t num_values;
+        double mean;
+        // Sum of the squared differences from the mean
+        double sum_of_squares;
+
+    };
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Wald's sequential probability ratio test whether pairs collide with
+     * null_probability, as for a PRP, or with a probability that differs
+     * from it by at least min_difference in either direction, as for the
+     * cipher. It is fed the cumulative numbers of collisions and pairs.
+     * Since the pairs of a PRP collide almost independently, the number of
+     * collisions is binomially distributed; no variance has to be estimated,
+     * so that the test can decide after any number of sets, also within the
+     * first key.
+     *
+     * Runs two one-sided tests against null_probability + min_difference
+     * and null_probability - min_difference; the alternative is accepted as
+     * soon as one accepts it, the null hypothesis once both accept it. Both
+     * errors, deciding for the cipher if the pairs stem from the PRP and
+     * vice versa, are about 1 - confidence (Wald's bounds).
+     */
+    class SequentialProbabilityRatioTest {
+
+    public:
+
+        /**
+         * @throws std::invalid_argument if null_probability +- min_difference
+         * is not in (0, 1).
+         */
+        SequentialProbabilityRatioTest(double null_probability,
+                                       double min_difference,
+                                       double confidence);
+
+        // ---------------------------------------------------------------------
+
+        SprtDecision decide(size_t num_collisions, size_t num_pairs) const;
+
+        // ---------------------------------------------------------------------
+
+        /**
+         * The log-likelihood ratio of alternative_probability against
+         * null_probability for num_collisions among num_pairs pairs.
+         */
+        double get_log_likelihood_ratio(size_t num_collisions,
+                                        size_t num_pairs,
+                                        double alternative_probability) const;
+
+    private:
+
+        double null_probability;
+        double min_difference;
+        // Accepts the null hypothesis at or below this log-likelihood ratio
+        double lower_bound;
+        // Accepts the alternative at or above this log-likelihood ratio
+        double upper_bound;
+
+    };
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _RUNNING_STATISTICS_H_
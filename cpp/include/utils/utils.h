@@ -92,7 +92,13 @@ namespace utils {
 #define vunpacklo8(x, y)            _mm_unpacklo_epi8(x, y)
 #define vunpackhi8(x, y)            _mm_unpackhi_epi8(x, y)
 #define vblend8(x, y, mask)         _mm_blendv_epi8(x, y, mask)
-#define vis_zero(x)                 (_mm_testc_si128(zero, x) && _mm_testz_si128(zero, x))
+#define vcompare_equal8(x, y)       _mm_cmpeq_epi8(x, y)
+#define vsub8(x, y)                 _mm_sub_epi8(x, y)
+#define vadd64(x, y)                _mm_add_epi64(x, y)
+#define vrotate_bytes(x, shift)     _mm_alignr_epi8(x, x, shift)
+// Sums the bytes of each 64-bit half into the 64-bit lanes
+#define vsum_bytes64(x)             _mm_sad_epu8(x, zero)
+#define vis_zero(x)                 _mm_testz_si128(x, x)
 #define vare_equal(x, y)            vis_zero(vxor(x, y))
 
 #define vxor4values(a, b, c, d)     vxor(vxor(a, b), vxor(c, d))
@@ -122,8 +128,16 @@ namespace utils {
     #define avxand(x, y)                _mm256_and_si256(x, y)
     #define avxxor(x, y)                _mm256_xor_si256(x, y)
     #define avxor(x, y)                 _mm256_or_si256(x, y)
+    #define avxandnot(x, y)             _mm256_andnot_si256(x, y)
     #define avxshuffle(x, mask)         _mm256_shuffle_epi8(x, mask)
     #define avxis_zero(x)               (_mm256_testc_si256(avxzero, x) && _mm256_testz_si256(avxzero, x))
+    #define avxadd8(x, y)               _mm256_add_epi8(x, y)
+    #define avxshiftright16(x, shift)   _mm256_srli_epi16(x, shift)
+    #define avxshiftleft64(x, shift)    _mm256_slli_epi64(x, shift)
+    #define avxshiftright64(x, shift)   _mm256_srli_epi64(x, shift)
+    #define avxshiftleftv64(x, shifts)  _mm256_sllv_epi64(x, shifts)
+    #define avxshiftrightv64(x, shifts) _mm256_srlv_epi64(x, shifts)
+    #define avxbroadcast128(x)          _mm256_broadcastsi128_si256(x)
 
     #define vget128(x, i)               _mm256_extracti128_si256(x, i)
     #define vset128(x0, x1)             _mm256_set_m128i(x1, x0)
@@ -134,6 +148,7 @@ namespace utils {
     #define avxand(x, y)                avx_to_int(_mm256_and_ps(avx_to_float(x), avx_to_float(y)))
     #define avxxor(x, y)                avx_to_int(_mm256_xor_ps(avx_to_float(x), avx_to_float(y)))
     #define avxor(x, y)                 avx_to_int(_mm256_or_ps(avx_to_float(x), avx_to_float(y)))
+    #define avxandnot(x, y)             avx_to_int(_mm256_andnot_ps(avx_to_float(x), avx_to_float(y)))
 
     // Some old compilers lack the _mm256_set_m128i intrinsic
     // https://stackoverflow.com/questions/32630458/setting-m256i-to-the-value-of-two-m128i-values
@@ -142,6 +157,8 @@ namespace utils {
     #define vset128(v0, v1)             _mm256_insertf128_si256(_mm256_castsi128_si256(v0), (v1), 1)
 
     #define avxshuffle(x, mask)         vset128(vshuffle(vget128(x, 0), vget128(mask, 0)), vshuffle(vget128(x, 1), vget128(mask, 1)))
+    #define avxshiftleft64(x, shift)    vset128(vshiftleft64(vget128(x, 0), shift), vshiftleft64(vget128(x, 1), shift))
+    #define avxshiftright64(x, shift)   vset128(vshiftright64(vget128(x, 0), shift), vshiftright64(vget128(x, 1), shift))
 #endif
 
 
@@ -225,6 +242,66 @@ namespace utils {
      */
     uint64_t convert_to_uint64(__m128i source);
 
+    // ---------------------------------------------------------
+
+    /**
+     * Inverse of convert_to_uint64(): spreads the 16 nibbles
+     * [x0 || x1 || ... || x15] of source to the low nibbles of the bytes
+     * [x15, x14, ..., x0].
+     */
+    __m128i convert_from_uint64(uint64_t source);
+
+    // ---------------------------------------------------------
+
+    /**
+     * Gathers the bits of x at the set positions of mask into the least
+     * significant bits, e.g., the four nibbles of a diagonal of a packed
+     * Small-AES state. Uses BMI2 pext if available.
+     */
+    inline uint64_t extract_bits(const uint64_t x, const uint64_t mask) {
+#ifdef __BMI2__
+        return _pext_u64(x, mask);
+#else
+        uint64_t result = 0;
+        uint64_t bit = 1;
+
+        for (uint64_t m = mask; m != 0; m &= m - 1) {
+            if (x & m & (~m + 1)) {
+                result |= bit;
+            }
+
+            bit <<= 1;
+        }
+
+        return result;
+#endif
+    }
+
+    // ---------------------------------------------------------
+
+    /**
+     * Inverse of extract_bits(): scatters the least significant bits of x to
+     * the set positions of mask. Uses BMI2 pdep if available.
+     */
+    inline uint64_t deposit_bits(const uint64_t x, const uint64_t mask) {
+#ifdef __BMI2__
+        return _pdep_u64(x, mask);
+#else
+        uint64_t result = 0;
+        uint64_t bit = 1;
+
+        for (uint64_t m = mask; m != 0; m &= m - 1) {
+            if (x & bit) {
+                result |= m & (~m + 1);
+            }
+
+            bit <<= 1;
+        }
+
+        return result;
+#endif
+    }
+
     // ---------------------------------------------------------------------
 
     void xor_arrays(uint8_t *target,
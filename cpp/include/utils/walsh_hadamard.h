@@ -0,0 +1,47 @@
+/**
+ * Fast Walsh-Hadamard transforms over GF(2)^n.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#ifndef _WALSH_HADAMARD_H_
+#define _WALSH_HADAMARD_H_
+
+// ---------------------------------------------------------------------
+
+#include <stdint.h>
+#include <cstddef>
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    /**
+     * Replaces the function f: GF(2)^n -> Z given by its num_values = 2^n
+     * values by its unnormalized Walsh-Hadamard transform
+     * F(u) = sum_x (-1)^{<u, x>} f(x), in place, with n * 2^n additions.
+     *
+     * The transform turns XOR convolutions into pointwise products: for
+     * (f * g)(d) = sum_{x ^ y = d} f(x) g(y), it holds that
+     * W(f * g) = W(f) W(g).
+     * @param values Array of num_values values.
+     * @param num_values Must be a power of two.
+     */
+    void walsh_hadamard_transform(int64_t *values, size_t num_values);
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Inverts walsh_hadamard_transform() in place. Since W(W(f)) = 2^n f,
+     * this is the same transform followed by a division by num_values.
+     */
+    void inverse_walsh_hadamard_transform(int64_t *values,
+                                          size_t num_values);
+
+}
+
+// ---------------------------------------------------------------------
+
+#endif  // _WALSH_HADAMARD_H_
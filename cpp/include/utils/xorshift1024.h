@@ -45,7 +45,19 @@ typedef struct {
 
 // ---------------------------------------------------------
 
-void get_random_bytes_from_dev_urandom(uint8_t* data, size_t num_bytes) {
+// The jump polynomial that is equivalent to 2^512 calls to next().
+static const uint64_t XORSHIFT1024_JUMP[16] = {
+    0x84242f96eca9c41dULL, 0xa3c65b8776f96855ULL, 0x5b34a39f070b5837ULL,
+    0x4489affce4f31a1eULL, 0x2ffeeb0a48316f40ULL, 0xdc2d9891fe68c022ULL,
+    0x3659132bb12fea70ULL, 0xaac17d8efa43cab8ULL, 0xc4cb815590989b13ULL,
+    0x5ee975283d71c93bULL, 0x691548c86c1bd540ULL, 0x7910c41d10a1e6a5ULL,
+    0x0b5fc64563b3e2a8ULL, 0x047f7684e9fc949dULL, 0xb99181f2d8f685caULL,
+    0x284600e3f30e38c3ULL
+};
+
+// ---------------------------------------------------------
+
+inline void get_random_bytes_from_dev_urandom(uint8_t* data, size_t num_bytes) {
     int gathered_bytes = open("/dev/urandom", O_RDONLY);
     size_t len = 0;
 
@@ -70,7 +82,15 @@ void get_random_bytes_from_dev_urandom(uint8_t* data, size_t num_bytes) {
 
 // ---------------------------------------------------------
 
-void xorshift1024_init(xorshift_prng_ctx_t* ctx) {
+inline uint64_t get_random_seed_from_dev_urandom() {
+    uint64_t seed;
+    get_random_bytes_from_dev_urandom((uint8_t*)(&seed), sizeof(uint64_t));
+    return seed;
+}
+
+// ---------------------------------------------------------
+
+inline void xorshift1024_init(xorshift_prng_ctx_t* ctx) {
     const size_t num_bytes = 16 * sizeof(uint64_t);
     get_random_bytes_from_dev_urandom((uint8_t*)(ctx->s), num_bytes);
     ctx->p = 0;
@@ -78,7 +98,26 @@ void xorshift1024_init(xorshift_prng_ctx_t* ctx) {
 
 // ---------------------------------------------------------
 
-uint64_t xorshift1024_next(xorshift_prng_ctx_t* ctx) {
+/**
+ * Seeds the state deterministically from a 64-bit seed by filling it with
+ * the outputs of a splitmix64 generator, as suggested above.
+ */
+inline void xorshift1024_init_with_seed(xorshift_prng_ctx_t* ctx,
+                                        uint64_t seed) {
+    for (size_t i = 0; i < 16; ++i) {
+        seed += UINT64_C(0x9e3779b97f4a7c15);
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+        z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+        ctx->s[i] = z ^ (z >> 31);
+    }
+
+    ctx->p = 0;
+}
+
+// ---------------------------------------------------------
+
+inline uint64_t xorshift1024_next(xorshift_prng_ctx_t* ctx) {
     const uint64_t s0 = ctx->s[ctx->p];
     uint64_t s1 = ctx->s[ctx->p = (ctx->p + 1) & 15];
     s1 ^= s1 << 31; // a
@@ -88,9 +127,47 @@ uint64_t xorshift1024_next(xorshift_prng_ctx_t* ctx) {
 
 // ---------------------------------------------------------
 
-void get_random_bytes(xorshift_prng_ctx_t *ctx,
-                      uint8_t* data,
-                      const size_t num_bytes) {
+/**
+ * Advances the state by 2^512 calls to next(). It can be used to generate
+ * 2^512 non-overlapping subsequences for parallel computations.
+ */
+inline void xorshift1024_jump(xorshift_prng_ctx_t* ctx) {
+    uint64_t t[16] = { 0 };
+
+    for (size_t i = 0; i < 16; ++i) {
+        for (size_t b = 0; b < 64; ++b) {
+            if (XORSHIFT1024_JUMP[i] & (UINT64_C(1) << b)) {
+                for (size_t j = 0; j < 16; ++j) {
+                    t[j] ^= ctx->s[(j + ctx->p) & 15];
+                }
+            }
+
+            xorshift1024_next(ctx);
+        }
+    }
+
+    for (size_t j = 0; j < 16; ++j) {
+        ctx->s[(j + ctx->p) & 15] = t[j];
+    }
+}
+
+// ---------------------------------------------------------
+
+/**
+ * Hands the current subsequence of ctx over to stream and jumps ctx ahead
+ * to the next one, so that stream and ctx never overlap.
+ */
+inline void xorshift1024_split(xorshift_prng_ctx_t* ctx,
+                               xorshift_prng_ctx_t* stream) {
+    memcpy(stream, ctx, sizeof(xorshift_prng_ctx_t));
+    xorshift1024_jump(ctx);
+}
+
+// ---------------------------------------------------------
+
+inline void get_random_bytes(xorshift_prng_ctx_t *ctx,
+                             uint8_t* data,
+                             const size_t num_bytes) {
     const size_t wordsize = sizeof(uint64_t);
     const size_t num_words = num_bytes / wordsize;
 
@@ -109,11 +186,27 @@ void get_random_bytes(xorshift_prng_ctx_t *ctx,
 
 // ---------------------------------------------------------
 
-void get_random_bytes(uint8_t* data,
-                      const size_t num_bytes) {
-    xorshift_prng_ctx_t ctx;
-    xorshift1024_init(&ctx);
-    get_random_bytes(&ctx, data, num_bytes);
+/**
+ * Returns a long-lived generator per thread that is seeded from
+ * /dev/urandom once on its first use.
+ */
+inline xorshift_prng_ctx_t* get_thread_prng() {
+    static thread_local xorshift_prng_ctx_t ctx;
+    static thread_local bool is_initialized = false;
+
+    if (!is_initialized) {
+        xorshift1024_init(&ctx);
+        is_initialized = true;
+    }
+
+    return &ctx;
+}
+
+// ---------------------------------------------------------
+
+inline void get_random_bytes(uint8_t* data,
+                             const size_t num_bytes) {
+    get_random_bytes(get_thread_prng(), data, num_bytes);
 }
 
 } // namespace utils
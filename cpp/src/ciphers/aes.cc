@@ -6,10 +6,14 @@
 
 // ---------------------------------------------------------------------
 
+#include <algorithm>
+
 #include <emmintrin.h>
+#include <immintrin.h>
 #include <wmmintrin.h>
 #include <smmintrin.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "ciphers/aes.h"
 #include "utils/utils.h"
@@ -159,6 +163,352 @@ namespace ciphers {
         storeu(ciphertext, state);
     }
 
+    // ---------------------------------------------------------------------
+    // Batches
+    // ---------------------------------------------------------------------
+
+#if defined(__VAES__) && defined(__AVX512F__) && defined(__AVX512BW__)
+
+    typedef __m512i blocks_t;
+
+#define NUM_BLOCKS_PER_VECTOR           4
+#define blocksloadu(p)                  _mm512_loadu_si512((const void *) (p))
+#define blocksstoreu(p, x)              _mm512_storeu_si512((void *) (p), x)
+#define blocksxor(x, y)                 _mm512_xor_si512(x, y)
+#define blocksadd8(x, y)                _mm512_add_epi8(x, y)
+#define blocksshuffle(x, mask)          _mm512_shuffle_epi8(x, mask)
+#define blocksaesenc(x, k)              _mm512_aesenc_epi128(x, k)
+#define blocksaesenclast(x, k)          _mm512_aesenclast_epi128(x, k)
+#define blockszero                      _mm512_setzero_si512()
+// The unmasked broadcast trips -Wmaybe-uninitialized in some GCC headers
+#define blocksbroadcast128(x)           _mm512_maskz_broadcast_i32x4(-1, x)
+
+#elif defined(__VAES__) && defined(__AVX2__)
+
+    typedef __m256i blocks_t;
+
+#define NUM_BLOCKS_PER_VECTOR           2
+#define blocksloadu(p)                  _mm256_loadu_si256((const __m256i *) (p))
+#define blocksstoreu(p, x)              _mm256_storeu_si256((__m256i *) (p), x)
+#define blocksxor(x, y)                 avxxor(x, y)
+#define blocksadd8(x, y)                avxadd8(x, y)
+#define blocksshuffle(x, mask)          avxshuffle(x, mask)
+#define blocksaesenc(x, k)              _mm256_aesenc_epi128(x, k)
+#define blocksaesenclast(x, k)          _mm256_aesenclast_epi128(x, k)
+#define blockszero                      _mm256_setzero_si256()
+#define blocksbroadcast128(x)           avxbroadcast128(x)
+
+#else
+
+    typedef __m128i blocks_t;
+
+#define NUM_BLOCKS_PER_VECTOR           1
+#define blocksloadu(p)                  loadu(p)
+#define blocksstoreu(p, x)              storeu(p, x)
+#define blocksxor(x, y)                 vxor(x, y)
+#define blocksadd8(x, y)                _mm_add_epi8(x, y)
+#define blocksshuffle(x, mask)          vshuffle(x, mask)
+#define blocksaesenc(x, k)              aesenc(x, k)
+#define blocksaesenclast(x, k)          aesenclast(x, k)
+#define blockszero                      zero
+#define blocksbroadcast128(x)           (x)
+
+#endif
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Increments histogram[x[0]] for the first byte of every text in x.
+     */
+    static inline void add_first_bytes_to_histogram(const blocks_t x,
+                                                    size_t *histogram) {
+#if defined(__VAES__) && defined(__AVX512F__) && defined(__AVX512BW__)
+        // Truncates every 64-bit word to its lowest byte; the even ones are
+        // the first bytes of the four texts. Masked for the same GCC
+        // warning as blocksbroadcast128
+        const uint64_t bytes = (uint64_t) _mm_cvtsi128_si64(
+            _mm512_maskz_cvtepi64_epi8(0xFF, x)
+        );
+        histogram[bytes & 0xFF]++;
+        histogram[(bytes >> 16) & 0xFF]++;
+        histogram[(bytes >> 32) & 0xFF]++;
+        histogram[(bytes >> 48) & 0xFF]++;
+#elif defined(__VAES__) && defined(__AVX2__)
+        histogram[_mm256_extract_epi8(x, 0) & 0xFF]++;
+        histogram[_mm256_extract_epi8(x, 16) & 0xFF]++;
+#else
+        histogram[_mm_extract_epi8(x, 0) & 0xFF]++;
+#endif
+    }
+
+    // ---------------------------------------------------------------------
+
+    typedef enum {
+        AES_FINAL_ROUND_WITHOUT_MC,
+        AES_FINAL_ROUND_WITH_MC,
+        AES_FINAL_ROUND_ONLY_SBOX
+    } aes_final_round_t;
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Encrypts NumTexts texts as aes128_encrypt_rounds(),
+     * aes128_encrypt_rounds_always_mc(), or
+     * aes128_encrypt_rounds_only_sbox_in_final(), depending on final_round.
+     * Expects 1 <= num_rounds <= AES_128_NUM_ROUNDS for
+     * AES_FINAL_ROUND_WITH_MC and num_rounds <= AES_128_NUM_ROUNDS
+     * otherwise.
+     */
+    template <size_t NumTexts>
+    static inline void encrypt_blocks(const aes128_ctx_t *ctx,
+                                      const aes_state_t *plaintexts,
+                                      aes_state_t *ciphertexts,
+                                      const size_t num_rounds,
+                                      const aes_final_round_t final_round) {
+        static const size_t NUM_VECTORS = NumTexts / NUM_BLOCKS_PER_VECTOR;
+        const __m128i *keys = ctx->encryption_keys;
+        blocks_t states[NUM_VECTORS];
+        blocks_t round_key = blocksbroadcast128(keys[0]);
+
+        for (size_t j = 0; j < NUM_VECTORS; ++j) {
+            const aes_state_t *plaintext =
+                &plaintexts[j * NUM_BLOCKS_PER_VECTOR];
+            states[j] = blocksxor(blocksloadu(plaintext), round_key);
+        }
+
+        for (size_t i = 1; i < num_rounds; ++i) {
+            round_key = blocksbroadcast128(keys[i]);
+
+            for (size_t j = 0; j < NUM_VECTORS; ++j) {
+                states[j] = blocksaesenc(states[j], round_key);
+            }
+        }
+
+        round_key = blocksbroadcast128(keys[num_rounds]);
+
+        if (final_round == AES_FINAL_ROUND_WITH_MC) {
+            for (size_t j = 0; j < NUM_VECTORS; ++j) {
+                states[j] = blocksaesenc(states[j], round_key);
+            }
+        } else if (final_round == AES_FINAL_ROUND_WITHOUT_MC) {
+            for (size_t j = 0; j < NUM_VECTORS; ++j) {
+                states[j] = blocksaesenclast(states[j], round_key);
+            }
+        } else {
+            // As aes_sub_bytes(): aesenclast includes the ShiftRows
+            const blocks_t mask = blocksbroadcast128(
+                AES_INVERSE_SHIFT_ROWS_MASK
+            );
+
+            for (size_t j = 0; j < NUM_VECTORS; ++j) {
+                states[j] = blocksaesenclast(blocksshuffle(states[j], mask),
+                                             blockszero);
+            }
+        }
+
+        for (size_t j = 0; j < NUM_VECTORS; ++j) {
+            aes_state_t *ciphertext = &ciphertexts[j * NUM_BLOCKS_PER_VECTOR];
+            blocksstoreu(ciphertext, states[j]);
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    void aes128_encrypt_rounds_8(const aes128_ctx_t *ctx,
+                                 const aes_state_t plaintexts[8],
+                                 aes_state_t ciphertexts[8],
+                                 const size_t num_rounds) {
+        if (num_rounds > AES_128_NUM_ROUNDS) {
+            return;
+        }
+
+        encrypt_blocks<8>(ctx, plaintexts, ciphertexts, num_rounds,
+                          AES_FINAL_ROUND_WITHOUT_MC);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void aes128_encrypt_rounds_16(const aes128_ctx_t *ctx,
+                                  const aes_state_t plaintexts[16],
+                                  aes_state_t ciphertexts[16],
+                                  const size_t num_rounds) {
+        if (num_rounds > AES_128_NUM_ROUNDS) {
+            return;
+        }
+
+        encrypt_blocks<16>(ctx, plaintexts, ciphertexts, num_rounds,
+                           AES_FINAL_ROUND_WITHOUT_MC);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void aes128_encrypt_rounds_always_mc_8(const aes128_ctx_t *ctx,
+                                           const aes_state_t plaintexts[8],
+                                           aes_state_t ciphertexts[8],
+                                           const size_t num_rounds) {
+        if (num_rounds > AES_128_NUM_ROUNDS) {
+            return;
+        }
+
+        if (num_rounds == 0) {
+            memcpy(ciphertexts, plaintexts, 8 * AES_NUM_STATE_BYTES);
+            return;
+        }
+
+        encrypt_blocks<8>(ctx, plaintexts, ciphertexts, num_rounds,
+                          AES_FINAL_ROUND_WITH_MC);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void aes128_encrypt_rounds_always_mc_16(const aes128_ctx_t *ctx,
+                                            const aes_state_t plaintexts[16],
+                                            aes_state_t ciphertexts[16],
+                                            const size_t num_rounds) {
+        if (num_rounds > AES_128_NUM_ROUNDS) {
+            return;
+        }
+
+        if (num_rounds == 0) {
+            memcpy(ciphertexts, plaintexts, 16 * AES_NUM_STATE_BYTES);
+            return;
+        }
+
+        encrypt_blocks<16>(ctx, plaintexts, ciphertexts, num_rounds,
+                           AES_FINAL_ROUND_WITH_MC);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void aes128_encrypt_rounds_only_sbox_in_final_8(
+        const aes128_ctx_t *ctx,
+        const aes_state_t plaintexts[8],
+        aes_state_t ciphertexts[8],
+        const size_t num_rounds) {
+        if (num_rounds > AES_128_NUM_ROUNDS) {
+            return;
+        }
+
+        encrypt_blocks<8>(ctx, plaintexts, ciphertexts, num_rounds,
+                          AES_FINAL_ROUND_ONLY_SBOX);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void aes128_encrypt_rounds_only_sbox_in_final_16(
+        const aes128_ctx_t *ctx,
+        const aes_state_t plaintexts[16],
+        aes_state_t ciphertexts[16],
+        const size_t num_rounds) {
+        if (num_rounds > AES_128_NUM_ROUNDS) {
+            return;
+        }
+
+        encrypt_blocks<16>(ctx, plaintexts, ciphertexts, num_rounds,
+                           AES_FINAL_ROUND_ONLY_SBOX);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void aes128_encrypt_diagonal_structure_histogram(
+        const aes128_ctx_t *ctx,
+        const aes_state_t base_plaintext,
+        const size_t first_text_index,
+        const size_t num_texts,
+        const size_t num_rounds,
+        size_t histogram[256]) {
+        static const size_t NUM_TEXTS_PER_STEP = 8;
+        static const size_t NUM_VECTORS =
+            NUM_TEXTS_PER_STEP / NUM_BLOCKS_PER_VECTOR;
+        static const size_t NUM_TEXTS_PER_RUN = 256;
+
+        if ((num_rounds > AES_128_NUM_ROUNDS)
+            || ((first_text_index % NUM_TEXTS_PER_STEP) != 0)
+            || ((num_texts % NUM_TEXTS_PER_STEP) != 0)
+            || (first_text_index + num_texts
+                > AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE)) {
+            return;
+        }
+
+        // Text j of the eight has the offset j in byte 15
+        ALIGN(64) uint8_t offsets[NUM_TEXTS_PER_STEP][AES_NUM_STATE_BYTES];
+        memset(offsets, 0, sizeof(offsets));
+
+        for (size_t j = 0; j < NUM_TEXTS_PER_STEP; ++j) {
+            offsets[j][15] = (uint8_t) j;
+        }
+
+        blocks_t lane_offsets[NUM_VECTORS];
+
+        for (size_t v = 0; v < NUM_VECTORS; ++v) {
+            lane_offsets[v] = blocksloadu(
+                &offsets[v * NUM_BLOCKS_PER_VECTOR]
+            );
+        }
+
+        const blocks_t increment = blocksbroadcast128(
+            vsetr8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                   (uint8_t) NUM_TEXTS_PER_STEP)
+        );
+        const __m128i base = vand(
+            loadu(base_plaintext),
+            vsetr8(0, -1, -1, -1, -1, 0, -1, -1, -1, -1, 0, -1, -1, -1, -1, 0)
+        );
+
+        // Zero rounds leave the texts untouched
+        const __m128i *keys = ctx->encryption_keys;
+        const blocks_t first_key = (num_rounds == 0)
+            ? blocksbroadcast128(zero) : blocksbroadcast128(keys[0]);
+        blocks_t round_keys[AES_128_NUM_ROUND_KEYS];
+
+        for (size_t i = 1; i <= num_rounds; ++i) {
+            round_keys[i] = blocksbroadcast128(keys[i]);
+        }
+
+        const size_t end = first_text_index + num_texts;
+        size_t index = first_text_index;
+
+        while (index < end) {
+            // Bytes 0, 5, and 10 stay fixed in a run of up to 256 texts;
+            // byte 15 steps by eight in register
+            __m128i text = base;
+            text = _mm_insert_epi8(text, (int) ((index >> 24) & 0xFF), 0);
+            text = _mm_insert_epi8(text, (int) ((index >> 16) & 0xFF), 5);
+            text = _mm_insert_epi8(text, (int) ((index >> 8) & 0xFF), 10);
+            text = _mm_insert_epi8(text, (int) (index & 0xFF), 15);
+
+            blocks_t texts[NUM_VECTORS];
+
+            for (size_t v = 0; v < NUM_VECTORS; ++v) {
+                texts[v] = blocksadd8(blocksbroadcast128(text),
+                                      lane_offsets[v]);
+            }
+
+            const size_t run_end = std::min(
+                end, (index & ~(NUM_TEXTS_PER_RUN - 1)) + NUM_TEXTS_PER_RUN
+            );
+
+            for (; index < run_end; index += NUM_TEXTS_PER_STEP) {
+                blocks_t states[NUM_VECTORS];
+
+                for (size_t v = 0; v < NUM_VECTORS; ++v) {
+                    states[v] = blocksxor(texts[v], first_key);
+                    texts[v] = blocksadd8(texts[v], increment);
+                }
+
+                for (size_t i = 1; i <= num_rounds; ++i) {
+                    for (size_t v = 0; v < NUM_VECTORS; ++v) {
+                        states[v] = blocksaesenc(states[v], round_keys[i]);
+                    }
+                }
+
+                for (size_t v = 0; v < NUM_VECTORS; ++v) {
+                    add_first_bytes_to_histogram(states[v], histogram);
+                }
+            }
+        }
+    }
+
     // ---------------------------------------------------------------------
 
     inline
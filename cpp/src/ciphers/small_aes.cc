@@ -69,21 +69,7 @@ namespace ciphers {
      * @return
      */
     __m128i to_lower_nibbles(const small_aes_state_t input) {
-        // K01, K23, K34, ...
-        const __m128i x = vset8(
-            0, 0, 0, 0,
-            0, 0, 0, 0,
-            input[7], input[6], input[5], input[4],
-            input[3], input[2], input[1], input[0]
-        );
-        const __m128i mask = LO_NIBBLES_MASK;
-
-        // K1, K3, K5, ...
-        __m128i x_hi = vand(x, mask);
-        const __m128i x_lo = vand(vshiftright16(x, 4), mask);
-        // K0, K2, K4, ...
-        x_hi = vand(x_hi, mask);
-        return vunpacklo8(x_lo, x_hi);
+        return utils::convert_from_uint64(small_aes_to_packed(input));
     }
 
     // ---------------------------------------------------------------------
@@ -136,34 +122,24 @@ namespace ciphers {
     // ---------------------------------------------------------------------
 
     void to_byte_array(small_aes_state_t output, const __m128i input) {
-        // x0, x2, ..., x14; 0, ... 0
-        __m128i evens = vshuffle(
-            input,
-            vsetr8(0, 2, 4, 6,
-                   8, 10, 12, 14,
-                   (uint8_t) 0xFF, (uint8_t) 0xFF, (uint8_t) 0xFF,
-                   (uint8_t) 0xFF,
-                   (uint8_t) 0xFF, (uint8_t) 0xFF, (uint8_t) 0xFF,
-                   (uint8_t) 0xFF
-            )
-        );
-        // x1, x3, ..., x15; 0, ... 0
-        __m128i odds = vshuffle(
-            input,
-            vsetr8(1, 3, 5, 7,
-                   9, 11, 13, 15,
-                   (uint8_t) 0xFF, (uint8_t) 0xFF, (uint8_t) 0xFF,
-                   (uint8_t) 0xFF,
-                   (uint8_t) 0xFF, (uint8_t) 0xFF, (uint8_t) 0xFF,
-                   (uint8_t) 0xFF
-            )
-        );
-        // Shift evens to higher nibbles
-        evens = vshiftleft16(evens, 4);
+        small_aes_from_packed(output, utils::convert_to_uint64(input));
+    }
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_to_packed(const small_aes_state_t input) {
+        uint64_t value;
+        memcpy(&value, input, SMALL_AES_NUM_STATE_BYTES);
+        return __builtin_bswap64(value);
+    }
+
+    // ---------------------------------------------------------------------
 
-        uint8_t temp[16];
-        storeu(temp, vxor(evens, odds));
-        memcpy(output, temp, SMALL_AES_NUM_STATE_BYTES);
+    void small_aes_from_packed(small_aes_state_t output,
+                               const small_aes_packed_state_t input) {
+        const uint64_t value = __builtin_bswap64(input);
+        memcpy(output, &value, SMALL_AES_NUM_STATE_BYTES);
     }
 
     // ---------------------------------------------------------------------
@@ -256,13 +232,11 @@ namespace ciphers {
     }
 
     // ---------------------------------------------------------------------
-    // Public API
+    // Encryption and decryption of states in the low nibbles of the bytes
     // ---------------------------------------------------------------------
 
-    void small_aes_decrypt(const small_aes_ctx_t *ctx,
-                           const small_aes_state_t ciphertext,
-                           small_aes_state_t plaintext) {
-        __m128i state = to_lower_nibbles(ciphertext);
+    static inline __m128i decrypt_nibbles(const small_aes_ctx_t *ctx,
+                                          __m128i state) {
         const __m128i *keys = ctx->key;
 
         state = small_aes_decrypt_last_round(state, keys[SMALL_AES_NUM_ROUNDS]);
@@ -272,48 +246,122 @@ namespace ciphers {
                                             keys[SMALL_AES_NUM_ROUNDS - i]);
         }
 
-        state = vxor(state, keys[0]);
-        to_byte_array(plaintext, state);
+        return vxor(state, keys[0]);
     }
 
     // ---------------------------------------------------------------------
 
-    void small_aes_encrypt(const small_aes_ctx_t *ctx,
-                           const small_aes_state_t plaintext,
-                           small_aes_state_t ciphertext) {
-        __m128i state = to_lower_nibbles(plaintext);
+    static inline __m128i encrypt_rounds_nibbles(const small_aes_ctx_t *ctx,
+                                                 __m128i state,
+                                                 const size_t num_rounds) {
         const __m128i *keys = ctx->key;
+
         state = vxor(state, keys[0]);
 
-        for (size_t i = 1; i < SMALL_AES_NUM_ROUNDS; ++i) {
+        for (size_t i = 1; i < num_rounds; ++i) {
             state = small_aes_encrypt_round(state, keys[i]);
         }
 
-        state = small_aes_encrypt_last_round(state, keys[SMALL_AES_NUM_ROUNDS]);
-        to_byte_array(ciphertext, state);
+        return small_aes_encrypt_last_round(state, keys[num_rounds]);
     }
 
     // ---------------------------------------------------------------------
 
-    void small_aes_encrypt_rounds(const small_aes_ctx_t *ctx,
-                                  const small_aes_state_t plaintext,
-                                  small_aes_state_t ciphertext,
-                                  const size_t num_rounds) {
-        if (num_rounds > SMALL_AES_NUM_ROUNDS) {
-            return;
+    /**
+     * Expects num_rounds in [1, SMALL_AES_NUM_ROUNDS].
+     */
+    static inline __m128i
+    decrypt_rounds_always_mc_nibbles(const small_aes_ctx_t *ctx,
+                                     __m128i state,
+                                     const size_t num_rounds) {
+        const __m128i *keys = ctx->key;
+
+        for (size_t i = num_rounds; i > 0; --i) {
+            state = small_aes_decrypt_round(state, keys[i]);
         }
 
-        __m128i state = to_lower_nibbles(plaintext);
+        return vxor(state, keys[0]);
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Expects num_rounds in [1, SMALL_AES_NUM_ROUNDS].
+     */
+    static inline __m128i
+    encrypt_rounds_always_mc_nibbles(const small_aes_ctx_t *ctx,
+                                     __m128i state,
+                                     const size_t num_rounds) {
         const __m128i *keys = ctx->key;
 
         state = vxor(state, keys[0]);
 
-        for (size_t i = 1; i < num_rounds; ++i) {
+        for (size_t i = 1; i <= num_rounds; ++i) {
             state = small_aes_encrypt_round(state, keys[i]);
         }
 
-        state = small_aes_encrypt_last_round(state, keys[num_rounds]);
-        to_byte_array(ciphertext, state);
+        return state;
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline bool is_valid_round_range(const size_t min_num_rounds,
+                                            const size_t max_num_rounds) {
+        return (min_num_rounds >= 1)
+               && (min_num_rounds <= max_num_rounds)
+               && (max_num_rounds <= SMALL_AES_NUM_ROUNDS);
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline __m128i
+    encrypt_rounds_only_sbox_in_final_nibbles(const small_aes_ctx_t *ctx,
+                                              __m128i state,
+                                              const size_t num_rounds) {
+        state = vxor(state, ctx->key[0]);
+
+        for (size_t i = 1; i < num_rounds; ++i) {
+            state = small_aes_encrypt_round(state, ctx->key[i]);
+        }
+
+        state = small_aes_sub_bytes(state);
+        return vxor(state, ctx->key[num_rounds]);
+    }
+
+    // ---------------------------------------------------------------------
+    // Public API
+    // ---------------------------------------------------------------------
+
+    void small_aes_decrypt(const small_aes_ctx_t *ctx,
+                           const small_aes_state_t ciphertext,
+                           small_aes_state_t plaintext) {
+        to_byte_array(plaintext,
+                      decrypt_nibbles(ctx, to_lower_nibbles(ciphertext)));
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_encrypt(const small_aes_ctx_t *ctx,
+                           const small_aes_state_t plaintext,
+                           small_aes_state_t ciphertext) {
+        to_byte_array(ciphertext,
+                      encrypt_rounds_nibbles(ctx, to_lower_nibbles(plaintext),
+                                             SMALL_AES_NUM_ROUNDS));
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_encrypt_rounds(const small_aes_ctx_t *ctx,
+                                  const small_aes_state_t plaintext,
+                                  small_aes_state_t ciphertext,
+                                  const size_t num_rounds) {
+        if (num_rounds > SMALL_AES_NUM_ROUNDS) {
+            return;
+        }
+
+        to_byte_array(ciphertext,
+                      encrypt_rounds_nibbles(ctx, to_lower_nibbles(plaintext),
+                                             num_rounds));
     }
 
     // ---------------------------------------------------------------------
@@ -331,15 +379,9 @@ namespace ciphers {
             return;
         }
 
-        __m128i state = to_lower_nibbles(ciphertext);
-        const __m128i *keys = ctx->key;
-
-        for (size_t i = num_rounds; i > 0; --i) {
-            state = small_aes_decrypt_round(state, keys[i]);
-        }
-
-        state = vxor(state, keys[0]);
-        to_byte_array(plaintext, state);
+        to_byte_array(plaintext, decrypt_rounds_always_mc_nibbles(
+            ctx, to_lower_nibbles(ciphertext), num_rounds
+        ));
     }
 
     // ---------------------------------------------------------------------
@@ -357,16 +399,9 @@ namespace ciphers {
             return;
         }
 
-        __m128i state = to_lower_nibbles(plaintext);
-        const __m128i *keys = ctx->key;
-
-        state = vxor(state, keys[0]);
-
-        for (size_t i = 1; i <= num_rounds; ++i) {
-            state = small_aes_encrypt_round(state, keys[i]);
-        }
-
-        to_byte_array(ciphertext, state);
+        to_byte_array(ciphertext, encrypt_rounds_always_mc_nibbles(
+            ctx, to_lower_nibbles(plaintext), num_rounds
+        ));
     }
 
     // ---------------------------------------------------------------------
@@ -381,17 +416,122 @@ namespace ciphers {
             return;
         }
 
-        __m128i state = to_lower_nibbles(plaintext);
-        state = vxor(state, ctx->key[0]);
+        to_byte_array(ciphertext, encrypt_rounds_only_sbox_in_final_nibbles(
+            ctx, to_lower_nibbles(plaintext), num_rounds
+        ));
+    }
 
-        for (size_t i = 1; i < num_rounds; ++i) {
-            state = small_aes_encrypt_round(state, ctx->key[i]);
+    // ---------------------------------------------------------------------
+    // Public API on packed states
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_decrypt(const small_aes_ctx_t *ctx,
+                      const small_aes_packed_state_t ciphertext) {
+        return utils::convert_to_uint64(
+            decrypt_nibbles(ctx, utils::convert_from_uint64(ciphertext))
+        );
+    }
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_encrypt(const small_aes_ctx_t *ctx,
+                      const small_aes_packed_state_t plaintext) {
+        return utils::convert_to_uint64(encrypt_rounds_nibbles(
+            ctx, utils::convert_from_uint64(plaintext), SMALL_AES_NUM_ROUNDS
+        ));
+    }
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_encrypt_rounds(const small_aes_ctx_t *ctx,
+                             const small_aes_packed_state_t plaintext,
+                             const size_t num_rounds) {
+        if (num_rounds > SMALL_AES_NUM_ROUNDS) {
+            return plaintext;
         }
 
-        state = small_aes_sub_bytes(state);
-        state = vxor(state, ctx->key[num_rounds]);
+        return utils::convert_to_uint64(encrypt_rounds_nibbles(
+            ctx, utils::convert_from_uint64(plaintext), num_rounds
+        ));
+    }
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_encrypt_rounds_always_mc(const small_aes_ctx_t *ctx,
+                                       const small_aes_packed_state_t plaintext,
+                                       const size_t num_rounds) {
+        if ((num_rounds == 0) || (num_rounds > SMALL_AES_NUM_ROUNDS)) {
+            return plaintext;
+        }
+
+        return utils::convert_to_uint64(encrypt_rounds_always_mc_nibbles(
+            ctx, utils::convert_from_uint64(plaintext), num_rounds
+        ));
+    }
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_decrypt_rounds_always_mc(const small_aes_ctx_t *ctx,
+                                       const small_aes_packed_state_t ciphertext,
+                                       const size_t num_rounds) {
+        if ((num_rounds == 0) || (num_rounds > SMALL_AES_NUM_ROUNDS)) {
+            return ciphertext;
+        }
+
+        return utils::convert_to_uint64(decrypt_rounds_always_mc_nibbles(
+            ctx, utils::convert_from_uint64(ciphertext), num_rounds
+        ));
+    }
+
+    // ---------------------------------------------------------------------
+
+    small_aes_packed_state_t
+    small_aes_encrypt_rounds_only_sbox_in_final(
+        const small_aes_ctx_t *ctx,
+        const small_aes_packed_state_t plaintext,
+        const size_t num_rounds) {
+        if (num_rounds > SMALL_AES_NUM_ROUNDS) {
+            return plaintext;
+        }
 
-        to_byte_array(ciphertext, state);
+        return utils::convert_to_uint64(
+            encrypt_rounds_only_sbox_in_final_nibbles(
+                ctx, utils::convert_from_uint64(plaintext), num_rounds
+            )
+        );
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_encrypt_rounds_only_sbox_in_final_sweep(
+        const small_aes_ctx_t *ctx,
+        const small_aes_packed_state_t plaintext,
+        small_aes_packed_state_t *ciphertexts,
+        const size_t min_num_rounds,
+        const size_t max_num_rounds) {
+        if (!is_valid_round_range(min_num_rounds, max_num_rounds)) {
+            return;
+        }
+
+        __m128i state = vxor(utils::convert_from_uint64(plaintext),
+                             ctx->key[0]);
+
+        for (size_t i = 1; i <= max_num_rounds; ++i) {
+            if (i >= min_num_rounds) {
+                ciphertexts[i - min_num_rounds] = utils::convert_to_uint64(
+                    vxor(small_aes_sub_bytes(state), ctx->key[i])
+                );
+            }
+
+            if (i < max_num_rounds) {
+                state = small_aes_encrypt_round(state, ctx->key[i]);
+            }
+        }
     }
 
     // ---------------------------------------------------------------------
@@ -935,4 +1075,295 @@ namespace ciphers {
         return avxxor(b, z);
     }
 
+    // ---------------------------------------------------------------------
+    // Diagonal structures
+    // ---------------------------------------------------------------------
+
+    static inline __m128i
+    get_diagonal_structure_base_plaintext(const size_t structure_index) {
+        const size_t i = structure_index;
+        return vsetr8(
+            0, 0, (uint8_t) ((i >> 28) & 0xF), (uint8_t) ((i >> 24) & 0xF),
+            0, 0, (uint8_t) ((i >> 20) & 0xF), (uint8_t) ((i >> 16) & 0xF),
+            (uint8_t) ((i >> 12) & 0xF), (uint8_t) ((i >> 8) & 0xF), 0, 0,
+            (uint8_t) ((i >> 4) & 0xF), (uint8_t) (i & 0xF), 0, 0
+        );
+    }
+
+#ifdef __AVX2__
+
+#define AVX_LO_NIBBLES_MASK             avxbroadcast128(LO_NIBBLES_MASK)
+#define AVX_HI_NIBBLES_MASK             avxbroadcast128(HI_NIBBLES_MASK)
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Applies the 4-bit function in table_lo to the low and high nibbles of
+     * every byte. table_hi contains the same values shifted by four bits.
+     */
+    static inline __m256i
+    shuffle_nibbles_4(const __m256i table_lo,
+                      const __m256i table_hi,
+                      const __m256i state) {
+        const __m256i mask = AVX_LO_NIBBLES_MASK;
+        const __m256i lo = avxshuffle(table_lo, avxand(state, mask));
+        const __m256i hi = avxshuffle(table_hi,
+                                      avxand(avxshiftright16(state, 4), mask));
+        return avxor(lo, hi);
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Tables and masks of a round for four states that are packed as in
+     * small_aes_encrypt_rounds_4, held in registers for the whole structure.
+     */
+    typedef struct {
+        __m256i sbox_lo;
+        __m256i sbox_hi;
+        __m256i times_two_lo;
+        __m256i times_two_hi;
+        __m256i shift_rows;
+        __m256i rotate_by_one;
+        __m256i rotate_by_two;
+        __m256i rotate_by_three;
+    } small_aes_round_tables_4_t;
+
+    // ---------------------------------------------------------------------
+
+    static inline __m256i
+    small_aes_encrypt_fast_round_4(const small_aes_round_tables_4_t &tables,
+                                   __m256i state,
+                                   const __m256i round_key) {
+        state = shuffle_nibbles_4(tables.sbox_lo, tables.sbox_hi, state);
+        state = avxshuffle(state, tables.shift_rows);
+
+        // 2x_i xor 3x_{i+1} xor x_{i+2} xor x_{i+3} for all columns
+        const __m256i times_two = shuffle_nibbles_4(
+            tables.times_two_lo, tables.times_two_hi, state
+        );
+        const __m256i times_three = avxxor(times_two, state);
+        state = avxxor(
+            avxxor(times_two, avxshuffle(times_three, tables.rotate_by_one)),
+            avxxor(avxshuffle(state, tables.rotate_by_two),
+                   avxshuffle(state, tables.rotate_by_three))
+        );
+        return avxxor(state, round_key);
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Converts four packed states [A, B] [C, D], where A and C are stored in
+     * the low and B and D in the high nibbles of the lanes, to the uint64
+     * representation of A, B, C, D, in this order.
+     */
+    static inline __m256i to_uint64_4(const __m256i state) {
+        const __m128i evens = vsetr8(14, 12, 10, 8, 6, 4, 2, 0,
+                                     14, 12, 10, 8, 6, 4, 2, 0);
+        const __m128i odds = vsetr8(15, 13, 11, 9, 7, 5, 3, 1,
+                                    15, 13, 11, 9, 7, 5, 3, 1);
+
+        // Byte k of every 64-bit word holds the nibbles 14 - 2k and 15 - 2k
+        // of both states in its lane.
+        const __m256i x = avxshuffle(state, avxbroadcast128(evens));
+        const __m256i y = avxshuffle(state, avxbroadcast128(odds));
+
+        // Words of the low-nibble states take the low nibbles, the others
+        // the high nibbles.
+        const __m256i x_shifts = _mm256_setr_epi64x(4, 0, 4, 0);
+        const __m256i y_shifts = _mm256_setr_epi64x(0, 4, 0, 4);
+        return avxor(
+            avxand(avxshiftleftv64(x, x_shifts), AVX_HI_NIBBLES_MASK),
+            avxand(avxshiftrightv64(y, y_shifts), AVX_LO_NIBBLES_MASK)
+        );
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline __m256i get_diagonal_byte_step_4(const size_t byte_index) {
+        ALIGN(16) uint8_t step[16];
+        memset(step, 0, sizeof(step));
+        step[byte_index] = 0x11;
+        return avxbroadcast128(load(step));
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_encrypt_diagonal_structure_sweep(
+        const small_aes_ctx_t *ctx,
+        const size_t structure_index,
+        uint64_t *ciphertexts,
+        const size_t min_num_rounds,
+        const size_t max_num_rounds) {
+        if (!is_valid_round_range(min_num_rounds, max_num_rounds)) {
+            return;
+        }
+
+        const size_t NUM_TEXTS = SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE;
+
+        small_aes_round_tables_4_t tables;
+        tables.sbox_lo = avxbroadcast128(SMALL_AES_SBOX);
+        tables.sbox_hi = avxbroadcast128(vshiftleft16(SMALL_AES_SBOX, 4));
+        tables.times_two_lo = avxbroadcast128(SMALL_AES_TIMES_TWO);
+        tables.times_two_hi = avxbroadcast128(
+            vshiftleft16(SMALL_AES_TIMES_TWO, 4)
+        );
+        tables.shift_rows = avxbroadcast128(SMALL_AES_SHIFT_ROWS);
+        tables.rotate_by_one = avxbroadcast128(
+            vsetr8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12)
+        );
+        tables.rotate_by_two = avxbroadcast128(
+            vsetr8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13)
+        );
+        tables.rotate_by_three = avxbroadcast128(
+            vsetr8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14)
+        );
+
+        // Round keys with every nibble in both halves of its byte
+        __m256i keys[SMALL_AES_NUM_ROUND_KEYS];
+
+        for (size_t i = 0; i <= max_num_rounds; ++i) {
+            const __m128i k = ctx->key[i];
+            keys[i] = avxbroadcast128(
+                vor(k, vand(vshiftleft16(k, 4), HI_NIBBLES_MASK))
+            );
+        }
+
+        // Every register holds four consecutive texts 4r + t of a block of
+        // 16 texts that share the diagonal nibbles 0, 5, and 10. They differ
+        // only in nibble 15, which is t in the low nibble of lane 0, t + 1
+        // in the high nibble of lane 0, and so on.
+        const size_t NUM_REGISTERS = 4;
+        __m256i differences[NUM_REGISTERS];
+
+        for (size_t r = 0; r < NUM_REGISTERS; ++r) {
+            const uint8_t t = (uint8_t) (4 * r);
+            differences[r] = _mm256_setr_epi8(
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                (char) (t | ((t + 1) << 4)),
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                (char) ((t + 2) | ((t + 3) << 4))
+            );
+        }
+
+        const __m128i base = get_diagonal_structure_base_plaintext(
+            structure_index
+        );
+        const __m256i step_0 = get_diagonal_byte_step_4(0);
+        const __m256i step_5 = get_diagonal_byte_step_4(5);
+        const __m256i step_10 = get_diagonal_byte_step_4(10);
+
+        __m256i text_0 = avxbroadcast128(
+            vor(base, vshiftleft16(base, 4))
+        );
+        __m256i states[NUM_REGISTERS];
+
+        for (size_t i0 = 0; i0 < 16; ++i0) {
+            __m256i text_5 = text_0;
+
+            for (size_t i1 = 0; i1 < 16; ++i1) {
+                __m256i text_10 = text_5;
+
+                for (size_t i2 = 0; i2 < 16; ++i2) {
+                    for (size_t r = 0; r < NUM_REGISTERS; ++r) {
+                        states[r] = avxxor(avxxor(text_10, differences[r]),
+                                           keys[0]);
+                    }
+
+                    // The final SubBytes and key addition of every round
+                    // count go to a copy of the carried-forward state.
+                    for (size_t i = 1; i <= max_num_rounds; ++i) {
+                        if (i >= min_num_rounds) {
+                            uint64_t *targets = ciphertexts
+                                + (i - min_num_rounds) * NUM_TEXTS;
+
+                            for (size_t r = 0; r < NUM_REGISTERS; ++r) {
+                                const __m256i ciphertext = avxxor(
+                                    shuffle_nibbles_4(tables.sbox_lo,
+                                                      tables.sbox_hi,
+                                                      states[r]),
+                                    keys[i]
+                                );
+                                uint64_t *target = targets + 4 * r;
+                                avxstoreu(target, to_uint64_4(ciphertext));
+                            }
+                        }
+
+                        if (i == max_num_rounds) {
+                            break;
+                        }
+
+                        for (size_t r = 0; r < NUM_REGISTERS; ++r) {
+                            states[r] = small_aes_encrypt_fast_round_4(
+                                tables, states[r], keys[i]
+                            );
+                        }
+                    }
+
+                    ciphertexts += 4 * NUM_REGISTERS;
+                    text_10 = avxadd8(text_10, step_10);
+                }
+
+                text_5 = avxadd8(text_5, step_5);
+            }
+
+            text_0 = avxadd8(text_0, step_0);
+        }
+    }
+
+#else
+
+    void small_aes_encrypt_diagonal_structure_sweep(
+        const small_aes_ctx_t *ctx,
+        const size_t structure_index,
+        uint64_t *ciphertexts,
+        const size_t min_num_rounds,
+        const size_t max_num_rounds) {
+        if (!is_valid_round_range(min_num_rounds, max_num_rounds)) {
+            return;
+        }
+
+        const size_t NUM_TEXTS = SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE;
+        const __m128i base = get_diagonal_structure_base_plaintext(
+            structure_index
+        );
+
+        for (size_t j = 0; j < NUM_TEXTS; ++j) {
+            const __m128i plaintext = vxor(base, vsetr8(
+                (uint8_t) ((j >> 12) & 0xF), 0, 0, 0,
+                0, (uint8_t) ((j >> 8) & 0xF), 0, 0,
+                0, 0, (uint8_t) ((j >> 4) & 0xF), 0,
+                0, 0, 0, (uint8_t) (j & 0xF)
+            ));
+            __m128i state = vxor(plaintext, ctx->key[0]);
+
+            for (size_t i = 1; i <= max_num_rounds; ++i) {
+                if (i >= min_num_rounds) {
+                    ciphertexts[(i - min_num_rounds) * NUM_TEXTS + j] =
+                        utils::convert_to_uint64(
+                            vxor(small_aes_sub_bytes(state), ctx->key[i])
+                        );
+                }
+
+                if (i < max_num_rounds) {
+                    state = small_aes_encrypt_round(state, ctx->key[i]);
+                }
+            }
+        }
+    }
+
+#endif
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_encrypt_diagonal_structure(const small_aes_ctx_t *ctx,
+                                              const size_t structure_index,
+                                              uint64_t *ciphertexts,
+                                              const size_t num_rounds) {
+        small_aes_encrypt_diagonal_structure_sweep(ctx, structure_index,
+                                                   ciphertexts, num_rounds,
+                                                   num_rounds);
+    }
+
 }
@@ -0,0 +1,481 @@
+/**
+ * Bitsliced implementation of Small-AES that encrypts 256 states at once.
+ * Every bit of the state is a plane of 256 bits, so that SubBytes becomes
+ * a Boolean circuit, and ShiftRows and MixColumns become wire permutations
+ * and XORs.
+ *
+ * Do NOT use for any production purpose. No guarantees are given for anything.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+// ---------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ciphers/small_aes.h"
+#include "ciphers/small_aes_bitsliced.h"
+#include "utils/utils.h"
+
+// ---------------------------------------------------------------------
+
+namespace ciphers {
+
+    static const size_t NUM_BITS = 64;
+    static const size_t NUM_LANES = 4;
+
+    typedef small_aes_bitsliced_state_t bitsliced_state_t;
+
+    // ---------------------------------------------------------------------
+    // Transposition
+    // ---------------------------------------------------------------------
+
+    static inline __m256d to_double(const __m256i x) {
+        return _mm256_castsi256_pd(x);
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Swaps the bits (k, j + i) and (k + j, i) of the 64 x 64 bit matrices
+     * in the lanes of rows for all k with k & j == 0, and i with mask bit i
+     * set.
+     */
+    static inline void transpose_step(__m256i rows[NUM_BITS],
+                                      const int shift,
+                                      const uint64_t mask) {
+        const __m256i m = _mm256_set1_epi64x((long long) mask);
+        const size_t j = (size_t) shift;
+
+        for (size_t k = 0; k < NUM_BITS; k += 2 * j) {
+            for (size_t i = k; i < k + j; ++i) {
+                const __m256i t = avxand(
+                    avxxor(avxshiftright64(rows[i], shift), rows[i + j]), m
+                );
+                rows[i + j] = avxxor(rows[i + j], t);
+                rows[i] = avxxor(rows[i], avxshiftleft64(t, shift));
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Transposes the 64 x 64 bit matrices in all lanes of rows, where bit i
+     * of row r is the element (r, i).
+     */
+    static void transpose(__m256i rows[NUM_BITS]) {
+        transpose_step(rows, 32, 0x00000000FFFFFFFFL);
+        transpose_step(rows, 16, 0x0000FFFF0000FFFFL);
+        transpose_step(rows, 8, 0x00FF00FF00FF00FFL);
+        transpose_step(rows, 4, 0x0F0F0F0F0F0F0F0FL);
+        transpose_step(rows, 2, 0x3333333333333333L);
+        transpose_step(rows, 1, 0x5555555555555555L);
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * The row with bit q of the uint64 states is the plane of bit q % 4 of
+     * cell 15 - q / 4.
+     */
+    static inline __m256i &get_plane(bitsliced_state_t *state,
+                                     const size_t bit_index) {
+        return state->cells[SMALL_AES_NUM_CELLS - 1 - bit_index / 4]
+                           [bit_index % 4];
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline const __m256i &get_plane(const bitsliced_state_t *state,
+                                           const size_t bit_index) {
+        return state->cells[SMALL_AES_NUM_CELLS - 1 - bit_index / 4]
+                           [bit_index % 4];
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_bitsliced_pack(bitsliced_state_t *state,
+                                  const uint64_t *texts) {
+        __m256i rows[NUM_BITS];
+
+        for (size_t i = 0; i < NUM_BITS; ++i) {
+            rows[i] = _mm256_setr_epi64x((long long) texts[i],
+                                         (long long) texts[NUM_BITS + i],
+                                         (long long) texts[2 * NUM_BITS + i],
+                                         (long long) texts[3 * NUM_BITS + i]);
+        }
+
+        transpose(rows);
+
+        for (size_t q = 0; q < NUM_BITS; ++q) {
+            get_plane(state, q) = rows[q];
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_bitsliced_unpack(uint64_t *texts,
+                                    const bitsliced_state_t *state) {
+        __m256i rows[NUM_BITS];
+
+        for (size_t q = 0; q < NUM_BITS; ++q) {
+            rows[q] = get_plane(state, q);
+        }
+
+        transpose(rows);
+
+        // Transposes the 4 x 4 words of the rows i to i + 3, so that every
+        // lane l yields the texts 64 * l + i to 64 * l + i + 3.
+        for (size_t i = 0; i < NUM_BITS; i += NUM_LANES) {
+            const __m256d t0 = _mm256_unpacklo_pd(to_double(rows[i]),
+                                                  to_double(rows[i + 1]));
+            const __m256d t1 = _mm256_unpackhi_pd(to_double(rows[i]),
+                                                  to_double(rows[i + 1]));
+            const __m256d t2 = _mm256_unpacklo_pd(to_double(rows[i + 2]),
+                                                  to_double(rows[i + 3]));
+            const __m256d t3 = _mm256_unpackhi_pd(to_double(rows[i + 2]),
+                                                  to_double(rows[i + 3]));
+            const __m256d lanes[NUM_LANES] = {
+                _mm256_permute2f128_pd(t0, t2, 0x20),
+                _mm256_permute2f128_pd(t1, t3, 0x20),
+                _mm256_permute2f128_pd(t0, t2, 0x31),
+                _mm256_permute2f128_pd(t1, t3, 0x31)
+            };
+
+            for (size_t l = 0; l < NUM_LANES; ++l) {
+                _mm256_storeu_pd((double *) (texts + l * NUM_BITS + i),
+                                 lanes[l]);
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Sets all planes to all-ones or zero, depending on the bits of the
+     * uint64 state value.
+     */
+    static void set_constant_planes(bitsliced_state_t *state,
+                                    const uint64_t value) {
+        const __m256i ones = _mm256_set1_epi64x(-1);
+
+        for (size_t q = 0; q < NUM_BITS; ++q) {
+            get_plane(state, q) = ((value >> q) & 1) ? ones : avxzero;
+        }
+    }
+
+    // ---------------------------------------------------------------------
+    // Round functions
+    // ---------------------------------------------------------------------
+
+    /**
+     * The S-box as a circuit of 29 gates, where x[0] is the least
+     * significant bit. Omits the complement of the bits 1 and 2, i.e.,
+     * computes S(x) ^ 0x6; the round keys absorb the constant.
+     */
+    static inline void sbox(__m256i x[SMALL_AES_NUM_CELL_BITS]) {
+        const __m256i a = x[0];
+        const __m256i b = x[1];
+        const __m256i c = x[2];
+        const __m256i d = x[3];
+        const __m256i a_xor_b = avxxor(a, b);
+
+        // d & ~c ^ a & ~((b | d) ^ (b & c))
+        x[3] = avxxor(
+            avxandnot(c, d),
+            avxandnot(avxxor(avxor(b, d), avxand(b, c)), a)
+        );
+
+        // b & ~c ^ d & ~(a & b ^ c & ~(a ^ b)), complemented
+        x[1] = avxxor(
+            avxandnot(c, b),
+            avxandnot(avxxor(avxand(a, b), avxandnot(a_xor_b, c)), d)
+        );
+
+        // a & ~b ^ c & ~(b & ~a) ^ d & ~(b ^ c & ~a), complemented
+        x[2] = avxxor(
+            avxxor(avxandnot(b, a), avxandnot(avxandnot(a, b), c)),
+            avxandnot(avxxor(b, avxandnot(a, c)), d)
+        );
+
+        // b ^ a & ~(c & ~b) ^ d & ~((a | b) ^ c & (a ^ b))
+        x[0] = avxxor(
+            avxxor(b, avxandnot(avxandnot(b, c), a)),
+            avxandnot(avxxor(avxor(a, b), avxand(c, a_xor_b)), d)
+        );
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline void sub_bytes(bitsliced_state_t *state) {
+        for (size_t k = 0; k < SMALL_AES_NUM_CELLS; ++k) {
+            sbox(state->cells[k]);
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline void add_round_key(bitsliced_state_t *state,
+                                     const bitsliced_state_t *key) {
+        for (size_t k = 0; k < SMALL_AES_NUM_CELLS; ++k) {
+            for (size_t b = 0; b < SMALL_AES_NUM_CELL_BITS; ++b) {
+                state->cells[k][b] = avxxor(state->cells[k][b],
+                                            key->cells[k][b]);
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Cell (r, c) after ShiftRows is the cell (r, c + r) before.
+     */
+    static inline size_t get_shifted_cell_index(const size_t row,
+                                                const size_t column) {
+        return ((column + row) % SMALL_AES_NUM_COLUMNS) * SMALL_AES_NUM_ROWS
+               + row;
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * ShiftRows and the round key: out = SR(in) ^ key.
+     */
+    static inline void shift_rows_and_add_key(bitsliced_state_t *out,
+                                              const bitsliced_state_t *in,
+                                              const bitsliced_state_t *key) {
+        for (size_t c = 0; c < SMALL_AES_NUM_COLUMNS; ++c) {
+            for (size_t r = 0; r < SMALL_AES_NUM_ROWS; ++r) {
+                const size_t k = c * SMALL_AES_NUM_ROWS + r;
+                const __m256i *source = in->cells[get_shifted_cell_index(r, c)];
+
+                for (size_t b = 0; b < SMALL_AES_NUM_CELL_BITS; ++b) {
+                    out->cells[k][b] = avxxor(source[b], key->cells[k][b]);
+                }
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * A full round out = MC(SR(SB(in))) ^ key, column by column. Row r of a
+     * column is 2 (a_r ^ a_{r+1}) ^ a_r ^ (a_0 ^ a_1 ^ a_2 ^ a_3), where the
+     * multiplication by two in GF(2^4) / x^4 + x + 1 maps the bits
+     * (x3, x2, x1, x0) to (x2, x1, x0 ^ x3, x3).
+     */
+    static inline void encrypt_round(bitsliced_state_t *out,
+                                     const bitsliced_state_t *in,
+                                     const bitsliced_state_t *key) {
+        for (size_t c = 0; c < SMALL_AES_NUM_COLUMNS; ++c) {
+            __m256i a[SMALL_AES_NUM_ROWS][SMALL_AES_NUM_CELL_BITS];
+
+            for (size_t r = 0; r < SMALL_AES_NUM_ROWS; ++r) {
+                const __m256i *source = in->cells[get_shifted_cell_index(r, c)];
+
+                for (size_t b = 0; b < SMALL_AES_NUM_CELL_BITS; ++b) {
+                    a[r][b] = source[b];
+                }
+
+                sbox(a[r]);
+            }
+
+            __m256i sum[SMALL_AES_NUM_CELL_BITS];
+
+            for (size_t b = 0; b < SMALL_AES_NUM_CELL_BITS; ++b) {
+                sum[b] = avxxor(avxxor(a[0][b], a[1][b]),
+                                avxxor(a[2][b], a[3][b]));
+            }
+
+            for (size_t r = 0; r < SMALL_AES_NUM_ROWS; ++r) {
+                const size_t k = c * SMALL_AES_NUM_ROWS + r;
+                const __m256i *next = a[(r + 1) % SMALL_AES_NUM_ROWS];
+                __m256i y[SMALL_AES_NUM_CELL_BITS];
+
+                for (size_t b = 0; b < SMALL_AES_NUM_CELL_BITS; ++b) {
+                    y[b] = avxxor(a[r][b], next[b]);
+                }
+
+                const __m256i times_two[SMALL_AES_NUM_CELL_BITS] = {
+                    y[3], avxxor(y[0], y[3]), y[1], y[2]
+                };
+
+                for (size_t b = 0; b < SMALL_AES_NUM_CELL_BITS; ++b) {
+                    out->cells[k][b] = avxxor(
+                        avxxor(times_two[b], a[r][b]),
+                        avxxor(sum[b], key->cells[k][b])
+                    );
+                }
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Applies rounds 1 to num_rounds - 1 to the state after the initial key
+     * addition. Returns the buffer that holds the result.
+     */
+    static bitsliced_state_t *
+    encrypt_full_rounds(const small_aes_bitsliced_ctx_t *ctx,
+                        bitsliced_state_t *state,
+                        bitsliced_state_t *buffer,
+                        const size_t num_rounds) {
+        for (size_t i = 1; i < num_rounds; ++i) {
+            encrypt_round(buffer, state, &ctx->key[i]);
+
+            bitsliced_state_t *temp = state;
+            state = buffer;
+            buffer = temp;
+        }
+
+        return state;
+    }
+
+    // ---------------------------------------------------------------------
+    // API
+    // ---------------------------------------------------------------------
+
+    void small_aes_bitsliced_key_setup(small_aes_bitsliced_ctx_t *ctx,
+                                       const small_aes_key_t key) {
+        small_aes_ctx_t cipher_ctx;
+        small_aes_key_setup(&cipher_ctx, key);
+
+        // sbox() leaves 0x6 in every cell. ShiftRows and MixColumns map
+        // this constant to itself, so that it can be added to the keys of
+        // all rounds that follow an S-box layer.
+        const uint64_t SBOX_CONSTANT = 0x6666666666666666L;
+        set_constant_planes(&ctx->key[0],
+                            utils::convert_to_uint64(cipher_ctx.key[0]));
+
+        for (size_t i = 1; i < SMALL_AES_NUM_ROUND_KEYS; ++i) {
+            set_constant_planes(
+                &ctx->key[i],
+                utils::convert_to_uint64(cipher_ctx.key[i]) ^ SBOX_CONSTANT
+            );
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_bitsliced_encrypt_rounds(
+        const small_aes_bitsliced_ctx_t *ctx,
+        bitsliced_state_t *state,
+        const size_t num_rounds) {
+        if ((num_rounds == 0) || (num_rounds > SMALL_AES_NUM_ROUNDS)) {
+            return;
+        }
+
+        bitsliced_state_t buffer;
+        add_round_key(state, &ctx->key[0]);
+
+        bitsliced_state_t *result = encrypt_full_rounds(ctx, state, &buffer,
+                                                        num_rounds);
+        bitsliced_state_t *target = (result == state) ? &buffer : state;
+
+        sub_bytes(result);
+        shift_rows_and_add_key(target, result, &ctx->key[num_rounds]);
+
+        if (target != state) {
+            memcpy(state, target, sizeof(bitsliced_state_t));
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_bitsliced_encrypt_rounds_only_sbox_in_final(
+        const small_aes_bitsliced_ctx_t *ctx,
+        bitsliced_state_t *state,
+        const size_t num_rounds) {
+        if ((num_rounds == 0) || (num_rounds > SMALL_AES_NUM_ROUNDS)) {
+            return;
+        }
+
+        bitsliced_state_t buffer;
+        add_round_key(state, &ctx->key[0]);
+
+        bitsliced_state_t *result = encrypt_full_rounds(ctx, state, &buffer,
+                                                        num_rounds);
+        sub_bytes(result);
+        add_round_key(result, &ctx->key[num_rounds]);
+
+        if (result != state) {
+            memcpy(state, result, sizeof(bitsliced_state_t));
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Returns the plane of bit m of the batch-local text index t in [0, 256).
+     */
+    static __m256i get_counter_plane(const size_t m) {
+        ALIGN(32) uint64_t words[NUM_LANES];
+
+        for (size_t l = 0; l < NUM_LANES; ++l) {
+            words[l] = 0;
+
+            for (size_t i = 0; i < NUM_BITS; ++i) {
+                const size_t t = l * NUM_BITS + i;
+                words[l] |= (uint64_t) ((t >> m) & 1) << i;
+            }
+        }
+
+        return avxload(words);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_bitsliced_encrypt_diagonal_structure(
+        const small_aes_bitsliced_ctx_t *ctx,
+        const size_t structure_index,
+        uint64_t *ciphertexts,
+        const size_t num_rounds) {
+        if ((num_rounds == 0) || (num_rounds > SMALL_AES_NUM_ROUNDS)) {
+            return;
+        }
+
+        // Nibbles 2, 3, 6, 7, 8, 9, 12, 13 of the structure
+        const uint64_t i = structure_index;
+        const uint64_t base = ((i & 0xFF000000L) << 24)
+                              | ((i & 0x00FF0000L) << 16)
+                              | ((i & 0x0000FF00L) << 16)
+                              | ((i & 0x000000FFL) << 8);
+
+        // The texts t of a batch take nibble 10 = t >> 4 and nibble 15 = t
+        __m256i counters[8];
+
+        for (size_t m = 0; m < 8; ++m) {
+            counters[m] = get_counter_plane(m);
+        }
+
+        const size_t NUM_BATCHES = SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE
+                                   / SMALL_AES_BITSLICED_NUM_STATES;
+        bitsliced_state_t state;
+
+        for (size_t h = 0; h < NUM_BATCHES; ++h) {
+            // Nibble 0 = h >> 4, nibble 5 = h & 0xF
+            const uint64_t plaintext = base
+                                       | ((uint64_t) (h >> 4) << 60)
+                                       | ((uint64_t) (h & 0xF) << 40);
+            set_constant_planes(&state, plaintext);
+
+            for (size_t b = 0; b < SMALL_AES_NUM_CELL_BITS; ++b) {
+                state.cells[10][b] = counters[4 + b];
+                state.cells[15][b] = counters[b];
+            }
+
+            small_aes_bitsliced_encrypt_rounds_only_sbox_in_final(
+                ctx, &state, num_rounds
+            );
+            small_aes_bitsliced_unpack(
+                ciphertexts + h * SMALL_AES_BITSLICED_NUM_STATES, &state
+            );
+        }
+    }
+
+}
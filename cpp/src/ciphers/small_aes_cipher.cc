@@ -0,0 +1,38 @@
+/**
+ * Explicit instantiations of the Small-AES variants in small_aes_cipher.h,
+ * so that every variant is compiled, for all numbers of rounds, with the
+ * library.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+// ---------------------------------------------------------------------
+
+#include "ciphers/small_aes_cipher.h"
+
+// ---------------------------------------------------------------------
+
+namespace ciphers {
+
+    template class SmallAesCipherVariant<SmallAesSBox, SmallAesMixColumns>;
+    template class SmallAesCipherVariant<SmallAesSBox, SmallAesM02MixColumns>;
+    template class SmallAesCipherVariant<SmallAesSBox,
+                                         SmallAesMidoriMixColumns>;
+    template class SmallAesCipherVariant<SmallAesPresentSBox,
+                                         SmallAesMixColumns>;
+    template class SmallAesCipherVariant<SmallAesPresentSBox,
+                                         SmallAesM02MixColumns>;
+    template class SmallAesCipherVariant<SmallAesPresentSBox,
+                                         SmallAesMidoriMixColumns>;
+    template class SmallAesCipherVariant<SmallAesPrideSBox,
+                                         SmallAesMixColumns>;
+    template class SmallAesCipherVariant<SmallAesPrinceSBox,
+                                         SmallAesMixColumns>;
+    template class SmallAesCipherVariant<SmallAesToy6SBox, SmallAesMixColumns>;
+    template class SmallAesCipherVariant<SmallAesToy8SBox, SmallAesMixColumns>;
+    template class SmallAesCipherVariant<SmallAesToy10SBox,
+                                         SmallAesMixColumns>;
+
+}
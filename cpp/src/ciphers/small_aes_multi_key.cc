@@ -0,0 +1,541 @@
+/**
+ * Implementation of Small-AES that encrypts the same texts under several
+ * keys, or under one key with several S-boxes, at once.
+ *
+ * Every 128-bit lane holds the state of one key or S-box, with two texts in
+ * the low and the high nibbles of its bytes as in
+ * small_aes_encrypt_rounds_2(). Since the byte shuffles work within lanes,
+ * SubBytes applies the S-box of every lane with a single shuffle per nibble
+ * half. The lanes form AVX-512 registers of four keys if AVX-512BW is
+ * available, AVX2 registers of two keys if AVX2 is, and single SSE
+ * registers otherwise.
+ *
+ * Do NOT use for any production purpose. No guarantees are given for anything.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+// ---------------------------------------------------------------------
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#include "ciphers/small_aes.h"
+#include "ciphers/small_aes_multi_key.h"
+#include "utils/utils.h"
+
+// ---------------------------------------------------------------------
+
+namespace ciphers {
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+
+    typedef __m512i lanes_t;
+
+#define NUM_LANES                       4
+#define lanesload(p)                    _mm512_load_si512((const void *) (p))
+#define lanesstore(p, x)                _mm512_store_si512((void *) (p), x)
+#define lanesand(x, y)                  _mm512_and_si512(x, y)
+#define lanesor(x, y)                   _mm512_or_si512(x, y)
+#define lanesxor(x, y)                  _mm512_xor_si512(x, y)
+#define lanesadd8(x, y)                 _mm512_add_epi8(x, y)
+#define lanesshuffle(x, mask)           _mm512_shuffle_epi8(x, mask)
+#define lanesshiftleft16(x, shift)      _mm512_slli_epi16(x, shift)
+#define lanesshiftright16(x, shift)     _mm512_srli_epi16(x, shift)
+#define lanesshiftleft_bytes(x, shift)  _mm512_bslli_epi128(x, shift)
+// The unmasked broadcast trips -Wmaybe-uninitialized in some GCC headers
+#define lanesbroadcast128(x)            _mm512_maskz_broadcast_i32x4(-1, x)
+
+#elif defined(__AVX2__)
+
+    typedef __m256i lanes_t;
+
+#define NUM_LANES                       2
+#define lanesload(p)                    avxload(p)
+#define lanesstore(p, x)                avxstore(p, x)
+#define lanesand(x, y)                  avxand(x, y)
+#define lanesor(x, y)                   avxor(x, y)
+#define lanesxor(x, y)                  avxxor(x, y)
+#define lanesadd8(x, y)                 avxadd8(x, y)
+#define lanesshuffle(x, mask)           avxshuffle(x, mask)
+#define lanesshiftleft16(x, shift)      _mm256_slli_epi16(x, shift)
+#define lanesshiftright16(x, shift)     avxshiftright16(x, shift)
+#define lanesshiftleft_bytes(x, shift)  _mm256_bslli_epi128(x, shift)
+#define lanesbroadcast128(x)            avxbroadcast128(x)
+
+#else
+
+    typedef __m128i lanes_t;
+
+#define NUM_LANES                       1
+#define lanesload(p)                    load(p)
+#define lanesstore(p, x)                store(p, x)
+#define lanesand(x, y)                  vand(x, y)
+#define lanesor(x, y)                   vor(x, y)
+#define lanesxor(x, y)                  vxor(x, y)
+#define lanesadd8(x, y)                 _mm_add_epi8(x, y)
+#define lanesshuffle(x, mask)           vshuffle(x, mask)
+#define lanesshiftleft16(x, shift)      vshiftleft16(x, shift)
+#define lanesshiftright16(x, shift)     vshiftright16(x, shift)
+#define lanesshiftleft_bytes(x, shift)  vshiftleft_bytes(x, shift)
+#define lanesbroadcast128(x)            (x)
+
+#endif
+
+#define NUM_VECTORS         (SMALL_AES_MULTI_KEY_MAX_NUM_KEYS / NUM_LANES)
+#define NUM_TEXT_PAIRS      8
+#define ZERO_INDEX          ((char) 0x80)
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Tables and masks of a round, broadcast to all lanes. sbox_lo is the
+     * Small-AES S-box of the key schedule; SubBytes uses the S-boxes of ctx.
+     */
+    typedef struct {
+        lanes_t lo_nibbles_mask;
+        lanes_t sbox_lo;
+        lanes_t times_two_lo;
+        lanes_t times_two_hi;
+        lanes_t shift_rows;
+        lanes_t rotate_by_one;
+        lanes_t rotate_by_two;
+        lanes_t rotate_by_three;
+    } round_tables_t;
+
+    // ---------------------------------------------------------------------
+
+    static void init_round_tables(round_tables_t *tables) {
+        tables->lo_nibbles_mask = lanesbroadcast128(vset8_single(0x0F));
+        tables->sbox_lo = lanesbroadcast128(SMALL_AES_SBOX_1);
+        tables->times_two_lo = lanesbroadcast128(SMALL_AES_TIMES_TWO);
+        tables->times_two_hi = lanesbroadcast128(
+            vshiftleft16(SMALL_AES_TIMES_TWO, 4)
+        );
+        tables->shift_rows = lanesbroadcast128(
+            vsetr8(0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11)
+        );
+        tables->rotate_by_one = lanesbroadcast128(
+            vsetr8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12)
+        );
+        tables->rotate_by_two = lanesbroadcast128(
+            vsetr8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13)
+        );
+        tables->rotate_by_three = lanesbroadcast128(
+            vsetr8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14)
+        );
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Applies the 4-bit function in table_lo to the low and high nibbles of
+     * every byte. table_hi contains the same values shifted by four bits.
+     */
+    static inline lanes_t shuffle_nibbles(const round_tables_t &tables,
+                                          const lanes_t table_lo,
+                                          const lanes_t table_hi,
+                                          const lanes_t state) {
+        const lanes_t mask = tables.lo_nibbles_mask;
+        const lanes_t lo = lanesshuffle(table_lo, lanesand(state, mask));
+        const lanes_t hi = lanesshuffle(
+            table_hi, lanesand(lanesshiftright16(state, 4), mask)
+        );
+        return lanesor(lo, hi);
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline lanes_t encrypt_round(const round_tables_t &tables,
+                                        const lanes_t sbox_lo,
+                                        const lanes_t sbox_hi,
+                                        lanes_t state,
+                                        const lanes_t round_key) {
+        state = shuffle_nibbles(tables, sbox_lo, sbox_hi, state);
+        state = lanesshuffle(state, tables.shift_rows);
+
+        // 2x_i xor 3x_{i+1} xor x_{i+2} xor x_{i+3} for all columns
+        const lanes_t times_two = shuffle_nibbles(
+            tables, tables.times_two_lo, tables.times_two_hi, state
+        );
+        const lanes_t times_three = lanesxor(times_two, state);
+        state = lanesxor(
+            lanesxor(times_two,
+                     lanesshuffle(times_three, tables.rotate_by_one)),
+            lanesxor(lanesshuffle(state, tables.rotate_by_two),
+                     lanesshuffle(state, tables.rotate_by_three))
+        );
+        return lanesxor(state, round_key);
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Converts every lane with the texts A in the low and B in the high
+     * nibbles to the uint64 representations of A and B, in this order.
+     */
+    static inline lanes_t to_uint64_pairs(const round_tables_t &tables,
+                                          const lanes_t state) {
+        const char Z = ZERO_INDEX;
+        const lanes_t evens_lo = lanesbroadcast128(
+            _mm_setr_epi8(14, 12, 10, 8, 6, 4, 2, 0, Z, Z, Z, Z, Z, Z, Z, Z)
+        );
+        const lanes_t odds_lo = lanesbroadcast128(
+            _mm_setr_epi8(15, 13, 11, 9, 7, 5, 3, 1, Z, Z, Z, Z, Z, Z, Z, Z)
+        );
+        const lanes_t evens_hi = lanesbroadcast128(
+            _mm_setr_epi8(Z, Z, Z, Z, Z, Z, Z, Z, 14, 12, 10, 8, 6, 4, 2, 0)
+        );
+        const lanes_t odds_hi = lanesbroadcast128(
+            _mm_setr_epi8(Z, Z, Z, Z, Z, Z, Z, Z, 15, 13, 11, 9, 7, 5, 3, 1)
+        );
+
+        const lanes_t mask = tables.lo_nibbles_mask;
+        const lanes_t lo = lanesand(state, mask);
+        const lanes_t hi = lanesand(lanesshiftright16(state, 4), mask);
+
+        // Bytes hold at most 0x0F, so that the 16-bit shift cannot carry.
+        const lanes_t evens = lanesor(lanesshuffle(lo, evens_lo),
+                                      lanesshuffle(hi, evens_hi));
+        const lanes_t odds = lanesor(lanesshuffle(lo, odds_lo),
+                                     lanesshuffle(hi, odds_hi));
+        return lanesor(lanesshiftleft16(evens, 4), odds);
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Returns the plaintexts a and b in the low and high nibbles of every
+     * lane.
+     */
+    static inline lanes_t to_text_pair(const uint64_t a, const uint64_t b) {
+        const __m128i x = utils::convert_from_uint64(a);
+        const __m128i y = utils::convert_from_uint64(b);
+        return lanesbroadcast128(vor(x, vshiftleft16(y, 4)));
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline lanes_t load_round_key(const small_aes_multi_key_ctx_t *ctx,
+                                         const size_t round,
+                                         const size_t vector_index) {
+        return lanesload(ctx->round_keys[round][vector_index * NUM_LANES]);
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline size_t get_num_vectors(const small_aes_multi_key_ctx_t *ctx) {
+        return (ctx->num_keys + NUM_LANES - 1) / NUM_LANES;
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Encrypts num_pairs <= NUM_TEXT_PAIRS text pairs, where texts[p] holds
+     * the texts first_text + 2p and first_text + 2p + 1, under all keys.
+     * Stores the ciphertext of the text j under the key k to
+     * ciphertexts[k * num_texts + j] if j < num_texts.
+     */
+    static void encrypt_text_pairs(const small_aes_multi_key_ctx_t *ctx,
+                                   const round_tables_t &tables,
+                                   const lanes_t *texts,
+                                   const size_t num_pairs,
+                                   const size_t first_text,
+                                   const size_t num_texts,
+                                   uint64_t *ciphertexts,
+                                   const size_t num_rounds,
+                                   const bool has_only_sbox_in_final) {
+        ALIGN(64) uint64_t words[2 * NUM_LANES];
+        lanes_t states[NUM_TEXT_PAIRS];
+
+        for (size_t v = 0; v < get_num_vectors(ctx); ++v) {
+            // S-box values are at most 0x0F, so that the shift cannot carry.
+            const lanes_t sbox_lo = lanesload(ctx->sboxes[v * NUM_LANES]);
+            const lanes_t sbox_hi = lanesshiftleft16(sbox_lo, 4);
+            lanes_t round_key = load_round_key(ctx, 0, v);
+
+            for (size_t p = 0; p < num_pairs; ++p) {
+                states[p] = lanesxor(texts[p], round_key);
+            }
+
+            for (size_t i = 1; i < num_rounds; ++i) {
+                round_key = load_round_key(ctx, i, v);
+
+                for (size_t p = 0; p < num_pairs; ++p) {
+                    states[p] = encrypt_round(tables, sbox_lo, sbox_hi,
+                                              states[p], round_key);
+                }
+            }
+
+            round_key = load_round_key(ctx, num_rounds, v);
+
+            for (size_t p = 0; p < num_pairs; ++p) {
+                lanes_t state = shuffle_nibbles(tables, sbox_lo, sbox_hi,
+                                                states[p]);
+
+                if (!has_only_sbox_in_final) {
+                    state = lanesshuffle(state, tables.shift_rows);
+                }
+
+                state = lanesxor(state, round_key);
+                lanesstore(words, to_uint64_pairs(tables, state));
+
+                const size_t j = first_text + 2 * p;
+                const bool has_second_text = (j + 1) < num_texts;
+
+                for (size_t l = 0; l < NUM_LANES; ++l) {
+                    const size_t k = v * NUM_LANES + l;
+
+                    if (k >= ctx->num_keys) {
+                        break;
+                    }
+
+                    uint64_t *target = ciphertexts + k * num_texts + j;
+
+                    if (has_second_text) {
+                        storeu(target, load(&words[2 * l]));
+                    } else {
+                        target[0] = words[2 * l];
+                    }
+                }
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    static void encrypt_texts(const small_aes_multi_key_ctx_t *ctx,
+                              const uint64_t *plaintexts,
+                              const size_t num_texts,
+                              uint64_t *ciphertexts,
+                              const size_t num_rounds,
+                              const bool has_only_sbox_in_final) {
+        if ((num_rounds == 0) || (num_rounds > SMALL_AES_NUM_ROUNDS)) {
+            return;
+        }
+
+        round_tables_t tables;
+        init_round_tables(&tables);
+        lanes_t texts[NUM_TEXT_PAIRS];
+
+        for (size_t j = 0; j < num_texts; j += 2 * NUM_TEXT_PAIRS) {
+            size_t num_pairs = 0;
+
+            for (size_t t = j; (t < num_texts) && (num_pairs < NUM_TEXT_PAIRS);
+                 t += 2) {
+                const uint64_t b = (t + 1 < num_texts) ? plaintexts[t + 1] : 0;
+                texts[num_pairs] = to_text_pair(plaintexts[t], b);
+                num_pairs++;
+            }
+
+            encrypt_text_pairs(ctx, tables, texts, num_pairs, j, num_texts,
+                               ciphertexts, num_rounds,
+                               has_only_sbox_in_final);
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Computes the next round key of every lane as generate_round_key() in
+     * small_aes.cc. The round constant rcon is the same for all lanes.
+     */
+    static lanes_t generate_round_keys(const round_tables_t &tables,
+                                       const lanes_t k,
+                                       const uint8_t rcon) {
+        const lanes_t rotate_last_column = lanesbroadcast128(
+            vset8(
+                (uint8_t) 0xff, (uint8_t) 0xff, (uint8_t) 0xff, (uint8_t) 0xff,
+                (uint8_t) 0xff, (uint8_t) 0xff, (uint8_t) 0xff, (uint8_t) 0xff,
+                (uint8_t) 0xff, (uint8_t) 0xff, (uint8_t) 0xff, (uint8_t) 0xff,
+                12, 15, 14, 13
+            )
+        );
+
+        lanes_t col0 = lanesshuffle(tables.sbox_lo, k);
+        col0 = lanesshuffle(col0, rotate_last_column);
+        col0 = lanesxor(col0, lanesbroadcast128(vset8_single0(rcon)));
+        col0 = lanesand(lanesxor(k, col0),
+                        lanesbroadcast128(vset32(0xFFFFFFFF, 0, 0, 0)));
+
+        const lanes_t col1 = lanesand(
+            lanesxor(lanesshiftleft_bytes(col0, 4), k),
+            lanesbroadcast128(vset32(0, 0xFFFFFFFF, 0, 0))
+        );
+        const lanes_t col2 = lanesand(
+            lanesxor(lanesshiftleft_bytes(col1, 4), k),
+            lanesbroadcast128(vset32(0, 0, 0xFFFFFFFF, 0))
+        );
+        const lanes_t col3 = lanesand(
+            lanesxor(lanesshiftleft_bytes(col2, 4), k),
+            lanesbroadcast128(vset32(0, 0, 0, 0xFFFFFFFF))
+        );
+        return lanesxor(lanesxor(col0, col1), lanesxor(col2, col3));
+    }
+
+    /**
+     * Expands the first round keys in the low nibbles of lanes into all
+     * round keys of ctx.
+     */
+    static void expand_keys(small_aes_multi_key_ctx_t *ctx,
+                            const uint8_t lanes[][16]) {
+        round_tables_t tables;
+        init_round_tables(&tables);
+
+        for (size_t v = 0; v < NUM_VECTORS; ++v) {
+            lanes_t k = lanesload(lanes[v * NUM_LANES]);
+            uint8_t rcon = 1;
+
+            for (size_t i = 0; i < SMALL_AES_NUM_ROUND_KEYS; ++i) {
+                if (i > 0) {
+                    k = generate_round_keys(tables, k, rcon);
+                    rcon = (uint8_t) (((rcon << 1) ^ ((rcon & 8) ? 0x3 : 0))
+                                      & 0xF);
+                }
+
+                lanesstore(ctx->round_keys[i][v * NUM_LANES],
+                           lanesor(k, lanesshiftleft16(k, 4)));
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+    // API
+    // ---------------------------------------------------------------------
+
+    void small_aes_multi_key_key_setup(small_aes_multi_key_ctx_t *ctx,
+                                       const small_aes_key_t *keys,
+                                       const size_t num_keys) {
+        ctx->num_keys = 0;
+
+        if ((num_keys != 2) && (num_keys != 4) && (num_keys != 8)) {
+            return;
+        }
+
+        // The first round keys in the low nibbles
+        ALIGN(64) uint8_t lanes[SMALL_AES_MULTI_KEY_MAX_NUM_KEYS][16];
+
+        for (size_t k = 0; k < SMALL_AES_MULTI_KEY_MAX_NUM_KEYS; ++k) {
+            const size_t key_index = (k < num_keys) ? k : 0;
+            store(lanes[k], to_lower_nibbles(keys[key_index]));
+            store(ctx->sboxes[k], SMALL_AES_SBOX_1);
+        }
+
+        expand_keys(ctx, lanes);
+        ctx->num_keys = num_keys;
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_multi_key_sbox_setup(small_aes_multi_key_ctx_t *ctx,
+                                        const small_aes_key_t key,
+                                        const __m128i *sboxes,
+                                        const size_t num_sboxes) {
+        ctx->num_keys = 0;
+
+        if ((num_sboxes == 0)
+            || (num_sboxes > SMALL_AES_MULTI_KEY_MAX_NUM_KEYS)) {
+            return;
+        }
+
+        ALIGN(64) uint8_t lanes[SMALL_AES_MULTI_KEY_MAX_NUM_KEYS][16];
+        const __m128i first_round_key = to_lower_nibbles(key);
+
+        for (size_t k = 0; k < SMALL_AES_MULTI_KEY_MAX_NUM_KEYS; ++k) {
+            const size_t sbox_index = (k < num_sboxes) ? k : 0;
+            store(lanes[k], first_round_key);
+            store(ctx->sboxes[k], sboxes[sbox_index]);
+        }
+
+        expand_keys(ctx, lanes);
+        ctx->num_keys = num_sboxes;
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_multi_key_encrypt_rounds(
+        const small_aes_multi_key_ctx_t *ctx,
+        const uint64_t *plaintexts,
+        const size_t num_texts,
+        uint64_t *ciphertexts,
+        const size_t num_rounds) {
+        encrypt_texts(ctx, plaintexts, num_texts, ciphertexts, num_rounds,
+                      false);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_multi_key_encrypt_rounds_only_sbox_in_final(
+        const small_aes_multi_key_ctx_t *ctx,
+        const uint64_t *plaintexts,
+        const size_t num_texts,
+        uint64_t *ciphertexts,
+        const size_t num_rounds) {
+        encrypt_texts(ctx, plaintexts, num_texts, ciphertexts, num_rounds,
+                      true);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void small_aes_multi_key_encrypt_diagonal_structure(
+        const small_aes_multi_key_ctx_t *ctx,
+        const size_t structure_index,
+        uint64_t *ciphertexts,
+        const size_t num_rounds) {
+        if ((num_rounds == 0) || (num_rounds > SMALL_AES_NUM_ROUNDS)) {
+            return;
+        }
+
+        const size_t NUM_TEXTS = SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE;
+
+        round_tables_t tables;
+        init_round_tables(&tables);
+
+        // Nibbles 2, 3, 6, 7, 8, 9, 12, 13 from the structure index
+        const uint64_t base = utils::deposit_bits(structure_index,
+                                                  0x00FF00FFFF00FF00L);
+
+        // Blocks of 16 texts share the diagonal nibbles 0, 5, and 10. The
+        // pair p of a block holds 2p and 2p + 1 in the nibble 15.
+        lanes_t differences[NUM_TEXT_PAIRS];
+
+        for (size_t p = 0; p < NUM_TEXT_PAIRS; ++p) {
+            differences[p] = to_text_pair(2 * p, 2 * p + 1);
+        }
+
+        const lanes_t step_0 = lanesbroadcast128(vset8_single0(0x11));
+        const lanes_t step_5 = lanesshiftleft_bytes(step_0, 5);
+        const lanes_t step_10 = lanesshiftleft_bytes(step_0, 10);
+
+        lanes_t text_0 = to_text_pair(base, base);
+        lanes_t texts[NUM_TEXT_PAIRS];
+        size_t j = 0;
+
+        for (size_t i0 = 0; i0 < 16; ++i0) {
+            lanes_t text_5 = text_0;
+
+            for (size_t i1 = 0; i1 < 16; ++i1) {
+                lanes_t text_10 = text_5;
+
+                for (size_t i2 = 0; i2 < 16; ++i2) {
+                    for (size_t p = 0; p < NUM_TEXT_PAIRS; ++p) {
+                        texts[p] = lanesxor(text_10, differences[p]);
+                    }
+
+                    encrypt_text_pairs(ctx, tables, texts, NUM_TEXT_PAIRS, j,
+                                       NUM_TEXTS, ciphertexts, num_rounds,
+                                       true);
+                    j += 2 * NUM_TEXT_PAIRS;
+                    text_10 = lanesadd8(text_10, step_10);
+                }
+
+                text_5 = lanesadd8(text_5, step_5);
+            }
+
+            text_0 = lanesadd8(text_0, step_0);
+        }
+    }
+
+}
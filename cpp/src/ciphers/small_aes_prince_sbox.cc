@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 
+#include "ciphers/small_aes_cipher.h"
 #include "ciphers/small_aes_prince_sbox.h"
 #include "utils/utils.h"
 
@@ -18,19 +19,7 @@
 
 namespace ciphers {
 
-    __m128i small_aes_prince_sbox_sub_bytes(__m128i state) {
-        return vshuffle(SMALL_AES_PRINCE_SBOX, state);
-    }
-
-    // ---------------------------------------------------------------------
-
-    __m128i small_aes_prince_sbox_encrypt_round(__m128i state,
-                                                 const __m128i round_key) {
-        state = small_aes_prince_sbox_sub_bytes(state);
-        state = small_aes_shift_rows(state);
-        state = small_aes_mix_columns(state);
-        return vxor(state, round_key);
-    }
+    typedef SmallAesPrinceSBoxCipher Variant;
 
     // ---------------------------------------------------------------------
 
@@ -39,22 +28,8 @@ namespace ciphers {
         const small_aes_state_t plaintext,
         small_aes_state_t ciphertext,
         const size_t num_rounds) {
-
-        if (num_rounds > SMALL_AES_NUM_ROUNDS) {
-            return;
-        }
-
-        __m128i state = to_lower_nibbles(plaintext);
-        state = vxor(state, ctx->key[0]);
-
-        for (size_t i = 1; i < num_rounds; ++i) {
-            state = small_aes_prince_sbox_encrypt_round(state, ctx->key[i]);
-        }
-
-        state = small_aes_prince_sbox_sub_bytes(state);
-        state = vxor(state, ctx->key[num_rounds]);
-
-        to_byte_array(ciphertext, state);
+        Variant::encrypt_rounds_only_sbox_in_final(ctx, plaintext, ciphertext,
+                                                   num_rounds);
     }
 
     // ---------------------------------------------------------------------
@@ -64,15 +39,9 @@ namespace ciphers {
         const small_aes_ctx_t *ctx,
         __m128i plaintext,
         const size_t num_rounds) {
-
-        __m128i state = vxor(plaintext, ctx->key[0]);
-
-        for (size_t i = 1; i < num_rounds; ++i) {
-            state = small_aes_prince_sbox_encrypt_round(state, ctx->key[i]);
-        }
-
-        state = small_aes_prince_sbox_sub_bytes(state);
-        return vxor(state, ctx->key[num_rounds]);
+        return Variant::encrypt_rounds_only_sbox_in_final_with_aes_ni(
+            ctx, plaintext, num_rounds
+        );
     }
 
     // ---------------------------------------------------------------------
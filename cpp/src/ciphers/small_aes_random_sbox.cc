@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 
+#include "ciphers/small_aes_cipher.h"
 #include "ciphers/small_aes_random_sbox.h"
 #include "utils/utils.h"
 
@@ -75,12 +76,15 @@ namespace ciphers {
             return plaintext;
         }
 
+        const __m128i sbox_map = small_aes_aes_ni_sbox_map(
+            SMALL_AES_RANDOM_SBOXES[sbox_index]
+        );
         __m128i state = vxor(plaintext, ctx->key[0]);
 
         for (size_t i = 1; i < num_rounds; ++i) {
-            state = small_aes_random_sbox_encrypt_round(state,
+            state = small_aes_encrypt_round_with_aes_ni(state,
                                                         ctx->key[i],
-                                                        sbox_index);
+                                                        sbox_map);
         }
 
         state = small_aes_random_sbox_sub_bytes(state, sbox_index);
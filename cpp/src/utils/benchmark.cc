@@ -0,0 +1,302 @@
+/**
+ * A small harness to measure the throughput of the kernels, with results
+ * in cycles per byte and states per second, printable as JSON.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "utils/benchmark.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    static const size_t MAX_NUM_ITERATIONS = 1UL << 40;
+
+    // ---------------------------------------------------------------------
+
+    double get_cycles_per_byte(const BenchmarkResult &result) {
+        const double num_bytes = (double) result.num_iterations
+                                 * result.num_states_per_iteration
+                                 * result.num_bytes_per_state;
+        return (num_bytes == 0) ? 0.0 : (double) result.num_cycles / num_bytes;
+    }
+
+    // ---------------------------------------------------------------------
+
+    double get_states_per_second(const BenchmarkResult &result) {
+        const double num_states = (double) result.num_iterations
+                                  * result.num_states_per_iteration;
+        return (result.num_seconds == 0)
+               ? 0.0 : num_states / result.num_seconds;
+    }
+
+    // ---------------------------------------------------------------------
+
+    std::string to_json_string(const std::string &value) {
+        std::string result = "\"";
+
+        for (size_t i = 0; i < value.size(); ++i) {
+            const char c = value[i];
+
+            if ((c == '"') || (c == '\\')) {
+                result += '\\';
+                result += c;
+            } else if ((unsigned char) c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x",
+                         (unsigned int) c);
+                result += escaped;
+            } else {
+                result += c;
+            }
+        }
+
+        return result + "\"";
+    }
+
+    // ---------------------------------------------------------------------
+
+    void print_benchmark_table_header(FILE *file) {
+        fprintf(file, "# %-78s %12s %10s %14s\n",
+                "Benchmark", "Iterations", "cycles/B", "states/s");
+    }
+
+    // ---------------------------------------------------------------------
+
+    void print_benchmark_table_row(FILE *file, const BenchmarkResult &result) {
+        fprintf(file, "%-80s %12zu %10.3f %14.4e\n",
+                result.name.c_str(),
+                result.num_iterations,
+                get_cycles_per_byte(result),
+                get_states_per_second(result));
+    }
+
+    // ---------------------------------------------------------------------
+
+    static std::string get_cpu_name() {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+
+        while (std::getline(cpuinfo, line)) {
+            if (line.compare(0, 10, "model name") != 0) {
+                continue;
+            }
+
+            const size_t colon = line.find(':');
+
+            if ((colon != std::string::npos) && (colon + 2 <= line.size())) {
+                return line.substr(colon + 2);
+            }
+        }
+
+        return "unknown";
+    }
+
+    // ---------------------------------------------------------------------
+
+    static std::string get_host_name() {
+        char name[256];
+
+        if (gethostname(name, sizeof(name)) != 0) {
+            return "unknown";
+        }
+
+        name[sizeof(name) - 1] = '\0';
+        return name;
+    }
+
+    // ---------------------------------------------------------------------
+
+    static std::string get_date() {
+        char date[32];
+        const time_t now = time(NULL);
+        struct tm local_time;
+        localtime_r(&now, &local_time);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", &local_time);
+        return date;
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * The vector extensions the kernels were compiled for, which select
+     * their code paths.
+     */
+    static std::string get_isa_extensions() {
+        std::string extensions = "sse4.1";
+#if defined(__AES__)
+        extensions += " aes";
+#endif
+#if defined(__AVX2__)
+        extensions += " avx2";
+#endif
+#if defined(__AVX512F__)
+        extensions += " avx512f";
+#endif
+#if defined(__VAES__)
+        extensions += " vaes";
+#endif
+        return extensions;
+    }
+
+    // ---------------------------------------------------------------------
+    // BenchmarkRunner
+    // ---------------------------------------------------------------------
+
+    BenchmarkRunner::BenchmarkRunner(const double min_seconds,
+                                     const size_t num_repetitions) :
+        min_seconds(min_seconds),
+        num_repetitions(num_repetitions) {
+
+    }
+
+    // ---------------------------------------------------------------------
+
+    BenchmarkResult
+    BenchmarkRunner::measure(const std::string &name,
+                             const size_t num_states_per_iteration,
+                             const size_t num_bytes_per_state,
+                             const size_t num_iterations,
+                             const benchmark_function_t &function) const {
+        BenchmarkResult result;
+        result.name = name;
+        result.num_iterations = num_iterations;
+        result.num_states_per_iteration = num_states_per_iteration;
+        result.num_bytes_per_state = num_bytes_per_state;
+
+        const clock_t start_cpu_time = clock();
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t start_cycles = read_cycle_counter();
+        function(num_iterations);
+        const uint64_t end_cycles = read_cycle_counter();
+        const auto end = std::chrono::steady_clock::now();
+        const clock_t end_cpu_time = clock();
+
+        const std::chrono::duration<double> elapsed_seconds = end - start;
+        result.num_seconds = elapsed_seconds.count();
+        result.num_cpu_seconds =
+            (double) (end_cpu_time - start_cpu_time) / CLOCKS_PER_SEC;
+        result.num_cycles = end_cycles - start_cycles;
+        return result;
+    }
+
+    // ---------------------------------------------------------------------
+
+    const BenchmarkResult &
+    BenchmarkRunner::run(const std::string &name,
+                         const size_t num_states_per_iteration,
+                         const size_t num_bytes_per_state,
+                         const benchmark_function_t &function) {
+        size_t num_iterations = 1;
+        BenchmarkResult result = measure(
+            name, num_states_per_iteration, num_bytes_per_state,
+            num_iterations, function
+        );
+
+        while ((result.num_seconds < min_seconds)
+               && (num_iterations < MAX_NUM_ITERATIONS)) {
+            num_iterations *= 2;
+            result = measure(name, num_states_per_iteration,
+                             num_bytes_per_state, num_iterations, function);
+        }
+
+        for (size_t i = 1; i < num_repetitions; ++i) {
+            const BenchmarkResult repetition = measure(
+                name, num_states_per_iteration, num_bytes_per_state,
+                num_iterations, function
+            );
+
+            if (repetition.num_cycles < result.num_cycles) {
+                result = repetition;
+            }
+        }
+
+        results.push_back(result);
+        return results.back();
+    }
+
+    // ---------------------------------------------------------------------
+
+    void BenchmarkRunner::add_context(const std::string &key,
+                                      const std::string &value) {
+        context.push_back(std::make_pair(key, value));
+    }
+
+    // ---------------------------------------------------------------------
+
+    const std::vector<BenchmarkResult> &BenchmarkRunner::get_results() const {
+        return results;
+    }
+
+    // ---------------------------------------------------------------------
+
+    void BenchmarkRunner::write_json(FILE *file) const {
+        std::vector<std::pair<std::string, std::string> > all_context;
+        all_context.push_back(std::make_pair("date", get_date()));
+        all_context.push_back(std::make_pair("host_name", get_host_name()));
+        all_context.push_back(std::make_pair("cpu_name", get_cpu_name()));
+        all_context.push_back(std::make_pair(
+            "num_cpus", std::to_string(std::thread::hardware_concurrency())
+        ));
+        all_context.push_back(std::make_pair("compiler", __VERSION__));
+        all_context.push_back(std::make_pair("isa_extensions",
+                                             get_isa_extensions()));
+        all_context.push_back(std::make_pair("min_seconds",
+                                             std::to_string(min_seconds)));
+        all_context.push_back(std::make_pair(
+            "num_repetitions", std::to_string(num_repetitions)
+        ));
+        all_context.insert(all_context.end(), context.begin(), context.end());
+
+        fprintf(file, "{\n  \"context\": {\n");
+
+        for (size_t i = 0; i < all_context.size(); ++i) {
+            fprintf(file, "    %s: %s%s\n",
+                    to_json_string(all_context[i].first).c_str(),
+                    to_json_string(all_context[i].second).c_str(),
+                    (i + 1 < all_context.size()) ? "," : "");
+        }
+
+        fprintf(file, "  },\n  \"benchmarks\": [\n");
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchmarkResult &result = results[i];
+            const double num_iterations = (double) result.num_iterations;
+
+            fprintf(file, "    {\n");
+            fprintf(file, "      \"name\": %s,\n",
+                    to_json_string(result.name).c_str());
+            fprintf(file, "      \"iterations\": %zu,\n",
+                    result.num_iterations);
+            fprintf(file, "      \"real_time\": %.6e,\n",
+                    result.num_seconds * 1e9 / num_iterations);
+            fprintf(file, "      \"cpu_time\": %.6e,\n",
+                    result.num_cpu_seconds * 1e9 / num_iterations);
+            fprintf(file, "      \"time_unit\": \"ns\",\n");
+            fprintf(file, "      \"states_per_iteration\": %zu,\n",
+                    result.num_states_per_iteration);
+            fprintf(file, "      \"bytes_per_state\": %zu,\n",
+                    result.num_bytes_per_state);
+            fprintf(file, "      \"cycles\": %llu,\n",
+                    (unsigned long long) result.num_cycles);
+            fprintf(file, "      \"cycles_per_byte\": %.6e,\n",
+                    get_cycles_per_byte(result));
+            fprintf(file, "      \"states_per_second\": %.6e\n",
+                    get_states_per_second(result));
+            fprintf(file, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+        }
+
+        fprintf(file, "  ]\n}\n");
+    }
+
+}
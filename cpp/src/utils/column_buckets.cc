@@ -0,0 +1,71 @@
+/**
+ * Flat bucket storage of Small-AES texts by the value of a ciphertext column.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <string.h>
+
+#include <stdexcept>
+
+#include "utils/column_buckets.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    static const size_t NUM_COLUMN_VALUES = COLUMN_BUCKETS_NUM_COLUMN_VALUES;
+
+    // ---------------------------------------------------------------------
+
+    ColumnBuckets::ColumnBuckets()
+        : offsets(NUM_COLUMN_VALUES + 1, 0),
+          entries(NUM_COLUMN_VALUES, 0),
+          column_index(0) {}
+
+    // ---------------------------------------------------------------------
+
+    void ColumnBuckets::fill(const uint64_t *ciphertexts,
+                             const size_t num_texts,
+                             const size_t column_index) {
+        // The text index j must fit into the bucketed column
+        if (num_texts > NUM_COLUMN_VALUES) {
+            throw std::length_error("ColumnBuckets: more than 2^16 texts");
+        }
+
+        this->column_index = column_index;
+
+        const size_t shift = (COLUMN_BUCKETS_NUM_COLUMNS - 1 - column_index)
+                             * 16;
+        const uint64_t column_mask = ~((uint64_t) 0xFFFF << shift);
+        uint32_t *counts = offsets.data() + 1;
+
+        // Histogram of the column values, shifted by one bucket, ...
+        memset(offsets.data(), 0, offsets.size() * sizeof(uint32_t));
+
+        for (size_t j = 0; j < num_texts; ++j) {
+            counts[(ciphertexts[j] >> shift) & 0xFFFF]++;
+        }
+
+        // ... so that its prefix sum yields the begin of every bucket ...
+        for (size_t value = 1; value <= NUM_COLUMN_VALUES; ++value) {
+            offsets[value] += offsets[value - 1];
+        }
+
+        // ... which is moved to its end while scattering. Afterwards,
+        // offsets[value] is the begin of the bucket of value again.
+        for (size_t j = 0; j < num_texts; ++j) {
+            const uint64_t ciphertext = ciphertexts[j];
+            const size_t value = (ciphertext >> shift) & 0xFFFF;
+            entries[offsets[value]++] =
+                (ciphertext & column_mask) | ((uint64_t) j << shift);
+        }
+
+        memmove(offsets.data() + 1, offsets.data(),
+                NUM_COLUMN_VALUES * sizeof(uint32_t));
+        offsets[0] = 0;
+    }
+
+}
@@ -0,0 +1,237 @@
+/**
+ * Counts column collisions among Small-AES states in linear time.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <string.h>
+
+#include <stdexcept>
+
+#include "utils/column_collision_counter.h"
+#include "utils/profiler.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    static const size_t NUM_COLUMNS = COLUMN_COLLISION_COUNTER_NUM_COLUMNS;
+    static const size_t NUM_COLUMN_VALUES =
+        COLUMN_COLLISION_COUNTER_NUM_COLUMN_VALUES;
+    static const size_t NUM_COLUMN_MASKS = 1 << NUM_COLUMNS;
+
+    // ---------------------------------------------------------------------
+
+    static inline size_t extract_column(const uint64_t state,
+                                        const size_t column_index) {
+        const size_t shift = (NUM_COLUMNS - 1 - column_index) * 16;
+        return (state >> shift) & 0xFFFF;
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline size_t to_column_bit(const size_t column_index) {
+        return (size_t) 1 << (NUM_COLUMNS - 1 - column_index);
+    }
+
+    // ---------------------------------------------------------------------
+
+    static inline size_t count_pairs(const size_t num_texts) {
+        return (num_texts * (num_texts - 1)) / 2;
+    }
+
+    // ---------------------------------------------------------------------
+
+    ColumnCollisionCounter::ColumnCollisionCounter(const size_t max_num_texts)
+        : histograms(NUM_COLUMNS * NUM_COLUMN_VALUES, 0),
+          bucket_ends(NUM_COLUMN_VALUES, 0),
+          buckets(max_num_texts, 0),
+          max_num_texts(max_num_texts) {
+        memset(num_pairs_colliding_in, 0, sizeof(num_pairs_colliding_in));
+    }
+
+    // ---------------------------------------------------------------------
+
+    void ColumnCollisionCounter::build_histograms(const uint64_t *texts,
+                                                  const size_t num_texts) {
+        memset(histograms.data(), 0, histograms.size() * sizeof(uint32_t));
+        uint32_t *histogram_0 = histograms.data();
+        uint32_t *histogram_1 = histogram_0 + NUM_COLUMN_VALUES;
+        uint32_t *histogram_2 = histogram_1 + NUM_COLUMN_VALUES;
+        uint32_t *histogram_3 = histogram_2 + NUM_COLUMN_VALUES;
+
+        for (size_t i = 0; i < num_texts; ++i) {
+            const uint64_t text = texts[i];
+            histogram_0[extract_column(text, 0)]++;
+            histogram_1[extract_column(text, 1)]++;
+            histogram_2[extract_column(text, 2)]++;
+            histogram_3[extract_column(text, 3)]++;
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Counting sort of all texts whose value in the given column occurs at
+     * least twice. Afterwards, the texts with column value v are stored in
+     * buckets[bucket_ends[v] - histogram[v], bucket_ends[v]).
+     */
+    void ColumnCollisionCounter::scatter_to_buckets(const uint64_t *texts,
+                                                    const size_t num_texts,
+                                                    const size_t column_index) {
+        const uint32_t *histogram =
+            histograms.data() + column_index * NUM_COLUMN_VALUES;
+        uint32_t offset = 0;
+
+        for (size_t value = 0; value < NUM_COLUMN_VALUES; ++value) {
+            bucket_ends[value] = offset;
+
+            if (histogram[value] > 1) {
+                offset += histogram[value];
+            }
+        }
+
+        for (size_t i = 0; i < num_texts; ++i) {
+            const uint64_t text = texts[i];
+            const size_t value = extract_column(text, column_index);
+
+            if (histogram[value] > 1) {
+                buckets[bucket_ends[value]++] = text;
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * All texts in a bucket collide in column_index. Adds every pair of them
+     * to N_S for all S = {column_index} u T, where T is a non-empty subset of
+     * the later columns in which the pair also collides. So, every N_S is
+     * counted exactly once: in the buckets of the smallest column in S.
+     */
+    void ColumnCollisionCounter::count_pairs_in_buckets(
+        const size_t column_index) {
+        const uint32_t *histogram =
+            histograms.data() + column_index * NUM_COLUMN_VALUES;
+        const size_t column_bit = to_column_bit(column_index);
+
+        for (size_t value = 0; value < NUM_COLUMN_VALUES; ++value) {
+            const size_t num_texts_in_bucket = histogram[value];
+
+            if (num_texts_in_bucket < 2) {
+                continue;
+            }
+
+            const size_t end = bucket_ends[value];
+            const size_t begin = end - num_texts_in_bucket;
+
+            for (size_t i = begin; i < end; ++i) {
+                const uint64_t first = buckets[i];
+
+                for (size_t j = i + 1; j < end; ++j) {
+                    const uint64_t difference = first ^buckets[j];
+                    size_t colliding_columns_mask = 0;
+
+                    for (size_t k = column_index + 1; k < NUM_COLUMNS; ++k) {
+                        if (extract_column(difference, k) == 0) {
+                            colliding_columns_mask |= to_column_bit(k);
+                        }
+                    }
+
+                    // Enumerate all non-empty subsets T of the mask
+                    for (size_t subset = colliding_columns_mask;
+                         subset != 0;
+                         subset = (subset - 1) & colliding_columns_mask) {
+                        num_pairs_colliding_in[column_bit | subset]++;
+                    }
+                }
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    ColumnCollisions ColumnCollisionCounter::count(const uint64_t *texts,
+                                                   const size_t num_texts) {
+        if (num_texts > max_num_texts) {
+            throw std::length_error(
+                "ColumnCollisionCounter: more texts than max_num_texts"
+            );
+        }
+
+        memset(num_pairs_colliding_in, 0, sizeof(num_pairs_colliding_in));
+
+        {
+            PROFILE_PHASE(PROFILER_PHASE_BUCKETING);
+            build_histograms(texts, num_texts);
+        }
+
+        for (size_t column_index = 0;
+             column_index < NUM_COLUMNS;
+             ++column_index) {
+            PROFILE_PHASE(PROFILER_PHASE_COLLISION_COUNTING);
+            const uint32_t *histogram =
+                histograms.data() + column_index * NUM_COLUMN_VALUES;
+            size_t num_pairs = 0;
+
+            for (size_t value = 0; value < NUM_COLUMN_VALUES; ++value) {
+                if (histogram[value] > 1) {
+                    num_pairs += count_pairs(histogram[value]);
+                }
+            }
+
+            num_pairs_colliding_in[to_column_bit(column_index)] = num_pairs;
+        }
+
+        // The last column has no later columns to combine with
+        for (size_t column_index = 0;
+             column_index < NUM_COLUMNS - 1;
+             ++column_index) {
+            {
+                PROFILE_PHASE(PROFILER_PHASE_BUCKETING);
+                scatter_to_buckets(texts, num_texts, column_index);
+            }
+
+            PROFILE_PHASE(PROFILER_PHASE_COLLISION_COUNTING);
+            count_pairs_in_buckets(column_index);
+        }
+
+        // Inclusion-exclusion: |u_i A_i| = sum_S (-1)^(|S| + 1) N_S
+        size_t num_single_column_pairs = 0;
+        int64_t num_collisions = 0;
+
+        for (size_t mask = 1; mask < NUM_COLUMN_MASKS; ++mask) {
+            const int64_t num_pairs = (int64_t) num_pairs_colliding_in[mask];
+
+            if (__builtin_popcountl(mask) & 1) {
+                num_collisions += num_pairs;
+            } else {
+                num_collisions -= num_pairs;
+            }
+
+            if (__builtin_popcountl(mask) == 1) {
+                num_single_column_pairs += num_pairs;
+            }
+        }
+
+        ColumnCollisions result;
+        result.num_collisions = (size_t) num_collisions;
+        result.num_multi_column_collisions =
+            num_single_column_pairs - result.num_collisions;
+        return result;
+    }
+
+    // ---------------------------------------------------------------------
+
+    size_t ColumnCollisionCounter::get_num_pairs_colliding_in(
+        const size_t column_mask) const {
+        if ((column_mask == 0) || (column_mask >= NUM_COLUMN_MASKS)) {
+            return 0;
+        }
+
+        return num_pairs_colliding_in[column_mask];
+    }
+
+}
@@ -0,0 +1,279 @@
+/**
+ * Compact, serializable form of the hash tables for the key recovery.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils/compact_hash_table.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    static size_t get_num_offsets(const size_t num_tables,
+                                  const size_t num_alphas) {
+        return num_tables * (num_alphas + 1);
+    }
+
+    // ---------------------------------------------------------------------
+
+    static size_t get_num_bytes(const size_t num_tables,
+                                const size_t num_alphas,
+                                const size_t num_diagonals) {
+        return sizeof(CompactHashTableHeader)
+               + get_num_offsets(num_tables, num_alphas) * sizeof(uint32_t)
+               + num_diagonals * sizeof(uint16_t);
+    }
+
+    // ---------------------------------------------------------------------
+
+    static bool has_sbox(const CompactHashTableHeader *header,
+                         const size_t *sbox,
+                         const size_t num_sbox_entries) {
+        if (num_sbox_entries > COMPACT_HASH_TABLE_MAX_SBOX_SIZE) {
+            return false;
+        }
+
+        for (size_t i = 0; i < COMPACT_HASH_TABLE_MAX_SBOX_SIZE; ++i) {
+            const uint8_t value =
+                (i < num_sbox_entries) ? (uint8_t) sbox[i] : 0;
+
+            if (header->sbox[i] != value) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // ---------------------------------------------------------------------
+
+    static uint16_t to_diagonal(const IntegerList &cells) {
+        return (uint16_t) (((cells[0] & 0xF) << 12)
+                           | ((cells[1] & 0xF) << 8)
+                           | ((cells[2] & 0xF) << 4)
+                           | (cells[3] & 0xF));
+    }
+
+    // ---------------------------------------------------------------------
+
+    CompactHashTables::CompactHashTables()
+        : mapped_data(NULL),
+          mapped_size(0),
+          header(NULL),
+          offsets(NULL),
+          diagonals(NULL) {}
+
+    // ---------------------------------------------------------------------
+
+    CompactHashTables::~CompactHashTables() {
+        release();
+    }
+
+    // ---------------------------------------------------------------------
+
+    void CompactHashTables::release() {
+        if (mapped_data != NULL) {
+            munmap(mapped_data, mapped_size);
+            mapped_data = NULL;
+            mapped_size = 0;
+        }
+
+        buffer.clear();
+        buffer.shrink_to_fit();
+        header = NULL;
+        offsets = NULL;
+        diagonals = NULL;
+    }
+
+    // ---------------------------------------------------------------------
+
+    bool CompactHashTables::set_pointers(const uint8_t *data,
+                                         const size_t num_bytes) {
+        if (num_bytes < sizeof(CompactHashTableHeader)) {
+            return false;
+        }
+
+        const CompactHashTableHeader *data_header =
+            (const CompactHashTableHeader *) data;
+
+        if ((data_header->magic != COMPACT_HASH_TABLE_MAGIC)
+            || (data_header->version != COMPACT_HASH_TABLE_VERSION)
+            || (data_header->num_alphas != COMPACT_HASH_TABLE_NUM_ALPHAS)) {
+            return false;
+        }
+
+        const size_t num_offsets = get_num_offsets(data_header->num_tables,
+                                                   data_header->num_alphas);
+
+        if (num_bytes != get_num_bytes(data_header->num_tables,
+                                       data_header->num_alphas,
+                                       data_header->num_diagonals)) {
+            return false;
+        }
+
+        header = data_header;
+        offsets = (const uint32_t *) (data + sizeof(CompactHashTableHeader));
+        diagonals = (const uint16_t *) (offsets + num_offsets);
+        return true;
+    }
+
+    // ---------------------------------------------------------------------
+
+    void CompactHashTables::build(const std::vector<ExtendedDDT> &hash_tables,
+                                  const size_t *sbox,
+                                  const size_t num_sbox_entries) {
+        release();
+
+        const size_t num_tables = hash_tables.size();
+        const size_t num_alphas = COMPACT_HASH_TABLE_NUM_ALPHAS;
+        size_t num_diagonals = 0;
+
+        for (const ExtendedDDT &hash_table : hash_tables) {
+            for (const IntegerMatrix &transitions : hash_table) {
+                num_diagonals += transitions.size();
+            }
+        }
+
+        buffer.assign(get_num_bytes(num_tables, num_alphas, num_diagonals), 0);
+
+        CompactHashTableHeader *target_header =
+            (CompactHashTableHeader *) buffer.data();
+        target_header->magic = COMPACT_HASH_TABLE_MAGIC;
+        target_header->version = COMPACT_HASH_TABLE_VERSION;
+        target_header->num_tables = (uint32_t) num_tables;
+        target_header->num_alphas = (uint32_t) num_alphas;
+        target_header->num_diagonals = num_diagonals;
+
+        for (size_t i = 0;
+             (i < num_sbox_entries) && (i < COMPACT_HASH_TABLE_MAX_SBOX_SIZE);
+             ++i) {
+            target_header->sbox[i] = (uint8_t) sbox[i];
+        }
+
+        uint32_t *target_offsets =
+            (uint32_t *) (buffer.data() + sizeof(CompactHashTableHeader));
+        uint16_t *target_diagonals =
+            (uint16_t *) (target_offsets + get_num_offsets(num_tables,
+                                                           num_alphas));
+        uint32_t offset = 0;
+
+        for (size_t t = 0; t < num_tables; ++t) {
+            const ExtendedDDT &hash_table = hash_tables[t];
+            uint32_t *table_offsets = target_offsets + t * (num_alphas + 1);
+
+            for (size_t alpha = 0; alpha < num_alphas; ++alpha) {
+                table_offsets[alpha] = offset;
+
+                if (alpha >= hash_table.size()) {
+                    continue;
+                }
+
+                for (const IntegerList &cells : hash_table[alpha]) {
+                    target_diagonals[offset++] = to_diagonal(cells);
+                }
+            }
+
+            table_offsets[num_alphas] = offset;
+        }
+
+        set_pointers(buffer.data(), buffer.size());
+    }
+
+    // ---------------------------------------------------------------------
+
+    bool CompactHashTables::write_to_file(const std::string &file_name) const {
+        if (is_empty()) {
+            return false;
+        }
+
+        // Write to a temporary file first, so that concurrent runs never
+        // map a partially written file.
+        const std::string temp_file_name = file_name + ".tmp";
+        FILE *file = fopen(temp_file_name.c_str(), "wb");
+
+        if (file == NULL) {
+            return false;
+        }
+
+        const size_t num_bytes = get_num_bytes(header->num_tables,
+                                               header->num_alphas,
+                                               header->num_diagonals);
+        const bool is_written =
+            fwrite(header, 1, num_bytes, file) == num_bytes;
+
+        if ((fclose(file) != 0) || !is_written) {
+            remove(temp_file_name.c_str());
+            return false;
+        }
+
+        return rename(temp_file_name.c_str(), file_name.c_str()) == 0;
+    }
+
+    // ---------------------------------------------------------------------
+
+    bool CompactHashTables::map_from_file(const std::string &file_name,
+                                          const size_t *sbox,
+                                          const size_t num_sbox_entries) {
+        release();
+
+        const int file_descriptor = open(file_name.c_str(), O_RDONLY);
+
+        if (file_descriptor < 0) {
+            return false;
+        }
+
+        struct stat file_status;
+
+        if ((fstat(file_descriptor, &file_status) != 0)
+            || (file_status.st_size <= 0)) {
+            close(file_descriptor);
+            return false;
+        }
+
+        const size_t num_bytes = (size_t) file_status.st_size;
+        void *data = mmap(NULL, num_bytes, PROT_READ, MAP_PRIVATE,
+                          file_descriptor, 0);
+        close(file_descriptor);
+
+        if (data == MAP_FAILED) {
+            return false;
+        }
+
+        mapped_data = data;
+        mapped_size = num_bytes;
+
+        if (!set_pointers((const uint8_t *) data, num_bytes)
+            || !has_sbox(header, sbox, num_sbox_entries)) {
+            release();
+            return false;
+        }
+
+        return true;
+    }
+
+    // ---------------------------------------------------------------------
+
+    std::string get_compact_hash_table_file_name(const size_t *sbox,
+                                                 const size_t num_sbox_entries) {
+        std::string file_name = "hash_tables_";
+        char digit[2];
+
+        for (size_t i = 0; i < num_sbox_entries; ++i) {
+            snprintf(digit, sizeof(digit), "%01zx", sbox[i] & 0xF);
+            file_name += digit;
+        }
+
+        return file_name + ".bin";
+    }
+
+}
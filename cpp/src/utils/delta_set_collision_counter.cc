@@ -0,0 +1,131 @@
+/**
+ * Counts collisions among the 16 packed Small-AES states of a delta set.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "utils/delta_set_collision_counter.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    static const size_t NUM_TEXTS = DELTA_SET_COLLISION_COUNTER_NUM_TEXTS;
+
+    // ---------------------------------------------------------------------
+
+    const uint64_t COLUMN_MASKS[DELTA_SET_COLLISION_COUNTER_NUM_COLUMNS] = {
+        0xFFFF000000000000ULL,
+        0x0000FFFF00000000ULL,
+        0x00000000FFFF0000ULL,
+        0x000000000000FFFFULL
+    };
+
+    // ---------------------------------------------------------------------
+
+#if defined(__AVX2__)
+
+    /**
+     * Bit j is set iff texts[j] collides with the broadcast text in at least
+     * one of the masks.
+     */
+    static inline size_t get_colliding_texts(const __m256i texts[4],
+                                             const __m256i text,
+                                             const uint64_t *masks,
+                                             const size_t num_masks) {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i differences[4];
+        __m256i collisions[4];
+
+        for (size_t k = 0; k < 4; ++k) {
+            differences[k] = _mm256_xor_si256(texts[k], text);
+            collisions[k] = zero;
+        }
+
+        for (size_t m = 0; m < num_masks; ++m) {
+            const __m256i mask = _mm256_set1_epi64x((long long) masks[m]);
+
+            for (size_t k = 0; k < 4; ++k) {
+                collisions[k] = _mm256_or_si256(
+                    collisions[k],
+                    _mm256_cmpeq_epi64(_mm256_and_si256(differences[k], mask),
+                                       zero)
+                );
+            }
+        }
+
+        size_t result = 0;
+
+        for (size_t k = 0; k < 4; ++k) {
+            result |= (size_t) _mm256_movemask_pd(
+                _mm256_castsi256_pd(collisions[k])
+            ) << (4 * k);
+        }
+
+        return result;
+    }
+
+    // ---------------------------------------------------------------------
+
+    size_t count_delta_set_collisions(const uint64_t texts[NUM_TEXTS],
+                                      const uint64_t *masks,
+                                      const size_t num_masks) {
+        __m256i text_vectors[4];
+
+        for (size_t k = 0; k < 4; ++k) {
+            text_vectors[k] = _mm256_loadu_si256(
+                (const __m256i *) (texts + 4 * k)
+            );
+        }
+
+        size_t num_collisions = 0;
+
+        for (size_t i = 0; i < NUM_TEXTS - 1; ++i) {
+            // Counts only the pairs (i, j) with j > i
+            const size_t later_texts = (0xFFFFUL << (i + 1)) & 0xFFFF;
+            const size_t colliding = get_colliding_texts(
+                text_vectors,
+                _mm256_set1_epi64x((long long) texts[i]),
+                masks,
+                num_masks
+            );
+            num_collisions += (size_t) __builtin_popcountll(
+                colliding & later_texts
+            );
+        }
+
+        return num_collisions;
+    }
+
+#else
+
+    size_t count_delta_set_collisions(const uint64_t texts[NUM_TEXTS],
+                                      const uint64_t *masks,
+                                      const size_t num_masks) {
+        size_t num_collisions = 0;
+
+        for (size_t i = 0; i < NUM_TEXTS; ++i) {
+            for (size_t j = i + 1; j < NUM_TEXTS; ++j) {
+                const uint64_t difference = texts[i] ^ texts[j];
+
+                for (size_t m = 0; m < num_masks; ++m) {
+                    if ((difference & masks[m]) == 0) {
+                        num_collisions++;
+                        break;
+                    }
+                }
+            }
+        }
+
+        return num_collisions;
+    }
+
+#endif
+
+}
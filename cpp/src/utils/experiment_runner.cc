@@ -0,0 +1,242 @@
+/**
+ * Runs the experiments of the distinguishers on multiple threads.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <atomic>
+#include <thread>
+
+#include "utils/experiment_runner.h"
+#include "utils/profiler.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    size_t get_num_available_threads() {
+        const size_t num_threads = std::thread::hardware_concurrency();
+        return (num_threads == 0) ? 1 : num_threads;
+    }
+
+    // ---------------------------------------------------------------------
+
+    void run_in_parallel(const size_t num_tasks,
+                         size_t num_threads,
+                         const parallel_function_t &function) {
+        if (num_threads > num_tasks) {
+            num_threads = num_tasks;
+        }
+
+        if (num_threads <= 1) {
+            for (size_t i = 0; i < num_tasks; ++i) {
+                function(i, 0);
+            }
+
+            return;
+        }
+
+        std::atomic<size_t> next_task_index(0);
+        std::vector<std::thread> threads;
+
+        for (size_t thread_index = 0;
+             thread_index < num_threads;
+             ++thread_index) {
+            threads.push_back(std::thread(
+                [&next_task_index, &function, num_tasks, thread_index]() {
+                    size_t task_index = next_task_index++;
+
+                    while (task_index < num_tasks) {
+                        function(task_index, thread_index);
+                        task_index = next_task_index++;
+                    }
+                }
+            ));
+        }
+
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    static size_t get_num_tasks_per_key(const size_t num_sets_per_key,
+                                        const size_t num_sets_per_task) {
+        return (num_sets_per_key + num_sets_per_task - 1) / num_sets_per_task;
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * The sets of the task with index task_index, where the tasks of a key
+     * follow those of the previous key.
+     */
+    static ExperimentTask get_task(const size_t task_index,
+                                   const size_t num_sets_per_key,
+                                   const size_t num_sets_per_task) {
+        const size_t num_tasks_per_key = get_num_tasks_per_key(
+            num_sets_per_key, num_sets_per_task
+        );
+        ExperimentTask task;
+        task.key_index = task_index / num_tasks_per_key;
+        task.first_set_index =
+            (task_index % num_tasks_per_key) * num_sets_per_task;
+        task.num_sets = num_sets_per_key - task.first_set_index;
+        task.thread_index = 0;
+        task.prng = NULL;
+
+        if (task.num_sets > num_sets_per_task) {
+            task.num_sets = num_sets_per_task;
+        }
+
+        return task;
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Runs the tasks [first_task_index, first_task_index + num_tasks) and
+     * stores their numbers of collisions in num_collisions_per_task.
+     * Splits the task streams off prng in the order of the tasks.
+     */
+    static void run_tasks_in_parallel(IntegerList &num_collisions_per_task,
+                                      const size_t first_task_index,
+                                      const size_t num_tasks,
+                                      const size_t num_sets_per_key,
+                                      const size_t num_sets_per_task,
+                                      const size_t num_threads,
+                                      xorshift_prng_ctx_t *prng,
+                                      const experiment_task_function_t &function) {
+        // Every task writes only its own entry, so no locking is needed and
+        // the reduction by the callers is independent of the scheduling.
+        num_collisions_per_task.assign(num_tasks, 0);
+        std::vector<xorshift_prng_ctx_t> prngs(num_tasks);
+
+        {
+            PROFILE_PHASE(PROFILER_PHASE_RNG);
+
+            for (xorshift_prng_ctx_t &task_prng : prngs) {
+                xorshift1024_split(prng, &task_prng);
+            }
+        }
+
+        run_in_parallel(
+            num_tasks,
+            num_threads,
+            [&](const size_t task_index, const size_t thread_index) {
+                ExperimentTask task = get_task(first_task_index + task_index,
+                                               num_sets_per_key,
+                                               num_sets_per_task);
+                task.thread_index = thread_index;
+                task.prng = &prngs[task_index];
+                num_collisions_per_task[task_index] = function(task);
+            }
+        );
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * Adds the collisions and sets of a finished task to its key.
+     */
+    static void add_task(ExperimentResult &result,
+                         const ExperimentTask &task,
+                         const size_t num_collisions) {
+        if (result.num_collisions_per_set.size() <= task.key_index) {
+            result.num_collisions_per_set.resize(task.key_index + 1, 0);
+            result.num_sets_per_key.resize(task.key_index + 1, 0);
+        }
+
+        result.num_collisions_per_set[task.key_index] += num_collisions;
+        result.num_sets_per_key[task.key_index] += task.num_sets;
+        result.num_collisions += num_collisions;
+    }
+
+    // ---------------------------------------------------------------------
+
+    void run_experiments_in_parallel(ExperimentResult &result,
+                                     const size_t num_keys,
+                                     const size_t num_sets_per_key,
+                                     size_t num_sets_per_task,
+                                     const size_t num_threads,
+                                     xorshift_prng_ctx_t *prng,
+                                     const experiment_task_function_t &function) {
+        if (num_sets_per_task == 0) {
+            num_sets_per_task = 1;
+        }
+
+        const size_t num_tasks = num_keys * get_num_tasks_per_key(
+            num_sets_per_key, num_sets_per_task
+        );
+        IntegerList num_collisions_per_task;
+        run_tasks_in_parallel(num_collisions_per_task, 0, num_tasks,
+                              num_sets_per_key, num_sets_per_task,
+                              num_threads, prng, function);
+
+        result.num_collisions_per_set.assign(num_keys, 0);
+        result.num_sets_per_key.assign(num_keys, 0);
+        result.num_collisions = 0;
+
+        for (size_t i = 0; i < num_tasks; ++i) {
+            add_task(result,
+                     get_task(i, num_sets_per_key, num_sets_per_task),
+                     num_collisions_per_task[i]);
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    void run_experiments_in_parallel(ExperimentResult &result,
+                                     const size_t num_keys,
+                                     const size_t num_sets_per_key,
+                                     size_t num_sets_per_task,
+                                     const size_t num_threads,
+                                     xorshift_prng_ctx_t *prng,
+                                     const experiment_task_function_t &function,
+                                     const stop_function_t &should_stop) {
+        if (num_sets_per_task == 0) {
+            num_sets_per_task = 1;
+        }
+
+        const size_t num_tasks = num_keys * get_num_tasks_per_key(
+            num_sets_per_key, num_sets_per_task
+        );
+        const size_t num_tasks_per_batch = (num_threads == 0) ? 1 : num_threads;
+
+        result.num_collisions_per_set.clear();
+        result.num_sets_per_key.clear();
+        result.num_collisions = 0;
+
+        IntegerList num_collisions_per_task;
+        size_t task_index = 0;
+        bool is_stopped = false;
+
+        while (!is_stopped && (task_index < num_tasks)) {
+            const size_t num_tasks_in_batch =
+                (num_tasks - task_index < num_tasks_per_batch) ?
+                num_tasks - task_index :
+                num_tasks_per_batch;
+
+            run_tasks_in_parallel(num_collisions_per_task, task_index,
+                                  num_tasks_in_batch, num_sets_per_key,
+                                  num_sets_per_task, num_threads, prng,
+                                  function);
+
+            for (size_t i = 0; i < num_tasks_in_batch; ++i) {
+                const ExperimentTask task = get_task(
+                    task_index++, num_sets_per_key, num_sets_per_task
+                );
+                add_task(result, task, num_collisions_per_task[i]);
+
+                if (should_stop(task, num_collisions_per_task[i])) {
+                    is_stopped = true;
+                    break;
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,47 @@
+/**
+ * Counts nibble collisions among Small-AES states for all cells at once.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <string.h>
+
+#include "utils/nibble_collision_counter.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    static const size_t NUM_CELLS = NIBBLE_COLLISION_COUNTER_NUM_CELLS;
+    static const size_t NUM_CELL_VALUES =
+        NIBBLE_COLLISION_COUNTER_NUM_CELL_VALUES;
+
+    // ---------------------------------------------------------------------
+
+    void count_nibble_collisions(const uint64_t *texts,
+                                 const size_t num_texts,
+                                 size_t *num_collisions) {
+        // Row i is the histogram of cell i
+        size_t histograms[NUM_CELLS][NUM_CELL_VALUES];
+        memset(histograms, 0, sizeof(histograms));
+
+        for (size_t j = 0; j < num_texts; ++j) {
+            uint64_t text = texts[j];
+
+            for (size_t i = NUM_CELLS; i > 0; --i) {
+                histograms[i - 1][text & 0xF]++;
+                text >>= 4;
+            }
+        }
+
+        for (size_t i = 0; i < NUM_CELLS; ++i) {
+            for (size_t value = 0; value < NUM_CELL_VALUES; ++value) {
+                const size_t n = histograms[i][value];
+                num_collisions[i] += (n * (n - 1)) / 2;
+            }
+        }
+    }
+
+}
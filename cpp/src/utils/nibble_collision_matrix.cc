@@ -0,0 +1,145 @@
+/**
+ * Counts nibble collisions for all 16x16 input/output cells of the
+ * byte-combination distinguishers.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdio.h>
+
+#include <stdexcept>
+
+#include "utils/nibble_collision_matrix.h"
+#include "utils/xorshift1024.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    static const size_t NUM_CELLS = NIBBLE_COLLISION_COUNTER_NUM_CELLS;
+    static const size_t NUM_TEXTS_IN_DELTA_SET =
+        NIBBLE_COLLISION_COUNTER_NUM_CELL_VALUES;
+
+    // ---------------------------------------------------------------------
+
+    void add_nibble_collision_matrix(
+        const size_t num_sets,
+        const packed_encryption_function_t &encrypt,
+        NibbleCollisionMatrix &matrix) {
+        uint64_t ciphertexts[NUM_TEXTS_IN_DELTA_SET];
+
+        for (size_t input_cell_index = 0; input_cell_index < NUM_CELLS;
+             ++input_cell_index) {
+            const size_t shift = (NUM_CELLS - 1 - input_cell_index) * 4;
+            const uint64_t cell_mask = ~(UINT64_C(0xF) << shift);
+
+            for (size_t i = 0; i < num_sets; ++i) {
+                const uint64_t base_plaintext =
+                    xorshift1024_next(get_thread_prng()) & cell_mask;
+
+                for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
+                    ciphertexts[j] = encrypt(
+                        base_plaintext | ((uint64_t) j << shift)
+                    );
+                }
+
+                count_nibble_collisions(ciphertexts,
+                                        NUM_TEXTS_IN_DELTA_SET,
+                                        matrix[input_cell_index].data());
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    void print_nibble_collision_matrix(const NibbleCollisionMatrix &matrix,
+                                       const size_t num_sets) {
+        printf("# In\\Out");
+
+        for (size_t o = 0; o < NUM_CELLS; ++o) {
+            printf(" %7zu", o);
+        }
+
+        puts("");
+
+        for (size_t i = 0; i < NUM_CELLS; ++i) {
+            printf("%8zu", i);
+
+            for (size_t o = 0; o < NUM_CELLS; ++o) {
+                printf(" %7.4f", (double) matrix[i][o] / (double) num_sets);
+            }
+
+            puts("");
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    void perform_nibble_collision_matrix_experiments(
+        const size_t num_keys,
+        const size_t num_sets_per_key,
+        const key_setup_function_t &setup_key,
+        const packed_encryption_function_t &encrypt) {
+        NibbleCollisionMatrix all_results = {};
+
+        printf("#%8zu Experiments\n", num_keys);
+        printf("#%8zu Sets/key/input cell\n", num_sets_per_key);
+        printf("# Key Collisions Mean\n");
+
+        for (size_t k = 0; k < num_keys; ++k) {
+            NibbleCollisionMatrix matrix = {};
+            setup_key();
+            add_nibble_collision_matrix(num_sets_per_key, encrypt, matrix);
+            size_t num_collisions = 0;
+
+            for (size_t i = 0; i < NUM_CELLS; ++i) {
+                for (size_t o = 0; o < NUM_CELLS; ++o) {
+                    num_collisions += matrix[i][o];
+                    all_results[i][o] += matrix[i][o];
+                }
+            }
+
+            const double mean = (double) num_collisions
+                / (double) (NUM_CELLS * NUM_CELLS * num_sets_per_key);
+            printf("%4zu %8zu %8.4f\n", k + 1, num_collisions, mean);
+        }
+
+        printf("# Mean collisions per set (input cell x output cell)\n");
+        print_nibble_collision_matrix(all_results,
+                                      num_keys * num_sets_per_key);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void add_cell_arguments(ArgumentParser &parser) {
+        parser.addArgument("-i", "--input_cell_index", 1, true);
+        parser.addArgument("-o", "--output_cell_index", 1, true);
+        parser.addArgument("-a", "--all_cells", 1, true);
+    }
+
+    // ---------------------------------------------------------------------
+
+    bool retrieve_cell_arguments(ArgumentParser &parser,
+                                 size_t *input_cell_index,
+                                 size_t *output_cell_index) {
+        *input_cell_index = 0;
+        *output_cell_index = 0;
+
+        if (parser.wasSet("-a") && (bool) parser.retrieveAsInt("a")) {
+            return true;
+        }
+
+        if (!parser.wasSet("-i") || !parser.wasSet("-o")) {
+            throw std::invalid_argument(
+                "-i and -o are required unless -a 1 is set"
+            );
+        }
+
+        *input_cell_index = parser.retrieveAsLong("i");
+        *output_cell_index = parser.retrieveAsLong("o");
+        return false;
+    }
+
+}
@@ -0,0 +1,228 @@
+/**
+ * Per-phase cycle counters for the distinguishers and the key recovery.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <string.h>
+
+#include <chrono>
+#include <mutex>
+
+#include "utils/profiler.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    static const char *PROFILER_PHASE_NAMES[PROFILER_NUM_PHASES] = {
+        "key setup",
+        "rng",
+        "plaintext generation",
+        "encryption",
+        "bucketing/sorting",
+        "collision counting",
+        "precomputation"
+    };
+
+    // ---------------------------------------------------------------------
+
+    const char *get_profiler_phase_name(const ProfilerPhase phase) {
+        if (phase >= PROFILER_NUM_PHASES) {
+            return "unknown";
+        }
+
+        return PROFILER_PHASE_NAMES[phase];
+    }
+
+    // ---------------------------------------------------------------------
+    // Types
+    // ---------------------------------------------------------------------
+
+    typedef struct {
+        uint64_t num_cycles[PROFILER_NUM_PHASES];
+        uint64_t num_scopes[PROFILER_NUM_PHASES];
+        uint64_t counters[PROFILER_NUM_COUNTERS];
+    } ProfileCounters;
+
+    // ---------------------------------------------------------------------
+
+    static void add_counters(ProfileCounters *target,
+                             const ProfileCounters &source) {
+        for (size_t i = 0; i < PROFILER_NUM_PHASES; ++i) {
+            target->num_cycles[i] += source.num_cycles[i];
+            target->num_scopes[i] += source.num_scopes[i];
+        }
+
+        for (size_t i = 0; i < PROFILER_NUM_COUNTERS; ++i) {
+            target->counters[i] += source.counters[i];
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * The totals of all threads that have exited or been merged.
+     */
+    class Profile {
+
+    public:
+
+        Profile() :
+            start_time(std::chrono::steady_clock::now()) {
+            memset(&totals, 0, sizeof(totals));
+        }
+
+        // ---------------------------------------------------------------------
+
+        void merge(ProfileCounters *counters) {
+            std::lock_guard<std::mutex> lock(mutex);
+            add_counters(&totals, *counters);
+            memset(counters, 0, sizeof(*counters));
+        }
+
+        // ---------------------------------------------------------------------
+
+        void reset() {
+            std::lock_guard<std::mutex> lock(mutex);
+            memset(&totals, 0, sizeof(totals));
+            start_time = std::chrono::steady_clock::now();
+        }
+
+        // ---------------------------------------------------------------------
+
+        ProfileCounters get_totals() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return totals;
+        }
+
+        // ---------------------------------------------------------------------
+
+        double get_num_elapsed_seconds() {
+            std::lock_guard<std::mutex> lock(mutex);
+            const std::chrono::duration<double> elapsed_seconds =
+                std::chrono::steady_clock::now() - start_time;
+            return elapsed_seconds.count();
+        }
+
+    private:
+
+        std::mutex mutex;
+        ProfileCounters totals;
+        std::chrono::steady_clock::time_point start_time;
+
+    };
+
+    // ---------------------------------------------------------------------
+
+    static Profile &get_profile() {
+        static Profile profile;
+        return profile;
+    }
+
+    // ---------------------------------------------------------------------
+
+    /**
+     * The counters of one thread, merged into the profile at thread exit.
+     */
+    class ThreadProfile {
+
+    public:
+
+        ThreadProfile() {
+            // Constructs the profile first, so that it outlives the thread
+            // profile of the main thread
+            get_profile();
+            memset(&counters, 0, sizeof(counters));
+        }
+
+        // ---------------------------------------------------------------------
+
+        ~ThreadProfile() {
+            get_profile().merge(&counters);
+        }
+
+        // ---------------------------------------------------------------------
+
+        ProfileCounters counters;
+
+    };
+
+    // ---------------------------------------------------------------------
+
+    static thread_local ThreadProfile thread_profile;
+
+    // ---------------------------------------------------------------------
+    // API
+    // ---------------------------------------------------------------------
+
+    void profiler_add_cycles(const ProfilerPhase phase,
+                             const uint64_t num_cycles) {
+        thread_profile.counters.num_cycles[phase] += num_cycles;
+        thread_profile.counters.num_scopes[phase]++;
+    }
+
+    // ---------------------------------------------------------------------
+
+    void profiler_add(const ProfilerCounter counter, const uint64_t value) {
+        thread_profile.counters.counters[counter] += value;
+    }
+
+    // ---------------------------------------------------------------------
+
+    void profiler_start() {
+        memset(&thread_profile.counters, 0, sizeof(thread_profile.counters));
+        get_profile().reset();
+    }
+
+    // ---------------------------------------------------------------------
+
+    void profiler_print(FILE *file) {
+        Profile &profile = get_profile();
+        profile.merge(&thread_profile.counters);
+
+        const ProfileCounters totals = profile.get_totals();
+        const double num_seconds = profile.get_num_elapsed_seconds();
+        const double num_texts =
+            (double) totals.counters[PROFILER_COUNTER_TEXTS];
+        uint64_t num_total_cycles = 0;
+
+        for (size_t i = 0; i < PROFILER_NUM_PHASES; ++i) {
+            num_total_cycles += totals.num_cycles[i];
+        }
+
+        fprintf(file, "# Profile (cycles summed over all threads)\n");
+        fprintf(file, "# %-20s %14s %7s %12s %12s\n",
+                "Phase", "Cycles", "Share", "Scopes", "Cycles/text");
+
+        for (size_t i = 0; i < PROFILER_NUM_PHASES; ++i) {
+            if (totals.num_scopes[i] == 0) {
+                continue;
+            }
+
+            const double num_cycles = (double) totals.num_cycles[i];
+            fprintf(file, "# %-20s %14.6e %6.2f%% %12llu %12.2f\n",
+                    get_profiler_phase_name((ProfilerPhase) i),
+                    num_cycles,
+                    (num_total_cycles == 0)
+                    ? 0.0 : 100.0 * num_cycles / (double) num_total_cycles,
+                    (unsigned long long) totals.num_scopes[i],
+                    (num_texts == 0) ? 0.0 : num_cycles / num_texts);
+        }
+
+        fprintf(file, "# %-20s %14.6e\n", "Total",
+                (double) num_total_cycles);
+        fprintf(file, "# %-20s %14llu\n", "Texts",
+                (unsigned long long) totals.counters[PROFILER_COUNTER_TEXTS]);
+        fprintf(file, "# %-20s %14llu\n", "Sets",
+                (unsigned long long) totals.counters[PROFILER_COUNTER_SETS]);
+        fprintf(file, "# %-20s %14.6f\n", "Seconds", num_seconds);
+        fprintf(file, "# %-20s %14.6e\n", "Texts/second",
+                (num_seconds == 0) ? 0.0 : num_texts / num_seconds);
+        fprintf(file, "# %-20s %14.2f\n", "Cycles/text",
+                (num_texts == 0) ? 0.0 : (double) num_total_cycles / num_texts);
+    }
+
+}
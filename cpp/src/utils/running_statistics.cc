@@ -0,0 +1,245 @@
+/**
+ * Streaming statistics and a sequential test for the distinguishers.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <math.h>
+
+#include <stdexcept>
+
+#include "utils/running_statistics.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    static const double NORMAL_QUANTILE_A[6] = {
+        -3.969683028665376e+01, 2.209460984245205e+02,
+        -2.759285104469687e+02, 1.383577518672690e+02,
+        -3.066479806614716e+01, 2.506628277459239e+00
+    };
+    static const double NORMAL_QUANTILE_B[5] = {
+        -5.447609879822406e+01, 1.615858368580409e+02,
+        -1.556989798598866e+02, 6.680131188771972e+01,
+        -1.328068155288572e+01
+    };
+    static const double NORMAL_QUANTILE_C[6] = {
+        -7.784894002430293e-03, -3.223964580411365e-01,
+        -2.400758277161838e+00, -2.549671010429946e+00,
+        4.374664141464968e+00, 2.938163982698783e+00
+    };
+    static const double NORMAL_QUANTILE_D[4] = {
+        7.784695709041462e-03, 3.224671290700398e-01,
+        2.445134137142996e+00, 3.754408661907416e+00
+    };
+    static const double NORMAL_QUANTILE_P_LOW = 0.02425;
+
+    // ---------------------------------------------------------------------
+
+    static double get_normal_quantile_of_tail(const double p) {
+        const double *c = NORMAL_QUANTILE_C;
+        const double *d = NORMAL_QUANTILE_D;
+        const double q = sqrt(-2 * log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q
+                + c[5])
+               / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+
+    // ---------------------------------------------------------------------
+
+    static double approximate_normal_quantile(const double p) {
+        if (p < NORMAL_QUANTILE_P_LOW) {
+            return get_normal_quantile_of_tail(p);
+        }
+
+        if (p > 1 - NORMAL_QUANTILE_P_LOW) {
+            return -get_normal_quantile_of_tail(1 - p);
+        }
+
+        const double *a = NORMAL_QUANTILE_A;
+        const double *b = NORMAL_QUANTILE_B;
+        const double q = p - 0.5;
+        const double r = q * q;
+        return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r
+                + a[5]) * q
+               / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r
+                  + 1);
+    }
+
+    // ---------------------------------------------------------------------
+
+    double get_normal_quantile(const double p) {
+        if (p <= 0) {
+            return -HUGE_VAL;
+        }
+
+        if (p >= 1) {
+            return HUGE_VAL;
+        }
+
+        const double x = approximate_normal_quantile(p);
+
+        // One step of Halley's method on the exact distribution function
+        const double error = 0.5 * erfc(-x / sqrt(2.0)) - p;
+        const double u = error * sqrt(2 * M_PI) * exp(x * x / 2);
+        return x - u / (1 + x * u / 2);
+    }
+
+    // ---------------------------------------------------------------------
+    // RunningStatistics
+    // ---------------------------------------------------------------------
+
+    RunningStatistics::RunningStatistics() :
+        num_values(0),
+        mean(0.0),
+        sum_of_squares(0.0) {
+
+    }
+
+    // ---------------------------------------------------------------------
+
+    void RunningStatistics::add(const double value) {
+        num_values++;
+        const double delta = value - mean;
+        mean += delta / (double) num_values;
+        sum_of_squares += delta * (value - mean);
+    }
+
+    // ---------------------------------------------------------------------
+
+    void RunningStatistics::merge(const RunningStatistics &other) {
+        if (other.num_values == 0) {
+            return;
+        }
+
+        if (num_values == 0) {
+            *this = other;
+            return;
+        }
+
+        const double n = (double) num_values;
+        const double m = (double) other.num_values;
+        const double delta = other.mean - mean;
+
+        num_values += other.num_values;
+        mean += delta * m / (n + m);
+        sum_of_squares += other.sum_of_squares
+                          + delta * delta * n * m / (n + m);
+    }
+
+    // ---------------------------------------------------------------------
+
+    size_t RunningStatistics::get_num_values() const {
+        return num_values;
+    }
+
+    // ---------------------------------------------------------------------
+
+    double RunningStatistics::get_mean() const {
+        return mean;
+    }
+
+    // ---------------------------------------------------------------------
+
+    double RunningStatistics::get_variance() const {
+        if (num_values < 2) {
+            return 0.0;
+        }
+
+        return sum_of_squares / (double) (num_values - 1);
+    }
+
+    // ---------------------------------------------------------------------
+
+    double RunningStatistics::get_standard_deviation() const {
+        return sqrt(get_variance());
+    }
+
+    // ---------------------------------------------------------------------
+
+    double RunningStatistics::get_standard_error() const {
+        if (num_values == 0) {
+            return 0.0;
+        }
+
+        return sqrt(get_variance() / (double) num_values);
+    }
+
+    // ---------------------------------------------------------------------
+
+    ConfidenceInterval
+    RunningStatistics::get_confidence_interval(const double confidence) const {
+        const double z = get_normal_quantile((1 + confidence) / 2);
+        const double half_width = z * get_standard_error();
+        ConfidenceInterval interval;
+        interval.lower = mean - half_width;
+        interval.upper = mean + half_width;
+        return interval;
+    }
+
+    // ---------------------------------------------------------------------
+    // SequentialProbabilityRatioTest
+    // ---------------------------------------------------------------------
+
+    SequentialProbabilityRatioTest::SequentialProbabilityRatioTest(
+        const double null_probability,
+        const double min_difference,
+        const double confidence) :
+        null_probability(null_probability),
+        min_difference(min_difference) {
+        if ((null_probability - min_difference <= 0)
+            || (null_probability + min_difference >= 1)) {
+            throw std::invalid_argument(
+                "null_probability +- min_difference must be in (0, 1)"
+            );
+        }
+
+        // Each of the two one-sided tests may err for the PRP with half of
+        // the error probability 1 - confidence
+        const double error = 1 - confidence;
+        lower_bound = log(error / (1 - error / 2));
+        upper_bound = log((1 - error) / (error / 2));
+    }
+
+    // ---------------------------------------------------------------------
+
+    double SequentialProbabilityRatioTest::get_log_likelihood_ratio(
+        const size_t num_collisions,
+        const size_t num_pairs,
+        const double alternative_probability) const {
+        // Binomial likelihoods; the binomial coefficients cancel out
+        const double num_non_collisions =
+            (double) num_pairs - (double) num_collisions;
+        return (double) num_collisions
+               * log(alternative_probability / null_probability)
+               + num_non_collisions
+                 * (log1p(-alternative_probability) - log1p(-null_probability));
+    }
+
+    // ---------------------------------------------------------------------
+
+    SprtDecision
+    SequentialProbabilityRatioTest::decide(const size_t num_collisions,
+                                           const size_t num_pairs) const {
+        const double upper_ratio = get_log_likelihood_ratio(
+            num_collisions, num_pairs, null_probability + min_difference
+        );
+        const double lower_ratio = get_log_likelihood_ratio(
+            num_collisions, num_pairs, null_probability - min_difference
+        );
+
+        if ((upper_ratio >= upper_bound) || (lower_ratio >= upper_bound)) {
+            return SPRT_ACCEPT_ALTERNATIVE;
+        }
+
+        if ((upper_ratio <= lower_bound) && (lower_ratio <= lower_bound)) {
+            return SPRT_ACCEPT_NULL;
+        }
+
+        return SPRT_CONTINUE;
+    }
+
+}
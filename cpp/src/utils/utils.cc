@@ -196,6 +196,21 @@ namespace utils {
 
     // ---------------------------------------------------------------------
 
+    __m128i convert_from_uint64(const uint64_t source) {
+        // [x14 x15, x12 x13, ..., x0 x1] -> [x0 x1, x2 x3, ..., x14 x15]
+        const __m128i x = vshuffle(
+            _mm_cvtsi64_si128((long long) source),
+            vsetr8(7, 6, 5, 4, 3, 2, 1, 0,
+                   (uint8_t) 0xFF, (uint8_t) 0xFF, (uint8_t) 0xFF,
+                   (uint8_t) 0xFF, (uint8_t) 0xFF, (uint8_t) 0xFF,
+                   (uint8_t) 0xFF, (uint8_t) 0xFF)
+        );
+        const __m128i mask = vset8_single(0x0F);
+        return vunpacklo8(vand(vshiftright16(x, 4), mask), vand(x, mask));
+    }
+
+    // ---------------------------------------------------------------------
+
     void xor_arrays(uint8_t *target,
                     const uint8_t *left,
                     const uint8_t *right,
@@ -0,0 +1,39 @@
+/**
+ * Fast Walsh-Hadamard transforms over GF(2)^n.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include "utils/walsh_hadamard.h"
+
+// ---------------------------------------------------------------------
+
+namespace utils {
+
+    void walsh_hadamard_transform(int64_t *values, const size_t num_values) {
+        for (size_t step = 1; step < num_values; step <<= 1) {
+            for (size_t i = 0; i < num_values; i += (step << 1)) {
+                for (size_t j = i; j < i + step; ++j) {
+                    const int64_t left = values[j];
+                    const int64_t right = values[j + step];
+                    values[j] = left + right;
+                    values[j + step] = left - right;
+                }
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------------
+
+    void inverse_walsh_hadamard_transform(int64_t *values,
+                                          const size_t num_values) {
+        walsh_hadamard_transform(values, num_values);
+
+        for (size_t i = 0; i < num_values; ++i) {
+            values[i] /= (int64_t) num_values;
+        }
+    }
+
+}
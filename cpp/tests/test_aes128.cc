@@ -5,10 +5,13 @@
  */
 
 #include <stdint.h>
+#include <string.h>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include "ciphers/aes.h"
 #include "utils/utils.h"
+#include "utils/xorshift1024.h"
 
 
 using ciphers::aes128_ctx_t;
@@ -147,6 +150,127 @@ TEST(AES, test_encrypt_i_rounds) {
 
 // ---------------------------------------------------------
 
+typedef void (*encrypt_function_t)(const aes128_ctx_t *,
+                                   const aes_state_t,
+                                   aes_state_t,
+                                   size_t);
+
+typedef void (*encrypt_batch_function_t)(const aes128_ctx_t *,
+                                         const aes_state_t *,
+                                         aes_state_t *,
+                                         size_t);
+
+// ---------------------------------------------------------
+
+static void run_batch_test(const encrypt_function_t encrypt,
+                           const encrypt_batch_function_t encrypt_batch,
+                           const size_t num_texts) {
+    aes128_key_t key;
+    utils::get_random_bytes(key, AES_128_NUM_KEY_BYTES);
+
+    aes128_ctx_t ctx;
+    aes128_key_setup(&ctx, key);
+
+    aes_state_t plaintexts[16];
+    utils::get_random_bytes((uint8_t *) plaintexts,
+                            num_texts * AES_NUM_STATE_BYTES);
+
+    for (size_t num_rounds = 0; num_rounds <= AES_128_NUM_ROUNDS;
+         ++num_rounds) {
+        aes_state_t expected_ciphertexts[16];
+        aes_state_t ciphertexts[16];
+
+        for (size_t i = 0; i < num_texts; ++i) {
+            encrypt(&ctx, plaintexts[i], expected_ciphertexts[i], num_rounds);
+        }
+
+        encrypt_batch(&ctx, plaintexts, ciphertexts, num_rounds);
+        ASSERT_EQ(0, memcmp(expected_ciphertexts, ciphertexts,
+                            num_texts * AES_NUM_STATE_BYTES));
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(AES, test_encrypt_rounds_batches) {
+    run_batch_test(&ciphers::aes128_encrypt_rounds,
+                   &ciphers::aes128_encrypt_rounds_8, 8);
+    run_batch_test(&ciphers::aes128_encrypt_rounds,
+                   &ciphers::aes128_encrypt_rounds_16, 16);
+}
+
+// ---------------------------------------------------------
+
+TEST(AES, test_encrypt_rounds_always_mc_batches) {
+    run_batch_test(&ciphers::aes128_encrypt_rounds_always_mc,
+                   &ciphers::aes128_encrypt_rounds_always_mc_8, 8);
+    run_batch_test(&ciphers::aes128_encrypt_rounds_always_mc,
+                   &ciphers::aes128_encrypt_rounds_always_mc_16, 16);
+}
+
+// ---------------------------------------------------------
+
+TEST(AES, test_encrypt_rounds_only_sbox_in_final_batches) {
+    run_batch_test(&ciphers::aes128_encrypt_rounds_only_sbox_in_final,
+                   &ciphers::aes128_encrypt_rounds_only_sbox_in_final_8, 8);
+    run_batch_test(&ciphers::aes128_encrypt_rounds_only_sbox_in_final,
+                   &ciphers::aes128_encrypt_rounds_only_sbox_in_final_16,
+                   16);
+}
+
+// ---------------------------------------------------------
+
+static void run_diagonal_structure_histogram_test(
+    const size_t first_text_index,
+    const size_t num_texts) {
+    aes128_key_t key;
+    aes_state_t base_plaintext;
+    utils::get_random_bytes(key, AES_128_NUM_KEY_BYTES);
+    utils::get_random_bytes(base_plaintext, AES_NUM_STATE_BYTES);
+
+    aes128_ctx_t ctx;
+    aes128_key_setup(&ctx, key);
+
+    for (size_t num_rounds = 0; num_rounds <= AES_128_NUM_ROUNDS;
+         ++num_rounds) {
+        std::vector<size_t> expected_histogram(256, 0);
+        std::vector<size_t> histogram(256, 0);
+
+        for (size_t i = first_text_index;
+             i < first_text_index + num_texts; ++i) {
+            aes_state_t plaintext;
+            aes_state_t ciphertext;
+            memcpy(plaintext, base_plaintext, AES_NUM_STATE_BYTES);
+            plaintext[0] = (uint8_t) ((i >> 24) & 0xFF);
+            plaintext[5] = (uint8_t) ((i >> 16) & 0xFF);
+            plaintext[10] = (uint8_t) ((i >> 8) & 0xFF);
+            plaintext[15] = (uint8_t) (i & 0xFF);
+
+            ciphers::aes128_encrypt_rounds_always_mc(&ctx, plaintext,
+                                                     ciphertext, num_rounds);
+            expected_histogram[ciphertext[0]]++;
+        }
+
+        ciphers::aes128_encrypt_diagonal_structure_histogram(
+            &ctx, base_plaintext, first_text_index, num_texts, num_rounds,
+            histogram.data()
+        );
+        ASSERT_EQ(expected_histogram, histogram);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(AES, test_encrypt_diagonal_structure_histogram) {
+    run_diagonal_structure_histogram_test(0, 512);
+    run_diagonal_structure_histogram_test(0x12345678, 1032);
+    run_diagonal_structure_histogram_test(
+        AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE - 264, 264
+    );
+}
+
+// ---------------------------------------------------------
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,122 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "utils/benchmark.h"
+
+
+using utils::BenchmarkResult;
+using utils::BenchmarkRunner;
+
+// ---------------------------------------------------------
+
+static BenchmarkResult get_result(const size_t num_iterations,
+                                  const double num_seconds,
+                                  const uint64_t num_cycles) {
+    BenchmarkResult result;
+    result.name = "kernel";
+    result.num_iterations = num_iterations;
+    result.num_states_per_iteration = 16;
+    result.num_bytes_per_state = 8;
+    result.num_seconds = num_seconds;
+    result.num_cpu_seconds = num_seconds;
+    result.num_cycles = num_cycles;
+    return result;
+}
+
+// ---------------------------------------------------------
+
+TEST(Benchmark, test_cycles_per_byte) {
+    // 4 * 16 * 8 = 512 bytes
+    ASSERT_DOUBLE_EQ(2.0, utils::get_cycles_per_byte(get_result(4, 1, 1024)));
+    ASSERT_DOUBLE_EQ(0.0, utils::get_cycles_per_byte(get_result(0, 1, 1024)));
+}
+
+// ---------------------------------------------------------
+
+TEST(Benchmark, test_states_per_second) {
+    ASSERT_DOUBLE_EQ(128.0,
+                     utils::get_states_per_second(get_result(4, 0.5, 1)));
+    ASSERT_DOUBLE_EQ(0.0, utils::get_states_per_second(get_result(4, 0, 1)));
+}
+
+// ---------------------------------------------------------
+
+TEST(Benchmark, test_to_json_string) {
+    ASSERT_EQ("\"aes128\"", utils::to_json_string("aes128"));
+    ASSERT_EQ("\"a\\\"b\\\\c\"", utils::to_json_string("a\"b\\c"));
+    ASSERT_EQ("\"\\u000a\"", utils::to_json_string("\n"));
+}
+
+// ---------------------------------------------------------
+
+TEST(Benchmark, test_runner_reaches_min_time) {
+    const double min_seconds = 0.01;
+    BenchmarkRunner runner(min_seconds, 2);
+    size_t num_calls = 0;
+    uint64_t sum = 0;
+
+    const BenchmarkResult &result = runner.run(
+        "sum", 1, 8,
+        [&](const size_t num_iterations) {
+            num_calls++;
+
+            for (size_t i = 0; i < num_iterations; ++i) {
+                sum += i;
+                utils::do_not_optimize(sum);
+            }
+        }
+    );
+
+    // The kept repetition may be faster than the one that reached
+    // min_seconds, so only the number of iterations is checked
+    ASSERT_EQ("sum", result.name);
+    ASSERT_GT(result.num_iterations, 1UL);
+    ASSERT_GT(result.num_seconds, 0.0);
+    ASSERT_GT(result.num_cycles, 0UL);
+    // A power of two
+    ASSERT_EQ(0UL, result.num_iterations & (result.num_iterations - 1));
+    ASSERT_EQ(1UL, runner.get_results().size());
+    // Calibration plus one more repetition
+    ASSERT_GE(num_calls, 3UL);
+}
+
+// ---------------------------------------------------------
+
+TEST(Benchmark, test_write_json) {
+    BenchmarkRunner runner(0.0, 1);
+    runner.add_context("label", "baseline");
+    runner.run("first", 1, 8, [](const size_t) {});
+    runner.run("second", 1, 8, [](const size_t) {});
+
+    char *buffer = NULL;
+    size_t size = 0;
+    FILE *file = open_memstream(&buffer, &size);
+    ASSERT_TRUE(file != NULL);
+    runner.write_json(file);
+    fclose(file);
+
+    const std::string json(buffer, size);
+    free(buffer);
+
+    ASSERT_EQ('{', json[0]);
+    ASSERT_NE(std::string::npos, json.find("\"label\": \"baseline\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\": \"first\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\": \"second\""));
+    ASSERT_NE(std::string::npos, json.find("\"cycles_per_byte\""));
+    ASSERT_NE(std::string::npos, json.find("\"states_per_second\""));
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
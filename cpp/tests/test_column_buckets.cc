@@ -0,0 +1,117 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "utils/column_buckets.h"
+#include "utils/xorshift1024.h"
+
+
+using utils::ColumnBuckets;
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+static const size_t NUM_TEXTS = 1 << 16;
+
+// ---------------------------------------------------------
+
+static std::vector<uint64_t> generate_texts(const uint64_t seed) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, seed);
+    std::vector<uint64_t> texts(NUM_TEXTS);
+
+    for (uint64_t &text : texts) {
+        text = utils::xorshift1024_next(&prng);
+    }
+
+    return texts;
+}
+
+// ---------------------------------------------------------
+
+static void check_buckets(const std::vector<uint64_t> &texts,
+                          const ColumnBuckets &buckets,
+                          const size_t column_index) {
+    const size_t shift = (3 - column_index) * 16;
+    const uint64_t column_mask = (uint64_t) 0xFFFF << shift;
+    size_t num_entries = 0;
+
+    ASSERT_EQ(column_index, buckets.get_column_index());
+
+    for (size_t value = 0; value < NUM_TEXTS; ++value) {
+        const uint64_t *begin = buckets.get_bucket_begin(value);
+        const uint64_t *end = buckets.get_bucket_end(value);
+        ASSERT_EQ(buckets.get_bucket_size(value), (size_t) (end - begin));
+        size_t previous_index = 0;
+
+        for (const uint64_t *entry = begin; entry != end; ++entry) {
+            const size_t j = buckets.get_text_index(*entry);
+            const uint64_t text = texts[j];
+
+            // The entry is the text with its column replaced by the index
+            ASSERT_EQ(value, ColumnBuckets::get_column(text, column_index));
+            ASSERT_EQ(text & ~column_mask, *entry & ~column_mask);
+
+            if (entry != begin) {
+                ASSERT_LT(previous_index, j);
+            }
+
+            previous_index = j;
+            num_entries++;
+        }
+    }
+
+    ASSERT_EQ(NUM_TEXTS, num_entries);
+}
+
+// ---------------------------------------------------------
+
+TEST(ColumnBuckets, contain_all_texts_sorted_by_column) {
+    const std::vector<uint64_t> texts = generate_texts(1);
+    ColumnBuckets buckets;
+
+    for (size_t column_index = 0; column_index < 4; ++column_index) {
+        buckets.fill(texts.data(), NUM_TEXTS, column_index);
+        check_buckets(texts, buckets, column_index);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(ColumnBuckets, can_be_refilled_with_fewer_texts) {
+    std::vector<uint64_t> texts = generate_texts(2);
+    ColumnBuckets buckets;
+    buckets.fill(texts.data(), NUM_TEXTS, 0);
+
+    texts.assign(3, 0x0123456789ABCDEFL);
+    buckets.fill(texts.data(), texts.size(), 2);
+
+    ASSERT_EQ((size_t) 3, buckets.get_bucket_size(0x89AB));
+    ASSERT_EQ((size_t) 0, buckets.get_bucket_size(0x89AA));
+    ASSERT_EQ((uint64_t) 0x012345670002CDEFL,
+              buckets.get_bucket_begin(0x89AB)[2]);
+}
+
+// ---------------------------------------------------------
+
+TEST(ColumnBuckets, reject_more_texts_than_column_values) {
+    const std::vector<uint64_t> texts(NUM_TEXTS + 1, 0x0123456789ABCDEFL);
+    ColumnBuckets buckets;
+
+    ASSERT_THROW(buckets.fill(texts.data(), texts.size(), 0),
+                 std::length_error);
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,161 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "utils/column_collision_counter.h"
+#include "utils/xorshift1024.h"
+
+
+using utils::ColumnCollisionCounter;
+using utils::ColumnCollisions;
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+static const size_t NUM_TEXTS = 1 << 10;
+
+// ---------------------------------------------------------
+
+static size_t get_column(const uint64_t text, const size_t column_index) {
+    return (text >> ((3 - column_index) * 16)) & 0xFFFF;
+}
+
+// ---------------------------------------------------------
+
+/**
+ * Restricts every column to few values, so that there are many collisions
+ * in multiple columns at once.
+ */
+static std::vector<uint64_t> generate_texts(const uint64_t seed,
+                                            const uint64_t column_mask) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, seed);
+    std::vector<uint64_t> texts(NUM_TEXTS);
+
+    for (uint64_t &text : texts) {
+        text = utils::xorshift1024_next(&prng) & column_mask;
+    }
+
+    return texts;
+}
+
+// ---------------------------------------------------------
+
+static ColumnCollisions count_naively(const std::vector<uint64_t> &texts,
+                                      size_t num_pairs_per_column[4]) {
+    ColumnCollisions result = {0, 0};
+
+    for (size_t i = 0; i < 4; ++i) {
+        num_pairs_per_column[i] = 0;
+    }
+
+    for (size_t i = 0; i < texts.size(); ++i) {
+        for (size_t j = i + 1; j < texts.size(); ++j) {
+            size_t num_colliding_columns = 0;
+
+            for (size_t k = 0; k < 4; ++k) {
+                if (get_column(texts[i], k) == get_column(texts[j], k)) {
+                    num_pairs_per_column[k]++;
+                    num_colliding_columns++;
+                }
+            }
+
+            if (num_colliding_columns > 0) {
+                result.num_collisions++;
+                result.num_multi_column_collisions +=
+                    num_colliding_columns - 1;
+            }
+        }
+    }
+
+    return result;
+}
+
+// ---------------------------------------------------------
+
+static void check_against_naive_count(const uint64_t seed,
+                                      const uint64_t column_mask) {
+    const std::vector<uint64_t> texts = generate_texts(seed, column_mask);
+    size_t num_pairs_per_column[4];
+    const ColumnCollisions expected = count_naively(texts,
+                                                    num_pairs_per_column);
+
+    ColumnCollisionCounter counter(NUM_TEXTS);
+    const ColumnCollisions result = counter.count(texts.data(), NUM_TEXTS);
+
+    ASSERT_EQ(expected.num_collisions, result.num_collisions);
+    ASSERT_EQ(expected.num_multi_column_collisions,
+              result.num_multi_column_collisions);
+
+    for (size_t k = 0; k < 4; ++k) {
+        ASSERT_EQ(num_pairs_per_column[k],
+                  counter.get_num_pairs_colliding_in((size_t) 1 << (3 - k)));
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(ColumnCollisionCounter, equals_naive_count_with_few_column_values) {
+    check_against_naive_count(1, 0x0007000700070007L);
+}
+
+// ---------------------------------------------------------
+
+TEST(ColumnCollisionCounter, equals_naive_count_with_many_column_values) {
+    check_against_naive_count(2, 0x00FF00FF00FF00FFL);
+}
+
+// ---------------------------------------------------------
+
+TEST(ColumnCollisionCounter, equals_naive_count_with_mixed_column_values) {
+    check_against_naive_count(3, 0x0003FFFF001F0001L);
+}
+
+// ---------------------------------------------------------
+
+TEST(ColumnCollisionCounter, can_be_reused) {
+    const std::vector<uint64_t> texts = generate_texts(4, 0x000F000F000F000FL);
+    ColumnCollisionCounter counter(NUM_TEXTS);
+    const ColumnCollisions first = counter.count(texts.data(), NUM_TEXTS);
+    const ColumnCollisions second = counter.count(texts.data(), NUM_TEXTS);
+
+    ASSERT_EQ(first.num_collisions, second.num_collisions);
+    ASSERT_EQ(first.num_multi_column_collisions,
+              second.num_multi_column_collisions);
+}
+
+// ---------------------------------------------------------
+
+TEST(ColumnCollisionCounter, identical_texts_collide_in_all_columns) {
+    const std::vector<uint64_t> texts(3, 0x0123456789ABCDEFL);
+    ColumnCollisionCounter counter(NUM_TEXTS);
+    const ColumnCollisions result = counter.count(texts.data(), texts.size());
+
+    ASSERT_EQ((size_t) 3, result.num_collisions);
+    ASSERT_EQ((size_t) 9, result.num_multi_column_collisions);
+    ASSERT_EQ((size_t) 3, counter.get_num_pairs_colliding_in(0xF));
+}
+
+// ---------------------------------------------------------
+
+TEST(ColumnCollisionCounter, rejects_more_texts_than_its_capacity) {
+    const std::vector<uint64_t> texts(NUM_TEXTS + 1, 0x0123456789ABCDEFL);
+    ColumnCollisionCounter counter(NUM_TEXTS);
+
+    ASSERT_THROW(counter.count(texts.data(), texts.size()),
+                 std::length_error);
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
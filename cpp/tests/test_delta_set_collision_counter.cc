@@ -0,0 +1,132 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+
+#include "utils/delta_set_collision_counter.h"
+#include "utils/xorshift1024.h"
+
+
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+static const size_t NUM_TEXTS = DELTA_SET_COLLISION_COUNTER_NUM_TEXTS;
+static const size_t NUM_TESTS = 64;
+
+// ---------------------------------------------------------
+
+static size_t count_naively(const uint64_t texts[NUM_TEXTS],
+                            const uint64_t *masks,
+                            const size_t num_masks) {
+    size_t num_collisions = 0;
+
+    for (size_t i = 0; i < NUM_TEXTS; ++i) {
+        for (size_t j = i + 1; j < NUM_TEXTS; ++j) {
+            for (size_t m = 0; m < num_masks; ++m) {
+                if (((texts[i] ^ texts[j]) & masks[m]) == 0) {
+                    num_collisions++;
+                    break;
+                }
+            }
+        }
+    }
+
+    return num_collisions;
+}
+
+// ---------------------------------------------------------
+
+/**
+ * Restricts the texts to few values per cell, so that there are many
+ * collisions in single cells and in columns.
+ */
+static void generate_texts(xorshift_prng_ctx_t *prng,
+                           uint64_t texts[NUM_TEXTS]) {
+    for (size_t j = 0; j < NUM_TEXTS; ++j) {
+        texts[j] = utils::xorshift1024_next(prng) & 0x1111111111111111ULL;
+    }
+}
+
+// ---------------------------------------------------------
+
+static void run_test(const uint64_t *masks, const size_t num_masks) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, num_masks);
+    uint64_t texts[NUM_TEXTS];
+
+    for (size_t i = 0; i < NUM_TESTS; ++i) {
+        generate_texts(&prng, texts);
+        ASSERT_EQ(count_naively(texts, masks, num_masks),
+                  utils::count_delta_set_collisions(texts, masks, num_masks));
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(DeltaSetCollisionCounter, test_cell_masks) {
+    for (size_t cell_index = 0; cell_index < 16; ++cell_index) {
+        const uint64_t mask = utils::get_cell_mask(cell_index);
+        run_test(&mask, 1);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(DeltaSetCollisionCounter, test_column_masks) {
+    for (size_t column_index = 0; column_index < 4; ++column_index) {
+        ASSERT_EQ(utils::COLUMN_MASKS[column_index],
+                  utils::get_column_mask(column_index));
+    }
+
+    run_test(utils::COLUMN_MASKS, DELTA_SET_COLLISION_COUNTER_NUM_COLUMNS);
+}
+
+// ---------------------------------------------------------
+
+TEST(DeltaSetCollisionCounter, test_inverse_diagonal_masks) {
+    uint64_t masks[4];
+
+    for (size_t i = 0; i < 4; ++i) {
+        masks[i] = 0;
+
+        // Cells (row r, column i - r), which InvShiftRows moves to column i
+        for (size_t row = 0; row < 4; ++row) {
+            masks[i] |= utils::get_cell_mask(4 * ((i + 4 - row) % 4) + row);
+        }
+    }
+
+    run_test(masks, 4);
+}
+
+// ---------------------------------------------------------
+
+TEST(DeltaSetCollisionCounter, test_trivial_masks) {
+    uint64_t texts[NUM_TEXTS];
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, 0);
+    generate_texts(&prng, texts);
+
+    const uint64_t empty_mask = 0;
+    ASSERT_EQ(NUM_TEXTS * (NUM_TEXTS - 1) / 2,
+              utils::count_delta_set_collisions(texts, &empty_mask, 1));
+    ASSERT_EQ(0U, utils::count_delta_set_collisions(texts, &empty_mask, 0));
+
+    for (size_t j = 0; j < NUM_TEXTS; ++j) {
+        texts[j] = j;
+    }
+
+    const uint64_t full_mask = 0xFFFFFFFFFFFFFFFFULL;
+    ASSERT_EQ(0U, utils::count_delta_set_collisions(texts, &full_mask, 1));
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
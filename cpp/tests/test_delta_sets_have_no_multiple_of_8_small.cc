@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <array>
 #include <vector>
 
 #include "ciphers/random_function.h"
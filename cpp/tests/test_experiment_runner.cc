@@ -0,0 +1,205 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include <gtest/gtest.h>
+
+#include "utils/experiment_runner.h"
+
+
+using utils::ExperimentResult;
+using utils::ExperimentTask;
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+static size_t count_in_task(const ExperimentTask &task) {
+    // A deterministic value per set, so that sums can be checked exactly
+    size_t result = 0;
+
+    for (size_t i = task.first_set_index;
+         i < task.first_set_index + task.num_sets;
+         ++i) {
+        result += (task.key_index + 1) * i;
+    }
+
+    return result;
+}
+
+// ---------------------------------------------------------
+
+static size_t count_random_values_in_task(const ExperimentTask &task) {
+    size_t result = 0;
+
+    for (size_t i = 0; i < task.num_sets; ++i) {
+        result += utils::xorshift1024_next(task.prng) & 0xFF;
+    }
+
+    return result;
+}
+
+// ---------------------------------------------------------
+
+static void run_experiments(ExperimentResult &result,
+                            const size_t num_threads,
+                            const utils::experiment_task_function_t &function) {
+    const size_t num_keys = 5;
+    const size_t num_sets_per_key = 1000;
+    const size_t num_sets_per_task = 64;
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, 42);
+    utils::run_experiments_in_parallel(result,
+                                       num_keys,
+                                       num_sets_per_key,
+                                       num_sets_per_task,
+                                       num_threads,
+                                       &prng,
+                                       function);
+}
+
+// ---------------------------------------------------------
+
+TEST(ExperimentRunner, run_in_parallel_visits_all_tasks) {
+    const size_t num_tasks = 1000;
+    std::vector<std::atomic<size_t> > num_visits(num_tasks);
+
+    for (std::atomic<size_t> &value : num_visits) {
+        value = 0;
+    }
+
+    utils::run_in_parallel(num_tasks, 4, [&](const size_t task_index,
+                                             const size_t thread_index) {
+        ASSERT_LT(thread_index, (size_t) 4);
+        num_visits[task_index]++;
+    });
+
+    for (size_t i = 0; i < num_tasks; ++i) {
+        ASSERT_EQ((size_t) 1, (size_t) num_visits[i]);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(ExperimentRunner, parallel_sums_equal_serial_sums) {
+    ExperimentResult serial_result;
+    ExperimentResult parallel_result;
+    run_experiments(serial_result, 1, &count_in_task);
+    run_experiments(parallel_result, 8, &count_in_task);
+
+    const size_t sum_of_set_indices = 999 * 1000 / 2;
+    ASSERT_EQ(serial_result.num_collisions, parallel_result.num_collisions);
+    ASSERT_EQ(serial_result.num_collisions_per_set,
+              parallel_result.num_collisions_per_set);
+    ASSERT_EQ((size_t) 5, parallel_result.num_collisions_per_set.size());
+    ASSERT_EQ(sum_of_set_indices * 3,
+              parallel_result.num_collisions_per_set[2]);
+    ASSERT_EQ(sum_of_set_indices * 15, parallel_result.num_collisions);
+}
+
+// ---------------------------------------------------------
+
+TEST(ExperimentRunner, seeded_random_sums_are_independent_of_threads) {
+    ExperimentResult serial_result;
+    ExperimentResult parallel_result;
+    run_experiments(serial_result, 1, &count_random_values_in_task);
+    run_experiments(parallel_result, 3, &count_random_values_in_task);
+
+    ASSERT_EQ(serial_result.num_collisions, parallel_result.num_collisions);
+    ASSERT_EQ(serial_result.num_collisions_per_set,
+              parallel_result.num_collisions_per_set);
+}
+
+// ---------------------------------------------------------
+
+static void run_experiments_until(ExperimentResult &result,
+                                  const size_t num_threads,
+                                  const size_t last_key_index,
+                                  const size_t last_first_set_index) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, 42);
+    size_t next_key_index = 0;
+    size_t next_first_set_index = 0;
+    utils::run_experiments_in_parallel(
+        result, 5, 1000, 64, num_threads, &prng,
+        &count_random_values_in_task,
+        [&](const ExperimentTask &task, const size_t num_collisions) {
+            EXPECT_EQ(next_key_index, task.key_index);
+            EXPECT_EQ(next_first_set_index, task.first_set_index);
+            EXPECT_GE(result.num_collisions_per_set[task.key_index],
+                      num_collisions);
+            next_first_set_index += task.num_sets;
+
+            if (next_first_set_index == 1000) {
+                next_key_index++;
+                next_first_set_index = 0;
+            }
+
+            return (task.key_index == last_key_index)
+                   && (task.first_set_index == last_first_set_index);
+        }
+    );
+}
+
+// ---------------------------------------------------------
+
+TEST(ExperimentRunner, stopped_runs_are_prefixes_of_full_runs) {
+    ExperimentResult full_result;
+    run_experiments(full_result, 1, &count_random_values_in_task);
+
+    for (size_t num_threads = 1; num_threads <= 32; num_threads *= 4) {
+        // Stops at the last task of the third key
+        ExperimentResult stopped_result;
+        run_experiments_until(stopped_result, num_threads, 2, 960);
+        ASSERT_EQ((size_t) 3, stopped_result.num_collisions_per_set.size());
+        ASSERT_EQ(full_result.num_collisions_per_set[0]
+                  + full_result.num_collisions_per_set[1]
+                  + full_result.num_collisions_per_set[2],
+                  stopped_result.num_collisions);
+
+        for (size_t i = 0; i < 3; ++i) {
+            ASSERT_EQ(full_result.num_collisions_per_set[i],
+                      stopped_result.num_collisions_per_set[i]);
+            ASSERT_EQ((size_t) 1000, stopped_result.num_sets_per_key[i]);
+        }
+
+        // Never stops
+        ExperimentResult unstopped_result;
+        run_experiments_until(unstopped_result, num_threads, 5, 0);
+        ASSERT_EQ(full_result.num_collisions_per_set,
+                  unstopped_result.num_collisions_per_set);
+        ASSERT_EQ(full_result.num_sets_per_key,
+                  unstopped_result.num_sets_per_key);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(ExperimentRunner, runs_can_stop_within_the_first_key) {
+    ExperimentResult full_result;
+    run_experiments(full_result, 1, &count_random_values_in_task);
+
+    ExperimentResult serial_result;
+    run_experiments_until(serial_result, 1, 0, 128);
+
+    for (size_t num_threads = 1; num_threads <= 32; num_threads *= 4) {
+        ExperimentResult stopped_result;
+        run_experiments_until(stopped_result, num_threads, 0, 128);
+        ASSERT_EQ((size_t) 1, stopped_result.num_collisions_per_set.size());
+        ASSERT_EQ((size_t) 192, stopped_result.num_sets_per_key[0]);
+        ASSERT_EQ(serial_result.num_collisions,
+                  stopped_result.num_collisions);
+        ASSERT_LT(stopped_result.num_collisions,
+                  full_result.num_collisions_per_set[0]);
+    }
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
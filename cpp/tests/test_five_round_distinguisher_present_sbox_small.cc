@@ -15,6 +15,7 @@
 #include "ciphers/small_state.h"
 #include "ciphers/speck64.h"
 #include "utils/argparse.h"
+#include "utils/delta_set_collision_counter.h"
 #include "utils/utils.h"
 #include "utils/xorshift1024.h"
 
@@ -29,7 +30,6 @@ using ciphers::speck64_state_t;
 using utils::assert_equal;
 using utils::compute_mean;
 using utils::compute_variance;
-using utils::xor_arrays;
 using utils::ArgumentParser;
 
 // ---------------------------------------------------------
@@ -56,8 +56,6 @@ typedef struct {
 
 typedef size_t (*experiment_function_t)(ExperimentContext *);
 
-typedef std::vector<SmallState> SmallStatesVector;
-
 // ---------------------------------------------------------
 
 static void
@@ -142,35 +140,11 @@ static void encrypt(const small_aes_ctx_t *aes_context,
 
 // ---------------------------------------------------------
 
-bool has_zero_column(const small_aes_state_t state) {
-    return ((state[0] == 0) && (state[1] == 0))
-           || ((state[2] == 0) && (state[3] == 0))
-           || ((state[4] == 0) && (state[5] == 0))
-           || ((state[6] == 0) && (state[7] == 0));
-}
-
-// ---------------------------------------------------------
-
-static size_t find_num_collisions(SmallStatesVector &ciphertexts) {
-    const size_t num_texts = ciphertexts.size();
-    size_t num_collisions = 0;
-    small_aes_state_t temp;
-
-    for (size_t i = 0; i != num_texts; ++i) {
-        const SmallState left = ciphertexts[i];
-
-        for (size_t j = i + 1; j != num_texts; ++j) {
-            const SmallState right = ciphertexts[j];
-            xor_arrays(temp, left.state, right.state,
-                       SMALL_AES_NUM_STATE_BYTES);
-
-            if (has_zero_column(temp)) {
-                num_collisions++;
-            }
-        }
-    }
-
-    return num_collisions;
+static size_t find_num_collisions(const uint64_t *ciphertexts) {
+    return utils::count_delta_set_collisions(
+        ciphertexts, utils::COLUMN_MASKS,
+        DELTA_SET_COLLISION_COUNTER_NUM_COLUMNS
+    );
 }
 
 // ---------------------------------------------------------
@@ -186,7 +160,7 @@ static size_t perform_experiment(ExperimentContext *context) {
     size_t num_collisions = 0;
 
     for (size_t i = 0; i < context->num_sets_per_key; ++i) {
-        SmallStatesVector ciphertexts;
+        uint64_t ciphertexts[NUM_TEXTS_IN_DELTA_SET];
         small_aes_state_t plaintext;
         generate_base_plaintext(plaintext);
 
@@ -194,7 +168,7 @@ static size_t perform_experiment(ExperimentContext *context) {
             SmallState ciphertext;
             get_text_from_delta_set(plaintext, j);
             encrypt(&cipher_ctx, plaintext, ciphertext);
-            ciphertexts.push_back(ciphertext);
+            ciphertexts[j] = ciphertext.to_packed();
         }
 
         num_collisions += find_num_collisions(ciphertexts);
@@ -230,13 +204,13 @@ static size_t perform_experiment_from_diagonal(ExperimentContext *context) {
     for (size_t i = 0; i < num_sets_in_diagonal; ++i) {
         for (size_t m = 0; m < num_bytes_in_diagonal; ++m) {
             generate_base_plaintext_in_diagonal(plaintext, i, m);
-            SmallStatesVector ciphertexts;
+            uint64_t ciphertexts[NUM_TEXTS_IN_DELTA_SET];
 
             for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
                 SmallState ciphertext;
                 get_text_from_diagonal_delta_set(plaintext, m, j);
                 encrypt(&cipher_ctx, plaintext, ciphertext);
-                ciphertexts.push_back(ciphertext);
+                ciphertexts[j] = ciphertext.to_packed();
             }
 
             num_collisions += find_num_collisions(ciphertexts);
@@ -266,7 +240,7 @@ static size_t perform_experiment_with_prp(ExperimentContext *context) {
     size_t num_collisions = 0;
 
     for (size_t i = 0; i < context->num_sets_per_key; ++i) {
-        SmallStatesVector ciphertexts;
+        uint64_t ciphertexts[NUM_TEXTS_IN_DELTA_SET];
         speck64_state_t plaintext;
         generate_base_plaintext(plaintext);
 
@@ -274,7 +248,7 @@ static size_t perform_experiment_with_prp(ExperimentContext *context) {
             SmallState ciphertext;
             get_text_from_delta_set(plaintext, j);
             speck64_encrypt(&cipher_ctx, plaintext, ciphertext.state);
-            ciphertexts.push_back(ciphertext);
+            ciphertexts[j] = ciphertext.to_packed();
         }
 
         num_collisions += find_num_collisions(ciphertexts);
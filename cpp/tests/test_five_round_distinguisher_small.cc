@@ -6,7 +6,9 @@
 
 
 #include <array>
+#include <mutex>
 #include <vector>
+#include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -15,6 +17,10 @@
 #include "ciphers/small_state.h"
 #include "ciphers/speck64.h"
 #include "utils/argparse.h"
+#include "utils/delta_set_collision_counter.h"
+#include "utils/experiment_runner.h"
+#include "utils/profiler.h"
+#include "utils/running_statistics.h"
 #include "utils/utils.h"
 #include "utils/xorshift1024.h"
 
@@ -26,42 +32,64 @@ using ciphers::SmallState;
 using ciphers::speck64_context_t;
 using ciphers::speck64_96_key_t;
 using ciphers::speck64_state_t;
-using utils::compute_mean;
-using utils::compute_variance;
-using utils::xor_arrays;
 using utils::ArgumentParser;
+using utils::ConfidenceInterval;
+using utils::ExperimentResult;
+using utils::ExperimentTask;
+using utils::RunningStatistics;
+using utils::SequentialProbabilityRatioTest;
+using utils::SprtDecision;
+using utils::xorshift_prng_ctx_t;
 
 // ---------------------------------------------------------
 
 static const size_t NUM_CONSIDERED_ROUNDS = 5;
 static const size_t NUM_TEXTS_IN_DELTA_SET = 16;
+static const size_t NUM_SETS_IN_DIAGONAL = 1L << 12;
+static const size_t NUM_SETS_PER_TASK = 1L << 12;
+static const size_t NUM_BYTES_IN_DIAGONAL = 4;
+static const size_t NUM_PAIRS_IN_DELTA_SET =
+    NUM_TEXTS_IN_DELTA_SET * (NUM_TEXTS_IN_DELTA_SET - 1) / 2;
+static const double DEFAULT_CONFIDENCE = 0.95;
+static const double DEFAULT_MIN_RELATIVE_DIFFERENCE = 0.01;
+
+// A PRP collides in at least one of the four 16-bit columns
+static const double PRP_COLLISION_PROBABILITY =
+    1.0 - pow(1.0 - 1.0 / (double) (1L << 16), 4);
 
 // ---------------------------------------------------------
 
+typedef std::array<uint8_t, SPECK_64_96_NUM_KEY_BYTES> KeyBytes;
+typedef std::array<uint8_t, SMALL_AES_NUM_STATE_BYTES> StateBytes;
+
 typedef struct {
-    small_aes_key_t key;
-    small_aes_ctx_t cipher_ctx;
     size_t num_keys;
     size_t num_sets_per_key;
+    size_t num_threads;
+    uint64_t seed;
+    xorshift_prng_ctx_t prng;
     std::vector<size_t> num_matches;
+    // Drawn in the order of the keys as their first task starts
+    std::vector<KeyBytes> keys;
+    std::vector<StateBytes> base_plaintexts;
+    size_t num_drawn_keys = 0;
+    xorshift_prng_ctx_t key_prng;
+    std::mutex key_mutex;
     bool use_prp = false;
     bool use_all_delta_sets_from_diagonal = false;
+    // Stops as soon as the sequential test decides if in (0, 1)
+    double target_confidence = 0.0;
+    double min_relative_difference = DEFAULT_MIN_RELATIVE_DIFFERENCE;
 } ExperimentContext;
 
-typedef struct {
-    std::vector<size_t> num_collisions_per_set;
-    size_t num_collisions;
-} ExperimentResult;
-
-typedef size_t (*experiment_function_t)(ExperimentContext *);
-
-typedef std::vector<SmallState> SmallStatesVector;
+typedef size_t (*experiment_function_t)(const ExperimentContext *,
+                                        const ExperimentTask &);
 
 // ---------------------------------------------------------
 
-static void
-generate_base_plaintext(small_aes_state_t plaintext) {
-    utils::get_random_bytes(plaintext, SMALL_AES_NUM_STATE_BYTES);
+static void generate_base_plaintext(xorshift_prng_ctx_t *prng,
+                                    small_aes_state_t plaintext) {
+    utils::get_random_bytes(prng, plaintext, SMALL_AES_NUM_STATE_BYTES);
 }
 
 // ---------------------------------------------------------
@@ -141,156 +169,227 @@ static void encrypt(const small_aes_ctx_t *aes_context,
 
 // ---------------------------------------------------------
 
-bool has_zero_column(const small_aes_state_t state) {
-    return ((state[0] == 0) && (state[1] == 0))
-           || ((state[2] == 0) && (state[3] == 0))
-           || ((state[4] == 0) && (state[5] == 0))
-           || ((state[6] == 0) && (state[7] == 0));
+static size_t find_num_collisions(const uint64_t *ciphertexts) {
+    return utils::count_delta_set_collisions(
+        ciphertexts, utils::COLUMN_MASKS,
+        DELTA_SET_COLLISION_COUNTER_NUM_COLUMNS
+    );
 }
 
 // ---------------------------------------------------------
 
-static size_t find_num_collisions(SmallStatesVector &ciphertexts) {
-    const size_t num_texts = ciphertexts.size();
-    size_t num_collisions = 0;
-    small_aes_state_t temp;
-
-    for (size_t i = 0; i != num_texts; ++i) {
-        const SmallState left = ciphertexts[i];
-
-        for (size_t j = i + 1; j != num_texts; ++j) {
-            const SmallState right = ciphertexts[j];
-            xor_arrays(temp, left.state, right.state,
-                       SMALL_AES_NUM_STATE_BYTES);
+static size_t perform_experiment(const ExperimentContext *context,
+                                 const ExperimentTask &task) {
+    small_aes_ctx_t cipher_ctx;
 
-            if (has_zero_column(temp)) {
-                num_collisions++;
-            }
-        }
+    {
+        PROFILE_PHASE(PROFILER_PHASE_KEY_SETUP);
+        small_aes_key_setup(&cipher_ctx, context->keys[task.key_index].data());
     }
 
-    return num_collisions;
-}
-
-// ---------------------------------------------------------
-
-static size_t perform_experiment(ExperimentContext *context) {
-    small_aes_ctx_t cipher_ctx = context->cipher_ctx;
-    small_aes_key_t key;
-
-    utils::get_random_bytes(key, SMALL_AES_NUM_KEY_BYTES);
-    small_aes_key_setup(&cipher_ctx, key);
-    utils::print_hex("# Key", key, SMALL_AES_NUM_KEY_BYTES);
-
     size_t num_collisions = 0;
 
-    for (size_t i = 0; i < context->num_sets_per_key; ++i) {
-        SmallStatesVector ciphertexts;
+    for (size_t i = 0; i < task.num_sets; ++i) {
+        uint64_t ciphertexts[NUM_TEXTS_IN_DELTA_SET];
         small_aes_state_t plaintext;
-        generate_base_plaintext(plaintext);
 
-        for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
-            SmallState ciphertext;
-            get_text_from_delta_set(plaintext, j);
-            encrypt(&cipher_ctx, plaintext, ciphertext);
-            ciphertexts.push_back(ciphertext);
+        {
+            PROFILE_PHASE(PROFILER_PHASE_RNG);
+            generate_base_plaintext(task.prng, plaintext);
         }
 
-        num_collisions += find_num_collisions(ciphertexts);
+        {
+            PROFILE_PHASE(PROFILER_PHASE_ENCRYPTION);
 
-        if (i > 0) {
-            if ((i & 0xFFFFF) == 0) {
-                printf("# Tested %8zu sets. Collisions: %8zu\n", i,
-                       num_collisions);
+            for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
+                SmallState ciphertext;
+                get_text_from_delta_set(plaintext, j);
+                encrypt(&cipher_ctx, plaintext, ciphertext);
+                ciphertexts[j] = ciphertext.to_packed();
             }
         }
+
+        PROFILE_PHASE(PROFILER_PHASE_COLLISION_COUNTING);
+        num_collisions += find_num_collisions(ciphertexts);
     }
 
+    PROFILE_ADD(PROFILER_COUNTER_TEXTS, task.num_sets * NUM_TEXTS_IN_DELTA_SET);
+    PROFILE_ADD(PROFILER_COUNTER_SETS, task.num_sets);
     return num_collisions;
 }
 
 // ---------------------------------------------------------
 
-static size_t perform_experiment_from_diagonal(ExperimentContext *context) {
-    small_aes_ctx_t cipher_ctx = context->cipher_ctx;
-    small_aes_key_t key;
+static size_t
+perform_experiment_from_diagonal(const ExperimentContext *context,
+                                 const ExperimentTask &task) {
+    small_aes_ctx_t cipher_ctx;
 
-    utils::get_random_bytes(key, SMALL_AES_NUM_KEY_BYTES);
-    small_aes_key_setup(&cipher_ctx, key);
-    utils::print_hex("# Key", key, SMALL_AES_NUM_KEY_BYTES);
+    {
+        PROFILE_PHASE(PROFILER_PHASE_KEY_SETUP);
+        small_aes_key_setup(&cipher_ctx, context->keys[task.key_index].data());
+    }
 
     size_t num_collisions = 0;
-    const size_t num_sets_in_diagonal = 1L << 12;
     const size_t num_bytes_in_diagonal = 4;
 
     small_aes_state_t plaintext;
-    generate_base_plaintext(plaintext);
+    memcpy(plaintext,
+           context->base_plaintexts[task.key_index].data(),
+           SMALL_AES_NUM_STATE_BYTES);
 
-    for (size_t i = 0; i < num_sets_in_diagonal; ++i) {
+    for (size_t i = task.first_set_index;
+         i < task.first_set_index + task.num_sets;
+         ++i) {
         for (size_t m = 0; m < num_bytes_in_diagonal; ++m) {
-            generate_base_plaintext_in_diagonal(plaintext, i, m);
-            SmallStatesVector ciphertexts;
+            uint64_t ciphertexts[NUM_TEXTS_IN_DELTA_SET];
 
-            for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
-                SmallState ciphertext;
-                get_text_from_diagonal_delta_set(plaintext, m, j);
-                encrypt(&cipher_ctx, plaintext, ciphertext);
-                ciphertexts.push_back(ciphertext);
+            {
+                PROFILE_PHASE(PROFILER_PHASE_PLAINTEXT_GENERATION);
+                generate_base_plaintext_in_diagonal(plaintext, i, m);
             }
 
-            num_collisions += find_num_collisions(ciphertexts);
-        }
+            {
+                PROFILE_PHASE(PROFILER_PHASE_ENCRYPTION);
 
-        if (i > 0) {
-            if ((i & 0xFFFFF) == 0) {
-                printf("# Tested %8zu sets. Collisions: %8zu\n", i,
-                       num_collisions);
+                for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
+                    SmallState ciphertext;
+                    get_text_from_diagonal_delta_set(plaintext, m, j);
+                    encrypt(&cipher_ctx, plaintext, ciphertext);
+                    ciphertexts[j] = ciphertext.to_packed();
+                }
             }
+
+            PROFILE_PHASE(PROFILER_PHASE_COLLISION_COUNTING);
+            num_collisions += find_num_collisions(ciphertexts);
         }
     }
 
+    PROFILE_ADD(PROFILER_COUNTER_TEXTS,
+                task.num_sets * num_bytes_in_diagonal * NUM_TEXTS_IN_DELTA_SET);
+    PROFILE_ADD(PROFILER_COUNTER_SETS, task.num_sets * num_bytes_in_diagonal);
     return num_collisions;
 }
 
 // ---------------------------------------------------------
 
-static size_t perform_experiment_with_prp(ExperimentContext *context) {
+static size_t perform_experiment_with_prp(const ExperimentContext *context,
+                                          const ExperimentTask &task) {
     speck64_context_t cipher_ctx;
-    speck64_96_key_t key;
 
-    utils::get_random_bytes(key, SPECK_64_96_NUM_KEY_BYTES);
-    utils::print_hex("# Key", key, SPECK_64_96_NUM_KEY_BYTES);
-    speck64_96_key_schedule(&cipher_ctx, key);
+    {
+        PROFILE_PHASE(PROFILER_PHASE_KEY_SETUP);
+        speck64_96_key_schedule(&cipher_ctx,
+                                context->keys[task.key_index].data());
+    }
 
     size_t num_collisions = 0;
 
-    for (size_t i = 0; i < context->num_sets_per_key; ++i) {
-        SmallStatesVector ciphertexts;
+    for (size_t i = 0; i < task.num_sets; ++i) {
+        uint64_t ciphertexts[NUM_TEXTS_IN_DELTA_SET];
         speck64_state_t plaintext;
-        generate_base_plaintext(plaintext);
 
-        for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
-            SmallState ciphertext;
-            get_text_from_delta_set(plaintext, j);
-            speck64_encrypt(&cipher_ctx, plaintext, ciphertext.state);
-            ciphertexts.push_back(ciphertext);
+        {
+            PROFILE_PHASE(PROFILER_PHASE_RNG);
+            generate_base_plaintext(task.prng, plaintext);
         }
 
-        num_collisions += find_num_collisions(ciphertexts);
+        {
+            PROFILE_PHASE(PROFILER_PHASE_ENCRYPTION);
 
-        if (i > 0) {
-            if ((i & 0xFFFFF) == 0) {
-                printf("# Tested %8zu sets. Collisions: %8zu\n", i,
-                       num_collisions);
+            for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
+                SmallState ciphertext;
+                get_text_from_delta_set(plaintext, j);
+                speck64_encrypt(&cipher_ctx, plaintext, ciphertext.state);
+                ciphertexts[j] = ciphertext.to_packed();
             }
         }
+
+        PROFILE_PHASE(PROFILER_PHASE_COLLISION_COUNTING);
+        num_collisions += find_num_collisions(ciphertexts);
     }
 
+    PROFILE_ADD(PROFILER_COUNTER_TEXTS, task.num_sets * NUM_TEXTS_IN_DELTA_SET);
+    PROFILE_ADD(PROFILER_COUNTER_SETS, task.num_sets);
     return num_collisions;
 }
 
 // ---------------------------------------------------------
 
+static void set_up_keys(ExperimentContext *context) {
+    context->keys.resize(context->num_keys);
+    context->base_plaintexts.resize(context->num_keys);
+    context->num_drawn_keys = 0;
+    utils::xorshift1024_split(&context->prng, &context->key_prng);
+}
+
+// ---------------------------------------------------------
+
+/**
+ * Draws the keys and base plaintexts up to key_index from their own stream
+ * in the order of the keys, so that they do not depend on the threads, and
+ * a run that stops early neither draws nor prints the keys it does not use.
+ */
+static void draw_keys(ExperimentContext *context, const size_t key_index) {
+    const size_t num_key_bytes = context->use_prp ?
+                                 SPECK_64_96_NUM_KEY_BYTES :
+                                 SMALL_AES_NUM_KEY_BYTES;
+    std::lock_guard<std::mutex> lock(context->key_mutex);
+
+    for (; context->num_drawn_keys <= key_index; ++context->num_drawn_keys) {
+        const size_t i = context->num_drawn_keys;
+        utils::get_random_bytes(&context->key_prng,
+                                context->keys[i].data(),
+                                num_key_bytes);
+        generate_base_plaintext(&context->key_prng,
+                                context->base_plaintexts[i].data());
+        utils::print_hex("# Key", context->keys[i].data(), num_key_bytes);
+    }
+}
+
+// ---------------------------------------------------------
+
+static const char *get_decision_name(const SprtDecision decision) {
+    switch (decision) {
+        case utils::SPRT_ACCEPT_NULL:
+            return "random";
+        case utils::SPRT_ACCEPT_ALTERNATIVE:
+            return "cipher";
+        default:
+            return "undecided";
+    }
+}
+
+// ---------------------------------------------------------
+
+static void print_statistics(const ExperimentContext *context,
+                             const RunningStatistics &statistics,
+                             const double expected_num_collisions_per_key,
+                             const SprtDecision decision,
+                             const size_t num_sets) {
+    const double confidence = (context->target_confidence > 0) ?
+                              context->target_confidence :
+                              DEFAULT_CONFIDENCE;
+
+    printf("# PRP Mean %8.4f\n", expected_num_collisions_per_key);
+
+    // The interval needs the variance over at least two complete keys
+    if (statistics.get_num_values() > 1) {
+        const ConfidenceInterval interval =
+            statistics.get_confidence_interval(confidence);
+        printf("# %.4f-CI of Mean [%8.4f, %8.4f]\n",
+               confidence, interval.lower, interval.upper);
+    }
+
+    if (context->target_confidence > 0) {
+        printf("# Decision %s after %zu sets\n",
+               get_decision_name(decision),
+               num_sets);
+    }
+}
+
+// ---------------------------------------------------------
+
 static void perform_experiments(ExperimentContext *context) {
     experiment_function_t experiment_function = nullptr;
 
@@ -303,35 +402,108 @@ static void perform_experiments(ExperimentContext *context) {
         experiment_function = &perform_experiment_from_diagonal;
     }
 
+    const size_t num_sets_per_key =
+        context->use_all_delta_sets_from_diagonal && !context->use_prp ?
+        NUM_SETS_IN_DIAGONAL :
+        context->num_sets_per_key;
+
+    PROFILE_START();
+    set_up_keys(context);
+
+    // Every set index in a diagonal yields one delta set per byte
+    const size_t num_pairs_per_set =
+        (context->use_all_delta_sets_from_diagonal && !context->use_prp ?
+         NUM_BYTES_IN_DIAGONAL :
+         1) * NUM_PAIRS_IN_DELTA_SET;
+    const double expected_num_collisions_per_key =
+        (double) (num_sets_per_key * num_pairs_per_set)
+        * PRP_COLLISION_PROBABILITY;
+    const utils::experiment_task_function_t task_function =
+        [context, experiment_function](const ExperimentTask &task) {
+            draw_keys(context, task.key_index);
+            return experiment_function(context, task);
+        };
+
     ExperimentResult all_results;
-    all_results.num_collisions = 0;
+    RunningStatistics statistics;
+    SprtDecision decision = utils::SPRT_CONTINUE;
+
+    if (context->target_confidence > 0) {
+        // Tests the collisions of all pairs so far after every task
+        const SequentialProbabilityRatioTest test(
+            PRP_COLLISION_PROBABILITY,
+            context->min_relative_difference * PRP_COLLISION_PROBABILITY,
+            context->target_confidence
+        );
+        size_t num_collisions = 0;
+        size_t num_pairs = 0;
+        utils::run_experiments_in_parallel(
+            all_results,
+            context->num_keys,
+            num_sets_per_key,
+            NUM_SETS_PER_TASK,
+            context->num_threads,
+            &context->prng,
+            task_function,
+            [&](const ExperimentTask &task,
+                const size_t num_task_collisions) {
+                num_collisions += num_task_collisions;
+                num_pairs += task.num_sets * num_pairs_per_set;
+                decision = test.decide(num_collisions, num_pairs);
+                return decision != utils::SPRT_CONTINUE;
+            }
+        );
+    } else {
+        utils::run_experiments_in_parallel(
+            all_results,
+            context->num_keys,
+            num_sets_per_key,
+            NUM_SETS_PER_TASK,
+            context->num_threads,
+            &context->prng,
+            task_function
+        );
+    }
+
+    const size_t num_keys = all_results.num_collisions_per_set.size();
+    size_t num_sets = 0;
+    size_t num_collisions_of_complete_keys = 0;
+
+    // A stopped run may end within its last key, which is left out of the
+    // statistics over the keys
+    for (size_t i = 0; i < num_keys; ++i) {
+        num_sets += all_results.num_sets_per_key[i];
 
-    printf("#%8zu Experiments\n", context->num_keys);
+        if (all_results.num_sets_per_key[i] == num_sets_per_key) {
+            const size_t num_collisions = all_results.num_collisions_per_set[i];
+            num_collisions_of_complete_keys += num_collisions;
+            statistics.add((double) num_collisions);
+        }
+    }
+
+    printf("#%8zu Experiments\n", num_keys);
     printf("#%8zu Sets/key\n", context->num_sets_per_key);
     printf("# Key Collisions Mean Variance \n");
 
-    for (size_t i = 0; i < context->num_keys; ++i) {
-        const size_t num_collisions = experiment_function(context);
-        const double mean =
-            (double) num_collisions / (double) context->num_sets_per_key;
-
-        all_results.num_collisions += num_collisions;
-        all_results.num_collisions_per_set.push_back(num_collisions);
+    for (size_t i = 0; i < num_keys; ++i) {
+        const size_t num_collisions = all_results.num_collisions_per_set[i];
+        const double mean = (double) num_collisions
+                            / (double) all_results.num_sets_per_key[i];
 
         printf("%4zu %8zu %8.4f\n", i + 1, num_collisions, mean);
     }
 
-    const double mean = compute_mean(all_results.num_collisions_per_set);
-    const double variance = compute_variance(
-        all_results.num_collisions_per_set);
-
     printf("# Total Keys Collisions Mean Variance \n");
 
     printf("# %4zu %8zu %8.4f %8.8f\n",
-           context->num_keys,
-           all_results.num_collisions,
-           mean,
-           variance);
+           statistics.get_num_values(),
+           num_collisions_of_complete_keys,
+           statistics.get_mean(),
+           statistics.get_variance());
+
+    print_statistics(context, statistics, expected_num_collisions_per_key,
+                     decision, num_sets);
+    PROFILE_PRINT();
 }
 
 // ---------------------------------------------------------
@@ -344,11 +516,19 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
     parser.appName("Test for the Small-AES five-round distinguisher."
                    "If -d 1 -r 0 is set, uses all 4 * 2^12 * binom(16, 2) "
                    "delta-sets from diagonals, but only for the Small-AES, "
-                   "not for the PRP.");
+                   "not for the PRP. "
+                   "If -c is set, stops after the first key at which a "
+                   "sequential test decides with this confidence whether "
+                   "the mean collisions differ from those of a PRP by at "
+                   "least the fraction -m (default: 0.01).");
     parser.addArgument("-k", "--num_keys", 1, false);
     parser.addArgument("-s", "--num_sets_per_key", 1, false);
     parser.addArgument("-r", "--use_random_function", 1, false);
     parser.addArgument("-d", "--use_diagonals", 1, false);
+    parser.addArgument("-t", "--num_threads", 1, true);
+    parser.addArgument("-e", "--seed", 1, true);
+    parser.addArgument("-c", "--target_confidence", 1, true);
+    parser.addArgument("-m", "--min_relative_difference", 1, true);
 
     try {
         parser.parse((size_t) argc, argv);
@@ -359,15 +539,56 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
         context->use_prp = (bool) parser.retrieveAsInt("r");
         context->use_all_delta_sets_from_diagonal = (bool) parser.retrieveAsInt(
             "d");
+        context->num_threads = utils::get_num_available_threads();
+
+        if (parser.wasSet("-t")) {
+            context->num_threads = parser.retrieveAsLong("t");
+        }
+
+        context->seed = parser.wasSet("-e") ?
+                        parser.retrieveAsLong("e") :
+                        utils::get_random_seed_from_dev_urandom();
+
+        if (parser.wasSet("-c")) {
+            context->target_confidence =
+                std::stod(parser.retrieve<std::string>("c"));
+        }
+
+        if (parser.wasSet("-m")) {
+            context->min_relative_difference =
+                std::stod(parser.retrieve<std::string>("m"));
+        }
     } catch (...) {
         fprintf(stderr, "%s\n", parser.usage().c_str());
         exit(EXIT_FAILURE);
     }
 
+    if ((context->target_confidence < 0) || (context->target_confidence >= 1)) {
+        fprintf(stderr, "target_confidence must be in (0, 1)\n");
+        fprintf(stderr, "%s\n", parser.usage().c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    if ((context->min_relative_difference <= 0)
+        || (context->min_relative_difference >= 1)) {
+        fprintf(stderr, "min_relative_difference must be in (0, 1)\n");
+        fprintf(stderr, "%s\n", parser.usage().c_str());
+        exit(EXIT_FAILURE);
+    }
+
     printf("#Keys           %8zu\n", context->num_keys);
     printf("#Sets/Key (log) %8zu\n", context->num_sets_per_key);
     printf("#Uses PRP       %8d\n", context->use_prp);
     printf("#Uses Diagonal  %8d\n", context->use_all_delta_sets_from_diagonal);
+    printf("#Threads        %8zu\n", context->num_threads);
+    printf("#Seed           %20zu\n", context->seed);
+
+    if (context->target_confidence > 0) {
+        printf("#Target conf.   %8.4f\n", context->target_confidence);
+        printf("#Min rel. diff. %8.4f\n", context->min_relative_difference);
+    }
+
+    utils::xorshift1024_init_with_seed(&context->prng, context->seed);
 }
 
 // ---------------------------------------------------------
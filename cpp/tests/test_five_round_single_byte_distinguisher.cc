@@ -13,6 +13,7 @@
 #include "ciphers/small_aes.h"
 #include "ciphers/aes_state.h"
 #include "utils/argparse.h"
+#include "utils/experiment_runner.h"
 #include "utils/utils.h"
 #include "utils/xorshift1024.h"
 
@@ -31,6 +32,8 @@ using utils::xorshift_prng_ctx_t;
 
 static const size_t NUM_TEXTS_IN_STRUCTURE = 1L << 32;
 static const size_t NUM_CELL_VALUES = 256;
+static const size_t NUM_TEXTS_PER_TASK = 1L << 24;
+static const size_t NUM_COUNTERS_PER_CACHE_LINE = 64 / sizeof(size_t);
 
 // ---------------------------------------------------------
 
@@ -40,6 +43,7 @@ typedef struct {
     size_t num_keys;
     size_t num_rounds;
     size_t num_structures_per_key;
+    size_t num_threads = 1;
     bool use_prp = false;
 } ExperimentContext;
 
@@ -48,6 +52,50 @@ typedef std::vector<AESState> AESStatesVector;
 
 // ---------------------------------------------------------
 
+/**
+ * One private histogram per thread in a common buffer. Every histogram
+ * starts at a cache line, so that no two threads increment counters in
+ * the same line.
+ */
+class ThreadHistograms {
+public:
+    explicit ThreadHistograms(const size_t num_threads) :
+        num_threads_(num_threads),
+        counters_(num_threads * NUM_CELL_VALUES
+                  + NUM_COUNTERS_PER_CACHE_LINE) {
+        const size_t misalignment =
+            ((uintptr_t) counters_.data() / sizeof(size_t))
+            % NUM_COUNTERS_PER_CACHE_LINE;
+        offset_ = (misalignment == 0)
+                  ? 0 : NUM_COUNTERS_PER_CACHE_LINE - misalignment;
+    }
+
+    size_t *get(const size_t thread_index) {
+        return counters_.data() + offset_ + thread_index * NUM_CELL_VALUES;
+    }
+
+    void clear() {
+        std::fill(counters_.begin(), counters_.end(), 0);
+    }
+
+    void merge_into(HistogramVector &histogram) {
+        for (size_t t = 0; t < num_threads_; ++t) {
+            const size_t *counters = get(t);
+
+            for (size_t i = 0; i < NUM_CELL_VALUES; ++i) {
+                histogram[i] += counters[i];
+            }
+        }
+    }
+
+private:
+    size_t num_threads_;
+    size_t offset_;
+    HistogramVector counters_;
+};
+
+// ---------------------------------------------------------
+
 static void generate_base_plaintext(aes_state_t plaintext) {
     utils::get_random_bytes(plaintext, AES_NUM_STATE_BYTES);
 
@@ -64,42 +112,38 @@ static void generate_base_plaintext(aes_state_t plaintext) {
 
 // ---------------------------------------------------------
 
-static void
-get_text_from_delta_set(aes_state_t base_text, const size_t i) {
-    // Extract from i = [i0 i1 i2 i3]
-    // i0 x  x  x
-    // x  i1 x  x
-    // x  x  i2 x
-    // x  x  x  i3
-    base_text[0] = (uint8_t)((i >> 24) & 0xFF);
-    base_text[5] = (uint8_t)((i >> 16) & 0xFF);
-    base_text[10] = (uint8_t)((i >> 8) & 0xFF);
-    base_text[15] = (uint8_t)(i & 0xFF);
-}
-
-// ---------------------------------------------------------
-
-static void encrypt(const aes128_ctx_t *aes_context,
-                    const size_t num_rounds,
-                    aes_state_t plaintext,
-                    AESState &ciphertext) {
-    aes128_encrypt_rounds_always_mc(
-        aes_context, plaintext, ciphertext.state, num_rounds
+/**
+ * Adds the first ciphertext bytes of all texts i = [i0 i1 i2 i3] of the
+ * structure to the histogram, where the plaintexts are
+ * i0 x  x  x
+ * x  i1 x  x
+ * x  x  i2 x
+ * x  x  x  i3
+ * Splits the indices into chunks of NUM_TEXTS_PER_TASK texts over all
+ * threads; every thread counts into its own histogram, which are merged
+ * at the end.
+ */
+static void encrypt_structure(const aes128_ctx_t *aes_context,
+                              const size_t num_rounds,
+                              const aes_state_t base_plaintext,
+                              ThreadHistograms &thread_histograms,
+                              const size_t num_threads,
+                              HistogramVector &histogram) {
+    thread_histograms.clear();
+
+    utils::run_in_parallel(
+        NUM_TEXTS_IN_STRUCTURE / NUM_TEXTS_PER_TASK,
+        num_threads,
+        [&](const size_t task_index, const size_t thread_index) {
+            ciphers::aes128_encrypt_diagonal_structure_histogram(
+                aes_context, base_plaintext, task_index * NUM_TEXTS_PER_TASK,
+                NUM_TEXTS_PER_TASK, num_rounds,
+                thread_histograms.get(thread_index)
+            );
+        }
     );
-}
-
-// ---------------------------------------------------------
-
-static size_t extract_cell_value(const aes_state_t state) {
-    return (size_t) state[0];
-}
-
-// ---------------------------------------------------------
 
-static void add_to_num_occurrences(HistogramVector &histogram,
-                                   const aes_state_t state) {
-    const size_t value = extract_cell_value(state);
-    histogram[value]++;
+    thread_histograms.merge_into(histogram);
 }
 
 // ---------------------------------------------------------
@@ -135,19 +179,16 @@ static void perform_experiment(ExperimentContext *context) {
 
     auto num_structures_per_key = context->num_structures_per_key;
     HistogramVector num_occurrences_vector(NUM_CELL_VALUES);
+    ThreadHistograms thread_histograms(context->num_threads);
 
     for (size_t i = 0; i < num_structures_per_key; ++i) {
         aes_state_t plaintext;
         generate_base_plaintext(plaintext);
         init_histogram(num_occurrences_vector);
 
-        for (size_t j = 0; j < NUM_TEXTS_IN_STRUCTURE; ++j) {
-            AESState ciphertext;
-            get_text_from_delta_set(plaintext, j);
-
-            encrypt(&cipher_ctx, context->num_rounds, plaintext, ciphertext);
-            add_to_num_occurrences(num_occurrences_vector, ciphertext.state);
-        }
+        encrypt_structure(&cipher_ctx, context->num_rounds, plaintext,
+                          thread_histograms, context->num_threads,
+                          num_occurrences_vector);
 
         const size_t num_collisions = find_num_collisions(
             num_occurrences_vector
@@ -179,6 +220,7 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
     parser.addArgument("-k", "--num_keys", 1, false);
     parser.addArgument("-s", "--num_structures_per_key", 1, false);
     parser.addArgument("-r", "--num_rounds", 1, false);
+    parser.addArgument("-t", "--num_threads", 1, true);
 
     try {
         parser.parse((size_t) argc, argv);
@@ -186,6 +228,15 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
         context->num_structures_per_key = parser.retrieveAsLong("s");
         context->num_keys = parser.retrieveAsLong("k");
         context->num_rounds = parser.retrieveAsLong("r");
+        context->num_threads = utils::get_num_available_threads();
+
+        if (parser.wasSet("-t")) {
+            context->num_threads = parser.retrieveAsLong("t");
+        }
+
+        if (context->num_threads == 0) {
+            context->num_threads = 1;
+        }
     } catch (...) {
         fprintf(stderr, "%s\n", parser.usage().c_str());
         exit(EXIT_FAILURE);
@@ -194,6 +245,7 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
     printf("#Rounds         %8zu\n", context->num_rounds);
     printf("#Keys           %8zu\n", context->num_keys);
     printf("#Sets/Key (log) %8zu\n", context->num_structures_per_key);
+    printf("#Threads        %8zu\n", context->num_threads);
 }
 
 // ---------------------------------------------------------
@@ -9,6 +9,7 @@
 #include <vector>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ciphers/random_function.h"
 #include "ciphers/aes.h"
@@ -32,6 +33,7 @@ using utils::ArgumentParser;
 
 static const size_t NUM_CONSIDERED_ROUNDS = 4;
 static const size_t NUM_TEXTS_IN_DELTA_SET = 256;
+static const size_t NUM_TEXTS_PER_BATCH = 16;
 
 // ---------------------------------------------------------
 
@@ -116,10 +118,10 @@ get_text_from_diagonal_delta_set(aes_state_t plaintext,
 // ---------------------------------------------------------
 
 static void encrypt(const aes128_ctx_t *aes_context,
-                    aes_state_t plaintext,
-                    AESState &ciphertext) {
-    aes128_encrypt_rounds_only_sbox_in_final(
-        aes_context, plaintext, ciphertext.state, NUM_CONSIDERED_ROUNDS
+                    const aes_state_t plaintexts[NUM_TEXTS_PER_BATCH],
+                    aes_state_t ciphertexts[NUM_TEXTS_PER_BATCH]) {
+    aes128_encrypt_rounds_only_sbox_in_final_16(
+        aes_context, plaintexts, ciphertexts, NUM_CONSIDERED_ROUNDS
     );
 }
 
@@ -167,13 +169,22 @@ static size_t perform_experiment(ExperimentContext *context) {
         generate_base_plaintext(plaintext);
         zeroize(first_bytes, 256);
 
-        for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
-            AESState ciphertext;
-            get_text_from_delta_set(plaintext, j);
-            encrypt(&cipher_ctx, plaintext, ciphertext);
-            
-            const uint8_t first_byte = ciphertext.state[0];
-            first_bytes[first_byte]++;
+        for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET;
+             j += NUM_TEXTS_PER_BATCH) {
+            aes_state_t plaintexts[NUM_TEXTS_PER_BATCH];
+            aes_state_t ciphertexts[NUM_TEXTS_PER_BATCH];
+
+            for (size_t k = 0; k < NUM_TEXTS_PER_BATCH; ++k) {
+                get_text_from_delta_set(plaintext, j + k);
+                memcpy(plaintexts[k], plaintext, AES_NUM_STATE_BYTES);
+            }
+
+            encrypt(&cipher_ctx, plaintexts, ciphertexts);
+
+            for (size_t k = 0; k < NUM_TEXTS_PER_BATCH; ++k) {
+                const uint8_t first_byte = ciphertexts[k][0];
+                first_bytes[first_byte]++;
+            }
         }
 
         num_collisions += find_num_collisions(first_bytes);
@@ -212,13 +223,22 @@ static size_t perform_experiment_from_diagonal(ExperimentContext *context) {
             generate_base_plaintext_in_diagonal(plaintext, i, m);
             zeroize(first_bytes, 256);
 
-            for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
-                AESState ciphertext;
-                get_text_from_diagonal_delta_set(plaintext, m, j);
-                encrypt(&cipher_ctx, plaintext, ciphertext);
+            for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET;
+                 j += NUM_TEXTS_PER_BATCH) {
+                aes_state_t plaintexts[NUM_TEXTS_PER_BATCH];
+                aes_state_t ciphertexts[NUM_TEXTS_PER_BATCH];
 
-                const uint8_t first_byte = ciphertext.state[0];
-                first_bytes[first_byte]++;
+                for (size_t k = 0; k < NUM_TEXTS_PER_BATCH; ++k) {
+                    get_text_from_diagonal_delta_set(plaintext, m, j + k);
+                    memcpy(plaintexts[k], plaintext, AES_NUM_STATE_BYTES);
+                }
+
+                encrypt(&cipher_ctx, plaintexts, ciphertexts);
+
+                for (size_t k = 0; k < NUM_TEXTS_PER_BATCH; ++k) {
+                    const uint8_t first_byte = ciphertexts[k][0];
+                    first_bytes[first_byte]++;
+                }
             }
 
             num_collisions += find_num_collisions(first_bytes);
@@ -5,7 +5,11 @@
  */
 #include <stdint.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "ciphers/random_function.h"
@@ -21,6 +25,7 @@
 #include "ciphers/small_state.h"
 #include "ciphers/speck64.h"
 #include "utils/argparse.h"
+#include "utils/experiment_runner.h"
 #include "utils/utils.h"
 #include "utils/xorshift1024.h"
 
@@ -28,12 +33,27 @@ using utils::ArgumentParser;
 
 // ---------------------------------------------------------
 
+static const size_t NUM_KEYS = 1L << 16;
+static const size_t NUM_K1_VALUES_PER_TASK = 1L << 8;
+
+// ---------------------------------------------------------
+
+/**
+ * The sweep covers all k1 in [first_k1, end_k1) and all 2^16 k2. Since the
+ * counters of disjoint k1 ranges simply add up, a sweep can be split into
+ * ranges that run on different machines, and be merged afterwards.
+ */
 typedef struct {
     __m128i _1SBOX;
     __m128i _2SBOX;
     __m128i _3SBOX;
+    size_t first_k1;
+    size_t end_k1;
+    size_t num_threads;
 } ExperimentContext;
 
+typedef std::array<size_t, 16> CollisionCounters;
+
 // ---------------------------------------------------------
 // Macros
 // ---------------------------------------------------------
@@ -377,14 +397,14 @@ static void finalize_config(const ExperimentContext &context,
 // ---------------------------------------------------------
 
 /**
- * Assumes __m128i inout[4], __m128i k[4] and computes
- * inout[i] ^= k[i] for all i.
+ * Assumes __m128i out[4], __m128i in[4], __m128i k[4] and computes
+ * out[i] = in[i] ^ k[i] for all i.
  */
-#define vxor_arrays_four(inout, k) do {\
-    inout[0] = vxor(inout[0], k[0]); \
-    inout[1] = vxor(inout[1], k[1]); \
-    inout[2] = vxor(inout[2], k[2]); \
-    inout[3] = vxor(inout[3], k[3]); \
+#define vxor_arrays_four(out, in, k) do {\
+    out[0] = vxor(in[0], k[0]); \
+    out[1] = vxor(in[1], k[1]); \
+    out[2] = vxor(in[2], k[2]); \
+    out[3] = vxor(in[3], k[3]); \
 } while (0)
 
 // ---------------------------------------------------------
@@ -402,16 +422,32 @@ static void finalize_config(const ExperimentContext &context,
 
 // ---------------------------------------------------------
 
-static void prepare_multiples(__m128i abcd[4],
+/**
+ * Computes 2 * abcd and 3 * abcd. Depends only on k1.
+ */
+static void prepare_multiples(const __m128i abcd[4],
                               __m128i _2abcd[4],
-                              __m128i _3abcd[4],
-                              __m128i k2[4]) {
+                              __m128i _3abcd[4]) {
     vshuffle_arrays_four(_2abcd, abcd, _X2);
     vshuffle_arrays_four(_3abcd, abcd, _X3);
+}
+
+// ---------------------------------------------------------
 
-    vxor_arrays_four(abcd, k2);
-    vxor_arrays_four(_2abcd, k2);
-    vxor_arrays_four(_3abcd, k2);
+/**
+ * Adds k2 to the k1-only values k1_abcd, k1_2abcd, k1_3abcd from
+ * prepare_multiples().
+ */
+static void add_second_key(const __m128i k1_abcd[4],
+                           const __m128i k1_2abcd[4],
+                           const __m128i k1_3abcd[4],
+                           __m128i abcd[4],
+                           __m128i _2abcd[4],
+                           __m128i _3abcd[4],
+                           const __m128i k2[4]) {
+    vxor_arrays_four(abcd, k1_abcd, k2);
+    vxor_arrays_four(_2abcd, k1_2abcd, k2);
+    vxor_arrays_four(_3abcd, k1_3abcd, k2);
 }
 
 // ---------------------------------------------------------
@@ -493,33 +529,61 @@ static void prepare_key(__m128i k[4], size_t index) {
 
 /**
  * Finds number of unordered collisions among any two bytes in x.
+ * Comparing x with x rotated by r bytes compares all pairs of cyclic
+ * distance r. For r in [1, 7], every such pair is compared once; for
+ * r = 8, every pair is compared twice, so only the lower half is kept.
  * @param x
- * @return
+ * @return The numbers of collisions in the two 64-bit lanes, whose sum is
+ * the number of collisions in x.
  */
-static size_t
-find_collisions(uint8_t list[16], uint8_t histogram[16], const __m128i x) {
-    memset(list, 0x00, 16);
-    storeu(list, x);
-    memset(histogram, 0x00, 16);
-
-    for (size_t i = 0; i < 16; ++i) {
-        histogram[list[i] & 0x0F]++;
-    }
-
-    size_t num_collisions = 0;
+static __m128i find_collisions(const __m128i x) {
+    const __m128i lower_half = vset64(0xFFFFFFFFFFFFFFFFL, 0L);
+    __m128i num_collisions = zero;
+
+    num_collisions = vsub8(num_collisions,
+                           vcompare_equal8(x, vrotate_bytes(x, 1)));
+    num_collisions = vsub8(num_collisions,
+                           vcompare_equal8(x, vrotate_bytes(x, 2)));
+    num_collisions = vsub8(num_collisions,
+                           vcompare_equal8(x, vrotate_bytes(x, 3)));
+    num_collisions = vsub8(num_collisions,
+                           vcompare_equal8(x, vrotate_bytes(x, 4)));
+    num_collisions = vsub8(num_collisions,
+                           vcompare_equal8(x, vrotate_bytes(x, 5)));
+    num_collisions = vsub8(num_collisions,
+                           vcompare_equal8(x, vrotate_bytes(x, 6)));
+    num_collisions = vsub8(num_collisions,
+                           vcompare_equal8(x, vrotate_bytes(x, 7)));
+    num_collisions = vsub8(num_collisions,
+                           vand(vcompare_equal8(x, vrotate_bytes(x, 8)),
+                                lower_half));
+    return vsum_bytes64(num_collisions);
+}
 
-    for (size_t i = 0; i < 16; ++i) {
-        num_collisions += (histogram[i] * (histogram[i] - 1)) / 2;
-    }
+// ---------------------------------------------------------
 
-    return num_collisions;
+static size_t get_num_collisions(const __m128i num_collisions) {
+    return (size_t) (vget64(num_collisions, 0)
+                     + vget64(num_collisions, 1));
 }
 
 // ---------------------------------------------------------
 
-static void perform_experiments(ExperimentContext &context) {
+/**
+ * Adds the collisions for all 16 output indices, all k1 in
+ * [first_k1, end_k1) and all k2 to num_collisions.
+ */
+static void sweep_keys(const ExperimentContext &context,
+                       const size_t input_index,
+                       const size_t first_k1,
+                       const size_t end_k1,
+                       CollisionCounters &num_collisions) {
     const __m128i x = vsetr8(0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7,
                              0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf);
+    __m128i k1_abcd[4];
+    __m128i k1_2abcd[4];
+    __m128i k1_3abcd[4];
+
     __m128i abcd[4];
     __m128i _2abcd[4];
     __m128i _3abcd[4];
@@ -528,45 +592,104 @@ static void perform_experiments(ExperimentContext &context) {
     __m128i k1[4];
     __m128i k2[4];
 
-    const size_t num_keys = 1L << 16;
-    uint8_t list[16];
-    uint8_t histogram[16];
+    const size_t row_index = input_index % 4;
+    const size_t column_index = input_index / 4;
+    const size_t config_index = (4 + row_index - column_index) % 4;
 
-    std::cout << "# in out num_collisions" << std::endl;
+    // Two 64-bit partial sums per output index
+    __m128i partial_num_collisions[16];
 
-    for (size_t input_index = 0; input_index < 16; ++input_index) {
-        const size_t row_index = input_index % 4;
-        const size_t column_index = input_index / 4;
-        const size_t config_index = (4 + row_index - column_index) % 4;
+    for (size_t output_index = 0; output_index < 16; ++output_index) {
+        partial_num_collisions[output_index] = zero;
+    }
 
-        printf("# in %2zu\n", input_index);
+    for (size_t k1_value = first_k1; k1_value < end_k1; ++k1_value) {
+        prepare_key(k1, k1_value);
+        compute_input_variables(context, row_index, x, k1_abcd, k1);
+        prepare_multiples(k1_abcd, k1_2abcd, k1_3abcd);
+
+        for (size_t k2_value = 0; k2_value < NUM_KEYS; ++k2_value) {
+            prepare_key(k2, k2_value);
+            add_second_key(k1_abcd, k1_2abcd, k1_3abcd,
+                           abcd, _2abcd, _3abcd, k2);
+
+            finalize_config(context, config_index, abcd, _2abcd, _3abcd,
+                            result);
+
+            for (size_t output_index = 0;
+                 output_index < 16;
+                 ++output_index) {
+                partial_num_collisions[output_index] = vadd64(
+                    partial_num_collisions[output_index],
+                    find_collisions(result[output_index])
+                );
+            }
+        }
+    }
 
-        size_t num_collisions[16] = {
-            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-        };
+    for (size_t output_index = 0; output_index < 16; ++output_index) {
+        num_collisions[output_index] +=
+            get_num_collisions(partial_num_collisions[output_index]);
+    }
+}
 
-        for (size_t k1_value = 0; k1_value < num_keys; ++k1_value) {
-            prepare_key(k1, k1_value);
+// ---------------------------------------------------------
 
-            for (size_t k2_value = 0; k2_value < num_keys; ++k2_value) {
-                prepare_key(k2, k2_value);
-                compute_input_variables(context, row_index, x, abcd, k1);
-                prepare_multiples(abcd, _2abcd, _3abcd, k2);
+static void perform_experiments(ExperimentContext &context) {
+    const size_t num_k1_values = context.end_k1 - context.first_k1;
+    const size_t num_tasks =
+        (num_k1_values + NUM_K1_VALUES_PER_TASK - 1) / NUM_K1_VALUES_PER_TASK;
 
-                finalize_config(context, config_index, abcd, _2abcd, _3abcd,
-                                result);
+    std::cout << "# in out num_collisions" << std::endl;
 
-                for (size_t output_index = 0;
-                     output_index < 16;
-                     ++output_index) {
-                    num_collisions[output_index] += find_collisions(
-                        list, histogram, result[output_index]
-                    );
+    for (size_t input_index = 0; input_index < 16; ++input_index) {
+        printf("# in %2zu\n", input_index);
+
+        // One set of counters per thread, reduced after all threads joined
+        std::vector<CollisionCounters> num_collisions_per_thread(
+            context.num_threads, CollisionCounters()
+        );
+        std::atomic<size_t> num_finished_tasks(0);
+
+        utils::run_in_parallel(
+            num_tasks,
+            context.num_threads,
+            [&context, &num_collisions_per_thread, &num_finished_tasks,
+                input_index, num_tasks, num_k1_values](
+                const size_t task_index, const size_t thread_index) {
+                const size_t first_k1 = context.first_k1
+                                        + task_index * NUM_K1_VALUES_PER_TASK;
+                const size_t end_k1 = std::min(
+                    first_k1 + NUM_K1_VALUES_PER_TASK, context.end_k1
+                );
+
+                CollisionCounters num_collisions = CollisionCounters();
+                sweep_keys(context, input_index, first_k1, end_k1,
+                           num_collisions);
+
+                CollisionCounters &thread_num_collisions =
+                    num_collisions_per_thread[thread_index];
+
+                for (size_t i = 0; i < num_collisions.size(); ++i) {
+                    thread_num_collisions[i] += num_collisions[i];
+                }
+
+                const size_t num_finished = ++num_finished_tasks;
+
+                if (num_finished < num_tasks) {
+                    printf("# %6zu / %6zu \n",
+                           num_finished * NUM_K1_VALUES_PER_TASK,
+                           num_k1_values);
                 }
             }
+        );
+
+        CollisionCounters num_collisions = CollisionCounters();
 
-            if ((k1_value > 0) && ((k1_value & 0x00FF) == 0)) {
-                printf("# %6zu / %6zu \n", k1_value, num_keys);
+        for (const CollisionCounters &thread_num_collisions :
+            num_collisions_per_thread) {
+            for (size_t i = 0; i < num_collisions.size(); ++i) {
+                num_collisions[i] += thread_num_collisions[i];
             }
         }
 
@@ -591,7 +714,6 @@ static void perform_test_experiment(ExperimentContext &context) {
     __m128i k2[4];
 
     uint8_t list[16];
-    uint8_t histogram[16];
 
     std::cout << "# in out num_collisions" << std::endl;
 
@@ -631,7 +753,8 @@ static void perform_test_experiment(ExperimentContext &context) {
     utils::print_128(" c", abcd[2]);
     utils::print_128(" d", abcd[3]);
 
-    prepare_multiples(abcd, _2abcd, _3abcd, k2);
+    prepare_multiples(abcd, _2abcd, _3abcd);
+    add_second_key(abcd, _2abcd, _3abcd, abcd, _2abcd, _3abcd, k2);
 
     utils::print_128(" a + k2[0]", abcd[0]);
     utils::print_128(" b + k2[1]", abcd[1]);
@@ -651,9 +774,10 @@ static void perform_test_experiment(ExperimentContext &context) {
     finalize_config(context, config_index, abcd, _2abcd, _3abcd, result);
 
     const size_t output_index = 0;
-    num_collisions[output_index] += find_collisions(
-        list, histogram, result[output_index]
+    num_collisions[output_index] += get_num_collisions(
+        find_collisions(result[output_index])
     );
+    storeu(list, result[output_index]);
 
     utils::print_128("Result: ", result[output_index]);
     utils::print_hex("List   ", list, 16);
@@ -734,6 +858,25 @@ static __m128i get_sbox(const size_t cipher_index) {
 
 // ---------------------------------------------------------
 
+/**
+ * Parses a range "first:end" of k1 values, e.g., "0:0x4000".
+ */
+static void parse_k1_range(ExperimentContext *context,
+                           const std::string &range) {
+    const size_t separator_index = range.find(':');
+
+    if (separator_index == std::string::npos) {
+        throw std::invalid_argument("k1 range must be first:end");
+    }
+
+    context->first_k1 = std::stoull(range.substr(0, separator_index),
+                                    nullptr, 0);
+    context->end_k1 = std::stoull(range.substr(separator_index + 1),
+                                  nullptr, 0);
+}
+
+// ---------------------------------------------------------
+
 static void initialize_context(ExperimentContext *context,
     const size_t cipher_index) {
     context->_1SBOX = vshuffle(_X1, get_sbox(cipher_index));
@@ -754,13 +897,37 @@ static void parse_args(ExperimentContext *context,
         "Small-AES cell-to-cell four-round distinguisher. "
         "Cipher must be {0, ..., 53} for Small-AES with one of the following S-boxes (in that order):"
         "[Small-AES, PRESENT, PRIDE, PRINCE, TOY6, TOY8, TOY10, RANDOM0, ..., RANDOM19, Identity,"
-        " Optimal0, ..., Optimal15, Platinum0, ..., Platinum9]");
+        " Optimal0, ..., Optimal15, Platinum0, ..., Platinum9]. "
+        "The k1 range first:end restricts the sweep to k1 in [first, end), "
+        "so that the counters of several ranges can be summed up.");
     parser.addArgument("-c", "--cipher", 1, false);
+    parser.addArgument("-t", "--num_threads", 1, true);
+    parser.addArgument("-w", "--k1_range", 1, true);
 
     try {
         parser.parse((size_t) argc, argv);
 
         const size_t cipher_index = parser.retrieveAsLong("c");
+        context->num_threads = parser.wasSet("-t") ?
+                               parser.retrieveAsLong("t") :
+                               utils::get_num_available_threads();
+        context->first_k1 = 0;
+        context->end_k1 = NUM_KEYS;
+
+        if (context->num_threads == 0) {
+            context->num_threads = 1;
+        }
+
+        if (parser.wasSet("-w")) {
+            parse_k1_range(context, parser.retrieve<std::string>("w"));
+        }
+
+        if ((context->first_k1 >= context->end_k1)
+            || (context->end_k1 > NUM_KEYS)) {
+            std::cerr << "k1 range first:end must have first < end <= 2^16."
+                      << std::endl;
+            exit(EXIT_FAILURE);
+        }
 
         if (cipher_index > 53) {
             std::cerr << "Cipher index must be in {0, ..., 53}." << std::endl;
@@ -772,6 +939,10 @@ static void parse_args(ExperimentContext *context,
         std::cerr << parser.usage() << std::endl;
         exit(EXIT_FAILURE);
     }
+
+    printf("#Threads        %8zu\n", context->num_threads);
+    printf("#K1 range       [%04zx, %04zx)\n", context->first_k1,
+           context->end_k1);
 }
 
 // ---------------------------------------------------------
@@ -5,6 +5,7 @@
  */
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <array>
 #include <vector>
 
@@ -22,8 +23,10 @@
 #include "ciphers/small_state.h"
 #include "ciphers/speck64.h"
 #include "utils/argparse.h"
+#include "utils/experiment_runner.h"
 #include "utils/utils.h"
 #include "utils/uint128_t.h"
+#include "utils/walsh_hadamard.h"
 #include "utils/xorshift1024.h"
 
 using utils::ArgumentParser;
@@ -34,6 +37,17 @@ typedef std::vector<size_t> Array;
 typedef std::vector<Array> Array2D;
 typedef std::vector<Array2D> Array3D;
 
+/**
+ * The values L_i[k][x] of the four tables i for all keys k and inputs x,
+ * stored flat as [i][x][k], so that the values of all keys for a fixed x
+ * are contiguous.
+ */
+typedef std::vector<uint8_t> ValueTables;
+
+/**
+ * Every thread works on its own copy of the context, so the buffers below
+ * need no locking.
+ */
 typedef struct {
     Array x2;
     Array x3;
@@ -48,6 +62,11 @@ typedef struct {
     Array2D b;
     Array2D c;
     Array2D d;
+    size_t num_threads;
+    ValueTables value_tables;
+    // For each table, the number of keys per difference of a pair (x, x')
+    std::vector<uint32_t> difference_counts;
+    std::vector<int64_t> transforms;
 } ExperimentContext;
 
 static const size_t NUM_4_BIT_SBOXES = 54;
@@ -111,30 +130,6 @@ static void print_vector_hex(const Array3D &table) {
 
 // ---------------------------------------------------------
 
-static void zeroize_array(Array &table) {
-    for (size_t i = 0; i < table.size(); ++i) {
-        table[i] = 0;
-    }
-}
-
-// ---------------------------------------------------------
-
-static void zeroize_2d_array(Array2D &table) {
-    for (size_t i = 0; i < table.size(); ++i) {
-        zeroize_array(table[i]);
-    }
-}
-
-// ---------------------------------------------------------
-
-static void zeroize_3d_array(Array3D &table) {
-    for (size_t i = 0; i < table.size(); ++i) {
-        zeroize_2d_array(table[i]);
-    }
-}
-
-// ---------------------------------------------------------
-
 static void compute_input_variables0(ExperimentContext &context,
                                      const size_t num_values) {
     for (size_t k1 = 0; k1 < num_values; ++k1) {
@@ -207,8 +202,18 @@ compute_input_variables(ExperimentContext &context,
 
 // ---------------------------------------------------------
 
+static size_t get_value_index(const size_t num_values,
+                              const size_t table_index,
+                              const size_t key_index,
+                              const size_t x) {
+    return (table_index * num_values + x) * num_values * num_values
+           + key_index;
+}
+
+// ---------------------------------------------------------
+
 static void compute_output_variables0(ExperimentContext &context,
-                                      Array3D &tables,
+                                      ValueTables &tables,
                                       const size_t output_row_index,
                                       const size_t num_values) {
     Array a_sbox = context._2SBOX;
@@ -243,10 +248,14 @@ static void compute_output_variables0(ExperimentContext &context,
             for (size_t k2 = 0; k2 < num_values; ++k2) {
                 const size_t key_index = (k2 * num_values) + k1;
 
-                tables[0][key_index][x] = a_sbox[context.x2[a] ^ k2];
-                tables[1][key_index][x] = b_sbox[b ^ k2];
-                tables[2][key_index][x] = c_sbox[context.x2[c] ^ k2];
-                tables[3][key_index][x] = d_sbox[d ^ k2];
+                tables[get_value_index(num_values, 0, key_index, x)] =
+                    a_sbox[context.x2[a] ^ k2];
+                tables[get_value_index(num_values, 1, key_index, x)] =
+                    b_sbox[b ^ k2];
+                tables[get_value_index(num_values, 2, key_index, x)] =
+                    c_sbox[context.x2[c] ^ k2];
+                tables[get_value_index(num_values, 3, key_index, x)] =
+                    d_sbox[d ^ k2];
             }
         }
     }
@@ -255,7 +264,7 @@ static void compute_output_variables0(ExperimentContext &context,
 // ---------------------------------------------------------
 
 static void compute_output_variables1(ExperimentContext &context,
-                                      Array3D &tables,
+                                      ValueTables &tables,
                                       const size_t output_row_index,
                                       const size_t num_values) {
     Array a_sbox = context._3SBOX;
@@ -289,10 +298,14 @@ static void compute_output_variables1(ExperimentContext &context,
                 const size_t d = context.d[k1][x];
                 const size_t key_index = (k2 * num_values) + k1;
 
-                tables[0][key_index][x] = a_sbox[a ^ k2];
-                tables[1][key_index][x] = b_sbox[context.x3[b] ^ k2];
-                tables[2][key_index][x] = c_sbox[c ^ k2];
-                tables[3][key_index][x] = d_sbox[context.x3[d] ^ k2];
+                tables[get_value_index(num_values, 0, key_index, x)] =
+                    a_sbox[a ^ k2];
+                tables[get_value_index(num_values, 1, key_index, x)] =
+                    b_sbox[context.x3[b] ^ k2];
+                tables[get_value_index(num_values, 2, key_index, x)] =
+                    c_sbox[c ^ k2];
+                tables[get_value_index(num_values, 3, key_index, x)] =
+                    d_sbox[context.x3[d] ^ k2];
             }
         }
     }
@@ -301,7 +314,7 @@ static void compute_output_variables1(ExperimentContext &context,
 // ---------------------------------------------------------
 
 static void compute_output_variables2(ExperimentContext &context,
-                                      Array3D &tables,
+                                      ValueTables &tables,
                                       const size_t output_row_index,
                                       const size_t num_values) {
     Array a_sbox = context._1SBOX;
@@ -335,10 +348,14 @@ static void compute_output_variables2(ExperimentContext &context,
                 const size_t d = context.d[k1][x];
                 const size_t key_index = (k2 * num_values) + k1;
 
-                tables[0][key_index][x] = a_sbox[a ^ k2];
-                tables[1][key_index][x] = b_sbox[context.x2[b] ^ k2];
-                tables[2][key_index][x] = c_sbox[c ^ k2];
-                tables[3][key_index][x] = d_sbox[context.x2[d] ^ k2];
+                tables[get_value_index(num_values, 0, key_index, x)] =
+                    a_sbox[a ^ k2];
+                tables[get_value_index(num_values, 1, key_index, x)] =
+                    b_sbox[context.x2[b] ^ k2];
+                tables[get_value_index(num_values, 2, key_index, x)] =
+                    c_sbox[c ^ k2];
+                tables[get_value_index(num_values, 3, key_index, x)] =
+                    d_sbox[context.x2[d] ^ k2];
             }
         }
     }
@@ -347,7 +364,7 @@ static void compute_output_variables2(ExperimentContext &context,
 // ---------------------------------------------------------
 
 static void compute_output_variables3(ExperimentContext &context,
-                                      Array3D &tables,
+                                      ValueTables &tables,
                                       const size_t output_row_index,
                                       const size_t num_values) {
     Array a_sbox = context._1SBOX;
@@ -381,10 +398,14 @@ static void compute_output_variables3(ExperimentContext &context,
                 const size_t d = context.d[k1][x];
                 const size_t key_index = (k2 * num_values) + k1;
 
-                tables[0][key_index][x] = a_sbox[context.x3[a] ^ k2];
-                tables[1][key_index][x] = b_sbox[b ^ k2];
-                tables[2][key_index][x] = c_sbox[context.x3[c] ^ k2];
-                tables[3][key_index][x] = d_sbox[d ^ k2];
+                tables[get_value_index(num_values, 0, key_index, x)] =
+                    a_sbox[context.x3[a] ^ k2];
+                tables[get_value_index(num_values, 1, key_index, x)] =
+                    b_sbox[b ^ k2];
+                tables[get_value_index(num_values, 2, key_index, x)] =
+                    c_sbox[context.x3[c] ^ k2];
+                tables[get_value_index(num_values, 3, key_index, x)] =
+                    d_sbox[d ^ k2];
             }
         }
     }
@@ -393,7 +414,7 @@ static void compute_output_variables3(ExperimentContext &context,
 // ---------------------------------------------------------
 
 static void compute_output_variables(ExperimentContext &context,
-                                     Array3D &tables,
+                                     ValueTables &tables,
                                      const size_t config_index,
                                      const size_t output_row_index) {
     if (config_index == 0) {
@@ -414,7 +435,7 @@ static void compute_output_variables(ExperimentContext &context,
 // ---------------------------------------------------------
 
 static void compute_values_tables(ExperimentContext &context,
-                                  Array3D &value_tables,
+                                  ValueTables &value_tables,
                                   const size_t input_index,
                                   const size_t output_index) {
     const size_t input_row_index = input_index % 4;
@@ -435,62 +456,75 @@ static void compute_values_tables(ExperimentContext &context,
 
 // ---------------------------------------------------------
 
-static void derive_difference_counts_table(Array &difference_counts_table,
-                                           const Array2D &table,
-                                           const size_t num_table_entries,
-                                           const size_t x,
-                                           const size_t x_prime) {
-    zeroize_array(difference_counts_table);
+/**
+ * For the current x, x', derives the difference tables that map each
+ * of the differences L_i[k][x] ^ L_i[k][x'] to the number of keys k that
+ * produce it.
+ */
+static void derive_difference_counts_tables(ExperimentContext &context,
+                                            const size_t x,
+                                            const size_t x_prime) {
+    const size_t num_tables = 4;
+    const size_t num_values = context.num_values;
+    const size_t num_keys = num_values * num_values;
+    uint32_t *difference_counts = context.difference_counts.data();
+
+    memset(difference_counts, 0x00, num_tables * num_values * sizeof(uint32_t));
 
-    for (size_t i = 0; i < num_table_entries; ++i) {
-        const size_t difference = table[i][x] ^table[i][x_prime];
-        difference_counts_table[difference]++;
+    for (size_t i = 0; i < num_tables; ++i) {
+        const uint8_t *values = context.value_tables.data()
+            + get_value_index(num_values, i, 0, x);
+        const uint8_t *values_prime = context.value_tables.data()
+            + get_value_index(num_values, i, 0, x_prime);
+        uint32_t *table_difference_counts = difference_counts
+                                            + i * num_values;
+
+        for (size_t k = 0; k < num_keys; ++k) {
+            table_difference_counts[values[k] ^ values_prime[k]]++;
+        }
     }
 }
 
 // ---------------------------------------------------------
 
-static void merge_difference_counts_tables(Array &result_table,
-                                           const Array &left_table,
-                                           const Array &right_table,
-                                           const size_t num_values) {
-    zeroize_array(result_table);
+/**
+ * Merges the four difference tables D_i to the number of key combinations
+ * whose differences sum to zero, i.e. sum_d (D_0 * D_1)(d) (D_2 * D_3)(d),
+ * where * is the XOR convolution. The convolutions are computed as
+ * pointwise products of Walsh-Hadamard transforms, in O(n log n) instead
+ * of O(n^2) for n values.
+ */
+static size_t count_num_collisions_for_pair(ExperimentContext &context) {
+    const size_t num_tables = 4;
+    const size_t num_values = context.num_values;
+    const uint32_t *difference_counts = context.difference_counts.data();
+    int64_t *transforms = context.transforms.data();
 
-    for (size_t i = 0; i < num_values; ++i) {
-        for (size_t j = 0; j < num_values; ++j) {
-            const size_t difference = i ^j;
-            const size_t num_combinations = left_table[i] * right_table[j];
-            result_table[difference] += num_combinations;
-        }
+    for (size_t i = 0; i < num_tables * num_values; ++i) {
+        transforms[i] = difference_counts[i];
     }
-}
 
-// ---------------------------------------------------------
+    for (size_t i = 0; i < num_tables; ++i) {
+        utils::walsh_hadamard_transform(transforms + i * num_values,
+                                        num_values);
+    }
 
-static size_t count_num_collisions_as_product(const Array &left_table,
-                                              const Array &right_table,
-                                              const size_t num_values) {
-    size_t num_collisions = 0;
+    int64_t *transform_0_1 = transforms;
+    int64_t *transform_2_3 = transforms + 2 * num_values;
 
     for (size_t i = 0; i < num_values; ++i) {
-        num_collisions += left_table[i] * right_table[i];
+        transform_0_1[i] *= transforms[num_values + i];
+        transform_2_3[i] *= transforms[3 * num_values + i];
     }
 
-    return num_collisions;
-}
-
-// ---------------------------------------------------------
+    utils::inverse_walsh_hadamard_transform(transform_0_1, num_values);
+    utils::inverse_walsh_hadamard_transform(transform_2_3, num_values);
 
-static uint128_t count_num_collisions_as_sum(const Array2D &table,
-                                             const size_t num_values,
-                                             const size_t num_inner_values) {
-    uint128_t num_collisions = 0;
+    size_t num_collisions = 0;
 
     for (size_t i = 0; i < num_values; ++i) {
-        for (size_t j = 0; j < num_inner_values; ++j) {
-            num_collisions += table[i][j];
-//            printf("# collisions[%3zu][%3zu] = %2zu\n", i, j, table[i][j]);
-        }
+        num_collisions += (size_t) transform_0_1[i]
+                          * (size_t) transform_2_3[i];
     }
 
     return num_collisions;
@@ -511,78 +545,36 @@ static uint128_t compute_num_collisions(ExperimentContext &context,
     const size_t num_values = context.num_values;
     const size_t num_value_table_entries = num_values * num_values;
 
-    Array3D value_tables(num_tables,
-                         Array2D(num_value_table_entries,
-                                 Array(num_values)));
-    zeroize_3d_array(value_tables);
-
-    compute_values_tables(context, value_tables, input_index, output_index);
+    context.value_tables.resize(
+        num_tables * num_value_table_entries * num_values);
+    context.difference_counts.resize(num_tables * num_values);
+    context.transforms.resize(num_tables * num_values);
 
-    Array2D num_collisions_tables(num_values, Array(num_values));
-    zeroize_2d_array(num_collisions_tables);
-
-    Array2D difference_counts_tables(num_tables, Array(num_values));
+    compute_values_tables(context, context.value_tables, input_index,
+                          output_index);
 
     // ---------------------------------------------------------
     // Iterate over distinct binom(16, 2) pairs (x, x')
     // ---------------------------------------------------------
 
+    uint128_t num_collisions = 0;
+
     for (size_t x = 0; x < num_values; ++x) {
         for (size_t x_prime = x + 1; x_prime < num_values; ++x_prime) {
-            // ---------------------------------------------------------
-            // For the current x, x', derive difference tables that map each
-            // of the 16 differences to the number of its occurrence.
-            // ---------------------------------------------------------
-
-            for (size_t i = 0; i < num_tables; ++i) {
-                derive_difference_counts_table(
-                    difference_counts_tables[i],
-                    value_tables[i],
-                    num_value_table_entries,
-                    x,
-                    x_prime
-                );
-            }
-
-            // ---------------------------------------------------------
-            // Merge the 4 tables to 2
-            // ---------------------------------------------------------
-
-            Array difference_counts_0_1(num_values);
-            Array difference_counts_2_3(num_values);
-
-            merge_difference_counts_tables(difference_counts_0_1,
-                                           difference_counts_tables[0],
-                                           difference_counts_tables[1],
-                                           num_values);
-            merge_difference_counts_tables(difference_counts_2_3,
-                                           difference_counts_tables[2],
-                                           difference_counts_tables[3],
-                                           num_values);
-
-            // ---------------------------------------------------------
-            // Merge the 2 tables, searching for collisions
-            // ---------------------------------------------------------
-
-            num_collisions_tables[x][x_prime] =
-                count_num_collisions_as_product(difference_counts_0_1,
-                                                difference_counts_2_3,
-                                                num_values);
+            derive_difference_counts_tables(context, x, x_prime);
+            num_collisions += count_num_collisions_for_pair(context);
         }
-
-        printf("# Finished x = %2zu\n", x);
     }
 
-    return count_num_collisions_as_sum(num_collisions_tables,
-                                       num_values,
-                                       num_values);
+    return num_collisions;
 }
 
 // ---------------------------------------------------------
 
 static void perform_experiments(ExperimentContext &context) {
     const size_t num_positions = context.num_positions;
-    puts("# in-byte out-byte collisions");
+    std::vector<size_t> input_indices;
+    std::vector<size_t> output_indices;
 
     for (size_t input_index = context.input_start_index;
         input_index < num_positions;
@@ -590,14 +582,43 @@ static void perform_experiments(ExperimentContext &context) {
         for (size_t output_index = context.output_start_index;
              output_index < num_positions;
              ++output_index) {
-            //
-            const uint128_t num_collisions = compute_num_collisions(
-                context, input_index, output_index
+            input_indices.push_back(input_index);
+            output_indices.push_back(output_index);
+        }
+    }
+
+    // ---------------------------------------------------------
+    // Run the (input, output) pairs in parallel, each thread with its own
+    // copy of the context.
+    // ---------------------------------------------------------
+
+    const size_t num_tasks = input_indices.size();
+    std::vector<ExperimentContext> thread_contexts(context.num_threads,
+                                                   context);
+    std::vector<uint128_t> num_collisions(num_tasks);
+
+    utils::run_in_parallel(
+        num_tasks,
+        context.num_threads,
+        [&thread_contexts, &input_indices, &output_indices, &num_collisions](
+            const size_t task_index, const size_t thread_index) {
+            const size_t input_index = input_indices[task_index];
+            const size_t output_index = output_indices[task_index];
+
+            num_collisions[task_index] = compute_num_collisions(
+                thread_contexts[thread_index], input_index, output_index
             );
 
-            printf("%2zu %2zu ", input_index, output_index);
-            std::cout << num_collisions << std::endl;
+            printf("# Finished %2zu %2zu %s\n", input_index, output_index,
+                   num_collisions[task_index].str().c_str());
         }
+    );
+
+    puts("# in-byte out-byte collisions");
+
+    for (size_t i = 0; i < num_tasks; ++i) {
+        printf("%2zu %2zu ", input_indices[i], output_indices[i]);
+        std::cout << num_collisions[i] << std::endl;
     }
 }
 
@@ -833,6 +854,7 @@ static void parse_args(ExperimentContext *context,
     parser.addArgument("-c", "--cipher", 1, false);
     parser.addArgument("-i", "--input_start_index", 1, false);
     parser.addArgument("-o", "--output_start_index", 1, false);
+    parser.addArgument("-t", "--num_threads", 1, true);
 
     try {
         parser.parse((size_t) argc, argv);
@@ -840,6 +862,13 @@ static void parse_args(ExperimentContext *context,
         const size_t cipher_index = parser.retrieveAsLong("c");
         const size_t input_start_index = parser.retrieveAsLong("i");
         const size_t output_start_index = parser.retrieveAsLong("o");
+        context->num_threads = parser.wasSet("-t") ?
+                               parser.retrieveAsLong("t") :
+                               utils::get_num_available_threads();
+
+        if (context->num_threads == 0) {
+            context->num_threads = 1;
+        }
 
         if (cipher_index > 54) {
             std::cerr << "Cipher index must be in {0, ..., 54}." << std::endl;
@@ -13,6 +13,7 @@
 #include "ciphers/small_state.h"
 #include "ciphers/speck64.h"
 #include "utils/argparse.h"
+#include "utils/nibble_collision_matrix.h"
 #include "utils/utils.h"
 #include "utils/xorshift1024.h"
 
@@ -46,6 +47,7 @@ typedef struct {
     size_t output_cell_index;
     bool use_prp = false;
     bool use_all_delta_sets_from_diagonal = false;
+    bool use_all_cells = false;
     std::vector<size_t> num_matches;
 } ExperimentContext;
 
@@ -322,6 +324,48 @@ static size_t perform_experiment_with_prp(ExperimentContext *context) {
 
 // ---------------------------------------------------------
 
+/**
+ * Counts the collisions of all 16x16 input/output cells, with the same
+ * keys and encryption as the single-cell experiments.
+ */
+static void perform_all_cells_experiments(ExperimentContext *context) {
+    small_aes_ctx_t cipher_ctx = context->cipher_ctx;
+    speck64_context_t prp_ctx;
+
+    const auto setup_key = [&]() {
+        if (context->use_prp) {
+            speck64_96_key_t key;
+            utils::get_random_bytes(key, SPECK_64_96_NUM_KEY_BYTES);
+            utils::print_hex("# Key", key, SPECK_64_96_NUM_KEY_BYTES);
+            speck64_96_key_schedule(&prp_ctx, key);
+        } else {
+            small_aes_key_t key;
+            utils::get_random_bytes(key, SMALL_AES_NUM_KEY_BYTES);
+            small_aes_key_setup(&cipher_ctx, key);
+            utils::print_hex("# Key", key, SMALL_AES_NUM_KEY_BYTES);
+        }
+    };
+    const auto encrypt_packed = [&](const uint64_t packed_plaintext) {
+        SmallState plaintext(packed_plaintext);
+        SmallState ciphertext;
+
+        if (context->use_prp) {
+            speck64_encrypt(&prp_ctx, plaintext.state, ciphertext.state);
+        } else {
+            encrypt(&cipher_ctx, plaintext.state, ciphertext);
+        }
+
+        return ciphertext.to_packed();
+    };
+
+    utils::perform_nibble_collision_matrix_experiments(
+        context->num_keys, context->num_sets_per_key, setup_key,
+        encrypt_packed
+    );
+}
+
+// ---------------------------------------------------------
+
 static void perform_experiments(ExperimentContext *context) {
     experiment_function_t experiment_function = nullptr;
 
@@ -376,13 +420,14 @@ static void parse_args(ExperimentContext *context,
     parser.appName("Test for the Small-AES four-round distinguisher."
                    "If -d 1 -r 0 is set, uses all 4 * 2^12 * binom(16, 2) "
                    "delta-sets from diagonals, but only for the Small-AES, "
-                   "not for the PRP.");
+                   "not for the PRP. "
+                   "If -a 1 is set, counts the collisions for all 16x16 "
+                   "input/output cells at once and ignores -i and -o.");
     parser.addArgument("-k", "--num_keys", 1, false);
     parser.addArgument("-s", "--num_sets_per_key", 1, false);
     parser.addArgument("-r", "--use_random_function", 1, false);
     parser.addArgument("-d", "--use_diagonals", 1, false);
-    parser.addArgument("-i", "--input_cell_index", 1, false);
-    parser.addArgument("-o", "--output_cell_index", 1, false);
+    utils::add_cell_arguments(parser);
 
     try {
         parser.parse((size_t) argc, argv);
@@ -390,16 +435,23 @@ static void parse_args(ExperimentContext *context,
         context->num_sets_per_key = static_cast<const size_t>(1L
             << parser.retrieveAsLong("s"));
         context->num_keys = parser.retrieveAsLong("k");
-        context->input_cell_index = parser.retrieveAsLong("i");
-        context->output_cell_index = parser.retrieveAsLong("o");
         context->use_prp = (bool) parser.retrieveAsInt("r");
         context->use_all_delta_sets_from_diagonal = (bool) parser.retrieveAsInt(
             "d");
+        context->use_all_cells = utils::retrieve_cell_arguments(
+            parser, &context->input_cell_index, &context->output_cell_index
+        );
     } catch (...) {
         fprintf(stderr, "%s\n", parser.usage().c_str());
         exit(EXIT_FAILURE);
     }
 
+    if (context->use_all_cells && context->use_all_delta_sets_from_diagonal) {
+        fprintf(stderr, "-a 1 cannot be combined with -d 1\n");
+        fprintf(stderr, "%s\n", parser.usage().c_str());
+        exit(EXIT_FAILURE);
+    }
+
     if (context->input_cell_index >= 16) {
         fprintf(stderr, "input_cell_index must be in [0..15]\n");
         fprintf(stderr, "%s\n", parser.usage().c_str());
@@ -414,10 +466,15 @@ static void parse_args(ExperimentContext *context,
 
     printf("#Keys           %8zu\n", context->num_keys);
     printf("#Sets/Key (log) %8zu\n", context->num_sets_per_key);
-    printf("#Input index    %8zu\n", context->input_cell_index);
-    printf("#Output index   %8zu\n", context->output_cell_index);
+
+    if (!context->use_all_cells) {
+        printf("#Input index    %8zu\n", context->input_cell_index);
+        printf("#Output index   %8zu\n", context->output_cell_index);
+    }
+
     printf("#Uses PRP       %8d\n", context->use_prp);
     printf("#Uses Diagonal  %8d\n", context->use_all_delta_sets_from_diagonal);
+    printf("#All cells      %8d\n", context->use_all_cells);
 }
 
 // ---------------------------------------------------------
@@ -425,6 +482,12 @@ static void parse_args(ExperimentContext *context,
 int main(int argc, const char **argv) {
     ExperimentContext context;
     parse_args(&context, argc, argv);
-    perform_experiments(&context);
+
+    if (context.use_all_cells) {
+        perform_all_cells_experiments(&context);
+    } else {
+        perform_experiments(&context);
+    }
+
     return EXIT_SUCCESS;
 }
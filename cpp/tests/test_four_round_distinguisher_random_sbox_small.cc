@@ -13,6 +13,7 @@
 #include "ciphers/small_state.h"
 #include "ciphers/speck64.h"
 #include "utils/argparse.h"
+#include "utils/delta_set_collision_counter.h"
 #include "utils/utils.h"
 #include "utils/xorshift1024.h"
 
@@ -24,7 +25,6 @@ using ciphers::SmallState;
 using ciphers::speck64_context_t;
 using ciphers::speck64_96_key_t;
 using ciphers::speck64_state_t;
-using utils::xor_arrays;
 using utils::compute_mean;
 using utils::compute_variance;
 using utils::ArgumentParser;
@@ -55,8 +55,6 @@ typedef struct {
 
 typedef size_t (*experiment_function_t)(ExperimentContext *);
 
-typedef std::vector<SmallState> SmallStatesVector;
-
 // ---------------------------------------------------------
 
 static void generate_base_plaintext(small_aes_state_t plaintext) {
@@ -145,32 +143,12 @@ static void encrypt(const small_aes_ctx_t *aes_context,
 
 // ---------------------------------------------------------
 
-bool has_zero_first_nibble(const small_aes_state_t state) {
-    return ((state[0] & 0xF0) == 0);
-}
+static const uint64_t FIRST_CELL_MASK = utils::get_cell_mask(0);
 
 // ---------------------------------------------------------
 
-static size_t find_num_collisions(SmallStatesVector &ciphertexts) {
-    const size_t num_texts = ciphertexts.size();
-    size_t num_collisions = 0;
-    small_aes_state_t temp;
-
-    for (size_t i = 0; i != num_texts; ++i) {
-        const SmallState left = ciphertexts[i];
-
-        for (size_t j = i + 1; j != num_texts; ++j) {
-            const SmallState right = ciphertexts[j];
-            xor_arrays(temp, left.state, right.state,
-                       SMALL_AES_NUM_STATE_BYTES);
-
-            if (has_zero_first_nibble(temp)) {
-                num_collisions++;
-            }
-        }
-    }
-
-    return num_collisions;
+static size_t find_num_collisions(const uint64_t *ciphertexts) {
+    return utils::count_delta_set_collisions(ciphertexts, &FIRST_CELL_MASK, 1);
 }
 
 // ---------------------------------------------------------
@@ -186,7 +164,7 @@ static size_t perform_experiment(ExperimentContext *context) {
     size_t num_collisions = 0;
 
     for (size_t i = 0; i < context->num_sets_per_key; ++i) {
-        SmallStatesVector ciphertexts;
+        uint64_t ciphertexts[NUM_TEXTS_IN_DELTA_SET];
         small_aes_state_t plaintext;
         generate_base_plaintext(plaintext);
 
@@ -194,7 +172,7 @@ static size_t perform_experiment(ExperimentContext *context) {
             SmallState ciphertext;
             get_text_from_delta_set(plaintext, j);
             encrypt(&cipher_ctx, plaintext, ciphertext, context->sbox_index);
-            ciphertexts.push_back(ciphertext);
+            ciphertexts[j] = ciphertext.to_packed();
         }
 
         num_collisions += find_num_collisions(ciphertexts);
@@ -230,7 +208,7 @@ static size_t perform_experiment_from_diagonal(ExperimentContext *context) {
     for (size_t i = 0; i < num_sets_in_diagonal; ++i) {
         for (size_t m = 0; m < num_bytes_in_diagonal; ++m) {
             generate_base_plaintext_in_diagonal(plaintext, i, m);
-            SmallStatesVector ciphertexts;
+            uint64_t ciphertexts[NUM_TEXTS_IN_DELTA_SET];
 
             for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
                 SmallState ciphertext;
@@ -239,7 +217,7 @@ static size_t perform_experiment_from_diagonal(ExperimentContext *context) {
                         plaintext,
                         ciphertext,
                         context->sbox_index);
-                ciphertexts.push_back(ciphertext);
+                ciphertexts[j] = ciphertext.to_packed();
             }
 
             num_collisions += find_num_collisions(ciphertexts);
@@ -269,7 +247,7 @@ static size_t perform_experiment_with_prp(ExperimentContext *context) {
     size_t num_collisions = 0;
 
     for (size_t i = 0; i < context->num_sets_per_key; ++i) {
-        SmallStatesVector ciphertexts;
+        uint64_t ciphertexts[NUM_TEXTS_IN_DELTA_SET];
         speck64_state_t plaintext;
         generate_base_plaintext(plaintext);
 
@@ -277,7 +255,7 @@ static size_t perform_experiment_with_prp(ExperimentContext *context) {
             SmallState ciphertext;
             get_text_from_delta_set(plaintext, j);
             speck64_encrypt(&cipher_ctx, plaintext, ciphertext.state);
-            ciphertexts.push_back(ciphertext);
+            ciphertexts[j] = ciphertext.to_packed();
         }
 
         num_collisions += find_num_collisions(ciphertexts);
@@ -0,0 +1,362 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "ciphers/small_aes.h"
+#include "ciphers/small_aes_multi_key.h"
+#include "ciphers/small_aes_random_sbox.h"
+#include "ciphers/small_sboxes.h"
+#include "utils/argparse.h"
+#include "utils/experiment_runner.h"
+#include "utils/utils.h"
+#include "utils/xorshift1024.h"
+
+
+using ciphers::small_aes_multi_key_ctx_t;
+using utils::compute_variance;
+using utils::ArgumentParser;
+using utils::ExperimentResult;
+using utils::ExperimentTask;
+using utils::IntegerList;
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+static const size_t NUM_CONSIDERED_ROUNDS = 4;
+static const size_t NUM_TEXTS_IN_DELTA_SET = 16;
+static const size_t NUM_SETS_PER_TASK = 1L << 10;
+static const size_t NUM_TEXTS_PER_TASK =
+    NUM_SETS_PER_TASK * NUM_TEXTS_IN_DELTA_SET;
+static const size_t NUM_SBOXES_PER_PASS = SMALL_AES_MULTI_KEY_MAX_NUM_KEYS;
+
+// ---------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    __m128i sbox;
+} SBoxVariant;
+
+/**
+ * All S-boxes that are swept, the Small-AES S-box first.
+ */
+static const SBoxVariant SBOX_VARIANTS[] = {
+    {"small-aes", SMALL_AES_SBOX_1},
+    {"random-0", SMALL_AES_RANDOM_SBOX0},
+    {"random-1", SMALL_AES_RANDOM_SBOX1},
+    {"random-2", SMALL_AES_RANDOM_SBOX2},
+    {"random-3", SMALL_AES_RANDOM_SBOX3},
+    {"random-4", SMALL_AES_RANDOM_SBOX4},
+    {"random-5", SMALL_AES_RANDOM_SBOX5},
+    {"random-6", SMALL_AES_RANDOM_SBOX6},
+    {"random-7", SMALL_AES_RANDOM_SBOX7},
+    {"random-8", SMALL_AES_RANDOM_SBOX8},
+    {"random-9", SMALL_AES_RANDOM_SBOX9},
+    {"random-10", SMALL_AES_RANDOM_SBOX10},
+    {"random-11", SMALL_AES_RANDOM_SBOX11},
+    {"random-12", SMALL_AES_RANDOM_SBOX12},
+    {"random-13", SMALL_AES_RANDOM_SBOX13},
+    {"random-14", SMALL_AES_RANDOM_SBOX14},
+    {"random-15", SMALL_AES_RANDOM_SBOX15},
+    {"random-16", SMALL_AES_RANDOM_SBOX16},
+    {"random-17", SMALL_AES_RANDOM_SBOX17},
+    {"random-18", SMALL_AES_RANDOM_SBOX18},
+    {"random-19", SMALL_AES_RANDOM_SBOX19},
+    {"optimal-0", _4_BIT_OPTIMAL_SBOX_0},
+    {"optimal-1", _4_BIT_OPTIMAL_SBOX_1},
+    {"optimal-2", _4_BIT_OPTIMAL_SBOX_2},
+    {"optimal-3", _4_BIT_OPTIMAL_SBOX_3},
+    {"optimal-4", _4_BIT_OPTIMAL_SBOX_4},
+    {"optimal-5", _4_BIT_OPTIMAL_SBOX_5},
+    {"optimal-6", _4_BIT_OPTIMAL_SBOX_6},
+    {"optimal-7", _4_BIT_OPTIMAL_SBOX_7},
+    {"optimal-8", _4_BIT_OPTIMAL_SBOX_8},
+    {"optimal-9", _4_BIT_OPTIMAL_SBOX_9},
+    {"optimal-10", _4_BIT_OPTIMAL_SBOX_10},
+    {"optimal-11", _4_BIT_OPTIMAL_SBOX_11},
+    {"optimal-12", _4_BIT_OPTIMAL_SBOX_12},
+    {"optimal-13", _4_BIT_OPTIMAL_SBOX_13},
+    {"optimal-14", _4_BIT_OPTIMAL_SBOX_14},
+    {"optimal-15", _4_BIT_OPTIMAL_SBOX_15},
+    {"platinum-0-4-0", _4_BIT_PLATINUM_SBOX_0_4_NUM_1_DL_CATEGORY_0},
+    {"platinum-0-4-1", _4_BIT_PLATINUM_SBOX_0_4_NUM_1_DL_CATEGORY_1},
+    {"platinum-1-3-0", _4_BIT_PLATINUM_SBOX_1_3_NUM_1_DL_CATEGORY_0},
+    {"platinum-1-3-1", _4_BIT_PLATINUM_SBOX_1_3_NUM_1_DL_CATEGORY_1},
+    {"platinum-1-3-2", _4_BIT_PLATINUM_SBOX_1_3_NUM_1_DL_CATEGORY_2},
+    {"platinum-1-3-3", _4_BIT_PLATINUM_SBOX_1_3_NUM_1_DL_CATEGORY_3},
+    {"platinum-2-2-0", _4_BIT_PLATINUM_SBOX_2_2_NUM_1_DL_CATEGORY_0},
+    {"platinum-2-2-1", _4_BIT_PLATINUM_SBOX_2_2_NUM_1_DL_CATEGORY_1},
+    {"platinum-2-2-2", _4_BIT_PLATINUM_SBOX_2_2_NUM_1_DL_CATEGORY_2},
+    {"platinum-2-2-3", _4_BIT_PLATINUM_SBOX_2_2_NUM_1_DL_CATEGORY_3}
+};
+
+static const size_t NUM_SBOX_VARIANTS =
+    sizeof(SBOX_VARIANTS) / sizeof(SBOX_VARIANTS[0]);
+
+// ---------------------------------------------------------
+
+typedef std::array<uint8_t, SMALL_AES_NUM_KEY_BYTES> KeyBytes;
+
+/**
+ * Per-thread storage for the plaintexts of a task and their ciphertexts
+ * under the S-boxes of a single pass.
+ */
+typedef struct {
+    std::vector<uint64_t> plaintexts;
+    std::vector<uint64_t> ciphertexts;
+} TaskBuffer;
+
+typedef struct {
+    size_t num_keys;
+    size_t num_sets_per_key;
+    size_t num_threads;
+    uint64_t seed;
+    xorshift_prng_ctx_t prng;
+    std::vector<KeyBytes> keys;
+} ExperimentContext;
+
+// ---------------------------------------------------------
+
+/**
+ * Writes num_sets delta sets of 16 texts each, which iterate over nibble 0
+ * of a random base text as in test_four_round_distinguisher_random_sbox_small.
+ */
+static void generate_plaintexts(xorshift_prng_ctx_t *prng,
+                                uint64_t *plaintexts,
+                                const size_t num_sets) {
+    for (size_t i = 0; i < num_sets; ++i) {
+        const uint64_t base = utils::xorshift1024_next(prng)
+                              & 0x0FFFFFFFFFFFFFFFL;
+
+        for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
+            plaintexts[i * NUM_TEXTS_IN_DELTA_SET + j] =
+                base | ((uint64_t) j << 60);
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+/**
+ * Returns the number of pairs in the delta sets of ciphertexts whose
+ * ciphertexts share nibble 0.
+ */
+static size_t find_num_collisions(const uint64_t *ciphertexts,
+                                  const size_t num_sets) {
+    size_t num_collisions = 0;
+
+    for (size_t i = 0; i < num_sets; ++i) {
+        size_t counters[16] = {0};
+
+        for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
+            counters[ciphertexts[i * NUM_TEXTS_IN_DELTA_SET + j] >> 60]++;
+        }
+
+        for (size_t counter : counters) {
+            num_collisions += counter * (counter - 1) / 2;
+        }
+    }
+
+    return num_collisions;
+}
+
+// ---------------------------------------------------------
+
+/**
+ * Encrypts the sets of the task once per pass of up to eight S-boxes and
+ * stores the collisions per S-box to num_collisions.
+ */
+static void perform_experiment(const ExperimentContext *context,
+                               const ExperimentTask &task,
+                               TaskBuffer &buffer,
+                               size_t *num_collisions) {
+    const size_t num_texts = task.num_sets * NUM_TEXTS_IN_DELTA_SET;
+    generate_plaintexts(task.prng, buffer.plaintexts.data(), task.num_sets);
+
+    __m128i sboxes[NUM_SBOXES_PER_PASS];
+    small_aes_multi_key_ctx_t cipher_ctx;
+
+    for (size_t first = 0; first < NUM_SBOX_VARIANTS;
+         first += NUM_SBOXES_PER_PASS) {
+        const size_t num_sboxes = std::min(NUM_SBOXES_PER_PASS,
+                                           NUM_SBOX_VARIANTS - first);
+
+        for (size_t b = 0; b < num_sboxes; ++b) {
+            sboxes[b] = SBOX_VARIANTS[first + b].sbox;
+        }
+
+        small_aes_multi_key_sbox_setup(&cipher_ctx,
+                                       context->keys[task.key_index].data(),
+                                       sboxes,
+                                       num_sboxes);
+        small_aes_multi_key_encrypt_rounds_only_sbox_in_final(
+            &cipher_ctx, buffer.plaintexts.data(), num_texts,
+            buffer.ciphertexts.data(), NUM_CONSIDERED_ROUNDS
+        );
+
+        for (size_t b = 0; b < num_sboxes; ++b) {
+            num_collisions[first + b] = find_num_collisions(
+                buffer.ciphertexts.data() + b * num_texts, task.num_sets
+            );
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+static void generate_keys(ExperimentContext *context) {
+    context->keys.resize(context->num_keys);
+
+    for (KeyBytes &key : context->keys) {
+        utils::get_random_bytes(&context->prng,
+                                key.data(),
+                                SMALL_AES_NUM_KEY_BYTES);
+        utils::print_hex("# Key", key.data(), SMALL_AES_NUM_KEY_BYTES);
+    }
+}
+
+// ---------------------------------------------------------
+
+static void perform_experiments(ExperimentContext *context) {
+    const size_t num_tasks_per_key =
+        (context->num_sets_per_key + NUM_SETS_PER_TASK - 1)
+        / NUM_SETS_PER_TASK;
+    const size_t num_tasks = context->num_keys * num_tasks_per_key;
+
+    generate_keys(context);
+
+    std::vector<TaskBuffer> buffers(context->num_threads);
+
+    for (TaskBuffer &buffer : buffers) {
+        buffer.plaintexts.resize(NUM_TEXTS_PER_TASK);
+        buffer.ciphertexts.resize(NUM_SBOXES_PER_PASS * NUM_TEXTS_PER_TASK);
+    }
+
+    // Every task writes only its own row, so no locking is needed.
+    IntegerList num_collisions_per_task(num_tasks * NUM_SBOX_VARIANTS, 0);
+
+    ExperimentResult all_results;
+    utils::run_experiments_in_parallel(
+        all_results,
+        context->num_keys,
+        context->num_sets_per_key,
+        NUM_SETS_PER_TASK,
+        context->num_threads,
+        &context->prng,
+        [&](const ExperimentTask &task) {
+            const size_t task_index = task.key_index * num_tasks_per_key
+                                      + task.first_set_index
+                                        / NUM_SETS_PER_TASK;
+            size_t *num_collisions =
+                &num_collisions_per_task[task_index * NUM_SBOX_VARIANTS];
+
+            perform_experiment(context, task, buffers[task.thread_index],
+                               num_collisions);
+
+            size_t total = 0;
+
+            for (size_t b = 0; b < NUM_SBOX_VARIANTS; ++b) {
+                total += num_collisions[b];
+            }
+
+            return total;
+        }
+    );
+
+    // A PRP yields binom(16, 2) / 16 collisions per set on average.
+    const double num_expected_prp_collisions =
+        (double) (NUM_TEXTS_IN_DELTA_SET * (NUM_TEXTS_IN_DELTA_SET - 1) / 2)
+        / 16.0;
+    const double num_sets =
+        (double) (context->num_keys * context->num_sets_per_key);
+
+    printf("#%8zu Experiments\n", context->num_keys);
+    printf("#%8zu Sets/key\n", context->num_sets_per_key);
+    printf("#%8zu S-boxes\n", NUM_SBOX_VARIANTS);
+    printf("# PRP Mean/set %8.4f\n", num_expected_prp_collisions);
+    printf("# S-box Name             Collisions Mean/set Variance\n");
+
+    for (size_t b = 0; b < NUM_SBOX_VARIANTS; ++b) {
+        IntegerList num_collisions_per_key(context->num_keys, 0);
+        size_t num_collisions = 0;
+
+        for (size_t i = 0; i < num_tasks; ++i) {
+            const size_t value = num_collisions_per_task[
+                i * NUM_SBOX_VARIANTS + b];
+            num_collisions_per_key[i / num_tasks_per_key] += value;
+            num_collisions += value;
+        }
+
+        const double variance = compute_variance(num_collisions_per_key);
+        printf("%7zu %-16s %10zu %8.4f %8.4f\n",
+               b,
+               SBOX_VARIANTS[b].name,
+               num_collisions,
+               (double) num_collisions / num_sets,
+               variance);
+    }
+}
+
+// ---------------------------------------------------------
+// Argument parsing
+// ---------------------------------------------------------
+
+static void parse_args(ExperimentContext *context,
+                       int argc,
+                       const char **argv) {
+    ArgumentParser parser;
+    parser.appName("Sweeps the Small-AES four-round distinguisher over all "
+                   "predefined S-boxes: the Small-AES S-box, the 20 random, "
+                   "the 16 optimal, and the platinum 4-bit S-boxes. Every "
+                   "delta set is generated once and encrypted under up to "
+                   "eight S-boxes at once.");
+    parser.addArgument("-k", "--num_keys", 1, false);
+    parser.addArgument("-s", "--num_sets_per_key", 1, false);
+    parser.addArgument("-t", "--num_threads", 1, true);
+    parser.addArgument("-e", "--seed", 1, true);
+
+    try {
+        parser.parse((size_t) argc, argv);
+
+        context->num_sets_per_key = static_cast<size_t>(1UL
+            << parser.retrieveAsLong("s"));
+        context->num_keys = parser.retrieveAsLong("k");
+        context->num_threads = utils::get_num_available_threads();
+
+        if (parser.wasSet("-t")) {
+            context->num_threads = parser.retrieveAsLong("t");
+        }
+
+        context->seed = parser.wasSet("-e") ?
+                        parser.retrieveAsLong("e") :
+                        utils::get_random_seed_from_dev_urandom();
+    } catch (...) {
+        fprintf(stderr, "%s\n", parser.usage().c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    if (context->num_threads == 0) {
+        context->num_threads = 1;
+    }
+
+    printf("#Keys           %8zu\n", context->num_keys);
+    printf("#Sets/Key       %8zu\n", context->num_sets_per_key);
+    printf("#Threads        %8zu\n", context->num_threads);
+    printf("#Seed           %20zu\n", context->seed);
+    utils::xorshift1024_init_with_seed(&context->prng, context->seed);
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, const char **argv) {
+    ExperimentContext context;
+    parse_args(&context, argc, argv);
+    perform_experiments(&context);
+    return EXIT_SUCCESS;
+}
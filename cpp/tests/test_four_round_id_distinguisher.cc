@@ -5,6 +5,7 @@
  */
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <array>
 #include <vector>
 
@@ -29,6 +30,7 @@ using utils::xorshift_prng_ctx_t;
 
 static const size_t NUM_CONSIDERED_ROUNDS = 4;
 static const size_t NUM_TEXTS_IN_DELTA_SET = 256;
+static const size_t NUM_TEXTS_PER_BATCH = 16;
 
 // ---------------------------------------------------------
 
@@ -81,14 +83,18 @@ static void get_text_from_delta_set(aes_state_t base_text, const size_t i) {
 // ---------------------------------------------------------
 
 static void encrypt(const aes128_ctx_t* aes_context,
-                    aes_state_t plaintext,
-                    AESState& ciphertext) {
-    aes128_encrypt_rounds(
-        aes_context, plaintext, ciphertext.state, NUM_CONSIDERED_ROUNDS
+                    const aes_state_t plaintexts[NUM_TEXTS_PER_BATCH],
+                    AESState ciphertexts[NUM_TEXTS_PER_BATCH]) {
+    aes_state_t batch[NUM_TEXTS_PER_BATCH];
+    aes128_encrypt_rounds_16(
+        aes_context, plaintexts, batch, NUM_CONSIDERED_ROUNDS
     );
-    __m128i c = loadu(ciphertext.state);
-    c = aes_invert_shift_rows(c);
-    storeu(ciphertext.state, c);
+
+    for (size_t k = 0; k < NUM_TEXTS_PER_BATCH; ++k) {
+        __m128i c = loadu(batch[k]);
+        c = aes_invert_shift_rows(c);
+        storeu(ciphertexts[k].state, c);
+    }
 }
 
 // ---------------------------------------------------------
@@ -181,11 +187,19 @@ static size_t perform_experiment(ExperimentContext* context) {
         aes_state_t plaintext;
         utils::get_random_bytes(plaintext, AES_NUM_STATE_BYTES);
 
-        for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET; ++j) {
-            AESState ciphertext;
-            get_text_from_delta_set(plaintext, j);
-            encrypt(&aes_context, plaintext, ciphertext);
-            ciphertexts.push_back(ciphertext);
+        for (size_t j = 0; j < NUM_TEXTS_IN_DELTA_SET;
+             j += NUM_TEXTS_PER_BATCH) {
+            aes_state_t plaintexts[NUM_TEXTS_PER_BATCH];
+            AESState batch[NUM_TEXTS_PER_BATCH];
+
+            for (size_t k = 0; k < NUM_TEXTS_PER_BATCH; ++k) {
+                get_text_from_delta_set(plaintext, j + k);
+                memcpy(plaintexts[k], plaintext, AES_NUM_STATE_BYTES);
+            }
+
+            encrypt(&aes_context, plaintexts, batch);
+            ciphertexts.insert(ciphertexts.end(), batch,
+                               batch + NUM_TEXTS_PER_BATCH);
         }
 
         num_collisions += find_equal_columns(ciphertexts);
@@ -5,13 +5,18 @@
  */
 
 #include <stdint.h>
+#include <stdio.h>
+#include <string>
 #include <gtest/gtest.h>
 
 #include "ciphers/small_aes.h"
+#include "utils/compact_hash_table.h"
 #include "utils/hash_table_generator.h"
 #include "utils/utils.h"
 
 using ciphers::SMALL_AES_INVERSE_SBOX_ARRAY;
+using ciphers::SMALL_AES_SBOX_ARRAY;
+using utils::CompactHashTables;
 using utils::ExtendedDDT;
 using utils::IntegerList;
 using utils::IntegerMatrix;
@@ -319,6 +324,77 @@ TEST(HashTableGenerator, create_hash_table_3) {
 
 // ---------------------------------------------------------
 
+static void create_hash_tables(std::vector<ExtendedDDT> &hash_tables,
+                               const size_t *sbox) {
+    ExtendedDDT extended_ddt;
+    HashTableGenerator generator;
+    generator.compute_extended_ddt(extended_ddt, sbox, 16);
+    hash_tables.resize(4);
+
+    for (size_t i = 0; i < 4; ++i) {
+        generator.create_hash_table(hash_tables[i], i, extended_ddt);
+    }
+}
+
+// ---------------------------------------------------------
+
+static void test_compact_hash_tables(const std::vector<ExtendedDDT> &hash_tables,
+                                     const CompactHashTables &compact_tables) {
+    ASSERT_EQ(hash_tables.size(), compact_tables.get_num_tables());
+
+    for (size_t i = 0; i < hash_tables.size(); ++i) {
+        for (size_t alpha = 0; alpha < hash_tables[i].size(); ++alpha) {
+            const IntegerMatrix &transitions = hash_tables[i][alpha];
+            const uint16_t *diagonals =
+                compact_tables.get_diagonals_begin(i, alpha);
+            ASSERT_EQ(transitions.size(),
+                      (size_t) (compact_tables.get_diagonals_end(i, alpha)
+                                - diagonals));
+
+            for (size_t j = 0; j < transitions.size(); ++j) {
+                const size_t expected_diagonal = (transitions[j][0] << 12)
+                                                 | (transitions[j][1] << 8)
+                                                 | (transitions[j][2] << 4)
+                                                 | transitions[j][3];
+                ASSERT_EQ(expected_diagonal, (size_t) diagonals[j]);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(HashTableGenerator, compact_hash_tables_can_be_stored_and_mapped) {
+    std::vector<ExtendedDDT> hash_tables;
+    create_hash_tables(hash_tables, SMALL_AES_SBOX_ARRAY);
+
+    CompactHashTables compact_tables;
+    compact_tables.build(hash_tables, SMALL_AES_SBOX_ARRAY, 16);
+    test_compact_hash_tables(hash_tables, compact_tables);
+
+    const std::string file_name = "test_compact_hash_tables.bin";
+    ASSERT_TRUE(compact_tables.write_to_file(file_name));
+
+    CompactHashTables mapped_tables;
+    ASSERT_TRUE(mapped_tables.map_from_file(file_name,
+                                            SMALL_AES_SBOX_ARRAY, 16));
+    ASSERT_EQ(compact_tables.get_num_diagonals(),
+              mapped_tables.get_num_diagonals());
+    test_compact_hash_tables(hash_tables, mapped_tables);
+
+    // Tables of other S-boxes must not be used
+    CompactHashTables other_tables;
+    ASSERT_FALSE(other_tables.map_from_file(file_name,
+                                            SMALL_AES_INVERSE_SBOX_ARRAY, 16));
+    ASSERT_TRUE(other_tables.is_empty());
+
+    remove(file_name.c_str());
+    ASSERT_FALSE(other_tables.map_from_file(file_name,
+                                            SMALL_AES_SBOX_ARRAY, 16));
+}
+
+// ---------------------------------------------------------
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
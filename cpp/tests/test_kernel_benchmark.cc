@@ -0,0 +1,881 @@
+/**
+ * Measures the throughput of the cipher and collision-counting kernels in
+ * cycles per byte and states per second, and writes the results as JSON
+ * that can be compared across commits and machines.
+ *
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "ciphers/aes.h"
+#include "ciphers/small_aes.h"
+#include "ciphers/small_aes_bitsliced.h"
+#include "ciphers/small_aes_m02_mc.h"
+#include "ciphers/small_aes_midori_mc.h"
+#include "ciphers/small_aes_multi_key.h"
+#include "ciphers/small_aes_present_sbox.h"
+#include "ciphers/small_aes_present_sbox_m02_mc.h"
+#include "ciphers/small_aes_present_sbox_midori_mc.h"
+#include "ciphers/small_aes_pride_sbox.h"
+#include "ciphers/small_aes_prince_sbox.h"
+#include "ciphers/small_aes_random_sbox.h"
+#include "ciphers/small_aes_toy10_sbox.h"
+#include "ciphers/small_aes_toy6_sbox.h"
+#include "ciphers/small_aes_toy8_sbox.h"
+#include "ciphers/speck64.h"
+#include "utils/argparse.h"
+#include "utils/benchmark.h"
+#include "utils/column_collision_counter.h"
+#include "utils/delta_set_collision_counter.h"
+#include "utils/nibble_collision_counter.h"
+#include "utils/xorshift1024.h"
+
+
+using ciphers::aes128_ctx_t;
+using ciphers::aes128_key_t;
+using ciphers::aes_state_t;
+using ciphers::small_aes_bitsliced_ctx_t;
+using ciphers::small_aes_bitsliced_state_t;
+using ciphers::small_aes_ctx_t;
+using ciphers::small_aes_key_t;
+using ciphers::small_aes_multi_key_ctx_t;
+using ciphers::small_aes_packed_state_t;
+using ciphers::small_aes_state_t;
+using ciphers::speck64_context_t;
+using ciphers::speck64_96_key_t;
+using ciphers::speck64_state_t;
+using utils::ArgumentParser;
+using utils::BenchmarkRunner;
+using utils::do_not_optimize;
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+// Constants
+// ---------------------------------------------------------
+
+// Number of independent states that every cipher kernel encrypts per
+// iteration; small enough to stay in L1
+static const size_t NUM_STATES = 256;
+static const size_t NUM_STATE_BYTES = NUM_STATES * SMALL_AES_NUM_STATE_BYTES;
+static const size_t NUM_STRUCTURE_TEXTS =
+    SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE;
+static const size_t NUM_DELTA_SET_TEXTS =
+    DELTA_SET_COLLISION_COUNTER_NUM_TEXTS;
+static const size_t NUM_MULTI_KEYS = SMALL_AES_MULTI_KEY_MAX_NUM_KEYS;
+static const size_t DEFAULT_NUM_ROUNDS = 4;
+static const size_t DEFAULT_AES_NUM_ROUNDS = 5;
+static const uint64_t SEED = 0xBE4C4A4BL;
+
+// ---------------------------------------------------------
+// Types
+// ---------------------------------------------------------
+
+typedef void (*small_aes_encrypt_function_t)(const small_aes_ctx_t *,
+                                             const small_aes_state_t,
+                                             small_aes_state_t,
+                                             size_t);
+
+typedef __m128i (*small_aes_aes_ni_encrypt_function_t)(
+    const small_aes_ctx_t *, __m128i, size_t);
+
+typedef void (*small_aes_multi_encrypt_function_t)(const small_aes_ctx_t *,
+                                                   const uint8_t *,
+                                                   uint8_t *,
+                                                   size_t);
+
+typedef void (*aes_encrypt_function_t)(const aes128_ctx_t *,
+                                       const aes_state_t,
+                                       aes_state_t,
+                                       size_t);
+
+typedef void (*aes_batch_encrypt_function_t)(const aes128_ctx_t *,
+                                             const aes_state_t *,
+                                             aes_state_t *,
+                                             size_t);
+
+typedef struct {
+    const char *name;
+    small_aes_encrypt_function_t encrypt;
+    small_aes_aes_ni_encrypt_function_t encrypt_with_aes_ni;
+    // NULL if the variant has no four-text version
+    small_aes_multi_encrypt_function_t encrypt_4;
+} SmallAesVariant;
+
+typedef struct {
+    size_t num_rounds;
+    size_t aes_num_rounds;
+    std::string filter;
+    std::string label;
+    std::string output_path;
+    FILE *table_file;
+    small_aes_ctx_t small_aes_ctx;
+    small_aes_bitsliced_ctx_t bitsliced_ctx;
+    small_aes_multi_key_ctx_t multi_key_ctx;
+    aes128_ctx_t aes_ctx;
+    speck64_context_t speck_ctx;
+    // States one after another, since small_aes_state_t is over-aligned
+    uint8_t small_aes_plaintexts[NUM_STATE_BYTES];
+    uint8_t small_aes_ciphertexts[NUM_STATE_BYTES];
+    small_aes_packed_state_t packed_plaintexts[NUM_STATES];
+    small_aes_packed_state_t packed_ciphertexts[NUM_STATES];
+    __m128i aes_ni_plaintexts[NUM_STATES];
+    __m128i aes_ni_ciphertexts[NUM_STATES];
+    aes_state_t aes_plaintexts[NUM_STATES];
+    aes_state_t aes_ciphertexts[NUM_STATES];
+    speck64_state_t speck_plaintexts[NUM_STATES];
+    speck64_state_t speck_ciphertexts[NUM_STATES];
+    small_aes_bitsliced_state_t bitsliced_states;
+    uint64_t multi_key_ciphertexts[NUM_MULTI_KEYS * NUM_STATES];
+    std::vector<uint64_t> structure_texts;
+    // Ciphertexts of a diagonal structure under all multi-key keys
+    std::vector<uint64_t> structure_ciphertexts;
+} BenchmarkContext;
+
+// ---------------------------------------------------------
+
+static const SmallAesVariant SMALL_AES_VARIANTS[] = {
+    {
+        "small_aes",
+        &ciphers::small_aes_encrypt_rounds_only_sbox_in_final,
+        &ciphers::small_aes_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        &ciphers::small_aes_encrypt_rounds_4_only_sbox_in_final
+    },
+    {
+        "small_aes_m02_mc",
+        &ciphers::small_aes_m02_mc_encrypt_rounds_only_sbox_in_final,
+        &ciphers::small_aes_m02_mc_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        NULL
+    },
+    {
+        "small_aes_midori_mc",
+        &ciphers::small_aes_midori_mc_encrypt_rounds_only_sbox_in_final,
+        &ciphers::
+            small_aes_midori_mc_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        NULL
+    },
+    {
+        "small_aes_present_sbox",
+        &ciphers::small_aes_present_sbox_encrypt_rounds_only_sbox_in_final,
+        &ciphers::
+            small_aes_present_sbox_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        &ciphers::small_aes_present_sbox_encrypt_rounds_4_only_sbox_in_final
+    },
+    {
+        "small_aes_present_sbox_m02_mc",
+        &ciphers::
+            small_aes_present_sbox_m02_mc_encrypt_rounds_only_sbox_in_final,
+        &ciphers::
+            small_aes_present_sbox_m02_mc_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        NULL
+    },
+    {
+        "small_aes_present_sbox_midori_mc",
+        &ciphers::
+            small_aes_present_sbox_midori_mc_encrypt_rounds_only_sbox_in_final,
+        &ciphers::
+            small_aes_present_sbox_midori_mc_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        NULL
+    },
+    {
+        "small_aes_pride_sbox",
+        &ciphers::small_aes_pride_sbox_encrypt_rounds_only_sbox_in_final,
+        &ciphers::
+            small_aes_pride_sbox_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        &ciphers::small_aes_pride_sbox_encrypt_rounds_4_only_sbox_in_final
+    },
+    {
+        "small_aes_prince_sbox",
+        &ciphers::small_aes_prince_sbox_encrypt_rounds_only_sbox_in_final,
+        &ciphers::
+            small_aes_prince_sbox_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        &ciphers::small_aes_prince_sbox_encrypt_rounds_4_only_sbox_in_final
+    },
+    {
+        "small_aes_toy6_sbox",
+        &ciphers::small_aes_toy6_sbox_encrypt_rounds_only_sbox_in_final,
+        &ciphers::
+            small_aes_toy6_sbox_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        &ciphers::small_aes_toy6_sbox_encrypt_rounds_4_only_sbox_in_final
+    },
+    {
+        "small_aes_toy8_sbox",
+        &ciphers::small_aes_toy8_sbox_encrypt_rounds_only_sbox_in_final,
+        &ciphers::
+            small_aes_toy8_sbox_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        &ciphers::small_aes_toy8_sbox_encrypt_rounds_4_only_sbox_in_final
+    },
+    {
+        "small_aes_toy10_sbox",
+        &ciphers::small_aes_toy10_sbox_encrypt_rounds_only_sbox_in_final,
+        &ciphers::
+            small_aes_toy10_sbox_encrypt_rounds_only_sbox_in_final_with_aes_ni,
+        &ciphers::small_aes_toy10_sbox_encrypt_rounds_4_only_sbox_in_final
+    }
+};
+
+static const size_t NUM_SMALL_AES_VARIANTS =
+    sizeof(SMALL_AES_VARIANTS) / sizeof(SmallAesVariant);
+
+// ---------------------------------------------------------
+// Harness
+// ---------------------------------------------------------
+
+
+static void run_benchmark(BenchmarkContext *context,
+                          BenchmarkRunner *runner,
+                          const std::string &name,
+                          const size_t num_states_per_iteration,
+                          const size_t num_bytes_per_state,
+                          const utils::benchmark_function_t &function) {
+    if (name.find(context->filter) == std::string::npos) {
+        return;
+    }
+
+    utils::print_benchmark_table_row(
+        context->table_file,
+        runner->run(name, num_states_per_iteration, num_bytes_per_state,
+                    function)
+    );
+    fflush(context->table_file);
+}
+
+// ---------------------------------------------------------
+// Small-AES
+// ---------------------------------------------------------
+
+static void benchmark_small_aes_variant(BenchmarkContext *context,
+                                       BenchmarkRunner *runner,
+                                       const SmallAesVariant &variant) {
+    const std::string prefix = std::string(variant.name) + "_";
+    const small_aes_ctx_t *ctx = &context->small_aes_ctx;
+    const size_t num_rounds = context->num_rounds;
+
+    run_benchmark(
+        context, runner,
+        prefix + "encrypt_rounds_only_sbox_in_final",
+        NUM_STATES, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATE_BYTES;
+                     j += SMALL_AES_NUM_STATE_BYTES) {
+                    variant.encrypt(ctx,
+                                    context->small_aes_plaintexts + j,
+                                    context->small_aes_ciphertexts + j,
+                                    num_rounds);
+                }
+
+                do_not_optimize(context->small_aes_ciphertexts);
+            }
+        }
+    );
+
+    run_benchmark(
+        context, runner,
+        prefix + "encrypt_rounds_only_sbox_in_final_with_aes_ni",
+        NUM_STATES, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATES; ++j) {
+                    context->aes_ni_ciphertexts[j] =
+                        variant.encrypt_with_aes_ni(
+                            ctx, context->aes_ni_plaintexts[j], num_rounds
+                        );
+                }
+
+                do_not_optimize(context->aes_ni_ciphertexts);
+            }
+        }
+    );
+
+    if (variant.encrypt_4 == NULL) {
+        return;
+    }
+
+    run_benchmark(
+        context, runner,
+        prefix + "encrypt_rounds_4_only_sbox_in_final",
+        NUM_STATES, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATE_BYTES;
+                     j += 4 * SMALL_AES_NUM_STATE_BYTES) {
+                    variant.encrypt_4(ctx,
+                                      context->small_aes_plaintexts + j,
+                                      context->small_aes_ciphertexts + j,
+                                      num_rounds);
+                }
+
+                do_not_optimize(context->small_aes_ciphertexts);
+            }
+        }
+    );
+}
+
+// ---------------------------------------------------------
+
+/**
+ * The versions without a counterpart in the variants: packed states, two
+ * or four texts with MixColumns in the final round, the round sweep, and
+ * the random S-boxes.
+ */
+static void benchmark_small_aes_extras(BenchmarkContext *context,
+                                       BenchmarkRunner *runner) {
+    const small_aes_ctx_t *ctx = &context->small_aes_ctx;
+    const size_t num_rounds = context->num_rounds;
+
+    run_benchmark(
+        context, runner,
+        "small_aes_encrypt_rounds_only_sbox_in_final_packed",
+        NUM_STATES, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATES; ++j) {
+                    context->packed_ciphertexts[j] =
+                        small_aes_encrypt_rounds_only_sbox_in_final(
+                            ctx, context->packed_plaintexts[j], num_rounds
+                        );
+                }
+
+                do_not_optimize(context->packed_ciphertexts);
+            }
+        }
+    );
+
+    run_benchmark(
+        context, runner,
+        "small_aes_encrypt_rounds_only_sbox_in_final_sweep",
+        NUM_STATES, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATES; ++j) {
+                    small_aes_encrypt_rounds_only_sbox_in_final_sweep(
+                        ctx, context->packed_plaintexts[j],
+                        &context->packed_ciphertexts[j],
+                        num_rounds, num_rounds
+                    );
+                }
+
+                do_not_optimize(context->packed_ciphertexts);
+            }
+        }
+    );
+
+    run_benchmark(
+        context, runner,
+        "small_aes_encrypt_rounds_2",
+        NUM_STATES, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATE_BYTES;
+                     j += 2 * SMALL_AES_NUM_STATE_BYTES) {
+                    small_aes_encrypt_rounds_2(
+                        ctx, context->small_aes_plaintexts + j,
+                        context->small_aes_ciphertexts + j, num_rounds
+                    );
+                }
+
+                do_not_optimize(context->small_aes_ciphertexts);
+            }
+        }
+    );
+
+    run_benchmark(
+        context, runner,
+        "small_aes_encrypt_rounds_4",
+        NUM_STATES, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATE_BYTES;
+                     j += 4 * SMALL_AES_NUM_STATE_BYTES) {
+                    small_aes_encrypt_rounds_4(
+                        ctx, context->small_aes_plaintexts + j,
+                        context->small_aes_ciphertexts + j, num_rounds
+                    );
+                }
+
+                do_not_optimize(context->small_aes_ciphertexts);
+            }
+        }
+    );
+
+    run_benchmark(
+        context, runner,
+        "small_aes_random_sbox_encrypt_rounds_only_sbox_in_final_with_aes_ni",
+        NUM_STATES, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATES; ++j) {
+                    context->aes_ni_ciphertexts[j] =
+                        small_aes_random_sbox_encrypt_rounds_only_sbox_in_final_with_aes_ni(
+                            ctx, context->aes_ni_plaintexts[j], num_rounds, 0
+                        );
+                }
+
+                do_not_optimize(context->aes_ni_ciphertexts);
+            }
+        }
+    );
+}
+
+// ---------------------------------------------------------
+// Small-AES structure engines
+// ---------------------------------------------------------
+
+/**
+ * The engines that encrypt batches or diagonal structures at once: the AVX
+ * structure engine, the bitsliced engine, and the multi-key engine. The
+ * multi-key engine counts the states under all of its keys.
+ */
+static void benchmark_small_aes_engines(BenchmarkContext *context,
+                                        BenchmarkRunner *runner) {
+    const small_aes_ctx_t *ctx = &context->small_aes_ctx;
+    const size_t num_rounds = context->num_rounds;
+    uint64_t *ciphertexts = context->structure_ciphertexts.data();
+
+    run_benchmark(
+        context, runner,
+        "small_aes_encrypt_diagonal_structure",
+        NUM_STRUCTURE_TEXTS, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                small_aes_encrypt_diagonal_structure(ctx, i, ciphertexts,
+                                                     num_rounds);
+                do_not_optimize(ciphertexts);
+            }
+        }
+    );
+
+    run_benchmark(
+        context, runner,
+        "small_aes_bitsliced_encrypt_rounds_only_sbox_in_final",
+        SMALL_AES_BITSLICED_NUM_STATES, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                // Encrypts in place, so that every iteration continues on
+                // the ciphertexts of the one before
+                small_aes_bitsliced_encrypt_rounds_only_sbox_in_final(
+                    &context->bitsliced_ctx, &context->bitsliced_states,
+                    num_rounds
+                );
+                do_not_optimize(context->bitsliced_states);
+            }
+        }
+    );
+
+    run_benchmark(
+        context, runner,
+        "small_aes_bitsliced_encrypt_diagonal_structure",
+        NUM_STRUCTURE_TEXTS, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                small_aes_bitsliced_encrypt_diagonal_structure(
+                    &context->bitsliced_ctx, i, ciphertexts, num_rounds
+                );
+                do_not_optimize(ciphertexts);
+            }
+        }
+    );
+
+    run_benchmark(
+        context, runner,
+        "small_aes_multi_key_encrypt_rounds_only_sbox_in_final",
+        NUM_MULTI_KEYS * NUM_STATES, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                small_aes_multi_key_encrypt_rounds_only_sbox_in_final(
+                    &context->multi_key_ctx, context->packed_plaintexts,
+                    NUM_STATES, context->multi_key_ciphertexts, num_rounds
+                );
+                do_not_optimize(context->multi_key_ciphertexts);
+            }
+        }
+    );
+
+    run_benchmark(
+        context, runner,
+        "small_aes_multi_key_encrypt_diagonal_structure",
+        NUM_MULTI_KEYS * NUM_STRUCTURE_TEXTS, SMALL_AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                small_aes_multi_key_encrypt_diagonal_structure(
+                    &context->multi_key_ctx, i, ciphertexts, num_rounds
+                );
+                do_not_optimize(ciphertexts);
+            }
+        }
+    );
+}
+
+// ---------------------------------------------------------
+// AES and Speck
+// ---------------------------------------------------------
+
+static void benchmark_aes_function(BenchmarkContext *context,
+                                   BenchmarkRunner *runner,
+                                   const std::string &name,
+                                   const aes_encrypt_function_t function) {
+    const aes128_ctx_t *ctx = &context->aes_ctx;
+    const size_t num_rounds = context->aes_num_rounds;
+
+    run_benchmark(
+        context, runner, name, NUM_STATES, AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATES; ++j) {
+                    function(ctx, context->aes_plaintexts[j],
+                             context->aes_ciphertexts[j], num_rounds);
+                }
+
+                do_not_optimize(context->aes_ciphertexts);
+            }
+        }
+    );
+}
+
+// ---------------------------------------------------------
+
+static void
+benchmark_aes_batch_function(BenchmarkContext *context,
+                             BenchmarkRunner *runner,
+                             const std::string &name,
+                             const size_t num_texts_per_call,
+                             const aes_batch_encrypt_function_t function) {
+    const aes128_ctx_t *ctx = &context->aes_ctx;
+    const size_t num_rounds = context->aes_num_rounds;
+
+    run_benchmark(
+        context, runner, name, NUM_STATES, AES_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATES; j += num_texts_per_call) {
+                    function(ctx, context->aes_plaintexts + j,
+                             context->aes_ciphertexts + j, num_rounds);
+                }
+
+                do_not_optimize(context->aes_ciphertexts);
+            }
+        }
+    );
+}
+
+// ---------------------------------------------------------
+
+static void benchmark_aes(BenchmarkContext *context,
+                          BenchmarkRunner *runner) {
+    benchmark_aes_function(context, runner, "aes128_encrypt_rounds",
+                           &ciphers::aes128_encrypt_rounds);
+    benchmark_aes_function(context, runner,
+                           "aes128_encrypt_rounds_always_mc",
+                           &ciphers::aes128_encrypt_rounds_always_mc);
+    benchmark_aes_function(context, runner,
+                           "aes128_encrypt_rounds_only_sbox_in_final",
+                           &ciphers::aes128_encrypt_rounds_only_sbox_in_final);
+    benchmark_aes_batch_function(context, runner,
+                                 "aes128_encrypt_rounds_always_mc_4", 4,
+                                 &ciphers::aes128_encrypt_rounds_always_mc_4);
+    benchmark_aes_batch_function(context, runner,
+                                 "aes128_encrypt_rounds_8", 8,
+                                 &ciphers::aes128_encrypt_rounds_8);
+    benchmark_aes_batch_function(context, runner,
+                                 "aes128_encrypt_rounds_16", 16,
+                                 &ciphers::aes128_encrypt_rounds_16);
+    benchmark_aes_batch_function(context, runner,
+                                 "aes128_encrypt_rounds_always_mc_8", 8,
+                                 &ciphers::aes128_encrypt_rounds_always_mc_8);
+    benchmark_aes_batch_function(context, runner,
+                                 "aes128_encrypt_rounds_always_mc_16", 16,
+                                 &ciphers::aes128_encrypt_rounds_always_mc_16);
+    benchmark_aes_batch_function(
+        context, runner, "aes128_encrypt_rounds_only_sbox_in_final_8", 8,
+        &ciphers::aes128_encrypt_rounds_only_sbox_in_final_8
+    );
+    benchmark_aes_batch_function(
+        context, runner, "aes128_encrypt_rounds_only_sbox_in_final_16", 16,
+        &ciphers::aes128_encrypt_rounds_only_sbox_in_final_16
+    );
+}
+
+// ---------------------------------------------------------
+
+static void benchmark_speck(BenchmarkContext *context,
+                            BenchmarkRunner *runner) {
+    run_benchmark(
+        context, runner, "speck64_encrypt",
+        NUM_STATES, SPECK_64_NUM_STATE_BYTES,
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                for (size_t j = 0; j < NUM_STATES; ++j) {
+                    speck64_encrypt(&context->speck_ctx,
+                                    context->speck_plaintexts[j],
+                                    context->speck_ciphertexts[j]);
+                }
+
+                do_not_optimize(context->speck_ciphertexts);
+            }
+        }
+    );
+}
+
+// ---------------------------------------------------------
+// Collision counting
+// ---------------------------------------------------------
+
+static void benchmark_collision_counters(BenchmarkContext *context,
+                                         BenchmarkRunner *runner) {
+    const uint64_t *texts = context->structure_texts.data();
+
+    run_benchmark(
+        context, runner, "count_nibble_collisions",
+        NUM_STRUCTURE_TEXTS, sizeof(uint64_t),
+        [&](const size_t num_iterations) {
+            size_t num_collisions[NIBBLE_COLLISION_COUNTER_NUM_CELLS] = {0};
+
+            for (size_t i = 0; i < num_iterations; ++i) {
+                utils::count_nibble_collisions(texts, NUM_STRUCTURE_TEXTS,
+                                               num_collisions);
+                do_not_optimize(num_collisions);
+            }
+        }
+    );
+
+    const uint64_t cell_mask = utils::get_cell_mask(0);
+
+    run_benchmark(
+        context, runner, "count_delta_set_collisions_cell",
+        NUM_STRUCTURE_TEXTS, sizeof(uint64_t),
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                size_t num_collisions = 0;
+
+                for (size_t j = 0; j < NUM_STRUCTURE_TEXTS;
+                     j += NUM_DELTA_SET_TEXTS) {
+                    num_collisions += utils::count_delta_set_collisions(
+                        texts + j, &cell_mask, 1
+                    );
+                }
+
+                do_not_optimize(num_collisions);
+            }
+        }
+    );
+
+    run_benchmark(
+        context, runner, "count_delta_set_collisions_columns",
+        NUM_STRUCTURE_TEXTS, sizeof(uint64_t),
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                size_t num_collisions = 0;
+
+                for (size_t j = 0; j < NUM_STRUCTURE_TEXTS;
+                     j += NUM_DELTA_SET_TEXTS) {
+                    num_collisions += utils::count_delta_set_collisions(
+                        texts + j, utils::COLUMN_MASKS,
+                        DELTA_SET_COLLISION_COUNTER_NUM_COLUMNS
+                    );
+                }
+
+                do_not_optimize(num_collisions);
+            }
+        }
+    );
+
+    utils::ColumnCollisionCounter counter(NUM_STRUCTURE_TEXTS);
+
+    run_benchmark(
+        context, runner, "column_collision_counter_count",
+        NUM_STRUCTURE_TEXTS, sizeof(uint64_t),
+        [&](const size_t num_iterations) {
+            for (size_t i = 0; i < num_iterations; ++i) {
+                const utils::ColumnCollisions collisions = counter.count(
+                    texts, NUM_STRUCTURE_TEXTS
+                );
+                do_not_optimize(collisions.num_collisions);
+            }
+        }
+    );
+}
+
+// ---------------------------------------------------------
+// Setup
+// ---------------------------------------------------------
+
+/**
+ * Draws keys and inputs from a fixed seed, so that every run measures the
+ * same inputs.
+ */
+static void setup_inputs(BenchmarkContext *context) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, SEED);
+
+    small_aes_key_t small_aes_key;
+    utils::get_random_bytes(&prng, small_aes_key, SMALL_AES_NUM_KEY_BYTES);
+    small_aes_key_setup(&context->small_aes_ctx, small_aes_key);
+    small_aes_key_setup_2(&context->small_aes_ctx);
+    small_aes_key_setup_4(&context->small_aes_ctx);
+
+    aes128_key_t aes_key;
+    utils::get_random_bytes(&prng, aes_key, AES_128_NUM_KEY_BYTES);
+    aes128_key_setup(&context->aes_ctx, aes_key);
+
+    speck64_96_key_t speck_key;
+    utils::get_random_bytes(&prng, speck_key, SPECK_64_96_NUM_KEY_BYTES);
+    speck64_96_key_schedule(&context->speck_ctx, speck_key);
+
+    utils::get_random_bytes(&prng, context->small_aes_plaintexts,
+                            NUM_STATE_BYTES);
+    utils::get_random_bytes(&prng, context->aes_plaintexts[0],
+                            sizeof(context->aes_plaintexts));
+    utils::get_random_bytes(&prng, context->speck_plaintexts[0],
+                            sizeof(context->speck_plaintexts));
+
+    for (size_t i = 0; i < NUM_STATES; ++i) {
+        const uint8_t *plaintext =
+            context->small_aes_plaintexts + i * SMALL_AES_NUM_STATE_BYTES;
+        context->packed_plaintexts[i] = ciphers::small_aes_to_packed(plaintext);
+        context->aes_ni_plaintexts[i] = ciphers::to_lower_nibbles(plaintext);
+    }
+
+    context->structure_texts.resize(NUM_STRUCTURE_TEXTS);
+
+    for (size_t i = 0; i < NUM_STRUCTURE_TEXTS; ++i) {
+        context->structure_texts[i] = utils::xorshift1024_next(&prng);
+    }
+
+    // Drawn last, so that the inputs of the other kernels stay as before
+    small_aes_bitsliced_key_setup(&context->bitsliced_ctx, small_aes_key);
+    small_aes_bitsliced_pack(&context->bitsliced_states,
+                             context->packed_plaintexts);
+
+    small_aes_key_t multi_keys[NUM_MULTI_KEYS];
+    memcpy(multi_keys[0], small_aes_key, SMALL_AES_NUM_KEY_BYTES);
+    utils::get_random_bytes(&prng, multi_keys[1],
+                            (NUM_MULTI_KEYS - 1) * SMALL_AES_NUM_KEY_BYTES);
+    small_aes_multi_key_key_setup(&context->multi_key_ctx, multi_keys,
+                                  NUM_MULTI_KEYS);
+    context->structure_ciphertexts.resize(
+        NUM_MULTI_KEYS * NUM_STRUCTURE_TEXTS
+    );
+}
+
+// ---------------------------------------------------------
+
+static void perform_benchmarks(BenchmarkContext *context,
+                               const double min_seconds,
+                               const size_t num_repetitions) {
+    setup_inputs(context);
+
+    BenchmarkRunner runner(min_seconds, num_repetitions);
+    runner.add_context("label", context->label);
+    runner.add_context("num_rounds", std::to_string(context->num_rounds));
+    runner.add_context("aes_num_rounds",
+                       std::to_string(context->aes_num_rounds));
+    utils::print_benchmark_table_header(context->table_file);
+
+    for (size_t i = 0; i < NUM_SMALL_AES_VARIANTS; ++i) {
+        benchmark_small_aes_variant(context, &runner, SMALL_AES_VARIANTS[i]);
+    }
+
+    benchmark_small_aes_extras(context, &runner);
+    benchmark_small_aes_engines(context, &runner);
+    benchmark_aes(context, &runner);
+    benchmark_speck(context, &runner);
+    benchmark_collision_counters(context, &runner);
+
+    if (context->output_path.empty()) {
+        runner.write_json(stdout);
+        return;
+    }
+
+    FILE *file = fopen(context->output_path.c_str(), "w");
+
+    if (file == NULL) {
+        fprintf(stderr, "# Could not open %s\n",
+                context->output_path.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    runner.write_json(file);
+    fclose(file);
+}
+
+// ---------------------------------------------------------
+// Argument parsing
+// ---------------------------------------------------------
+
+int main(int argc, const char **argv) {
+    ArgumentParser parser;
+    parser.appName("Measures cycles per byte and states per second of the "
+                   "Small-AES, AES, and Speck kernels and the collision "
+                   "counters, and writes them as JSON.");
+    parser.addArgument("-r", "--num_rounds", 1, true);
+    parser.addArgument("-a", "--aes_num_rounds", 1, true);
+    parser.addArgument("-t", "--min_time", 1, true);
+    parser.addArgument("-n", "--num_repetitions", 1, true);
+    parser.addArgument("-f", "--filter", 1, true);
+    parser.addArgument("-l", "--label", 1, true);
+    parser.addArgument("-o", "--output", 1, true);
+
+    BenchmarkContext context;
+    context.num_rounds = DEFAULT_NUM_ROUNDS;
+    context.aes_num_rounds = DEFAULT_AES_NUM_ROUNDS;
+    double min_seconds = BENCHMARK_DEFAULT_MIN_SECONDS;
+    size_t num_repetitions = BENCHMARK_DEFAULT_NUM_REPETITIONS;
+
+    try {
+        parser.parse((size_t) argc, argv);
+
+        if (parser.wasSet("-r")) {
+            context.num_rounds = parser.retrieveAsLong("r");
+        }
+
+        if (parser.wasSet("-a")) {
+            context.aes_num_rounds = parser.retrieveAsLong("a");
+        }
+
+        if (parser.wasSet("-t")) {
+            min_seconds = std::stod(parser.retrieve<std::string>("t"));
+        }
+
+        if (parser.wasSet("-n")) {
+            num_repetitions = parser.retrieveAsLong("n");
+        }
+
+        if (parser.wasSet("-f")) {
+            context.filter = parser.retrieve<std::string>("f");
+        }
+
+        if (parser.wasSet("-l")) {
+            context.label = parser.retrieve<std::string>("l");
+        }
+
+        if (parser.wasSet("-o")) {
+            context.output_path = parser.retrieve<std::string>("o");
+        }
+    } catch (...) {
+        fprintf(stderr, "%s\n", parser.usage().c_str());
+        return EXIT_FAILURE;
+    }
+
+    if ((context.num_rounds == 0)
+        || (context.num_rounds > SMALL_AES_NUM_ROUNDS)
+        || (context.aes_num_rounds == 0)
+        || (context.aes_num_rounds > AES_128_NUM_ROUNDS)
+        || (min_seconds <= 0)
+        || (num_repetitions == 0)) {
+        fprintf(stderr, "%s\n", parser.usage().c_str());
+        return EXIT_FAILURE;
+    }
+
+    // Keeps stdout clean for the JSON if it is not written to a file
+    context.table_file = context.output_path.empty() ? stderr : stdout;
+    perform_benchmarks(&context, min_seconds, num_repetitions);
+    return EXIT_SUCCESS;
+}
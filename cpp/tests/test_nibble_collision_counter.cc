@@ -0,0 +1,74 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "utils/nibble_collision_counter.h"
+#include "utils/xorshift1024.h"
+
+
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+static const size_t NUM_CELLS = NIBBLE_COLLISION_COUNTER_NUM_CELLS;
+
+// ---------------------------------------------------------
+
+static size_t get_cell(const uint64_t text, const size_t cell_index) {
+    return (text >> ((15 - cell_index) * 4)) & 0xF;
+}
+
+// ---------------------------------------------------------
+
+static void run_test(const size_t num_texts, const uint64_t seed) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, seed);
+    std::vector<uint64_t> texts(num_texts);
+
+    for (uint64_t &text : texts) {
+        text = utils::xorshift1024_next(&prng);
+    }
+
+    std::vector<size_t> expected_num_collisions(NUM_CELLS, 0);
+
+    for (size_t i = 0; i < num_texts; ++i) {
+        for (size_t j = i + 1; j < num_texts; ++j) {
+            for (size_t cell = 0; cell < NUM_CELLS; ++cell) {
+                if (get_cell(texts[i], cell) == get_cell(texts[j], cell)) {
+                    expected_num_collisions[cell]++;
+                }
+            }
+        }
+    }
+
+    // Adds to the previous values
+    std::vector<size_t> num_collisions(NUM_CELLS, 1);
+    utils::count_nibble_collisions(texts.data(), num_texts,
+                                   num_collisions.data());
+
+    for (size_t cell = 0; cell < NUM_CELLS; ++cell) {
+        ASSERT_EQ(expected_num_collisions[cell] + 1, num_collisions[cell]);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(NibbleCollisionCounter, test_count) {
+    run_test(0, 1);
+    run_test(1, 2);
+    run_test(16, 3);
+    run_test(1000, 4);
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
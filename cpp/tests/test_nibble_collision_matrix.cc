@@ -0,0 +1,92 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <stdexcept>
+#include <gtest/gtest.h>
+
+#include "utils/argparse.h"
+#include "utils/nibble_collision_matrix.h"
+
+
+using utils::ArgumentParser;
+using utils::NibbleCollisionMatrix;
+
+// ---------------------------------------------------------
+
+static const size_t NUM_CELLS = NIBBLE_COLLISION_COUNTER_NUM_CELLS;
+
+// ---------------------------------------------------------
+
+TEST(NibbleCollisionMatrix, identity_collides_outside_the_input_cell) {
+    const size_t num_sets = 3;
+    NibbleCollisionMatrix matrix = {};
+    size_t num_calls = 0;
+
+    utils::add_nibble_collision_matrix(
+        num_sets,
+        [&](const uint64_t plaintext) {
+            num_calls++;
+            return plaintext;
+        },
+        matrix
+    );
+
+    ASSERT_EQ(NUM_CELLS * num_sets * 16, num_calls);
+
+    // The texts of a delta set differ only in its input cell, so all
+    // binom(16, 2) pairs collide in every other cell
+    for (size_t i = 0; i < NUM_CELLS; ++i) {
+        for (size_t o = 0; o < NUM_CELLS; ++o) {
+            ASSERT_EQ((i == o) ? 0 : 120 * num_sets, matrix[i][o]);
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(NibbleCollisionMatrix, retrieves_cell_arguments) {
+    size_t input_cell_index = 1;
+    size_t output_cell_index = 1;
+
+    ArgumentParser all_cells_parser;
+    utils::add_cell_arguments(all_cells_parser);
+    const char *all_cells_argv[] = {"test", "-a", "1"};
+    all_cells_parser.parse(3, all_cells_argv);
+
+    ASSERT_TRUE(utils::retrieve_cell_arguments(
+        all_cells_parser, &input_cell_index, &output_cell_index
+    ));
+    ASSERT_EQ(0UL, input_cell_index);
+    ASSERT_EQ(0UL, output_cell_index);
+
+    ArgumentParser single_cell_parser;
+    utils::add_cell_arguments(single_cell_parser);
+    const char *single_cell_argv[] = {"test", "-i", "3", "-o", "7"};
+    single_cell_parser.parse(5, single_cell_argv);
+
+    ASSERT_FALSE(utils::retrieve_cell_arguments(
+        single_cell_parser, &input_cell_index, &output_cell_index
+    ));
+    ASSERT_EQ(3UL, input_cell_index);
+    ASSERT_EQ(7UL, output_cell_index);
+
+    ArgumentParser missing_parser;
+    utils::add_cell_arguments(missing_parser);
+    const char *missing_argv[] = {"test", "-i", "3"};
+    missing_parser.parse(3, missing_argv);
+
+    ASSERT_THROW(utils::retrieve_cell_arguments(
+        missing_parser, &input_cell_index, &output_cell_index
+    ), std::invalid_argument);
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,114 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "utils/profiler.h"
+
+
+using utils::ProfilerPhase;
+
+// ---------------------------------------------------------
+
+/**
+ * Returns the printed profile with every run of spaces replaced by a
+ * single space, so that the checks do not depend on the column widths.
+ */
+static std::string print_profile() {
+    char *buffer = NULL;
+    size_t size = 0;
+    FILE *file = open_memstream(&buffer, &size);
+
+    if (file == NULL) {
+        return "";
+    }
+
+    utils::profiler_print(file);
+    fclose(file);
+
+    std::string profile;
+
+    for (size_t i = 0; i < size; ++i) {
+        if ((buffer[i] != ' ') || profile.empty() || (profile.back() != ' ')) {
+            profile += buffer[i];
+        }
+    }
+
+    free(buffer);
+    return profile;
+}
+
+// ---------------------------------------------------------
+
+TEST(Profiler, test_phase_names) {
+    ASSERT_STREQ("encryption",
+                 utils::get_profiler_phase_name(
+                     utils::PROFILER_PHASE_ENCRYPTION));
+    ASSERT_STREQ("collision counting",
+                 utils::get_profiler_phase_name(
+                     utils::PROFILER_PHASE_COLLISION_COUNTING));
+    ASSERT_STREQ("unknown",
+                 utils::get_profiler_phase_name(utils::PROFILER_NUM_PHASES));
+
+    for (size_t i = 0; i < utils::PROFILER_NUM_PHASES; ++i) {
+        ASSERT_STRNE("unknown",
+                     utils::get_profiler_phase_name((ProfilerPhase) i));
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(Profiler, test_print) {
+    utils::profiler_start();
+    utils::profiler_add_cycles(utils::PROFILER_PHASE_ENCRYPTION, 300);
+    utils::profiler_add_cycles(utils::PROFILER_PHASE_ENCRYPTION, 100);
+    utils::profiler_add_cycles(utils::PROFILER_PHASE_BUCKETING, 100);
+    utils::profiler_add(utils::PROFILER_COUNTER_TEXTS, 50);
+    utils::profiler_add(utils::PROFILER_COUNTER_SETS, 2);
+
+    const std::string profile = print_profile();
+
+    // 400 of 500 cycles, over two scopes, and 8 cycles per text
+    ASSERT_NE(std::string::npos,
+              profile.find("# encryption 4.000000e+02 80.00% 2 8.00\n"));
+    ASSERT_NE(std::string::npos, profile.find("# bucketing/sorting"));
+    // Phases without scopes are omitted
+    ASSERT_EQ(std::string::npos, profile.find("# key setup"));
+    ASSERT_NE(std::string::npos, profile.find("# Texts 50\n"));
+    ASSERT_NE(std::string::npos, profile.find("# Cycles/text 10.00\n"));
+}
+
+// ---------------------------------------------------------
+
+TEST(Profiler, test_merges_threads) {
+    utils::profiler_start();
+
+    std::thread worker([]() {
+        utils::ScopedPhaseTimer timer(utils::PROFILER_PHASE_RNG);
+        utils::profiler_add(utils::PROFILER_COUNTER_SETS, 3);
+    });
+    worker.join();
+
+    utils::profiler_add(utils::PROFILER_COUNTER_SETS, 4);
+    const std::string profile = print_profile();
+
+    ASSERT_NE(std::string::npos, profile.find("# rng"));
+    ASSERT_NE(std::string::npos, profile.find("# Sets 7\n"));
+
+    // Printing merges the counters, so they are not counted twice
+    ASSERT_NE(std::string::npos, print_profile().find("# Sets 7\n"));
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -19,9 +19,9 @@
 
 
 using ciphers::small_aes_ctx_t;
+using ciphers::small_aes_packed_state_t;
 using ciphers::small_aes_state_t;
 using ciphers::small_aes_key_t;
-using ciphers::SmallState;
 using ciphers::SmallStatePair;
 using ciphers::speck64_context_t;
 using ciphers::speck64_96_key_t;
@@ -43,6 +43,7 @@ typedef struct {
     small_aes_ctx_t cipher_ctx;
     size_t num_keys;
     size_t num_rounds;
+    size_t max_num_rounds;
     size_t num_sets_per_key;
     size_t input_diagonal_index;
     size_t output_diagonal_index;
@@ -50,6 +51,7 @@ typedef struct {
 } ExperimentContext;
 
 typedef std::vector<size_t> UInt64Vector;
+typedef std::vector<UInt64Vector> HistogramVector;
 
 typedef struct {
     UInt64Vector num_collisions_per_set;
@@ -129,12 +131,18 @@ get_text_from_delta_set(small_aes_state_t base_text,
 
 // ---------------------------------------------------------
 
+/**
+ * Writes the ciphertexts after all numbers of rounds in
+ * [context->num_rounds, context->max_num_rounds] to ciphertexts, computing
+ * every round only once.
+ */
 static void encrypt(const small_aes_ctx_t *aes_context,
-                    const size_t num_rounds,
+                    const ExperimentContext *context,
                     small_aes_state_t plaintext,
-                    SmallState &ciphertext) {
-    small_aes_encrypt_rounds_only_sbox_in_final(
-        aes_context, plaintext, ciphertext.state, num_rounds
+                    small_aes_packed_state_t *ciphertexts) {
+    small_aes_encrypt_rounds_only_sbox_in_final_sweep(
+        aes_context, ciphers::small_aes_to_packed(plaintext), ciphertexts,
+        context->num_rounds, context->max_num_rounds
     );
 }
 
@@ -176,6 +184,34 @@ static void add_to_num_occurrences(UInt64Vector &histogram,
 
 // ---------------------------------------------------------
 
+static void add_to_num_occurrences(UInt64Vector &histogram,
+                                   const small_aes_packed_state_t state,
+                                   const size_t output_diagonal_index) {
+    const size_t shift = (3 - output_diagonal_index) * 16;
+    histogram[(state >> shift) & 0xFFFF]++;
+}
+
+// ---------------------------------------------------------
+
+static size_t get_num_round_counts(const ExperimentContext *context) {
+    return context->max_num_rounds - context->num_rounds + 1;
+}
+
+// ---------------------------------------------------------
+
+static void print_set_collisions(const size_t set_index,
+                                 const UInt64Vector &num_collisions) {
+    printf("# %8zu", set_index);
+
+    for (const size_t value : num_collisions) {
+        printf(" %8zu", value);
+    }
+
+    printf("\n");
+}
+
+// ---------------------------------------------------------
+
 static void init_histogram(UInt64Vector &histogram) {
     std::fill(histogram.begin(), histogram.end(), 0);
 }
@@ -198,40 +234,55 @@ static size_t find_num_collisions(const UInt64Vector &histogram) {
 
 // ---------------------------------------------------------
 
-static size_t perform_experiment(ExperimentContext *context) {
+/**
+ * Returns the number of collisions over all sets of a random key for every
+ * number of rounds in [context->num_rounds, context->max_num_rounds]. The
+ * rounds are swept in a single pass, with one histogram per number of
+ * rounds.
+ */
+static UInt64Vector perform_experiment(ExperimentContext *context) {
     small_aes_ctx_t cipher_ctx = context->cipher_ctx;
     small_aes_key_t correct_key;
 
     utils::get_random_bytes(correct_key, SMALL_AES_NUM_KEY_BYTES);
     small_aes_key_setup(&cipher_ctx, correct_key);
 
+    const size_t num_round_counts = get_num_round_counts(context);
     auto num_sets_per_key = context->num_sets_per_key;
-    size_t num_total_collisions = 0;
+    UInt64Vector num_total_collisions(num_round_counts, 0);
+    HistogramVector histograms(num_round_counts,
+                               UInt64Vector(NUM_TEXTS_IN_STRUCTURE));
+    small_aes_packed_state_t ciphertexts[SMALL_AES_NUM_ROUNDS];
 
     for (size_t i = 0; i < num_sets_per_key; ++i) {
-        UInt64Vector num_occurrences_vector(NUM_TEXTS_IN_STRUCTURE);
-        init_histogram(num_occurrences_vector);
+        for (UInt64Vector &histogram : histograms) {
+            init_histogram(histogram);
+        }
 
         small_aes_state_t plaintext;
         generate_base_plaintext(plaintext, i, context->input_diagonal_index);
 
         for (size_t j = 0; j < NUM_TEXTS_IN_STRUCTURE; ++j) {
-            SmallState ciphertext;
             get_text_from_delta_set(plaintext,
                                     j,
                                     context->input_diagonal_index);
+            encrypt(&cipher_ctx, context, plaintext, ciphertexts);
 
-            encrypt(&cipher_ctx, context->num_rounds, plaintext, ciphertext);
-            add_to_num_occurrences(num_occurrences_vector,
-                                   ciphertext.state,
-                                   context->output_diagonal_index);
+            for (size_t r = 0; r < num_round_counts; ++r) {
+                add_to_num_occurrences(histograms[r],
+                                       ciphertexts[r],
+                                       context->output_diagonal_index);
+            }
         }
 
-        const size_t num_collisions = find_num_collisions(
-            num_occurrences_vector);
-        num_total_collisions += num_collisions;
+        UInt64Vector num_collisions(num_round_counts);
 
-        printf("# %8zu %8zu\n", i, num_collisions);
+        for (size_t r = 0; r < num_round_counts; ++r) {
+            num_collisions[r] = find_num_collisions(histograms[r]);
+            num_total_collisions[r] += num_collisions[r];
+        }
+
+        print_set_collisions(i, num_collisions);
     }
 
     return num_total_collisions;
@@ -239,7 +290,11 @@ static size_t perform_experiment(ExperimentContext *context) {
 
 // ---------------------------------------------------------
 
-static size_t perform_experiment_prp(ExperimentContext *context) {
+/**
+ * The PRP does not depend on the number of rounds; its number of
+ * collisions is reported for every swept number of rounds.
+ */
+static UInt64Vector perform_experiment_prp(ExperimentContext *context) {
     speck64_context_t cipher_ctx;
     speck64_96_key_t key;
 
@@ -271,52 +326,67 @@ static size_t perform_experiment_prp(ExperimentContext *context) {
             num_occurrences_vector);
         num_total_collisions += num_collisions;
 
-        printf("# %8zu %8zu\n", i, num_collisions);
+        print_set_collisions(
+            i, UInt64Vector(get_num_round_counts(context), num_collisions)
+        );
     }
 
-    return num_total_collisions;
+    return UInt64Vector(get_num_round_counts(context), num_total_collisions);
 }
 
 
 // ---------------------------------------------------------
 
 static void perform_experiments(ExperimentContext *context) {
-    ExperimentResult all_results;
-    all_results.num_collisions = 0;
+    const size_t num_round_counts = get_num_round_counts(context);
+    std::vector<ExperimentResult> all_results(num_round_counts);
+
+    for (ExperimentResult &result : all_results) {
+        result.num_collisions = 0;
+    }
 
     printf("#%8zu Experiments\n", context->num_keys);
     printf("#%8zu Sets/key\n", context->num_sets_per_key);
     printf("# Key Collisions Mean Variance \n");
 
     for (size_t i = 0; i < context->num_keys; ++i) {
-        size_t num_collisions = 0;
+        const UInt64Vector num_collisions = context->use_prp ?
+            perform_experiment_prp(context) :
+            perform_experiment(context);
 
-        if (context->use_prp) {
-            num_collisions = perform_experiment_prp(context);
-        } else {
-            num_collisions = perform_experiment(context);
-        }
+        printf("%4zu", i + 1);
+
+        for (size_t r = 0; r < num_round_counts; ++r) {
+            const double mean =
+                (double) num_collisions[r] / (double) context->num_sets_per_key;
 
-        const double mean =
-            (double) num_collisions / (double) context->num_sets_per_key;
+            all_results[r].num_collisions += num_collisions[r];
+            all_results[r].num_collisions_per_set.push_back(num_collisions[r]);
 
-        all_results.num_collisions += num_collisions;
-        all_results.num_collisions_per_set.push_back(num_collisions);
+            printf(" %8zu %8.4f", num_collisions[r], mean);
+        }
 
-        printf("%4zu %8zu %8.4f\n", i + 1, num_collisions, mean);
+        printf("\n");
     }
 
-    const double mean = compute_mean(all_results.num_collisions_per_set);
-    const double variance = compute_variance(
-        all_results.num_collisions_per_set);
+    for (size_t r = 0; r < num_round_counts; ++r) {
+        const ExperimentResult &result = all_results[r];
+        const double mean = compute_mean(result.num_collisions_per_set);
+        const double variance = compute_variance(
+            result.num_collisions_per_set);
+
+        if (num_round_counts > 1) {
+            printf("# Rounds %8zu\n", context->num_rounds + r);
+        }
 
-    printf("# Total Keys Collisions Mean Variance \n");
+        printf("# Total Keys Collisions Mean Variance \n");
 
-    printf("# %4zu %8zu %8.4f %8.8f\n",
-           context->num_keys,
-           all_results.num_collisions,
-           mean,
-           variance);
+        printf("# %4zu %8zu %8.4f %8.8f\n",
+               context->num_keys,
+               result.num_collisions,
+               mean,
+               variance);
+    }
 }
 
 // ---------------------------------------------------------
@@ -329,10 +399,12 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
     parser.appName(
         "Test for the Small-AES r-round distinguisher that tests for"
         "the number of collisions in the i-th column from structures with"
-        "the o-th diagonal active.");
+        "the o-th diagonal active. With m, reports every number of rounds "
+        "in [r, m] from a single encryption pass.");
     parser.addArgument("-k", "--num_keys", 1, false);
     parser.addArgument("-s", "--num_sets_per_key", 1, false);
     parser.addArgument("-r", "--num_rounds", 1, false);
+    parser.addArgument("-m", "--max_num_rounds", 1, true);
     parser.addArgument("-p", "--use_prp", 1, false);
     parser.addArgument("-i", "--input_diagonal_index", 1, false);
     parser.addArgument("-o", "--output_diagonal_index", 1, false);
@@ -344,6 +416,9 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
             << parser.retrieveAsLong("s"));
         context->num_keys = parser.retrieveAsLong("k");
         context->num_rounds = parser.retrieveAsLong("r");
+        context->max_num_rounds = parser.wasSet("-m") ?
+                                  parser.retrieveAsLong("m") :
+                                  context->num_rounds;
         context->input_diagonal_index = parser.retrieveAsLong("i");
         context->output_diagonal_index = parser.retrieveAsLong("o");
         context->use_prp = (bool) parser.retrieveAsInt("p");
@@ -352,7 +427,15 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
         exit(EXIT_FAILURE);
     }
 
+    if ((context->num_rounds == 0)
+        || (context->num_rounds > context->max_num_rounds)
+        || (context->max_num_rounds > SMALL_AES_NUM_ROUNDS)) {
+        fprintf(stderr, "%s\n", parser.usage().c_str());
+        exit(EXIT_FAILURE);
+    }
+
     printf("#Rounds         %8zu\n", context->num_rounds);
+    printf("#Max. rounds    %8zu\n", context->max_num_rounds);
     printf("#Keys           %8zu\n", context->num_keys);
     printf("#Sets/Key (log) %8zu\n", context->num_sets_per_key);
     printf("#Input index    %8zu\n", context->input_diagonal_index);
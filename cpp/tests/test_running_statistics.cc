@@ -0,0 +1,218 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "utils/running_statistics.h"
+#include "utils/utils.h"
+#include "utils/xorshift1024.h"
+
+
+using utils::ConfidenceInterval;
+using utils::RunningStatistics;
+using utils::SequentialProbabilityRatioTest;
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+static std::vector<size_t> get_random_values(const size_t num_values,
+                                             const uint64_t seed) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, seed);
+    std::vector<size_t> values(num_values);
+
+    for (size_t &value : values) {
+        value = utils::xorshift1024_next(&prng) & 0xFFFF;
+    }
+
+    return values;
+}
+
+// ---------------------------------------------------------
+
+TEST(RunningStatistics, test_matches_compute_mean_and_variance) {
+    const std::vector<size_t> values = get_random_values(1000, 1);
+    RunningStatistics statistics;
+
+    for (const size_t value : values) {
+        statistics.add((double) value);
+    }
+
+    ASSERT_EQ(values.size(), statistics.get_num_values());
+    ASSERT_NEAR(utils::compute_mean(values), statistics.get_mean(), 1e-6);
+    ASSERT_NEAR(utils::compute_variance(values), statistics.get_variance(),
+                1e-3);
+    ASSERT_NEAR(utils::compute_standard_deviation(values),
+                statistics.get_standard_deviation(), 1e-6);
+}
+
+// ---------------------------------------------------------
+
+TEST(RunningStatistics, test_merge_equals_single_stream) {
+    const std::vector<size_t> values = get_random_values(1000, 2);
+    RunningStatistics all;
+    RunningStatistics parts[3];
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        all.add((double) values[i]);
+        // Uneven parts
+        parts[(i * i) % 3].add((double) values[i]);
+    }
+
+    RunningStatistics merged;
+    merged.merge(RunningStatistics());
+
+    for (const RunningStatistics &part : parts) {
+        merged.merge(part);
+    }
+
+    ASSERT_EQ(all.get_num_values(), merged.get_num_values());
+    ASSERT_NEAR(all.get_mean(), merged.get_mean(), 1e-6);
+    ASSERT_NEAR(all.get_variance(), merged.get_variance(), 1e-3);
+}
+
+// ---------------------------------------------------------
+
+TEST(RunningStatistics, test_few_values) {
+    RunningStatistics statistics;
+    ASSERT_EQ(0.0, statistics.get_mean());
+    ASSERT_EQ(0.0, statistics.get_variance());
+    ASSERT_EQ(0.0, statistics.get_standard_error());
+
+    statistics.add(3.0);
+    ASSERT_EQ(3.0, statistics.get_mean());
+    ASSERT_EQ(0.0, statistics.get_variance());
+}
+
+// ---------------------------------------------------------
+
+TEST(RunningStatistics, test_normal_quantile) {
+    ASSERT_NEAR(0.0, utils::get_normal_quantile(0.5), 1e-9);
+    ASSERT_NEAR(1.959963985, utils::get_normal_quantile(0.975), 1e-8);
+    ASSERT_NEAR(-1.959963985, utils::get_normal_quantile(0.025), 1e-8);
+    ASSERT_NEAR(2.575829304, utils::get_normal_quantile(0.995), 1e-8);
+    ASSERT_NEAR(-3.090232306, utils::get_normal_quantile(0.001), 1e-8);
+}
+
+// ---------------------------------------------------------
+
+TEST(RunningStatistics, test_confidence_interval) {
+    RunningStatistics statistics;
+
+    for (size_t i = 0; i < 100; ++i) {
+        statistics.add((double) (i % 2));
+    }
+
+    const ConfidenceInterval interval =
+        statistics.get_confidence_interval(0.95);
+    const double half_width = 1.959963985 * sqrt(100.0 / 396.0) / 10.0;
+    ASSERT_NEAR(0.5 - half_width, interval.lower, 1e-8);
+    ASSERT_NEAR(0.5 + half_width, interval.upper, 1e-8);
+}
+
+// ---------------------------------------------------------
+
+static const double NULL_PROBABILITY = 1.0 / 16;
+static const double MIN_DIFFERENCE = NULL_PROBABILITY / 5;
+static const size_t NUM_PAIRS_PER_SET = 120;
+
+// ---------------------------------------------------------
+
+/**
+ * Feeds the test sets of 120 pairs that collide independently with the
+ * given probability until it decides.
+ */
+static utils::SprtDecision run_sprt(const double probability,
+                                    const uint64_t seed,
+                                    size_t *num_sets) {
+    const SequentialProbabilityRatioTest test(NULL_PROBABILITY,
+                                              MIN_DIFFERENCE,
+                                              0.999);
+    const uint64_t threshold =
+        (uint64_t) (probability * (double) (1ULL << 53));
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, seed);
+    utils::SprtDecision decision = utils::SPRT_CONTINUE;
+    size_t num_collisions = 0;
+    *num_sets = 0;
+
+    while (decision == utils::SPRT_CONTINUE) {
+        for (size_t i = 0; i < NUM_PAIRS_PER_SET; ++i) {
+            if ((utils::xorshift1024_next(&prng) >> 11) < threshold) {
+                num_collisions++;
+            }
+        }
+
+        (*num_sets)++;
+        decision = test.decide(num_collisions,
+                               *num_sets * NUM_PAIRS_PER_SET);
+    }
+
+    return decision;
+}
+
+// ---------------------------------------------------------
+
+TEST(SequentialProbabilityRatioTest, test_decides_for_the_true_probability) {
+    for (uint64_t seed = 0; seed < 10; ++seed) {
+        size_t num_sets;
+        ASSERT_EQ(utils::SPRT_ACCEPT_NULL,
+                  run_sprt(NULL_PROBABILITY, seed, &num_sets));
+        ASSERT_LT(num_sets, (size_t) 1000);
+
+        ASSERT_EQ(utils::SPRT_ACCEPT_ALTERNATIVE,
+                  run_sprt(NULL_PROBABILITY + MIN_DIFFERENCE, seed,
+                           &num_sets));
+        ASSERT_LT(num_sets, (size_t) 1000);
+
+        ASSERT_EQ(utils::SPRT_ACCEPT_ALTERNATIVE,
+                  run_sprt(NULL_PROBABILITY - MIN_DIFFERENCE, seed,
+                           &num_sets));
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(SequentialProbabilityRatioTest, test_decides_from_a_single_observation) {
+    const SequentialProbabilityRatioTest test(NULL_PROBABILITY,
+                                              MIN_DIFFERENCE,
+                                              0.99);
+    const size_t num_pairs = NUM_PAIRS_PER_SET << 16;
+
+    // One key of 2^16 sets suffices; no minimal number of keys is needed
+    ASSERT_EQ(utils::SPRT_ACCEPT_NULL,
+              test.decide(num_pairs / 16, num_pairs));
+    ASSERT_EQ(utils::SPRT_ACCEPT_ALTERNATIVE,
+              test.decide(num_pairs / 16 + num_pairs / 80, num_pairs));
+    ASSERT_EQ(utils::SPRT_CONTINUE,
+              test.decide(NUM_PAIRS_PER_SET / 16, NUM_PAIRS_PER_SET));
+
+    const double p = NULL_PROBABILITY + MIN_DIFFERENCE;
+    ASSERT_NEAR(3 * log(p / NULL_PROBABILITY)
+                + 7 * log((1 - p) / (1 - NULL_PROBABILITY)),
+                test.get_log_likelihood_ratio(3, 10, p),
+                1e-12);
+}
+
+// ---------------------------------------------------------
+
+TEST(SequentialProbabilityRatioTest, test_rejects_invalid_probabilities) {
+    ASSERT_THROW(SequentialProbabilityRatioTest(0.5, 0.5, 0.99),
+                 std::invalid_argument);
+    ASSERT_THROW(SequentialProbabilityRatioTest(0.75, 0.25, 0.99),
+                 std::invalid_argument);
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -9,6 +9,7 @@
 
 #include <array>
 #include <map>
+#include <mutex>
 #include <chrono>
 #include <vector>
 #include <numeric>      // std::iota
@@ -20,7 +21,10 @@
 #include "ciphers/small_state_pair.h"
 #include "ciphers/speck64.h"
 #include "utils/argparse.h"
+#include "utils/column_collision_counter.h"
+#include "utils/experiment_runner.h"
 #include "utils/hash_table_generator.h"
+#include "utils/profiler.h"
 #include "utils/utils.h"
 #include "utils/xorshift1024.h"
 
@@ -33,16 +37,18 @@ using ciphers::speck64_context_t;
 using ciphers::speck64_96_key_t;
 using ciphers::speck64_state_t;
 using utils::ArgumentParser;
+using utils::ColumnCollisionCounter;
+using utils::ColumnCollisions;
 using utils::print_hex;
 using utils::to_uint64;
-using utils::convert_to_uint64;
 using utils::zeroize_array;
 
 // ---------------------------------------------------------
 // Constants
 // ---------------------------------------------------------
 
-const size_t NUM_TEXTS_PER_STRUCTURE = 1 << 16;
+const size_t NUM_TEXTS_PER_STRUCTURE =
+    SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE;
 const size_t NUM_CONSIDERED_ROUNDS = 6;
 
 // ---------------------------------------------------------
@@ -50,22 +56,33 @@ const size_t NUM_CONSIDERED_ROUNDS = 6;
 // ---------------------------------------------------------
 
 typedef std::pair<size_t, size_t> IntegerPair;
-typedef std::array<uint64_t, NUM_TEXTS_PER_STRUCTURE> UInt64List;
-typedef std::vector<uint64_t> UInt64Vector;
+
+typedef std::array<uint8_t, SMALL_AES_NUM_KEY_BYTES> KeyBytes;
 
 typedef struct {
     small_aes_key_t key;
-    small_aes_ctx_t cipher_ctx;
     bool has_set_key = false;
-    size_t num_collisions = 0;
-    size_t num_multi_column_collisions = 0;
     size_t num_keys = 0;
     size_t num_structures_per_key = 0;
     size_t structure_start_index = 0;
-    UInt64List list;
-    UInt64List count_lists[SMALL_AES_NUM_COLUMNS];
+    size_t num_rounds = NUM_CONSIDERED_ROUNDS;
+    size_t max_num_rounds = NUM_CONSIDERED_ROUNDS;
+    size_t num_threads = 1;
+    uint64_t seed = 0;
+    utils::xorshift_prng_ctx_t prng;
 } ExperimentContext;
 
+/**
+ * Per-thread storage for the ciphertexts of a structure after every swept
+ * number of rounds and the buffers of the collision counter.
+ */
+typedef struct StructureBuffer {
+    StructureBuffer() : counter(NUM_TEXTS_PER_STRUCTURE) {}
+
+    std::vector<uint64_t> ciphertexts;
+    ColumnCollisionCounter counter;
+} StructureBuffer;
+
 // ----------------------------------------------------------
 // Logging functions
 // ----------------------------------------------------------
@@ -86,296 +103,258 @@ static void log_double(const std::string &label,
 // Helper methods
 // ---------------------------------------------------------
 
-static __m128i
-generate_diagonal_base_plaintext(const size_t i) {
-    // Zeroize
-    // 0 x x x
-    // x 0 x x
-    // x x 0 x
-    // x x x 0
-    return vsetr8(
-        0, 0, (uint8_t) ((i >> 28) & 0xF), (uint8_t) ((i >> 24) & 0xF),
-        0, 0, (uint8_t) ((i >> 20) & 0xF), (uint8_t) ((i >> 16) & 0xF),
-        (uint8_t) ((i >> 12) & 0xF), (uint8_t) ((i >> 8) & 0xF), 0, 0,
-        (uint8_t) ((i >> 4) & 0xF), (uint8_t) (i & 0xF), 0, 0
+static IntegerPair count_collisions(StructureBuffer &buffer,
+                                    const size_t round_offset) {
+    const ColumnCollisions collisions = buffer.counter.count(
+        buffer.ciphertexts.data() + round_offset * NUM_TEXTS_PER_STRUCTURE,
+        NUM_TEXTS_PER_STRUCTURE
     );
-
-    // Random choice can produce collisions
-    // utils::get_random_bytes(plaintext, SMALL_AES_NUM_STATE_BYTES);
+    return IntegerPair(collisions.num_collisions,
+                       collisions.num_multi_column_collisions);
 }
 
 // ---------------------------------------------------------
 
-static __m128i
-get_diagonal_text_from_delta_set(const __m128i base_plaintext, const size_t i) {
-    // Extract from i = [i0 i1 i2 i3]
-    // i0 x  x  x
-    // x  i1 x  x
-    // x  x  i2 x
-    // x  x  x  i3
-
-    return vxor(base_plaintext, vsetr8(
-        (uint8_t) ((i >> 12) & 0xF), 0, 0, 0,
-        0, (uint8_t) ((i >> 8) & 0xF), 0, 0,
-        0, 0, (uint8_t) ((i >> 4) & 0xF), 0,
-        0, 0, 0, (uint8_t) (i & 0xF)
-    ));
+/**
+ * Encrypts the structure over all numbers of rounds in
+ * [min_num_rounds, max_num_rounds] in one pass.
+ */
+static void collect_pairs_for_structure(const small_aes_ctx_t *cipher_ctx,
+                                        const size_t structure_index,
+                                        const size_t min_num_rounds,
+                                        const size_t max_num_rounds,
+                                        std::vector<uint64_t> &ciphertexts) {
+    // Generates the plaintexts on the fly, so their time is included
+    PROFILE_PHASE(PROFILER_PHASE_ENCRYPTION);
+    small_aes_encrypt_diagonal_structure_sweep(cipher_ctx, structure_index,
+                                               ciphertexts.data(),
+                                               min_num_rounds,
+                                               max_num_rounds);
+    PROFILE_ADD(PROFILER_COUNTER_TEXTS, NUM_TEXTS_PER_STRUCTURE);
+    PROFILE_ADD(PROFILER_COUNTER_SETS, 1);
 }
 
 // ---------------------------------------------------------
 
-static inline __m128i encrypt(const small_aes_ctx_t *aes_context,
-                              __m128i plaintext,
-                              const size_t num_rounds) {
-    return small_aes_encrypt_rounds_only_sbox_in_final_with_aes_ni(
-        aes_context, plaintext, num_rounds
-    );
+static void print_collisions(const size_t num_collisions,
+                             const size_t num_multi_column_collisions,
+                             const size_t num_structures) {
+    log_unsigned("# Collisions:  ", num_collisions);
+    log_unsigned("# Multi-Colls: ", num_multi_column_collisions);
+    log_unsigned("# Structures:  ", num_structures);
 }
 
 // ---------------------------------------------------------
 
-static inline size_t extract_column_from_int(const uint64_t state,
-                                             const size_t column_index) {
-    const size_t shift = (3 - column_index) * 16;
-    return (state >> shift) & 0xFFFF;
-}
-
-// ---------------------------------------------------------
+/**
+ * Prints the per-structure results of the tasks in the order of the keys and
+ * structures, as soon as all tasks before them have finished, so that long
+ * runs show their progress and keep the output of the finished keys if they
+ * are killed. Every line holds the collisions of a structure for every swept
+ * number of rounds.
+ */
+class ResultPrinter {
+
+public:
+
+    ResultPrinter(const ExperimentContext *context,
+                  const std::vector<KeyBytes> &keys,
+                  const size_t num_structures,
+                  const size_t num_round_counts) :
+        context(context),
+        keys(keys),
+        num_structures(num_structures),
+        num_round_counts(num_round_counts),
+        sums(num_round_counts),
+        results(keys.size() * num_structures * num_round_counts),
+        is_finished(keys.size() * num_structures, false) {}
 
-static bool collide_in_column(const uint64_t first,
-                              const uint64_t second,
-                              const size_t column_index) {
-    const uint64_t difference = first ^second;
-    const uint64_t mask = 0xFFFF000000000000 >> (column_index * 16);
-    return (difference & mask) == 0;
-}
+    // ---------------------------------------------------------
 
-// ---------------------------------------------------------
+    /**
+     * Stores the results of the task for all numbers of rounds and prints
+     * all tasks that are now finished without a gap from the first one.
+     */
+    void add(const size_t task_index, const IntegerPair *task_results) {
+        std::lock_guard<std::mutex> lock(mutex);
 
-static bool collide_in_later_columns(const uint64_t first,
-                                     const uint64_t second,
-                                     const size_t column_index) {
-    if (column_index == 3) {
-        return false;
-    }
+        for (size_t r = 0; r < num_round_counts; ++r) {
+            results[task_index * num_round_counts + r] = task_results[r];
+        }
 
-    const uint64_t difference = first ^second;
+        is_finished[task_index] = true;
 
-    if ((difference & 0x0000FFFF00000000) == 0) {
-        return true;
+        while ((next_task_index < is_finished.size())
+               && is_finished[next_task_index]) {
+            print_task(next_task_index);
+            next_task_index++;
+        }
     }
 
-    if (column_index == 2) {
-        return false;
-    }
+    // ---------------------------------------------------------
 
-    if ((difference & 0x00000000FFFF0000) == 0) {
-        return true;
-    }
+    /**
+     * Prints the keys without any structures.
+     */
+    void print_empty_keys() {
+        if (num_structures != 0) {
+            return;
+        }
 
-    if (column_index == 1) {
-        return false;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            print_key_header(i);
+            print_key_footer();
+        }
     }
 
-    return (difference & 0x000000000000FFFF) == 0;
-}
+private:
 
-// ---------------------------------------------------------
+    void print_key_header(const size_t key_index) {
+        print_hex("# Key value", keys[key_index].data(),
+                  SMALL_AES_NUM_STATE_BYTES);
+        std::cout << "# Iteration Collisions" << '\n';
 
-static void shift_values_in_list(UInt64List &list) {
-    for (size_t i = 0; i < NUM_TEXTS_PER_STRUCTURE; ++i) {
-        list[i] <<= 16;
+        for (IntegerPair &sum : sums) {
+            sum = IntegerPair(0, 0);
+        }
     }
-}
 
-// ---------------------------------------------------------
+    // ---------------------------------------------------------
 
-static void sort_list(UInt64Vector &sorted_list,
-                      const UInt64List &original_list,
-                      const UInt64List &count_list) {
-    const size_t num_texts = original_list.size();
-    sorted_list.clear();
+    void print_key_footer() {
+        std::cout << "# Finished all structures" << '\n';
 
-    for (size_t i = 0; i < num_texts; ++i) {
-        const uint64_t text = original_list[i];
-        // Use column 0 since we shift!
-        const size_t column_value = extract_column_from_int(text, 0);
+        for (size_t r = 0; r < num_round_counts; ++r) {
+            if (num_round_counts > 1) {
+                log_unsigned("# Rounds:      ", context->num_rounds + r);
+            }
 
-        if (count_list[column_value] <= 1) {
-            continue;
+            print_collisions(sums[r].first,
+                             sums[r].second,
+                             context->num_structures_per_key);
         }
 
-        sorted_list.push_back(text);
+        std::cout << std::flush;
     }
 
-    std::sort(sorted_list.begin(), sorted_list.end());
-}
-
-// ---------------------------------------------------------
-
-static IntegerPair count_collisions_in_list(const UInt64List &list,
-                                            const UInt64List &count_list,
-                                            const size_t column_index) {
-    size_t num_collisions = 0;
-    size_t num_multi_column_collisions = 0;
-    UInt64Vector sorted_list;
+    // ---------------------------------------------------------
 
-    sort_list(sorted_list, list, count_list);
-    size_t num_texts = sorted_list.size();
+    void print_task(const size_t task_index) {
+        const size_t structure_index = task_index % num_structures;
 
-    // Find collisions
-    for (size_t i = 0; i < num_texts; ++i) {
-        const uint64_t first = sorted_list[i];
+        if (structure_index == 0) {
+            print_key_header(task_index / num_structures);
+        }
 
-        for (size_t j = i + 1; j < num_texts; ++j) {
-            const uint64_t second = sorted_list[j];
+        for (size_t r = 0; r < num_round_counts; ++r) {
+            const IntegerPair &pair =
+                results[task_index * num_round_counts + r];
+            sums[r].first += pair.first;
+            sums[r].second += pair.second;
 
-            // Collide in first column since we shift
-            if (!collide_in_column(first, second, 0)) {
-                break;
+            if (r > 0) {
+                std::cout << " ";
             }
 
-            if (collide_in_later_columns(first, second, column_index)) {
-                num_multi_column_collisions++;
-                continue;
-            }
-
-            num_collisions++;
+            std::cout << std::setw(8) << pair.first
+                      << " "
+                      << std::setw(8) << pair.second;
         }
-    }
-
-    IntegerPair result(num_collisions, num_multi_column_collisions);
-    return result;
-}
-
-// ---------------------------------------------------------
 
-static IntegerPair count_collisions(ExperimentContext *context) {
-    IntegerPair result(0, 0);
+        std::cout << std::endl;
 
-    for (size_t column_index = 0;
-         column_index < SMALL_AES_NUM_COLUMNS;
-         ++column_index) {
-
-        const IntegerPair pair = count_collisions_in_list(
-            context->list, context->count_lists[column_index], column_index
-        );
-        result.first += pair.first;
-        result.second += pair.second;
-        shift_values_in_list(context->list);
-    }
-
-    return result;
-}
-
-// ---------------------------------------------------------
-
-static void collect_pairs_for_structure(const small_aes_ctx_t *cipher_ctx,
-                                        const size_t structure_index,
-                                        const size_t num_rounds,
-                                        UInt64List &list,
-                                        UInt64List count_lists[SMALL_AES_NUM_COLUMNS]) {
-    __m128i base_plaintext = generate_diagonal_base_plaintext(structure_index);
-
-    for (size_t j = 0; j < NUM_TEXTS_PER_STRUCTURE; ++j) {
-        // Prepare plaintext
-        const __m128i plaintext = get_diagonal_text_from_delta_set(
-            base_plaintext, j);
-
-        // Encrypt and store to four lists
-        const __m128i ciphertext = encrypt(cipher_ctx, plaintext, num_rounds);
-        const uint64_t ciphertext_as_int = convert_to_uint64(ciphertext);
-        list[j] = ciphertext_as_int;
-
-        for (size_t i = 0; i < SMALL_AES_NUM_COLUMNS; ++i) {
-            const size_t column_value = extract_column_from_int(
-                ciphertext_as_int, i);
-            count_lists[i][column_value]++;
+        if (structure_index == num_structures - 1) {
+            print_key_footer();
         }
     }
-}
 
-// ---------------------------------------------------------
-
-static void print_collisions(const size_t num_collisions,
-                             const size_t num_multi_column_collisions,
-                             const size_t num_structures) {
-    log_unsigned("# Collisions:  ", num_collisions);
-    log_unsigned("# Multi-Colls: ", num_multi_column_collisions);
-    log_unsigned("# Structures:  ", num_structures);
-}
-
-// ---------------------------------------------------------
+    // ---------------------------------------------------------
 
-static void init_lists(UInt64List lists[SMALL_AES_NUM_COLUMNS],
-                       const size_t num_elements) {
-    for (size_t i = 0; i < SMALL_AES_NUM_COLUMNS; ++i) {
-        for (size_t j = 0; j < num_elements; ++j) {
-            lists[i][j] = 0;
-        }
-    }
-}
+    const ExperimentContext *context;
+    const std::vector<KeyBytes> &keys;
+    const size_t num_structures;
+    const size_t num_round_counts;
+    std::vector<IntegerPair> sums;
+    std::vector<IntegerPair> results;
+    std::vector<bool> is_finished;
+    size_t next_task_index = 0;
+    std::mutex mutex;
+};
 
 // ---------------------------------------------------------
 // Experiment
 // ---------------------------------------------------------
 
-static void perform_experiment(ExperimentContext *context) {
+static void perform_experiments(ExperimentContext *context) {
+    const size_t num_structures =
+        (context->num_structures_per_key > context->structure_start_index) ?
+        context->num_structures_per_key - context->structure_start_index : 0;
+    const size_t num_tasks = context->num_keys * num_structures;
+    const size_t num_round_counts =
+        context->max_num_rounds - context->num_rounds + 1;
+
     // ---------------------------------------------------------
-    // Set up the key
+    // Set up the keys
     // ---------------------------------------------------------
 
-    small_aes_ctx_t *cipher_ctx = &context->cipher_ctx;
+    PROFILE_START();
+    std::vector<KeyBytes> keys(context->num_keys);
 
-    if (!context->has_set_key) {
-        utils::get_random_bytes(context->key, SMALL_AES_NUM_KEY_BYTES);
+    for (KeyBytes &key : keys) {
+        if (context->has_set_key) {
+            memcpy(key.data(), context->key, SMALL_AES_NUM_KEY_BYTES);
+        } else {
+            utils::get_random_bytes(&context->prng,
+                                    key.data(),
+                                    SMALL_AES_NUM_KEY_BYTES);
+        }
     }
 
-    small_aes_key_setup(cipher_ctx, context->key);
-    context->num_collisions = 0;
-    context->num_multi_column_collisions = 0;
-
     // ---------------------------------------------------------
     // Encrypt texts
     // ---------------------------------------------------------
 
-    print_hex("# Key value", context->key, SMALL_AES_NUM_STATE_BYTES);
-    std::cout << "# Iteration Collisions" << '\n';
-
-    // ---------------------------------------------------------
+    const size_t num_buffers = std::max(
+        (size_t) 1, std::min(context->num_threads, num_tasks)
+    );
+    std::vector<StructureBuffer> buffers(num_buffers);
+    ResultPrinter printer(context, keys, num_structures, num_round_counts);
+    printer.print_empty_keys();
 
-    for (size_t i = context->structure_start_index;
-         i < context->num_structures_per_key;
-         ++i) {
-
-        init_lists(context->count_lists, NUM_TEXTS_PER_STRUCTURE);
-        collect_pairs_for_structure(cipher_ctx, i, NUM_CONSIDERED_ROUNDS,
-                                    context->list, context->count_lists);
-        const IntegerPair pair = count_collisions(context);
-        context->num_collisions += pair.first;
-        context->num_multi_column_collisions += pair.second;
-
-        std::cout << std::setw(8) << pair.first
-                  << " "
-                  << std::setw(8) << pair.second
-                  << '\n';
+    for (StructureBuffer &buffer : buffers) {
+        buffer.ciphertexts.resize(num_round_counts * NUM_TEXTS_PER_STRUCTURE);
     }
 
-    // ---------------------------------------------------------
+    utils::run_in_parallel(
+        num_tasks,
+        num_buffers,
+        [&](const size_t task_index, const size_t thread_index) {
+            const size_t key_index = task_index / num_structures;
+            const size_t structure_index = context->structure_start_index
+                                           + task_index % num_structures;
 
-    std::cout << "# Finished all structures" << '\n';
+            small_aes_ctx_t cipher_ctx;
 
-    print_collisions(context->num_collisions,
-                     context->num_multi_column_collisions,
-                     context->num_structures_per_key);
-}
+            {
+                PROFILE_PHASE(PROFILER_PHASE_KEY_SETUP);
+                small_aes_key_setup(&cipher_ctx, keys[key_index].data());
+            }
 
-// ---------------------------------------------------------
+            StructureBuffer &buffer = buffers[thread_index];
+            collect_pairs_for_structure(&cipher_ctx, structure_index,
+                                        context->num_rounds,
+                                        context->max_num_rounds,
+                                        buffer.ciphertexts);
 
-static void perform_experiments(ExperimentContext *context) {
-    for (size_t i = 0; i < context->num_keys; ++i) {
-        perform_experiment(context);
-    }
+            std::vector<IntegerPair> task_results(num_round_counts);
+
+            for (size_t r = 0; r < num_round_counts; ++r) {
+                task_results[r] = count_collisions(buffer, r);
+            }
+
+            printer.add(task_index, task_results.data());
+        }
+    );
 }
 
 // ---------------------------------------------------------
@@ -397,12 +376,18 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
     parser.helpString("Evaluates with the Small-AES the number of inverse-"
                       "diagonal collisions after six rounds. The number is "
                       "evaluated for structures of plaintexts that iterate over "
-                      "all values in the first diagonal.");
+                      "all values in the first diagonal. With r and m, "
+                      "evaluates every number of rounds in [r, m] from a "
+                      "single encryption pass per structure.");
     parser.useExceptions(true);
     parser.addArgument("-k", "--num_keys", 1, false);
     parser.addArgument("-s", "--num_structures_per_key", 1, false);
     parser.addArgument("-j", "--key_value", 1, true);
     parser.addArgument("-i", "--structure_index", 1, true);
+    parser.addArgument("-r", "--num_rounds", 1, true);
+    parser.addArgument("-m", "--max_num_rounds", 1, true);
+    parser.addArgument("-t", "--num_threads", 1, true);
+    parser.addArgument("-e", "--seed", 1, true);
 
     try {
         parser.parse((size_t) argc, argv);
@@ -410,6 +395,23 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
 
         context->num_keys = parser.retrieveAsLong("k");
         context->num_structures_per_key = parser.retrieveAsLong("s");
+        context->num_threads = utils::get_num_available_threads();
+
+        if (parser.wasSet("-t")) {
+            context->num_threads = parser.retrieveAsLong("t");
+        }
+
+        context->seed = parser.wasSet("-e") ?
+                        parser.retrieveAsLong("e") :
+                        utils::get_random_seed_from_dev_urandom();
+
+        if (parser.wasSet("-r")) {
+            context->num_rounds = parser.retrieveAsLong("r");
+        }
+
+        context->max_num_rounds = parser.wasSet("-m") ?
+                                  parser.retrieveAsLong("m") :
+                                  context->num_rounds;
 
         if (parser.wasSet("-i")) {
             context->structure_start_index = parser.retrieveAsLong("i");
@@ -425,9 +427,21 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
         exit(EXIT_FAILURE);
     }
 
+    if ((context->num_rounds == 0)
+        || (context->num_rounds > context->max_num_rounds)
+        || (context->max_num_rounds > SMALL_AES_NUM_ROUNDS)) {
+        std::cerr << parser.usage().c_str() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
     log_unsigned("# Keys            ", context->num_keys);
     log_unsigned("# Sets/Key        ", context->num_structures_per_key);
     log_unsigned("# Start structure ", context->structure_start_index);
+    log_unsigned("# Rounds          ", context->num_rounds);
+    log_unsigned("# Max. rounds     ", context->max_num_rounds);
+    log_unsigned("# Threads         ", context->num_threads);
+    log_unsigned("# Seed            ", context->seed);
+    utils::xorshift1024_init_with_seed(&context->prng, context->seed);
 }
 
 // ---------------------------------------------------------
@@ -442,6 +456,7 @@ int main(int argc, const char **argv) {
     const auto end = std::chrono::system_clock::now();
     const std::chrono::duration<double> elapsed_seconds = end - start;
     print_time(elapsed_seconds.count(), context.num_structures_per_key);
+    PROFILE_PRINT();
 
     return EXIT_SUCCESS;
 }
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 
 #include <map>
+#include <string>
 #include <vector>
 #include <numeric>      // std::iota
 #include <algorithm>    // std::sort
@@ -17,32 +18,38 @@
 #include "ciphers/small_state_pair.h"
 #include "ciphers/speck64.h"
 #include "utils/argparse.h"
+#include "utils/column_buckets.h"
+#include "utils/compact_hash_table.h"
 #include "utils/hash_table_generator.h"
+#include "utils/profiler.h"
 #include "utils/utils.h"
 #include "utils/xorshift1024.h"
 
 
 using ciphers::SMALL_AES_SBOX_ARRAY;
 using ciphers::small_aes_ctx_t;
+using ciphers::small_aes_packed_state_t;
 using ciphers::small_aes_state_t;
+using ciphers::small_aes_to_packed;
 using ciphers::small_aes_key_t;
 using ciphers::SmallState;
-using ciphers::SmallStatePair;
 using ciphers::speck64_context_t;
 using ciphers::speck64_96_key_t;
 using ciphers::speck64_state_t;
 using utils::ArgumentParser;
+using utils::ColumnBuckets;
+using utils::CompactHashTables;
+using utils::ExtendedDDT;
 using utils::HashTableGenerator;
 using utils::IntegerList;
-using utils::IntegerMatrix;
 using utils::print_hex;
-using utils::to_uint64;
 using utils::xor_arrays;
 using utils::zeroize_array;
 
 // ---------------------------------------------------------
 
-const size_t NUM_TEXTS_PER_STRUCTURE = 1 << 16;
+const size_t NUM_TEXTS_PER_STRUCTURE =
+    SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE;
 
 // ---------------------------------------------------------
 
@@ -54,28 +61,12 @@ typedef struct {
     IntegerList num_matches;
     size_t num_keys_to_print = 100;
     size_t num_considered_rounds = 6;
-    std::vector<std::vector<IntegerMatrix> > hash_tables; // 4D
+    std::string hash_table_file_name;
+    CompactHashTables hash_tables;
 } ExperimentContext;
 
-typedef std::vector<std::vector<SmallStatePair> > ColumnToPairsList;
 typedef std::vector<SmallState> SmallStatesVector;
-
-// ---------------------------------------------------------
-
-static void
-generate_diagonal_base_plaintext(small_aes_state_t plaintext, const size_t i) {
-    // Zeroize
-    // 0 x x x
-    // x 0 x x
-    // x x 0 x
-    // x x x 0
-    memset(plaintext, 0x00, SMALL_AES_NUM_STATE_BYTES);
-    // Index the plaintext bytes that are not used for creating structures
-    plaintext[1] = (uint8_t) ((i >> 24) & 0xFF);
-    plaintext[3] = (uint8_t) ((i >> 16) & 0xFF);
-    plaintext[4] = (uint8_t) ((i >> 8) & 0xFF);
-    plaintext[6] = (uint8_t) (i & 0xFF);
-}
+typedef std::vector<uint64_t> UInt64Vector;
 
 // ---------------------------------------------------------
 
@@ -99,81 +90,25 @@ generate_column_base_plaintext(small_aes_state_t plaintext, const size_t i) {
 
 // ---------------------------------------------------------
 
-static void
-get_diagonal_text_from_delta_set(small_aes_state_t text, const size_t i) {
-    // Extract from i = [i0 i1 i2 i3]
-    // i0 x  x  x
-    // x  i1 x  x
-    // x  x  i2 x
-    // x  x  x  i3
-    text[0] = (uint8_t) ((i >> 8) & 0xF0);
-    text[2] = (uint8_t) ((i >> 8) & 0x0F);
-    text[5] = (uint8_t) (i & 0xF0);
-    text[7] = (uint8_t) (i & 0x0F);
-}
-
-// ---------------------------------------------------------
-
-static void
-get_column_text_from_delta_set(small_aes_state_t text, const size_t i) {
-    // Extract from i = [i0 i1 i2 i3]
-    // i0 x  x  x
-    // i1 x  x  x
-    // i2 x  x  x
-    // i3 x  x  x
-    text[0] = (uint8_t) ((i >> 8) & 0xFF);
-    text[1] = (uint8_t) (i & 0xFF);
-}
-
-// ---------------------------------------------------------
-
-static void encrypt(const small_aes_ctx_t *aes_context,
-                    small_aes_state_t plaintext,
-                    small_aes_state_t ciphertext,
-                    const size_t num_rounds) {
-    small_aes_encrypt_rounds_only_sbox_in_final(
-        aes_context, plaintext, ciphertext, num_rounds
-    );
-}
-
-// ---------------------------------------------------------
-
-static size_t extract_column(const small_aes_state_t state,
-                             const size_t column_index) {
-    const size_t byte_index = 2 * column_index;
-    return (state[byte_index] << 8) | state[byte_index + 1];
-}
-
-// ---------------------------------------------------------
-
 static size_t extract_diagonal(const small_aes_state_t state) {
-    return (size_t) ((state[0] & 0xF0) << 8)
-           | ((state[2] & 0x0F) << 8)
-           | (state[5] & 0xF0)
-           | (state[7] & 0x0F);
+    return (size_t) utils::extract_bits(small_aes_to_packed(state),
+                                        SMALL_AES_PACKED_DIAGONAL_MASK);
 }
 
 // ---------------------------------------------------------
 
-static size_t to_diagonal(const IntegerList &list) {
-    return ((list[0] & 0x0F) << 12)
-           | ((list[1] & 0x0F) << 8)
-           | ((list[2] & 0x0F) << 4)
-           | (list[3] & 0x0F);
-}
-
-// ---------------------------------------------------------
-
-static bool collide_in_earlier_columns(const small_aes_state_t first_ciphertext,
-                                       const small_aes_state_t second_ciphertext,
+static bool collide_in_earlier_columns(const uint64_t first_ciphertext,
+                                       const uint64_t second_ciphertext,
                                        const size_t list_index) {
     if (list_index > SMALL_AES_NUM_COLUMNS) {
         return false;
     }
 
     for (size_t i = 0; i < list_index; ++i) {
-        const size_t first_column = extract_column(first_ciphertext, i);
-        const size_t second_column = extract_column(second_ciphertext, i);
+        const size_t first_column = ColumnBuckets::get_column(
+            first_ciphertext, i);
+        const size_t second_column = ColumnBuckets::get_column(
+            second_ciphertext, i);
 
         if (first_column == second_column) {
             return true;
@@ -192,6 +127,7 @@ static bool collide_in_earlier_columns(const small_aes_state_t first_ciphertext,
  */
 static void sort_key_candidates(IntegerList &sorted_key_indices,
                                 const IntegerList &key_candidates) {
+    PROFILE_PHASE(PROFILER_PHASE_BUCKETING);
     const size_t num_keys = key_candidates.size();
     sorted_key_indices.resize(num_keys);
 
@@ -232,28 +168,23 @@ static void increment_counters(const ExperimentContext *context,
                                IntegerList &key_candidates,
                                const size_t p_diagonal,
                                const size_t delta_p_diagonal) {
-    for (size_t k = 0; k < SMALL_AES_NUM_COLUMNS; ++k) {
-        // Get hash table for row
-        const std::vector<IntegerMatrix> &hash_table = context->hash_tables[k];
-
-        // Get the key candidates that can produce this collision
-        const std::vector<IntegerList> &transitions =
-            hash_table[delta_p_diagonal];
-
-        if (transitions.empty()) {
-            continue;
-        }
+    const CompactHashTables &hash_tables = context->hash_tables;
 
-        for (const IntegerList &diagonals_after_add_key : transitions) {
+    for (size_t k = 0; k < SMALL_AES_NUM_COLUMNS; ++k) {
+        // Get the key candidates that can produce this collision from the
+        // hash table for row k
+        const uint16_t *begin = hash_tables.get_diagonals_begin(
+            k, delta_p_diagonal);
+        const uint16_t *end = hash_tables.get_diagonals_end(
+            k, delta_p_diagonal);
+
+        for (const uint16_t *diagonal = begin; diagonal != end; ++diagonal) {
             // Example:
             // - column = K xor P = [{0, 2, e, c}, {0, 2, e, d}]
             // - P = {3, 4, 5, 6}
             // Then, the key candidates are
             // K = column xor P = [{3, 6, b, a}, {3, 6, b, b}].
-
-            const size_t diagonal_after_add_key = to_diagonal(
-                diagonals_after_add_key);
-            const size_t key_diagonal = p_diagonal ^diagonal_after_add_key;
+            const size_t key_diagonal = p_diagonal ^*diagonal;
             key_candidates[key_diagonal]++;
         }
     }
@@ -262,38 +193,40 @@ static void increment_counters(const ExperimentContext *context,
 // ---------------------------------------------------------
 
 static void find_collisions(const ExperimentContext *context,
-                            const ColumnToPairsList &target_list,
-                            IntegerList &key_candidates,
-                            const size_t list_index) {
+                            const ColumnBuckets &buckets,
+                            IntegerList &key_candidates) {
+    const size_t list_index = buckets.get_column_index();
+
     // For all column values
-    for (auto const &texts_with_column_value: target_list) {
+    for (size_t value = 0; value < NUM_TEXTS_PER_STRUCTURE; ++value) {
         // No collisions for the current column value
-        if (texts_with_column_value.size() < 2) {
+        if (buckets.get_bucket_size(value) < 2) {
             continue;
         }
 
-        // Collisions occurred
-        for (size_t i = 0; i < texts_with_column_value.size(); ++i) {
-            const SmallStatePair &first_text = texts_with_column_value[i];
-            const size_t p_diagonal = extract_diagonal(first_text.first);
+        const uint64_t *begin = buckets.get_bucket_begin(value);
+        const uint64_t *end = buckets.get_bucket_end(value);
 
-            for (size_t j = i + 1; j < texts_with_column_value.size(); ++j) {
-                const SmallStatePair &second_text = texts_with_column_value[j];
+        // Collisions occurred. Since the plaintexts differ only in the
+        // diagonal, which is the index of the text, the plaintext diagonal
+        // is the index, and their difference is the difference of indices.
+        for (const uint64_t *first_text = begin; first_text != end;
+             ++first_text) {
+            const size_t p_diagonal = buckets.get_text_index(*first_text);
 
+            for (const uint64_t *second_text = first_text + 1;
+                 second_text != end;
+                 ++second_text) {
                 // Look up if they collide in previous columns
                 if (list_index > 0 &&
-                    collide_in_earlier_columns(first_text.second,
-                                               second_text.second,
+                    collide_in_earlier_columns(*first_text,
+                                               *second_text,
                                                list_index)) {
                     continue;
                 }
 
-                small_aes_state_t delta_p;
-                xor_arrays(delta_p,
-                           first_text.first,
-                           second_text.first,
-                           SMALL_AES_NUM_STATE_BYTES);
-                const size_t delta_p_diagonal = extract_diagonal(delta_p);
+                const size_t delta_p_diagonal =
+                    p_diagonal ^ buckets.get_text_index(*second_text);
 
                 increment_counters(
                     context, key_candidates, p_diagonal, delta_p_diagonal
@@ -306,17 +239,14 @@ static void find_collisions(const ExperimentContext *context,
 // ---------------------------------------------------------
 
 static void count_keys(const ExperimentContext *context,
-                       ColumnToPairsList &list0,
-                       ColumnToPairsList &list1,
-                       ColumnToPairsList &list2,
-                       ColumnToPairsList &list3,
+                       const ColumnBuckets buckets[SMALL_AES_NUM_COLUMNS],
                        IntegerList &key_candidates) {
     // puts("# Counting keys");
+    PROFILE_PHASE(PROFILER_PHASE_COLLISION_COUNTING);
 
-    find_collisions(context, list0, key_candidates, 0);
-    find_collisions(context, list1, key_candidates, 1);
-    find_collisions(context, list2, key_candidates, 2);
-    find_collisions(context, list3, key_candidates, 3);
+    for (size_t i = 0; i < SMALL_AES_NUM_COLUMNS; ++i) {
+        find_collisions(context, buckets[i], key_candidates);
+    }
 
     // puts("# Counting keys done");
 }
@@ -324,30 +254,15 @@ static void count_keys(const ExperimentContext *context,
 // ---------------------------------------------------------
 
 /**
- *
- * @param list
- * @param column_index Integer of 0,1,2,3
- * @param pair Plaintext-ciphertext pair
+ * Sorts the texts into the buckets of all four columns.
+ * @param ciphertexts The ciphertexts in the order of their index in the
+ * structure.
  */
-static void insert_to_list(ColumnToPairsList &list,
-                           size_t column_index,
-                           const SmallStatePair &pair) {
-    const size_t column_as_int = extract_column(pair.second, column_index);
-    std::vector<SmallStatePair> &plaintexts_with_column = list[column_as_int];
-    plaintexts_with_column.push_back(pair);
-}
-
-// ---------------------------------------------------------
-
-static void insert_to_lists(ColumnToPairsList &list0,
-                            ColumnToPairsList &list1,
-                            ColumnToPairsList &list2,
-                            ColumnToPairsList &list3,
-                            const SmallStatePair &pair) {
-    insert_to_list(list0, 0, pair);
-    insert_to_list(list1, 1, pair);
-    insert_to_list(list2, 2, pair);
-    insert_to_list(list3, 3, pair);
+static void fill_buckets(const UInt64Vector &ciphertexts,
+                         ColumnBuckets buckets[SMALL_AES_NUM_COLUMNS]) {
+    for (size_t i = 0; i < SMALL_AES_NUM_COLUMNS; ++i) {
+        buckets[i].fill(ciphertexts.data(), NUM_TEXTS_PER_STRUCTURE, i);
+    }
 }
 
 // ---------------------------------------------------------
@@ -355,66 +270,69 @@ static void insert_to_lists(ColumnToPairsList &list0,
 static void collect_pairs_for_structure(const small_aes_ctx_t *cipher_ctx,
                                         const size_t structure_index,
                                         const size_t num_rounds,
-                                        ColumnToPairsList &list0,
-                                        ColumnToPairsList &list1,
-                                        ColumnToPairsList &list2,
-                                        ColumnToPairsList &list3) {
+                                        UInt64Vector &ciphertexts,
+                                        ColumnBuckets buckets[SMALL_AES_NUM_COLUMNS]) {
     // puts("# Collecting pairs");
 
-    small_aes_state_t base_plaintext;
-    generate_diagonal_base_plaintext(base_plaintext, structure_index);
+    {
+        // Encrypt the whole structure at once, in the order of j
+        PROFILE_PHASE(PROFILER_PHASE_ENCRYPTION);
+        small_aes_encrypt_diagonal_structure(cipher_ctx, structure_index,
+                                             ciphertexts.data(), num_rounds);
+    }
 
-    for (size_t j = 0; j < NUM_TEXTS_PER_STRUCTURE; ++j) {
-        // Prepare plaintext
-        SmallStatePair pair;
-        memcpy(pair.first, base_plaintext, SMALL_AES_NUM_STATE_BYTES);
-        get_diagonal_text_from_delta_set(pair.first, j);
-
-        // Encrypt and store to four lists
-        encrypt(cipher_ctx, pair.first, pair.second, num_rounds);
-        insert_to_lists(list0, list1, list2, list3, pair);
+    {
+        PROFILE_PHASE(PROFILER_PHASE_BUCKETING);
+        fill_buckets(ciphertexts, buckets);
     }
 
+    PROFILE_ADD(PROFILER_COUNTER_TEXTS, NUM_TEXTS_PER_STRUCTURE);
+    PROFILE_ADD(PROFILER_COUNTER_SETS, 1);
+
     // puts("# Collecting pairs done");
 }
 
 // ---------------------------------------------------------
 
 static void precompute_hash_tables(ExperimentContext *context) {
+    PROFILE_PHASE(PROFILER_PHASE_PRECOMPUTATION);
+    const size_t num_sbox_entries = 16;
+
+    if (context->hash_tables.map_from_file(context->hash_table_file_name,
+                                           SMALL_AES_SBOX_ARRAY,
+                                           num_sbox_entries)) {
+        printf("# Mapped hash tables from %s\n",
+               context->hash_table_file_name.c_str());
+        return;
+    }
+
     puts("# Precomputing hash tables");
 
     std::vector<std::vector<IntegerList> > extended_ddt;
+    std::vector<ExtendedDDT> hash_tables;
     HashTableGenerator generator;
 
-    generator.compute_extended_ddt(extended_ddt, SMALL_AES_SBOX_ARRAY, 16);
+    generator.compute_extended_ddt(extended_ddt, SMALL_AES_SBOX_ARRAY,
+                                   num_sbox_entries);
 
     for (size_t i = 0; i < SMALL_AES_NUM_ROWS; ++i) {
-        std::vector<IntegerMatrix> hash_table;
+        ExtendedDDT hash_table;
         generator.create_hash_table(hash_table, i, extended_ddt);
-        context->hash_tables.push_back(hash_table);
+        hash_tables.push_back(hash_table);
     }
 
-    puts("# Precomputing hash tables done");
-}
+    context->hash_tables.build(hash_tables, SMALL_AES_SBOX_ARRAY,
+                               num_sbox_entries);
 
-// ---------------------------------------------------------
-
-static void init_list(ColumnToPairsList &list, const size_t num_elements) {
-    list.clear();
-    list.resize(num_elements);
-}
-
-// ---------------------------------------------------------
+    if (context->hash_tables.write_to_file(context->hash_table_file_name)) {
+        printf("# Stored hash tables to %s\n",
+               context->hash_table_file_name.c_str());
+    } else {
+        fprintf(stderr, "# Could not store hash tables to %s\n",
+                context->hash_table_file_name.c_str());
+    }
 
-static void init_lists(ColumnToPairsList &list0,
-                       ColumnToPairsList &list1,
-                       ColumnToPairsList &list2,
-                       ColumnToPairsList &list3,
-                       const size_t num_elements) {
-    init_list(list0, num_elements);
-    init_list(list1, num_elements);
-    init_list(list2, num_elements);
-    init_list(list3, num_elements);
+    puts("# Precomputing hash tables done");
 }
 
 // ---------------------------------------------------------
@@ -427,36 +345,41 @@ static void perform_experiment(ExperimentContext *context) {
     small_aes_ctx_t *cipher_ctx = &context->cipher_ctx;
     small_aes_key_t correct_key;
 
-    utils::get_random_bytes(correct_key, SMALL_AES_NUM_KEY_BYTES);
+    {
+        PROFILE_PHASE(PROFILER_PHASE_RNG);
+        utils::get_random_bytes(correct_key, SMALL_AES_NUM_KEY_BYTES);
+    }
+
     print_hex("# Full correct key", correct_key, SMALL_AES_NUM_KEY_BYTES);
-    small_aes_key_setup(cipher_ctx, correct_key);
+
+    {
+        PROFILE_PHASE(PROFILER_PHASE_KEY_SETUP);
+        small_aes_key_setup(cipher_ctx, correct_key);
+    }
 
     IntegerList key_candidates;
     key_candidates.resize(NUM_TEXTS_PER_STRUCTURE, 0);
 
     // ---------------------------------------------------------
-    // Set up the lists to store the pairs for the ciphertext columns
+    // Set up the buckets to store the texts by ciphertext columns
     // ---------------------------------------------------------
 
-    ColumnToPairsList list0;
-    ColumnToPairsList list1;
-    ColumnToPairsList list2;
-    ColumnToPairsList list3;
+    ColumnBuckets buckets[SMALL_AES_NUM_COLUMNS];
 
     // ---------------------------------------------------------
     // Encrypt texts
     // ---------------------------------------------------------
 
     IntegerList sorted_key_indices;
+    UInt64Vector ciphertexts(NUM_TEXTS_PER_STRUCTURE);
 
     for (size_t i = 0; i < context->num_structures_per_key; ++i) {
         printf("# Iteration %6zu\n", i);
 
-        init_lists(list0, list1, list2, list3, NUM_TEXTS_PER_STRUCTURE);
         collect_pairs_for_structure(cipher_ctx, i,
-                                    context->num_considered_rounds, list0,
-                                    list1, list2, list3);
-        count_keys(context, list0, list1, list2, list3, key_candidates);
+                                    context->num_considered_rounds,
+                                    ciphertexts, buckets);
+        count_keys(context, buckets, key_candidates);
 
         if (i > 0 && (i % 100 == 0)) {
             sort_key_candidates(sorted_key_indices, key_candidates);
@@ -498,30 +421,33 @@ static bool is_only_single_cell_active(const size_t columns) {
 // ---------------------------------------------------------
 
 static size_t
-count_num_collisions_for_list(const ColumnToPairsList &target_list,
-                              const size_t list_index) {
+count_num_collisions_for_list(const ColumnBuckets &buckets) {
+    const size_t list_index = buckets.get_column_index();
     printf("# Searching collisions in column %2zu\n", list_index);
 
     size_t num_collisions = 0;
-    const size_t column_index = 0;
 
     // For all column values
-    for (auto const &texts_with_column_value: target_list) {
+    for (size_t value = 0; value < NUM_TEXTS_PER_STRUCTURE; ++value) {
         // No collisions for the current column value
-        if (texts_with_column_value.size() < 2) {
+        if (buckets.get_bucket_size(value) < 2) {
             continue;
         }
 
-        // Collisions occurred
-        for (size_t i = 0; i < texts_with_column_value.size(); ++i) {
-            const SmallStatePair &first_text = texts_with_column_value[i];
-            const size_t first_column = extract_column(first_text.first,
-                                                       column_index);
+        const uint64_t *begin = buckets.get_bucket_begin(value);
+        const uint64_t *end = buckets.get_bucket_end(value);
 
-            for (size_t j = i + 1; j < texts_with_column_value.size(); ++j) {
-                const SmallStatePair &second_text = texts_with_column_value[j];
-                const size_t second_column = extract_column(second_text.first,
-                                                            column_index);
+        // Collisions occurred. The plaintexts differ only in the first
+        // column, which is the index of the text.
+        for (const uint64_t *first_text = begin; first_text != end;
+             ++first_text) {
+            const size_t first_column = buckets.get_text_index(*first_text);
+
+            for (const uint64_t *second_text = first_text + 1;
+                 second_text != end;
+                 ++second_text) {
+                const size_t second_column =
+                    buckets.get_text_index(*second_text);
                 const size_t delta_p = first_column ^second_column;
 
                 // Check if it is a plaintext pair from a delta-set
@@ -531,8 +457,8 @@ count_num_collisions_for_list(const ColumnToPairsList &target_list,
 
                 // Look up if they collide in previous columns
                 if (list_index > 0 &&
-                    collide_in_earlier_columns(first_text.second,
-                                               second_text.second,
+                    collide_in_earlier_columns(*first_text,
+                                               *second_text,
                                                list_index)) {
                     continue;
                 }
@@ -550,17 +476,15 @@ count_num_collisions_for_list(const ColumnToPairsList &target_list,
 // ---------------------------------------------------------
 
 static size_t
-count_num_collisions_for_all_lists(ColumnToPairsList &list0,
-                                   ColumnToPairsList &list1,
-                                   ColumnToPairsList &list2,
-                                   ColumnToPairsList &list3) {
+count_num_collisions_for_all_lists(
+    const ColumnBuckets buckets[SMALL_AES_NUM_COLUMNS]) {
     puts("# Counting keys");
 
     size_t num_total_collisions = 0;
-    num_total_collisions += count_num_collisions_for_list(list0, 0);
-    num_total_collisions += count_num_collisions_for_list(list1, 1);
-    num_total_collisions += count_num_collisions_for_list(list2, 2);
-    num_total_collisions += count_num_collisions_for_list(list3, 3);
+
+    for (size_t i = 0; i < SMALL_AES_NUM_COLUMNS; ++i) {
+        num_total_collisions += count_num_collisions_for_list(buckets[i]);
+    }
 
     puts("# Counting keys done");
 
@@ -573,26 +497,26 @@ static void
 collect_column_pairs_for_structure(const small_aes_ctx_t *cipher_ctx,
                                    const size_t structure_index,
                                    const size_t num_rounds,
-                                   ColumnToPairsList &list0,
-                                   ColumnToPairsList &list1,
-                                   ColumnToPairsList &list2,
-                                   ColumnToPairsList &list3) {
+                                   UInt64Vector &ciphertexts,
+                                   ColumnBuckets buckets[SMALL_AES_NUM_COLUMNS]) {
     puts("# Collecting pairs");
 
     small_aes_state_t base_plaintext;
     generate_column_base_plaintext(base_plaintext, structure_index);
 
+    // The texts iterate over all values j of column 0
+    const small_aes_packed_state_t base = small_aes_to_packed(base_plaintext)
+                                          & ~SMALL_AES_PACKED_COLUMN_MASK(0);
+
     for (size_t j = 0; j < NUM_TEXTS_PER_STRUCTURE; ++j) {
-        // Prepare plaintext
-        SmallStatePair pair;
-        memcpy(pair.first, base_plaintext, SMALL_AES_NUM_STATE_BYTES);
-        get_column_text_from_delta_set(pair.first, j);
-
-        // Encrypt and store to four lists
-        encrypt(cipher_ctx, pair.first, pair.second, num_rounds);
-        insert_to_lists(list0, list1, list2, list3, pair);
+        // Encrypt and store in the order of j
+        const small_aes_packed_state_t plaintext = base | ((uint64_t) j << 48);
+        ciphertexts[j] = small_aes_encrypt_rounds_only_sbox_in_final(
+            cipher_ctx, plaintext, num_rounds
+        );
     }
 
+    fill_buckets(ciphertexts, buckets);
     puts("# Collecting pairs done");
 }
 
@@ -624,13 +548,11 @@ static void perform_counting_test(ExperimentContext *context) {
     move_subkeys_one_round_forwards(cipher_ctx, context->num_considered_rounds);
 
     // ---------------------------------------------------------
-    // Set up the lists to store the pairs for the ciphertext columns
+    // Set up the buckets to store the texts by ciphertext columns
     // ---------------------------------------------------------
 
-    ColumnToPairsList list0;
-    ColumnToPairsList list1;
-    ColumnToPairsList list2;
-    ColumnToPairsList list3;
+    ColumnBuckets buckets[SMALL_AES_NUM_COLUMNS];
+    UInt64Vector ciphertexts(NUM_TEXTS_PER_STRUCTURE);
 
     // ---------------------------------------------------------
     // Encrypt texts
@@ -639,12 +561,9 @@ static void perform_counting_test(ExperimentContext *context) {
     const size_t structure_index = 0;
     const size_t num_rounds = context->num_considered_rounds - 1;
 
-    init_lists(list0, list1, list2, list3, NUM_TEXTS_PER_STRUCTURE);
     collect_column_pairs_for_structure(cipher_ctx, structure_index, num_rounds,
-                                       list0, list1, list2, list3);
-    const size_t num_collisions = count_num_collisions_for_all_lists(
-        list0, list1, list2, list3
-    );
+                                       ciphertexts, buckets);
+    const size_t num_collisions = count_num_collisions_for_all_lists(buckets);
     printf("# Collisions:    %8zu\n", num_collisions);
 }
 
@@ -655,6 +574,8 @@ static void perform_experiments(ExperimentContext *context) {
         (void) perform_counting_test; // Unused, but prevent compiler warning
         perform_experiment(context);
     }
+
+    PROFILE_PRINT();
 }
 
 // ---------------------------------------------------------
@@ -667,12 +588,16 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
     parser.appName("Test for the Small-AES six-round key recovery.");
     parser.addArgument("-k", "--num_keys", 1, false);
     parser.addArgument("-s", "--num_structures_per_key", 1, false);
+    parser.addArgument("-f", "--hash_table_file", 1, true);
 
     try {
         parser.parse((size_t) argc, argv);
 
         context->num_keys = parser.retrieveAsLong("k");
         context->num_structures_per_key = parser.retrieveAsLong("s");
+        context->hash_table_file_name = parser.wasSet("-f") ?
+            parser.retrieve<std::string>("f") :
+            utils::get_compact_hash_table_file_name(SMALL_AES_SBOX_ARRAY, 16);
     } catch (...) {
         fprintf(stderr, "%s\n", parser.usage().c_str());
         exit(EXIT_FAILURE);
@@ -680,6 +605,7 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
 
     printf("# Keys      %8zu\n", context->num_keys);
     printf("# Sets/Key  %8zu\n", context->num_structures_per_key);
+    printf("# Tables    %s\n", context->hash_table_file_name.c_str());
 }
 
 // ---------------------------------------------------------
@@ -687,6 +613,7 @@ parse_args(ExperimentContext *context, int argc, const char **argv) {
 int main(int argc, const char **argv) {
     ExperimentContext context;
     parse_args(&context, argc, argv);
+    PROFILE_START();
     precompute_hash_tables(&context);
     perform_experiments(&context);
     return EXIT_SUCCESS;
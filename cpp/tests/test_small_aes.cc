@@ -5,6 +5,8 @@
  */
 
 #include <stdint.h>
+#include <algorithm>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include "ciphers/small_aes.h"
@@ -13,7 +15,11 @@
 
 using ciphers::small_aes_ctx_t;
 using ciphers::small_aes_key_t;
+using ciphers::small_aes_packed_state_t;
 using ciphers::small_aes_state_t;
+using ciphers::small_aes_from_packed;
+using ciphers::small_aes_to_packed;
+using ciphers::to_lower_nibbles;
 using utils::assert_equal;
 
 // ---------------------------------------------------------
@@ -362,6 +368,168 @@ TEST(Small_AES, test_encrypt_6_rounds_only_sbox_in_final_with_aes_ni) {
 
 // ---------------------------------------------------------
 
+static void run_diagonal_structure_test(const size_t structure_index,
+                                        const size_t num_rounds) {
+    const small_aes_key_t key = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef
+    };
+    small_aes_ctx_t ctx;
+    small_aes_key_setup(&ctx, key);
+
+    std::vector<uint64_t> ciphertexts(SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE);
+    small_aes_encrypt_diagonal_structure(&ctx, structure_index,
+                                         ciphertexts.data(), num_rounds);
+
+    for (size_t j = 0; j < SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE; ++j) {
+        const size_t i = structure_index;
+        const small_aes_state_t plaintext = {
+            (uint8_t) ((j >> 8) & 0xF0),
+            (uint8_t) ((i >> 24) & 0xFF),
+            (uint8_t) ((j >> 8) & 0x0F),
+            (uint8_t) ((i >> 16) & 0xFF),
+            (uint8_t) ((i >> 8) & 0xFF),
+            (uint8_t) (j & 0xF0),
+            (uint8_t) (i & 0xFF),
+            (uint8_t) (j & 0x0F)
+        };
+        small_aes_state_t ciphertext;
+        small_aes_encrypt_rounds_only_sbox_in_final(&ctx, plaintext,
+                                                    ciphertext, num_rounds);
+
+        uint64_t expected_ciphertext;
+        utils::to_uint64(&expected_ciphertext, ciphertext,
+                         SMALL_AES_NUM_STATE_BYTES);
+        ASSERT_EQ(expected_ciphertext, ciphertexts[j]);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES, test_packed_conversion) {
+    const small_aes_state_t state = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef
+    };
+    const small_aes_packed_state_t packed = small_aes_to_packed(state);
+    ASSERT_EQ(0x0123456789abcdefL, packed);
+    ASSERT_EQ(packed, utils::convert_to_uint64(to_lower_nibbles(state)));
+
+    small_aes_state_t unpacked;
+    small_aes_from_packed(unpacked, packed);
+    ASSERT_TRUE(assert_equal(state, unpacked,
+                             (size_t) SMALL_AES_NUM_STATE_BYTES));
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES, test_encrypt_and_decrypt_packed) {
+    const small_aes_key_t key = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef
+    };
+    small_aes_ctx_t ctx;
+    small_aes_key_setup(&ctx, key);
+
+    ASSERT_EQ(0x44fd3f912a2684bcL,
+              small_aes_encrypt(&ctx, 0x0123456789abcdefL));
+    ASSERT_EQ(0x0123456789abcdefL,
+              small_aes_decrypt(&ctx, 0x44fd3f912a2684bcL));
+
+    // After 3 rounds with MixColumns in all rounds
+    ASSERT_EQ(0x2be92cfe6bdd35d2L,
+              small_aes_encrypt_rounds_always_mc(&ctx, 0x0123456789abcdefL, 3));
+    ASSERT_EQ(0x0123456789abcdefL,
+              small_aes_decrypt_rounds_always_mc(&ctx, 0x2be92cfe6bdd35d2L, 3));
+
+    for (size_t num_rounds = 1; num_rounds <= SMALL_AES_NUM_ROUNDS;
+         ++num_rounds) {
+        const small_aes_packed_state_t plaintext =
+            0x0123456789abcdefL * num_rounds;
+        small_aes_state_t plaintext_bytes;
+        small_aes_from_packed(plaintext_bytes, plaintext);
+
+        small_aes_state_t ciphertext;
+        small_aes_encrypt_rounds(&ctx, plaintext_bytes, ciphertext, num_rounds);
+        ASSERT_EQ(small_aes_to_packed(ciphertext),
+                  small_aes_encrypt_rounds(&ctx, plaintext, num_rounds));
+
+        small_aes_encrypt_rounds_only_sbox_in_final(
+            &ctx, plaintext_bytes, ciphertext, num_rounds
+        );
+        ASSERT_EQ(small_aes_to_packed(ciphertext),
+                  small_aes_encrypt_rounds_only_sbox_in_final(
+                      &ctx, plaintext, num_rounds
+                  ));
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES, test_encrypt_diagonal_structure) {
+    run_diagonal_structure_test(0, 6);
+    run_diagonal_structure_test(0x12345678, 6);
+    run_diagonal_structure_test(0xFEDCBA98, 1);
+    run_diagonal_structure_test(0x0F1E2D3C, 10);
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES, test_encrypt_rounds_only_sbox_in_final_sweep) {
+    const small_aes_key_t key = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef
+    };
+    small_aes_ctx_t ctx;
+    small_aes_key_setup(&ctx, key);
+
+    const small_aes_packed_state_t plaintext = 0xfedcba9876543210L;
+    small_aes_packed_state_t ciphertexts[SMALL_AES_NUM_ROUNDS];
+    small_aes_encrypt_rounds_only_sbox_in_final_sweep(
+        &ctx, plaintext, ciphertexts, 2, 8
+    );
+
+    for (size_t num_rounds = 2; num_rounds <= 8; ++num_rounds) {
+        ASSERT_EQ(small_aes_encrypt_rounds_only_sbox_in_final(
+                      &ctx, plaintext, num_rounds
+                  ),
+                  ciphertexts[num_rounds - 2]);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES, test_encrypt_diagonal_structure_sweep) {
+    const small_aes_key_t key = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef
+    };
+    small_aes_ctx_t ctx;
+    small_aes_key_setup(&ctx, key);
+
+    const size_t NUM_TEXTS = SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE;
+    const size_t structure_index = 0x12345678;
+    const size_t min_num_rounds = 3;
+    const size_t max_num_rounds = 7;
+
+    std::vector<uint64_t> ciphertexts(
+        (max_num_rounds - min_num_rounds + 1) * NUM_TEXTS
+    );
+    small_aes_encrypt_diagonal_structure_sweep(&ctx, structure_index,
+                                               ciphertexts.data(),
+                                               min_num_rounds,
+                                               max_num_rounds);
+
+    std::vector<uint64_t> expected_ciphertexts(NUM_TEXTS);
+
+    for (size_t r = min_num_rounds; r <= max_num_rounds; ++r) {
+        small_aes_encrypt_diagonal_structure(&ctx, structure_index,
+                                             expected_ciphertexts.data(), r);
+        const uint64_t *actual = ciphertexts.data()
+                                 + (r - min_num_rounds) * NUM_TEXTS;
+        ASSERT_TRUE(std::equal(expected_ciphertexts.begin(),
+                               expected_ciphertexts.end(),
+                               actual));
+    }
+}
+
+// ---------------------------------------------------------
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
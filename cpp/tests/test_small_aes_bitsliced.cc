@@ -0,0 +1,177 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "ciphers/small_aes.h"
+#include "ciphers/small_aes_bitsliced.h"
+#include "utils/utils.h"
+#include "utils/xorshift1024.h"
+
+
+using ciphers::small_aes_bitsliced_ctx_t;
+using ciphers::small_aes_bitsliced_state_t;
+using ciphers::small_aes_ctx_t;
+using ciphers::small_aes_key_t;
+using ciphers::small_aes_state_t;
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+static const size_t NUM_STATES = SMALL_AES_BITSLICED_NUM_STATES;
+
+static const small_aes_key_t KEY = {
+    0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef
+};
+
+// ---------------------------------------------------------
+
+static void to_state(small_aes_state_t state, const uint64_t value) {
+    for (size_t i = 0; i < SMALL_AES_NUM_STATE_BYTES; ++i) {
+        state[i] = (uint8_t) (value >> (56 - 8 * i));
+    }
+}
+
+// ---------------------------------------------------------
+
+static std::vector<uint64_t> get_random_texts(const uint64_t seed) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, seed);
+    std::vector<uint64_t> texts(NUM_STATES);
+
+    for (uint64_t &text : texts) {
+        text = utils::xorshift1024_next(&prng);
+    }
+
+    return texts;
+}
+
+// ---------------------------------------------------------
+
+static void run_encryption_test(const size_t num_rounds,
+                                const bool has_only_sbox_in_final) {
+    small_aes_ctx_t ctx;
+    small_aes_key_setup(&ctx, KEY);
+
+    small_aes_bitsliced_ctx_t bitsliced_ctx;
+    small_aes_bitsliced_key_setup(&bitsliced_ctx, KEY);
+
+    const std::vector<uint64_t> plaintexts = get_random_texts(num_rounds);
+    std::vector<uint64_t> expected_ciphertexts(NUM_STATES);
+
+    for (size_t i = 0; i < NUM_STATES; ++i) {
+        small_aes_state_t plaintext;
+        small_aes_state_t ciphertext;
+        to_state(plaintext, plaintexts[i]);
+
+        if (has_only_sbox_in_final) {
+            small_aes_encrypt_rounds_only_sbox_in_final(
+                &ctx, plaintext, ciphertext, num_rounds
+            );
+        } else {
+            small_aes_encrypt_rounds(&ctx, plaintext, ciphertext, num_rounds);
+        }
+
+        utils::to_uint64(&expected_ciphertexts[i], ciphertext,
+                         SMALL_AES_NUM_STATE_BYTES);
+    }
+
+    small_aes_bitsliced_state_t state;
+    small_aes_bitsliced_pack(&state, plaintexts.data());
+
+    if (has_only_sbox_in_final) {
+        small_aes_bitsliced_encrypt_rounds_only_sbox_in_final(
+            &bitsliced_ctx, &state, num_rounds
+        );
+    } else {
+        small_aes_bitsliced_encrypt_rounds(&bitsliced_ctx, &state,
+                                           num_rounds);
+    }
+
+    std::vector<uint64_t> ciphertexts(NUM_STATES);
+    small_aes_bitsliced_unpack(ciphertexts.data(), &state);
+    ASSERT_EQ(expected_ciphertexts, ciphertexts);
+}
+
+// ---------------------------------------------------------
+
+static void run_diagonal_structure_test(const size_t structure_index,
+                                        const size_t num_rounds) {
+    small_aes_ctx_t ctx;
+    small_aes_key_setup(&ctx, KEY);
+
+    small_aes_bitsliced_ctx_t bitsliced_ctx;
+    small_aes_bitsliced_key_setup(&bitsliced_ctx, KEY);
+
+    std::vector<uint64_t> expected_ciphertexts(
+        SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE
+    );
+    std::vector<uint64_t> ciphertexts(
+        SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE
+    );
+
+    small_aes_encrypt_diagonal_structure(&ctx, structure_index,
+                                         expected_ciphertexts.data(),
+                                         num_rounds);
+    small_aes_bitsliced_encrypt_diagonal_structure(&bitsliced_ctx,
+                                                   structure_index,
+                                                   ciphertexts.data(),
+                                                   num_rounds);
+    ASSERT_EQ(expected_ciphertexts, ciphertexts);
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Bitsliced, test_pack_unpack) {
+    const std::vector<uint64_t> texts = get_random_texts(0);
+    small_aes_bitsliced_state_t state;
+    small_aes_bitsliced_pack(&state, texts.data());
+
+    // Bit 3 of nibble 0 is the most significant bit of the first text
+    ALIGN(32) uint64_t words[4];
+    avxstore(words, state.cells[0][3]);
+    ASSERT_EQ(texts[0] >> 63, words[0] & 1);
+
+    std::vector<uint64_t> unpacked_texts(NUM_STATES);
+    small_aes_bitsliced_unpack(unpacked_texts.data(), &state);
+    ASSERT_EQ(texts, unpacked_texts);
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Bitsliced, test_encrypt_rounds) {
+    for (size_t num_rounds = 1; num_rounds <= SMALL_AES_NUM_ROUNDS;
+         ++num_rounds) {
+        run_encryption_test(num_rounds, false);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Bitsliced, test_encrypt_rounds_only_sbox_in_final) {
+    for (size_t num_rounds = 1; num_rounds <= SMALL_AES_NUM_ROUNDS;
+         ++num_rounds) {
+        run_encryption_test(num_rounds, true);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Bitsliced, test_encrypt_diagonal_structure) {
+    run_diagonal_structure_test(0, 4);
+    run_diagonal_structure_test(0x12345678, 5);
+    run_diagonal_structure_test(0xFEDCBA98, 1);
+    run_diagonal_structure_test(0x0F1E2D3C, 6);
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,323 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <gtest/gtest.h>
+
+#include "ciphers/aes_tables.h"
+#include "ciphers/small_aes.h"
+#include "ciphers/small_aes_cipher.h"
+#include "ciphers/small_aes_random_sbox.h"
+#include "utils/utils.h"
+#include "utils/xorshift1024.h"
+
+
+using ciphers::small_aes_ctx_t;
+using ciphers::small_aes_key_t;
+using ciphers::small_aes_state_t;
+using ciphers::SmallAesCipher;
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+static const size_t NUM_TESTS_PER_ROUND = 16;
+
+// ---------------------------------------------------------
+
+/**
+ * Byte-wise reference of a variant that works on the states in low nibbles
+ * as the round keys in small_aes_ctx_t.
+ */
+template <typename Variant>
+class ReferenceCipher {
+public:
+    explicit ReferenceCipher(const small_aes_ctx_t *ctx) : ctx_(ctx) {
+        storeu(sbox_, Variant::SBoxType::table());
+    }
+
+    void encrypt(const small_aes_state_t plaintext,
+                 small_aes_state_t ciphertext,
+                 const size_t num_rounds,
+                 const bool has_mix_columns_in_final) const {
+        uint8_t state[16];
+        storeu(state, ciphers::to_lower_nibbles(plaintext));
+        add_round_key(state, 0);
+
+        for (size_t i = 1; i <= num_rounds; ++i) {
+            sub_bytes(state);
+
+            if ((i < num_rounds) || has_mix_columns_in_final) {
+                shift_rows(state);
+                mix_columns(state);
+            }
+
+            add_round_key(state, i);
+        }
+
+        ciphers::to_byte_array(ciphertext, loadu(state));
+    }
+
+private:
+    void add_round_key(uint8_t state[16], const size_t round) const {
+        uint8_t round_key[16];
+        storeu(round_key, ctx_->key[round]);
+
+        for (size_t i = 0; i < 16; ++i) {
+            state[i] ^= round_key[i];
+        }
+    }
+
+    void sub_bytes(uint8_t state[16]) const {
+        for (size_t i = 0; i < 16; ++i) {
+            state[i] = sbox_[state[i]];
+        }
+    }
+
+    static void shift_rows(uint8_t state[16]) {
+        static const size_t INDICES[16] = {
+            0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11
+        };
+        uint8_t temp[16];
+        memcpy(temp, state, 16);
+
+        for (size_t i = 0; i < 16; ++i) {
+            state[i] = temp[INDICES[i]];
+        }
+    }
+
+    static void mix_columns(uint8_t state[16]) {
+        typedef typename Variant::MixColumnsType MixColumns;
+        uint8_t temp[16];
+        memcpy(temp, state, 16);
+
+        for (size_t c = 0; c < 16; c += 4) {
+            for (size_t i = 0; i < 4; ++i) {
+                uint8_t value = 0;
+
+                for (size_t k = 0; k < 4; ++k) {
+                    value ^= ciphers::small_aes_gf16_multiply(
+                        MixColumns::coefficient(k), temp[c + (i + k) % 4]
+                    );
+                }
+
+                state[c + i] = value;
+            }
+        }
+    }
+
+    const small_aes_ctx_t *ctx_;
+    uint8_t sbox_[16];
+};
+
+// ---------------------------------------------------------
+
+template <typename Variant>
+class Small_AES_Cipher : public testing::Test {
+protected:
+    void SetUp() override {
+        utils::xorshift1024_init_with_seed(&prng_, 0x5A11AE5);
+    }
+
+    void get_random_inputs(small_aes_ctx_t *ctx,
+                           small_aes_state_t plaintext) {
+        small_aes_key_t key;
+        utils::get_random_bytes(&prng_, key, SMALL_AES_NUM_KEY_BYTES);
+        utils::get_random_bytes(&prng_, plaintext, SMALL_AES_NUM_STATE_BYTES);
+        small_aes_key_setup(ctx, key);
+    }
+
+    xorshift_prng_ctx_t prng_;
+};
+
+typedef testing::Types<
+    ciphers::SmallAesDefaultCipher,
+    ciphers::SmallAesM02McCipher,
+    ciphers::SmallAesMidoriMcCipher,
+    ciphers::SmallAesPresentSBoxCipher,
+    ciphers::SmallAesPresentSBoxM02McCipher,
+    ciphers::SmallAesPresentSBoxMidoriMcCipher,
+    ciphers::SmallAesPrideSBoxCipher,
+    ciphers::SmallAesPrinceSBoxCipher,
+    ciphers::SmallAesToy6SBoxCipher,
+    ciphers::SmallAesToy8SBoxCipher,
+    ciphers::SmallAesToy10SBoxCipher
+> Variants;
+
+TYPED_TEST_CASE(Small_AES_Cipher, Variants);
+
+// ---------------------------------------------------------
+
+TYPED_TEST(Small_AES_Cipher, test_encrypt_rounds_only_sbox_in_final) {
+    for (size_t num_rounds = 1; num_rounds <= SMALL_AES_NUM_ROUNDS;
+         ++num_rounds) {
+        for (size_t i = 0; i < NUM_TESTS_PER_ROUND; ++i) {
+            small_aes_ctx_t ctx;
+            small_aes_state_t plaintext;
+            small_aes_state_t expected_ciphertext;
+            small_aes_state_t ciphertext;
+            this->get_random_inputs(&ctx, plaintext);
+
+            ReferenceCipher<TypeParam>(&ctx).encrypt(
+                plaintext, expected_ciphertext, num_rounds, false
+            );
+            TypeParam::encrypt_rounds_only_sbox_in_final(
+                &ctx, plaintext, ciphertext, num_rounds
+            );
+            ASSERT_EQ(0, memcmp(expected_ciphertext, ciphertext,
+                                SMALL_AES_NUM_STATE_BYTES));
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+TYPED_TEST(Small_AES_Cipher, test_encrypt_rounds_always_mc) {
+    for (size_t num_rounds = 1; num_rounds <= SMALL_AES_NUM_ROUNDS;
+         ++num_rounds) {
+        for (size_t i = 0; i < NUM_TESTS_PER_ROUND; ++i) {
+            small_aes_ctx_t ctx;
+            small_aes_state_t plaintext;
+            small_aes_state_t expected_ciphertext;
+            small_aes_state_t ciphertext;
+            this->get_random_inputs(&ctx, plaintext);
+
+            ReferenceCipher<TypeParam>(&ctx).encrypt(
+                plaintext, expected_ciphertext, num_rounds, true
+            );
+            TypeParam::encrypt_rounds_always_mc(
+                &ctx, plaintext, ciphertext, num_rounds
+            );
+            ASSERT_EQ(0, memcmp(expected_ciphertext, ciphertext,
+                                SMALL_AES_NUM_STATE_BYTES));
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+static void assert_is_aes_ni_sbox_map(const __m128i sbox) {
+    uint8_t sbox_values[16];
+    uint8_t map[16];
+    storeu(sbox_values, sbox);
+    storeu(map, ciphers::small_aes_aes_ni_sbox_map(sbox));
+
+    for (size_t x = 0; x < 16; ++x) {
+        ASSERT_EQ(sbox_values[x], ciphers::AES_SBOX[map[x]]);
+    }
+}
+
+// ---------------------------------------------------------
+
+TYPED_TEST(Small_AES_Cipher, test_aes_ni_sbox_map) {
+    assert_is_aes_ni_sbox_map(TypeParam::SBoxType::table());
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Cipher_AES_NI, test_sbox_map_of_small_aes) {
+    const __m128i expected_map = vsetr8(
+        (uint8_t) 0xa5, (uint8_t) 0x9e, (uint8_t) 0x36, (uint8_t) 0x30,
+        (uint8_t) 0x6a, (uint8_t) 0xd7, (uint8_t) 0x38, (uint8_t) 0xa3,
+        (uint8_t) 0x40, (uint8_t) 0xf3, (uint8_t) 0xfb, (uint8_t) 0x81,
+        (uint8_t) 0xd5, (uint8_t) 0x09, (uint8_t) 0x52, (uint8_t) 0xbf
+    );
+    ASSERT_TRUE(vare_equal(
+        expected_map,
+        ciphers::small_aes_aes_ni_sbox_map(SMALL_AES_SBOX_1)
+    ));
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Cipher_AES_NI, test_has_aes_ni_round) {
+    ASSERT_TRUE(ciphers::SmallAesMixColumns::has_aes_ni_round());
+    ASSERT_FALSE(ciphers::SmallAesM02MixColumns::has_aes_ni_round());
+    ASSERT_FALSE(ciphers::SmallAesMidoriMixColumns::has_aes_ni_round());
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Cipher_AES_NI, test_random_sboxes) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, 17);
+
+    for (size_t sbox_index = 0; sbox_index < 20; ++sbox_index) {
+        assert_is_aes_ni_sbox_map(
+            ciphers::SMALL_AES_RANDOM_SBOXES[sbox_index]
+        );
+
+        for (size_t num_rounds = 1; num_rounds <= SMALL_AES_NUM_ROUNDS;
+             ++num_rounds) {
+            small_aes_key_t key;
+            small_aes_state_t plaintext;
+            utils::get_random_bytes(&prng, key, SMALL_AES_NUM_KEY_BYTES);
+            utils::get_random_bytes(&prng, plaintext,
+                                    SMALL_AES_NUM_STATE_BYTES);
+
+            small_aes_ctx_t ctx;
+            small_aes_key_setup(&ctx, key);
+
+            small_aes_state_t expected_ciphertext;
+            small_aes_random_sbox_encrypt_rounds_only_sbox_in_final(
+                &ctx, plaintext, expected_ciphertext, num_rounds, sbox_index
+            );
+
+            small_aes_state_t ciphertext;
+            ciphers::to_byte_array(
+                ciphertext,
+                small_aes_random_sbox_encrypt_rounds_only_sbox_in_final_with_aes_ni(
+                    &ctx, ciphers::to_lower_nibbles(plaintext), num_rounds,
+                    sbox_index
+                )
+            );
+            ASSERT_EQ(0, memcmp(expected_ciphertext, ciphertext,
+                                SMALL_AES_NUM_STATE_BYTES));
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Cipher_Default, test_matches_small_aes) {
+    typedef SmallAesCipher<ciphers::SmallAesSBox,
+                           ciphers::SmallAesMixColumns,
+                           4> FourRoundCipher;
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, 4);
+
+    for (size_t i = 0; i < NUM_TESTS_PER_ROUND; ++i) {
+        small_aes_key_t key;
+        small_aes_state_t plaintext;
+        utils::get_random_bytes(&prng, key, SMALL_AES_NUM_KEY_BYTES);
+        utils::get_random_bytes(&prng, plaintext, SMALL_AES_NUM_STATE_BYTES);
+
+        small_aes_ctx_t ctx;
+        small_aes_key_setup(&ctx, key);
+
+        small_aes_state_t expected_ciphertext;
+        small_aes_state_t ciphertext;
+        small_aes_encrypt_rounds_only_sbox_in_final(&ctx, plaintext,
+                                                    expected_ciphertext, 4);
+        FourRoundCipher::encrypt_rounds_only_sbox_in_final(&ctx, plaintext,
+                                                           ciphertext);
+        ASSERT_EQ(0, memcmp(expected_ciphertext, ciphertext,
+                            SMALL_AES_NUM_STATE_BYTES));
+
+        small_aes_encrypt_rounds_always_mc(&ctx, plaintext,
+                                           expected_ciphertext, 4);
+        FourRoundCipher::encrypt_rounds_always_mc(&ctx, plaintext, ciphertext);
+        ASSERT_EQ(0, memcmp(expected_ciphertext, ciphertext,
+                            SMALL_AES_NUM_STATE_BYTES));
+    }
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
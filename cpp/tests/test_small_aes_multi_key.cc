@@ -0,0 +1,261 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "ciphers/small_aes.h"
+#include "ciphers/small_aes_multi_key.h"
+#include "ciphers/small_aes_random_sbox.h"
+#include "utils/utils.h"
+#include "utils/xorshift1024.h"
+
+
+using ciphers::small_aes_ctx_t;
+using ciphers::small_aes_key_t;
+using ciphers::small_aes_multi_key_ctx_t;
+using ciphers::small_aes_state_t;
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+static const size_t NUM_TEXTS_PER_STRUCTURE =
+    SMALL_AES_NUM_TEXTS_PER_DIAGONAL_STRUCTURE;
+
+// ---------------------------------------------------------
+
+static void get_random_keys(small_aes_key_t *keys,
+                            const size_t num_keys,
+                            const uint64_t seed) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, seed);
+
+    for (size_t k = 0; k < num_keys; ++k) {
+        const uint64_t value = utils::xorshift1024_next(&prng);
+        ciphers::small_aes_from_packed(keys[k], value);
+    }
+}
+
+// ---------------------------------------------------------
+
+static std::vector<uint64_t> get_random_texts(const size_t num_texts,
+                                              const uint64_t seed) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, seed);
+    std::vector<uint64_t> texts(num_texts);
+
+    for (uint64_t &text : texts) {
+        text = utils::xorshift1024_next(&prng);
+    }
+
+    return texts;
+}
+
+// ---------------------------------------------------------
+
+static void run_encryption_test(const size_t num_keys,
+                                const size_t num_texts,
+                                const size_t num_rounds,
+                                const bool has_only_sbox_in_final) {
+    small_aes_key_t keys[SMALL_AES_MULTI_KEY_MAX_NUM_KEYS];
+    get_random_keys(keys, num_keys, num_keys * num_rounds);
+
+    small_aes_multi_key_ctx_t multi_key_ctx;
+    small_aes_multi_key_key_setup(&multi_key_ctx, keys, num_keys);
+    ASSERT_EQ(num_keys, multi_key_ctx.num_keys);
+
+    const std::vector<uint64_t> plaintexts = get_random_texts(num_texts,
+                                                              num_rounds);
+    std::vector<uint64_t> expected_ciphertexts(num_keys * num_texts);
+
+    for (size_t k = 0; k < num_keys; ++k) {
+        small_aes_ctx_t ctx;
+        small_aes_key_setup(&ctx, keys[k]);
+
+        for (size_t j = 0; j < num_texts; ++j) {
+            expected_ciphertexts[k * num_texts + j] = has_only_sbox_in_final
+                ? small_aes_encrypt_rounds_only_sbox_in_final(
+                    &ctx, plaintexts[j], num_rounds
+                )
+                : small_aes_encrypt_rounds(&ctx, plaintexts[j], num_rounds);
+        }
+    }
+
+    std::vector<uint64_t> ciphertexts(num_keys * num_texts);
+
+    if (has_only_sbox_in_final) {
+        small_aes_multi_key_encrypt_rounds_only_sbox_in_final(
+            &multi_key_ctx, plaintexts.data(), num_texts, ciphertexts.data(),
+            num_rounds
+        );
+    } else {
+        small_aes_multi_key_encrypt_rounds(
+            &multi_key_ctx, plaintexts.data(), num_texts, ciphertexts.data(),
+            num_rounds
+        );
+    }
+
+    ASSERT_EQ(expected_ciphertexts, ciphertexts);
+}
+
+// ---------------------------------------------------------
+
+static void run_diagonal_structure_test(const size_t num_keys,
+                                        const size_t structure_index,
+                                        const size_t num_rounds) {
+    small_aes_key_t keys[SMALL_AES_MULTI_KEY_MAX_NUM_KEYS];
+    get_random_keys(keys, num_keys, structure_index);
+
+    small_aes_multi_key_ctx_t multi_key_ctx;
+    small_aes_multi_key_key_setup(&multi_key_ctx, keys, num_keys);
+
+    std::vector<uint64_t> expected_ciphertexts(
+        num_keys * NUM_TEXTS_PER_STRUCTURE
+    );
+    std::vector<uint64_t> ciphertexts(num_keys * NUM_TEXTS_PER_STRUCTURE);
+
+    for (size_t k = 0; k < num_keys; ++k) {
+        small_aes_ctx_t ctx;
+        small_aes_key_setup(&ctx, keys[k]);
+        small_aes_encrypt_diagonal_structure(
+            &ctx, structure_index,
+            expected_ciphertexts.data() + k * NUM_TEXTS_PER_STRUCTURE,
+            num_rounds
+        );
+    }
+
+    small_aes_multi_key_encrypt_diagonal_structure(&multi_key_ctx,
+                                                   structure_index,
+                                                   ciphertexts.data(),
+                                                   num_rounds);
+    ASSERT_EQ(expected_ciphertexts, ciphertexts);
+}
+
+// ---------------------------------------------------------
+
+static void run_sbox_encryption_test(const size_t num_sboxes,
+                                     const size_t first_sbox_index,
+                                     const size_t num_texts,
+                                     const size_t num_rounds) {
+    small_aes_key_t key;
+    get_random_keys(&key, 1, num_sboxes * num_rounds);
+
+    small_aes_multi_key_ctx_t multi_key_ctx;
+    small_aes_multi_key_sbox_setup(
+        &multi_key_ctx, key,
+        ciphers::SMALL_AES_RANDOM_SBOXES + first_sbox_index, num_sboxes
+    );
+    ASSERT_EQ(num_sboxes, multi_key_ctx.num_keys);
+
+    small_aes_ctx_t ctx;
+    small_aes_key_setup(&ctx, key);
+
+    const std::vector<uint64_t> plaintexts = get_random_texts(num_texts,
+                                                              num_rounds);
+    std::vector<uint64_t> expected_ciphertexts(num_sboxes * num_texts);
+
+    for (size_t b = 0; b < num_sboxes; ++b) {
+        for (size_t j = 0; j < num_texts; ++j) {
+            small_aes_state_t plaintext;
+            small_aes_state_t ciphertext;
+            ciphers::small_aes_from_packed(plaintext, plaintexts[j]);
+            small_aes_random_sbox_encrypt_rounds_only_sbox_in_final(
+                &ctx, plaintext, ciphertext, num_rounds,
+                first_sbox_index + b
+            );
+            expected_ciphertexts[b * num_texts + j] =
+                ciphers::small_aes_to_packed(ciphertext);
+        }
+    }
+
+    std::vector<uint64_t> ciphertexts(num_sboxes * num_texts);
+    small_aes_multi_key_encrypt_rounds_only_sbox_in_final(
+        &multi_key_ctx, plaintexts.data(), num_texts, ciphertexts.data(),
+        num_rounds
+    );
+    ASSERT_EQ(expected_ciphertexts, ciphertexts);
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Multi_Key, test_key_setup_rejects_invalid_num_keys) {
+    small_aes_key_t keys[SMALL_AES_MULTI_KEY_MAX_NUM_KEYS];
+    get_random_keys(keys, 3, 0);
+
+    small_aes_multi_key_ctx_t ctx;
+    small_aes_multi_key_key_setup(&ctx, keys, 3);
+    ASSERT_EQ(0U, ctx.num_keys);
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Multi_Key, test_encrypt_rounds) {
+    for (size_t num_keys = 2; num_keys <= SMALL_AES_MULTI_KEY_MAX_NUM_KEYS;
+         num_keys *= 2) {
+        for (size_t num_rounds = 1; num_rounds <= SMALL_AES_NUM_ROUNDS;
+             ++num_rounds) {
+            run_encryption_test(num_keys, 37, num_rounds, false);
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Multi_Key, test_encrypt_rounds_only_sbox_in_final) {
+    for (size_t num_keys = 2; num_keys <= SMALL_AES_MULTI_KEY_MAX_NUM_KEYS;
+         num_keys *= 2) {
+        for (size_t num_rounds = 1; num_rounds <= SMALL_AES_NUM_ROUNDS;
+             ++num_rounds) {
+            run_encryption_test(num_keys, 32, num_rounds, true);
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Multi_Key, test_encrypt_diagonal_structure) {
+    run_diagonal_structure_test(2, 0, 4);
+    run_diagonal_structure_test(4, 0x12345678, 5);
+    run_diagonal_structure_test(8, 0xFEDCBA98, 1);
+    run_diagonal_structure_test(8, 0x0F1E2D3C, 6);
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Multi_Key, test_sbox_setup_rejects_invalid_num_sboxes) {
+    small_aes_key_t key;
+    get_random_keys(&key, 1, 0);
+
+    small_aes_multi_key_ctx_t ctx;
+    small_aes_multi_key_sbox_setup(&ctx, key, ciphers::SMALL_AES_RANDOM_SBOXES,
+                                   0);
+    ASSERT_EQ(0U, ctx.num_keys);
+
+    small_aes_multi_key_sbox_setup(&ctx, key, ciphers::SMALL_AES_RANDOM_SBOXES,
+                                   SMALL_AES_MULTI_KEY_MAX_NUM_KEYS + 1);
+    ASSERT_EQ(0U, ctx.num_keys);
+}
+
+// ---------------------------------------------------------
+
+TEST(Small_AES_Multi_Key, test_encrypt_under_several_sboxes) {
+    for (size_t num_sboxes = 1; num_sboxes <= SMALL_AES_MULTI_KEY_MAX_NUM_KEYS;
+         ++num_sboxes) {
+        for (size_t num_rounds = 1; num_rounds <= SMALL_AES_NUM_ROUNDS;
+             ++num_rounds) {
+            run_sbox_encryption_test(num_sboxes, 20 - num_sboxes, 33,
+                                     num_rounds);
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -8,10 +8,12 @@
 #include <gtest/gtest.h>
 
 #include "utils/utils.h"
+#include "utils/xorshift1024.h"
 
 
 using utils::assert_equal;
 using utils::convert_to_uint64;
+using utils::xorshift_prng_ctx_t;
 
 // ---------------------------------------------------------
 
@@ -27,6 +29,87 @@ TEST(Utils, convert_to_uint64) {
 
 // ---------------------------------------------------------
 
+TEST(Utils, convert_from_uint64) {
+    const __m128i expected = vsetr8(
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+    );
+    const __m128i actual = utils::convert_from_uint64(0x0123456789abcdef);
+    ASSERT_TRUE(vare_equal(expected, actual));
+}
+
+// ---------------------------------------------------------
+
+TEST(Utils, extract_and_deposit_bits) {
+    const uint64_t mask = 0xF0000F0000F0000FL;
+    ASSERT_EQ(0x05afL, utils::extract_bits(0x0123456789abcdefL, mask));
+    ASSERT_EQ(0x0000050000a0000fL, utils::deposit_bits(0x05af, mask));
+    ASSERT_EQ(0L, utils::extract_bits(0x0123456789abcdefL, 0));
+}
+
+// ---------------------------------------------------------
+
+TEST(Utils, xorshift1024_is_deterministic_for_same_seed) {
+    xorshift_prng_ctx_t first;
+    xorshift_prng_ctx_t second;
+    utils::xorshift1024_init_with_seed(&first, 1234);
+    utils::xorshift1024_init_with_seed(&second, 1234);
+
+    for (size_t i = 0; i < 100; ++i) {
+        ASSERT_EQ(utils::xorshift1024_next(&first),
+                  utils::xorshift1024_next(&second));
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(Utils, xorshift1024_split_streams_differ) {
+    xorshift_prng_ctx_t prng;
+    xorshift_prng_ctx_t first_stream;
+    xorshift_prng_ctx_t second_stream;
+    utils::xorshift1024_init_with_seed(&prng, 1234);
+    utils::xorshift1024_split(&prng, &first_stream);
+    utils::xorshift1024_split(&prng, &second_stream);
+
+    size_t num_equal_outputs = 0;
+
+    for (size_t i = 0; i < 100; ++i) {
+        if (utils::xorshift1024_next(&first_stream)
+            == utils::xorshift1024_next(&second_stream)) {
+            num_equal_outputs++;
+        }
+    }
+
+    ASSERT_EQ((size_t) 0, num_equal_outputs);
+}
+
+// ---------------------------------------------------------
+
+TEST(Utils, xorshift1024_jump_is_linear) {
+    // jump(x xor y) = jump(x) xor jump(y), since the jump is a polynomial in
+    // the linear state transition.
+    xorshift_prng_ctx_t x;
+    xorshift_prng_ctx_t y;
+    xorshift_prng_ctx_t x_xor_y;
+    utils::xorshift1024_init_with_seed(&x, 1);
+    utils::xorshift1024_init_with_seed(&y, 2);
+
+    for (size_t i = 0; i < 16; ++i) {
+        x_xor_y.s[i] = x.s[i] ^ y.s[i];
+    }
+
+    x.p = y.p = x_xor_y.p = 0;
+    utils::xorshift1024_jump(&x);
+    utils::xorshift1024_jump(&y);
+    utils::xorshift1024_jump(&x_xor_y);
+
+    for (size_t i = 0; i < 16; ++i) {
+        ASSERT_EQ(x.s[i] ^ y.s[i], x_xor_y.s[i]);
+    }
+}
+
+// ---------------------------------------------------------
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
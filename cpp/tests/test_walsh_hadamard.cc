@@ -0,0 +1,101 @@
+/**
+ * __author__ = anonymized
+ * __date__   = 2019-05
+ * __copyright__ = Creative Commons CC0
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "utils/walsh_hadamard.h"
+#include "utils/xorshift1024.h"
+
+
+using utils::xorshift_prng_ctx_t;
+
+// ---------------------------------------------------------
+
+typedef std::vector<int64_t> Values;
+
+// ---------------------------------------------------------
+
+static Values generate_values(xorshift_prng_ctx_t *prng,
+                              const size_t num_values) {
+    Values values(num_values);
+
+    for (int64_t &value : values) {
+        value = (int64_t) (utils::xorshift1024_next(prng) % 1000);
+    }
+
+    return values;
+}
+
+// ---------------------------------------------------------
+
+static Values xor_convolve(const Values &left, const Values &right) {
+    Values result(left.size(), 0);
+
+    for (size_t i = 0; i < left.size(); ++i) {
+        for (size_t j = 0; j < right.size(); ++j) {
+            result[i ^ j] += left[i] * right[j];
+        }
+    }
+
+    return result;
+}
+
+// ---------------------------------------------------------
+
+TEST(WalshHadamard, transform_of_delta_is_constant) {
+    Values values(16, 0);
+    values[0] = 3;
+    utils::walsh_hadamard_transform(values.data(), values.size());
+
+    for (const int64_t value : values) {
+        ASSERT_EQ(3, value);
+    }
+}
+
+// ---------------------------------------------------------
+
+TEST(WalshHadamard, inverse_restores_values) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, 1);
+    const Values expected = generate_values(&prng, 256);
+    Values values = expected;
+
+    utils::walsh_hadamard_transform(values.data(), values.size());
+    utils::inverse_walsh_hadamard_transform(values.data(), values.size());
+    ASSERT_EQ(expected, values);
+}
+
+// ---------------------------------------------------------
+
+TEST(WalshHadamard, products_of_transforms_are_xor_convolutions) {
+    xorshift_prng_ctx_t prng;
+    utils::xorshift1024_init_with_seed(&prng, 2);
+
+    for (size_t num_values = 1; num_values <= 256; num_values <<= 1) {
+        Values left = generate_values(&prng, num_values);
+        Values right = generate_values(&prng, num_values);
+        const Values expected = xor_convolve(left, right);
+
+        utils::walsh_hadamard_transform(left.data(), num_values);
+        utils::walsh_hadamard_transform(right.data(), num_values);
+
+        for (size_t i = 0; i < num_values; ++i) {
+            left[i] *= right[i];
+        }
+
+        utils::inverse_walsh_hadamard_transform(left.data(), num_values);
+        ASSERT_EQ(expected, left);
+    }
+}
+
+// ---------------------------------------------------------
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}